@@ -1,12 +1,14 @@
 #pragma once
 #include "Base.h"
 #include "../common/Macros.h"
+#include "../Maths/Matrix.h"
 #include <mutex>
 
 #define DECLARE_CLASS_RTTI(class_name)	\
 public:	\
 static std::size_t ClassHashCode;	\
 virtual bool IsSameClass(std::size_t classHashCode) const override;	\
+virtual std::size_t GetClassHashCode() const override { return ClassHashCode; }	\
 
 #define DEFINITE_CLASS_RTTI(class_name, base_class)	\
 std::size_t	class_name::ClassHashCode = std::hash<std::string>()(TO_STRING(class_name));	\
@@ -35,6 +37,9 @@ public:
 	virtual void CallbackFunc(std::shared_ptr<BaseObject>& pObject) {}
 	virtual void OnRenderObject() {}
 	virtual void OnPostRender() {}
+	// Called when cached data of its object is updated, "cachedWorldTransform" isn't published yet, see BaseObject::UpdateCachedData()
+	virtual void OnCachedDataUpdated(const Matrix4d& cachedWorldTransform) {}
+	virtual void OnCachedDataPublished() {}
 
 	virtual void Awake() {}
 	virtual void Start() {}
@@ -51,6 +56,9 @@ public:
 		return ClassHashCode == classHashCode;
 	}
 
+	// Hash code of the most derived class, used as component storage pool key
+	virtual std::size_t GetClassHashCode() const { return ClassHashCode; }
+
 	template <typename T>
 	std::shared_ptr<T> GetComponent(uint32_t index = 0) const
 	{
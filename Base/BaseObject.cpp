@@ -1,6 +1,8 @@
 #include "BaseObject.h"
 #include "../vulkan/GlobalDeviceObjects.h"
 
+std::atomic<uint32_t> BaseObject::m_hierarchyVersion{ 0 };
+
 bool BaseObject::Init(const std::shared_ptr<BaseObject>& pObj)
 {
 	if (!SelfRefBase<BaseObject>::Init(pObj))
@@ -24,6 +26,7 @@ void BaseObject::AddChild(const std::shared_ptr<BaseObject>& pObj)
 		return;
 	m_children.push_back(pObj);
 	pObj->m_pParent = GetSelfSharedPtr();
+	m_hierarchyVersion++;
 }
 
 void BaseObject::DelChild(uint32_t index)
@@ -31,6 +34,7 @@ void BaseObject::DelChild(uint32_t index)
 	if (index < 0 || index >= m_children.size())
 		return;
 	m_children.erase(m_children.begin() + index);
+	m_hierarchyVersion++;
 }
 
 std::shared_ptr<BaseObject> BaseObject::GetChild(uint32_t index)
@@ -50,78 +54,77 @@ bool BaseObject::ContainObject(const std::shared_ptr<BaseObject>& pObj) const
 	return false;
 }
 
-void BaseObject::Update()
+std::shared_ptr<ComponentStorage> BaseObject::GetComponentStorage()
 {
-	//update components attached to this object
-	for (size_t i = 0; i < m_components.size(); i++)
-		m_components[i]->Update();
+	if (m_pComponentStorage == nullptr)
+		m_pComponentStorage = ComponentStorage::Create(GetSelfSharedPtr());
+	return m_pComponentStorage;
+}
 
-	//update all children objects with global registered components
-	for (size_t i = 0; i < m_children.size(); i++)
-		m_children[i]->Update();
+void BaseObject::Update()
+{
+	GetComponentStorage()->ExecutePhase(ComponentStorage::PhaseUpdate);
 }
 
 void BaseObject::OnAnimationUpdate()
 {
-	for (size_t i = 0; i < m_components.size(); i++)
-		m_components[i]->OnAnimationUpdate();
-
-	for (size_t i = 0; i < m_children.size(); i++)
-		m_children[i]->OnAnimationUpdate();
+	GetComponentStorage()->ExecutePhase(ComponentStorage::PhaseAnimationUpdate);
 }
 
 void BaseObject::LateUpdate()
 {
-	for (size_t i = 0; i < m_components.size(); i++)
-		m_components[i]->LateUpdate();
-
-	for (size_t i = 0; i < m_children.size(); i++)
-		m_children[i]->LateUpdate();
+	GetComponentStorage()->ExecutePhase(ComponentStorage::PhaseLateUpdate);
 }
 
 void BaseObject::UpdateCachedData()
 {
 	Matrix4d cachedParentWorldTransform;
 
+	// Parent isn't updated in this pass, use its published data
 	if (!m_pParent.expired())
-		cachedParentWorldTransform = m_pParent.lock()->m_cachedWorldTransform;
-
-	m_cachedWorldTransform = cachedParentWorldTransform * m_localTransform;
-	m_cachedWorldPosition = (cachedParentWorldTransform * Vector4d(m_localPosition, 1.0f)).xyz();
+		cachedParentWorldTransform = m_pParent.lock()->GetCachedWorldTransform();
 
-	for (size_t i = 0; i < m_children.size(); i++)
-		m_children[i]->UpdateCachedData();
+	UpdateCachedData(cachedParentWorldTransform);
 }
 
-void BaseObject::OnPreRender()
+void BaseObject::UpdateCachedData(const Matrix4d& cachedParentWorldTransform)
 {
+	uint32_t backIndex = 1 - m_cachedDataIndex;
+
+	m_cachedWorldTransform[backIndex] = cachedParentWorldTransform * m_localTransform;
+	m_cachedWorldPosition[backIndex] = (cachedParentWorldTransform * Vector4d(m_localPosition, 1.0f)).xyz();
+
 	for (size_t i = 0; i < m_components.size(); i++)
-		m_components[i]->OnPreRender();
+		m_components[i]->OnCachedDataUpdated(m_cachedWorldTransform[backIndex]);
 
 	for (size_t i = 0; i < m_children.size(); i++)
-		m_children[i]->OnPreRender();
+		m_children[i]->UpdateCachedData(m_cachedWorldTransform[backIndex]);
 }
 
-void BaseObject::OnRenderObject()
+void BaseObject::PublishCachedData()
 {
-	//update components attached to this object
-	//for (size_t i = 0; i < m_components.size(); i++)
-	//	FrameWorkMgr()->AddJobToFrame(std::bind(&BaseComponent::OnRenderObject, m_components[i].get(), std::placeholders::_1));
+	m_cachedDataIndex = 1 - m_cachedDataIndex;
+
 	for (size_t i = 0; i < m_components.size(); i++)
-		m_components[i]->OnRenderObject();
+		m_components[i]->OnCachedDataPublished();
 
-	//update all children objects
 	for (size_t i = 0; i < m_children.size(); i++)
-		m_children[i]->OnRenderObject();
+		m_children[i]->PublishCachedData();
 }
 
-void BaseObject::OnPostRender()
+void BaseObject::OnPreRender()
 {
-	for (size_t i = 0; i < m_components.size(); i++)
-		m_components[i]->OnPostRender();
+	GetComponentStorage()->ExecutePhase(ComponentStorage::PhasePreRender);
+}
 
-	for (size_t i = 0; i < m_children.size(); i++)
-		m_children[i]->OnPostRender();
+void BaseObject::OnRenderObject()
+{
+	GetComponentStorage()->ExecutePhase(ComponentStorage::PhaseRenderObject);
+}
+
+void BaseObject::OnPostRender()
+{
+	GetComponentStorage()->ExecutePhase(ComponentStorage::PhasePostRender);
 }
 
 void BaseObject::Awake()
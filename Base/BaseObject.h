@@ -1,6 +1,8 @@
 #pragma once
 #include <vector>
+#include <atomic>
 #include "BaseComponent.h"
+#include "ComponentStorage.h"
 #include "../maths/Matrix.h"
 #include "../maths/Quaternion.h"
 
@@ -17,6 +19,7 @@ public:
 			return;
 
 		m_components.push_back(pComp);
+		m_hierarchyVersion++;
 		pComp->OnAddedToObject(GetSelfSharedPtr());
 	}
 
@@ -26,7 +29,9 @@ public:
 		uint32_t currentIndex = 0;
 		auto iter = std::find_if(m_components.begin(), m_components.end(), [&currentIndex, index, classHashCode = T::ClassHashCode](auto & pComp)
 		{
-			return (currentIndex == index) && pComp->IsSameClass(classHashCode);
+			if (!pComp->IsSameClass(classHashCode))
+				return false;
+			return (currentIndex++) == index;
 		});
 
 		return iter;
@@ -67,6 +72,7 @@ public:
 		if (iter != m_components.end())
 		{
 			m_components.erase(iter);
+			m_hierarchyVersion++;
 			return true;
 		}
 
@@ -90,6 +96,7 @@ public:
 			if (iter != m_components.end())
 			{
 				m_components.erase(iter);
+				m_hierarchyVersion++;
 				removed = true;
 				count++;
 			}
@@ -132,10 +139,14 @@ public:
 	void Rotate(const Vector3d& v, double angle);
 
 public:
+	// Phases below execute components of the whole sub tree, grouped by component class, see ComponentStorage
 	void Update();
 	void OnAnimationUpdate();
 	void LateUpdate();
+	// Writes back buffer of cached data, it's not visible until "PublishCachedData()"
 	void UpdateCachedData();
+	// Swap cached data buffers of the whole sub tree
+	void PublishCachedData();
 	void OnPreRender();
 	void OnRenderObject();
 	void OnPostRender();
@@ -155,14 +166,23 @@ public:
 	Quaterniond GetWorldRotationQ() const;
 
 	// These are before the stage of pre render
-	Matrix4d GetCachedWorldTransform() const { return m_cachedWorldTransform; }
-	Vector3d GetCachedWorldPosition() const { return m_cachedWorldPosition; }
+	// Double buffered, so that simulation of next frame could update them while render stage of current frame reads, see FramePipeline
+	Matrix4d GetCachedWorldTransform() const { return m_cachedWorldTransform[m_cachedDataIndex]; }
+	Vector3d GetCachedWorldPosition() const { return m_cachedWorldPosition[m_cachedDataIndex]; }
+
+	// Component storage of the sub tree rooted at this object, created when a phase is executed on it for the first time
+	std::shared_ptr<ComponentStorage> GetComponentStorage();
+
+	// Bumped whenever any object adds/removes a component or a child
+	// Atomic, since simulation thread could change hierarchy while render stage reads it
+	static uint32_t GetHierarchyVersion() { return m_hierarchyVersion.load(std::memory_order_acquire); }
 
 	//creators
 	static std::shared_ptr<BaseObject> Create();
 
 protected:
 	void UpdateLocalTransform();
+	void UpdateCachedData(const Matrix4d& cachedParentWorldTransform);
 
 protected:
 	std::vector<std::shared_ptr<BaseComponent>>		m_components;
@@ -176,6 +196,13 @@ protected:
 	Matrix3d	m_localRotationM;
 	Quaterniond m_localRotationQ;
 
-	Matrix4d	m_cachedWorldTransform;
-	Vector3d	m_cachedWorldPosition;
+	Matrix4d	m_cachedWorldTransform[2];
+	Vector3d	m_cachedWorldPosition[2];
+	uint32_t	m_cachedDataIndex = 0;
+
+	std::shared_ptr<ComponentStorage>				m_pComponentStorage;
+
+	static std::atomic<uint32_t>					m_hierarchyVersion;
+
+	friend class ComponentStorage;
 };
\ No newline at end of file
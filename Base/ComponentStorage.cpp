@@ -0,0 +1,93 @@
+#include "ComponentStorage.h"
+#include "BaseObject.h"
+
+bool ComponentStorage::Init(const std::shared_ptr<BaseObject>& pRootObject, const std::shared_ptr<ComponentStorage>& pSelf)
+{
+	if (!SelfRefBase<ComponentStorage>::Init(pSelf))
+		return false;
+
+	m_pRootObject = pRootObject;
+
+	// Make sure first EnsurePools() builds
+	m_builtVersion = BaseObject::GetHierarchyVersion() - 1;
+
+	return true;
+}
+
+std::shared_ptr<ComponentStorage> ComponentStorage::Create(const std::shared_ptr<BaseObject>& pRootObject)
+{
+	std::shared_ptr<ComponentStorage> pStorage = std::make_shared<ComponentStorage>();
+	if (pStorage.get() && pStorage->Init(pRootObject, pStorage))
+		return pStorage;
+	return nullptr;
+}
+
+void ComponentStorage::EnsurePools()
+{
+	// Pools can't be touched while they're iterated, changes made by components are picked up next time
+	if (m_poolsLocked || m_executingCount > 0 || m_builtVersion == BaseObject::GetHierarchyVersion())
+		return;
+
+	RebuildPools();
+}
+
+void ComponentStorage::RebuildPools()
+{
+	m_builtVersion = BaseObject::GetHierarchyVersion();
+	m_rebuildCount++;
+
+	m_pools.clear();
+	m_poolLookupTable.clear();
+	m_keepAliveComponents.clear();
+
+	if (!m_pRootObject.expired())
+		CollectComponents(m_pRootObject.lock());
+}
+
+void ComponentStorage::CollectComponents(const std::shared_ptr<BaseObject>& pObject)
+{
+	for (auto& pComp : pObject->m_components)
+	{
+		std::size_t classHashCode = pComp->GetClassHashCode();
+
+		auto iter = m_poolLookupTable.find(classHashCode);
+		if (iter == m_poolLookupTable.end())
+		{
+			m_poolLookupTable[classHashCode] = (uint32_t)m_pools.size();
+			m_pools.push_back({ classHashCode, {} });
+			iter = m_poolLookupTable.find(classHashCode);
+		}
+
+		m_pools[iter->second].components.push_back(pComp.get());
+		m_keepAliveComponents.push_back(pComp);
+	}
+
+	for (auto& pChild : pObject->m_children)
+		CollectComponents(pChild);
+}
+
+void ComponentStorage::ExecutePhase(ComponentPhase phase)
+{
+	EnsurePools();
+
+	m_executingCount++;
+
+	for (auto& pool : m_pools)
+	{
+		BaseComponent** ppComponents = pool.components.data();
+		size_t count = pool.components.size();
+
+		switch (phase)
+		{
+		case PhaseUpdate:			for (size_t i = 0; i < count; i++) ppComponents[i]->Update(); break;
+		case PhaseAnimationUpdate:	for (size_t i = 0; i < count; i++) ppComponents[i]->OnAnimationUpdate(); break;
+		case PhaseLateUpdate:		for (size_t i = 0; i < count; i++) ppComponents[i]->LateUpdate(); break;
+		case PhasePreRender:		for (size_t i = 0; i < count; i++) ppComponents[i]->OnPreRender(); break;
+		case PhaseRenderObject:		for (size_t i = 0; i < count; i++) ppComponents[i]->OnRenderObject(); break;
+		case PhasePostRender:		for (size_t i = 0; i < count; i++) ppComponents[i]->OnPostRender(); break;
+		default: ASSERTION(false); break;
+		}
+	}
+
+	m_executingCount--;
+}
\ No newline at end of file
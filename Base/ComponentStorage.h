@@ -0,0 +1,96 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include "BaseComponent.h"
+
+class BaseObject;
+
+// Flat storage of all components under a root object, grouped by component class
+// Components of one class are packed into one contiguous pool, so that a phase is executed pool by pool in a tight loop,
+// instead of recursively walking objects and virtual-calling whatever component type comes next
+// Pools are rebuilt lazily whenever the object hierarchy or any component list changes
+// Order of execution within one phase:
+// 1. Pools are ordered by the first appearance of their class in a depth first traversal
+// 2. Components within one pool keep depth first traversal order
+class ComponentStorage : public SelfRefBase<ComponentStorage>
+{
+public:
+	enum ComponentPhase
+	{
+		PhaseUpdate,
+		PhaseAnimationUpdate,
+		PhaseLateUpdate,
+		PhasePreRender,
+		PhaseRenderObject,
+		PhasePostRender,
+		ComponentPhaseCount
+	};
+
+	typedef struct _ComponentPool
+	{
+		std::size_t						classHashCode;
+		// Contiguous raw pointers for iteration, each range of it could be handed to a different worker
+		std::vector<BaseComponent*>		components;
+	}ComponentPool;
+
+protected:
+	bool Init(const std::shared_ptr<BaseObject>& pRootObject, const std::shared_ptr<ComponentStorage>& pSelf);
+
+public:
+	static std::shared_ptr<ComponentStorage> Create(const std::shared_ptr<BaseObject>& pRootObject);
+
+public:
+	// Execute one phase for every component under root object
+	void ExecutePhase(ComponentPhase phase);
+
+	// Rebuild pools if hierarchy changed since last build
+	void EnsurePools();
+	// Locked pools are never rebuilt, it's used when phases of this storage are executed on multiple threads at the same time
+	void SetPoolsLocked(bool locked) { m_poolsLocked = locked; }
+
+	const std::vector<ComponentPool>& GetPools() const { return m_pools; }
+
+	// System style access: iterate all components of exact class T without any per component rtti check
+	template <typename T>
+	const std::vector<BaseComponent*>& GetPool()
+	{
+		EnsurePools();
+
+		static const std::vector<BaseComponent*> emptyPool;
+		auto iter = m_poolLookupTable.find(T::ClassHashCode);
+		if (iter == m_poolLookupTable.end())
+			return emptyPool;
+		return m_pools[iter->second].components;
+	}
+
+	template <typename T, typename Func>
+	void ForEach(Func func)
+	{
+		const std::vector<BaseComponent*>& pool = GetPool<T>();
+		for (size_t i = 0; i < pool.size(); i++)
+			func(static_cast<T*>(pool[i]));
+	}
+
+	uint32_t GetComponentCount() const { return (uint32_t)m_keepAliveComponents.size(); }
+	uint32_t GetRebuildCount() const { return m_rebuildCount; }
+
+protected:
+	void RebuildPools();
+	void CollectComponents(const std::shared_ptr<BaseObject>& pObject);
+
+protected:
+	std::weak_ptr<BaseObject>						m_pRootObject;
+
+	std::vector<ComponentPool>						m_pools;
+	// Key: component class hash code, value: index into m_pools
+	std::unordered_map<std::size_t, uint32_t>		m_poolLookupTable;
+
+	// Components deleted during a phase stay alive until next rebuild, so that raw pointers in pools never dangle
+	std::vector<std::shared_ptr<BaseComponent>>		m_keepAliveComponents;
+
+	uint32_t										m_builtVersion = 0;
+	uint32_t										m_rebuildCount = 0;
+	std::atomic<uint32_t>							m_executingCount{ 0 };
+	bool											m_poolsLocked = false;
+};
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+#include <limits>
+
+template <typename T>
+class Vector3;
+
+template <typename T>
+class Matrix4x4;
+
+// Axis aligned bounding box
+template<typename T>
+class BoundingBox
+{
+public:
+	// Default box is invalid(min > max), merging anything into it makes it valid
+	BoundingBox();
+	BoundingBox(const Vector3<T>& min, const Vector3<T>& max);
+
+public:
+	bool IsValid() const;
+
+	void Merge(const Vector3<T>& p);
+	void Merge(const BoundingBox<T>& box);
+
+	Vector3<T> Center() const;
+	// Half size of the box
+	Vector3<T> Extent() const;
+	// Radius of the sphere that surrounds the box, centered at box center
+	T Radius() const;
+
+	// Result box contains transformed box, it's not as tight as the original one
+	BoundingBox<T> Transform(const Matrix4x4<T>& matrix) const;
+
+public:
+	Vector3<T>	min;
+	Vector3<T>	max;
+};
+
+#include "BoundingBox.inl"
+
+typedef BoundingBox<float>	BoundingBoxf;
+typedef BoundingBox<double>	BoundingBoxd;
\ No newline at end of file
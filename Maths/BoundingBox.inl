@@ -0,0 +1,81 @@
+#pragma once
+#include "BoundingBox.h"
+#include "Vector3.h"
+#include "Vector4.h"
+#include "Matrix4x4.h"
+
+template<typename T>
+BoundingBox<T>::BoundingBox()
+{
+	min = (std::numeric_limits<T>::max)();
+	max = (std::numeric_limits<T>::lowest)();
+}
+
+template<typename T>
+BoundingBox<T>::BoundingBox(const Vector3<T>& min, const Vector3<T>& max)
+{
+	this->min = min;
+	this->max = max;
+}
+
+template<typename T>
+bool BoundingBox<T>::IsValid() const
+{
+	return min.x <= max.x && min.y <= max.y && min.z <= max.z;
+}
+
+template<typename T>
+void BoundingBox<T>::Merge(const Vector3<T>& p)
+{
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		min[i] = min[i] < p[i] ? min[i] : p[i];
+		max[i] = max[i] > p[i] ? max[i] : p[i];
+	}
+}
+
+template<typename T>
+void BoundingBox<T>::Merge(const BoundingBox<T>& box)
+{
+	if (!box.IsValid())
+		return;
+
+	Merge(box.min);
+	Merge(box.max);
+}
+
+template<typename T>
+Vector3<T> BoundingBox<T>::Center() const
+{
+	return (min + max) * (T)0.5;
+}
+
+template<typename T>
+Vector3<T> BoundingBox<T>::Extent() const
+{
+	return (max - min) * (T)0.5;
+}
+
+template<typename T>
+T BoundingBox<T>::Radius() const
+{
+	return Extent().Length();
+}
+
+template<typename T>
+BoundingBox<T> BoundingBox<T>::Transform(const Matrix4x4<T>& matrix) const
+{
+	if (!IsValid())
+		return *this;
+
+	// Transform center, and project extent onto each axis with absolute matrix
+	Vector3<T> center = matrix.TransformAsPoint(Center());
+	Vector3<T> extent = Extent();
+	Vector3<T> newExtent;
+
+	for (uint32_t i = 0; i < 3; i++)
+		for (uint32_t j = 0; j < 3; j++)
+			newExtent[i] += std::abs(matrix[j][i]) * extent[j];
+
+	return { center - newExtent, center + newExtent };
+}
\ No newline at end of file
@@ -0,0 +1,382 @@
+#include "BoundingVolumeHierarchy.h"
+#include "Plane.h"
+#include "../thread/WorkerPool.hpp"
+#include <algorithm>
+
+const double BoundingVolumeHierarchy::REBUILD_SURFACE_AREA_RATIO = 1.5;
+
+uint32_t BoundingVolumeHierarchy::GetSubTreeNodeCount(uint32_t itemCount)
+{
+	if (itemCount <= MAX_LEAF_SIZE)
+		return 1;
+
+	uint32_t half = itemCount / 2;
+	return 1 + GetSubTreeNodeCount(half) + GetSubTreeNodeCount(itemCount - half);
+}
+
+double BoundingVolumeHierarchy::GetSurfaceArea(const BoundingBoxd& box)
+{
+	if (!box.IsValid())
+		return 0;
+
+	Vector3d size = box.max - box.min;
+	return 2.0 * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+void BoundingVolumeHierarchy::Clear()
+{
+	m_nodes.clear();
+	m_itemBounds.clear();
+	m_itemIndices.clear();
+}
+
+void BoundingVolumeHierarchy::Build(const std::vector<BoundingBoxd>& itemBounds)
+{
+	Clear();
+
+	m_itemBounds = itemBounds;
+	if (m_itemBounds.size() == 0)
+		return;
+
+	m_itemIndices.resize(m_itemBounds.size());
+	for (uint32_t i = 0; i < (uint32_t)m_itemIndices.size(); i++)
+		m_itemIndices[i] = i;
+
+	m_nodes.resize(GetSubTreeNodeCount((uint32_t)m_itemBounds.size()));
+	BuildNode(0, 0, (uint32_t)m_itemBounds.size());
+	m_totalRebuildCount++;
+}
+
+void BoundingVolumeHierarchy::BuildNode(uint32_t nodeIndex, uint32_t first, uint32_t count)
+{
+	Node& node = m_nodes[nodeIndex];
+	node.first = first;
+	node.count = count;
+	node.bounds = BoundingBoxd();
+
+	BoundingBoxd centroidBounds;
+	for (uint32_t i = first; i < first + count; i++)
+	{
+		node.bounds.Merge(m_itemBounds[m_itemIndices[i]]);
+		centroidBounds.Merge(m_itemBounds[m_itemIndices[i]].Center());
+	}
+
+	node.buildSurfaceArea = GetSurfaceArea(node.bounds);
+
+	if (count <= MAX_LEAF_SIZE)
+	{
+		node.rightChild = 0;
+		return;
+	}
+
+	// Split along the longest axis of centroids, by count median
+	Vector3d size = centroidBounds.max - centroidBounds.min;
+	uint32_t axis = 0;
+	if (size.y > size[axis])
+		axis = 1;
+	if (size.z > size[axis])
+		axis = 2;
+
+	uint32_t half = count / 2;
+	std::nth_element(m_itemIndices.begin() + first, m_itemIndices.begin() + first + half, m_itemIndices.begin() + first + count, [this, axis](uint32_t a, uint32_t b)
+	{
+		return m_itemBounds[a].Center()[axis] < m_itemBounds[b].Center()[axis];
+	});
+
+	uint32_t leftChild = nodeIndex + 1;
+	uint32_t rightChild = leftChild + GetSubTreeNodeCount(half);
+
+	// "node" might not be valid after recursion if storage changed, write through index
+	m_nodes[nodeIndex].rightChild = rightChild;
+
+	BuildNode(leftChild, first, half);
+	BuildNode(rightChild, first + half, count - half);
+}
+
+uint32_t BoundingVolumeHierarchy::Refit()
+{
+	if (m_nodes.size() == 0)
+		return 0;
+
+	// Children always have larger indices than parent
+	for (int32_t i = (int32_t)m_nodes.size() - 1; i >= 0; i--)
+	{
+		Node& node = m_nodes[i];
+		node.bounds = BoundingBoxd();
+
+		if (node.rightChild == 0)
+		{
+			for (uint32_t j = node.first; j < node.first + node.count; j++)
+				node.bounds.Merge(m_itemBounds[m_itemIndices[j]]);
+		}
+		else
+		{
+			node.bounds.Merge(m_nodes[i + 1].bounds);
+			node.bounds.Merge(m_nodes[node.rightChild].bounds);
+		}
+	}
+
+	// Rebuild top most sub trees that became too loose
+	uint32_t rebuildCount = 0;
+	std::vector<uint32_t> stack = { 0 };
+	while (stack.size() != 0)
+	{
+		uint32_t nodeIndex = stack.back();
+		stack.pop_back();
+
+		Node& node = m_nodes[nodeIndex];
+		if (node.rightChild == 0)
+			continue;
+
+		if (GetSurfaceArea(node.bounds) > node.buildSurfaceArea * REBUILD_SURFACE_AREA_RATIO)
+		{
+			BuildNode(nodeIndex, node.first, node.count);
+			rebuildCount++;
+			continue;
+		}
+
+		stack.push_back(nodeIndex + 1);
+		stack.push_back(node.rightChild);
+	}
+
+	m_totalRebuildCount += rebuildCount;
+	return rebuildCount;
+}
+
+void BoundingVolumeHierarchy::AppendSubTreeItems(const Node& node, std::vector<uint32_t>& results) const
+{
+	results.insert(results.end(), m_itemIndices.begin() + node.first, m_itemIndices.begin() + node.first + node.count);
+}
+
+uint32_t BoundingVolumeHierarchy::TestAABB(const PyramidFrustumd& frustum, const BoundingBoxd& box, uint32_t& planeMask)
+{
+	Vector3d center = box.Center();
+	Vector3d extent = box.Extent();
+
+	for (uint32_t i = 0; i < frustum.faceCount; i++)
+	{
+		if ((planeMask & (1 << i)) == 0)
+			continue;
+
+		const Planed& plane = frustum.planes[i];
+		double r = std::abs(plane.normal.x) * extent.x + std::abs(plane.normal.y) * extent.y + std::abs(plane.normal.z) * extent.z;
+		double dist = plane.PlaneTest(center);
+
+		if (dist < -r)
+			return 0;
+
+		// Fully on the positive side, children don't need this plane any more
+		if (dist > r)
+			planeMask &= ~(1 << i);
+	}
+
+	return planeMask == 0 ? 2 : 1;
+}
+
+uint32_t BoundingVolumeHierarchy::QueryFrustumSubTree(const PyramidFrustumd& frustum, uint32_t nodeIndex, uint32_t planeMask, std::vector<uint32_t>& results) const
+{
+	uint32_t visitedCount = 0;
+
+	std::vector<std::pair<uint32_t, uint32_t>> stack = { { nodeIndex, planeMask } };
+	while (stack.size() != 0)
+	{
+		uint32_t currentIndex = stack.back().first;
+		uint32_t mask = stack.back().second;
+		const Node& node = m_nodes[currentIndex];
+		stack.pop_back();
+
+		visitedCount++;
+
+		uint32_t result = TestAABB(frustum, node.bounds, mask);
+		if (result == 0)
+			continue;
+
+		if (result == 2)
+		{
+			AppendSubTreeItems(node, results);
+			continue;
+		}
+
+		if (node.rightChild == 0)
+		{
+			for (uint32_t i = node.first; i < node.first + node.count; i++)
+			{
+				uint32_t itemMask = mask;
+				if (TestAABB(frustum, m_itemBounds[m_itemIndices[i]], itemMask) != 0)
+					results.push_back(m_itemIndices[i]);
+			}
+			continue;
+		}
+
+		stack.push_back({ node.rightChild, mask });
+		stack.push_back({ currentIndex + 1, mask });
+	}
+
+	return visitedCount;
+}
+
+void BoundingVolumeHierarchy::QueryFrustum(const PyramidFrustumd& frustum, std::vector<uint32_t>& results) const
+{
+	m_visitedNodeCount = 0;
+
+	if (m_nodes.size() == 0)
+		return;
+
+	m_visitedNodeCount = QueryFrustumSubTree(frustum, 0, (1 << frustum.faceCount) - 1, results);
+}
+
+void BoundingVolumeHierarchy::QueryFrustumParallel(const PyramidFrustumd& frustum, std::vector<uint32_t>& results) const
+{
+	uint32_t workerCount = WorkerPool::GetInstance()->GetConcurrency();
+	if (GetItemCount() < PARALLEL_ITEM_THRESHOLD || workerCount == 1)
+	{
+		QueryFrustum(frustum, results);
+		return;
+	}
+
+	m_visitedNodeCount = 0;
+
+	// Expand top levels breadth first on this thread, until there're enough sub trees to feed workers
+	std::vector<std::pair<uint32_t, uint32_t>> subTrees;
+	std::vector<std::pair<uint32_t, uint32_t>> frontier = { { 0, (1u << frustum.faceCount) - 1 } };
+	while (frontier.size() != 0 && subTrees.size() + frontier.size() < workerCount * 4)
+	{
+		std::vector<std::pair<uint32_t, uint32_t>> nextFrontier;
+		for (auto& entry : frontier)
+		{
+			const Node& node = m_nodes[entry.first];
+			uint32_t mask = entry.second;
+			m_visitedNodeCount++;
+
+			uint32_t result = TestAABB(frustum, node.bounds, mask);
+			if (result == 0)
+				continue;
+
+			if (result == 2)
+			{
+				AppendSubTreeItems(node, results);
+				continue;
+			}
+
+			// Leaves are handed to workers as they are
+			if (node.rightChild == 0)
+			{
+				subTrees.push_back({ entry.first, mask });
+				continue;
+			}
+
+			nextFrontier.push_back({ entry.first + 1, mask });
+			nextFrontier.push_back({ node.rightChild, mask });
+		}
+		frontier.swap(nextFrontier);
+	}
+	subTrees.insert(subTrees.end(), frontier.begin(), frontier.end());
+
+	// Each worker takes an interleaved share of sub trees, results are merged in worker order
+	uint32_t taskCount = (std::min)(workerCount, (uint32_t)subTrees.size());
+	std::vector<std::vector<uint32_t>> taskResults(taskCount);
+	std::vector<uint32_t> taskVisitedCounts(taskCount, 0);
+	WorkerPool::GetInstance()->ParallelFor(taskCount, [this, taskCount, &frustum, &subTrees, &taskResults, &taskVisitedCounts](uint32_t i)
+	{
+		for (uint32_t j = i; j < (uint32_t)subTrees.size(); j += taskCount)
+			taskVisitedCounts[i] += QueryFrustumSubTree(frustum, subTrees[j].first, subTrees[j].second, taskResults[i]);
+	});
+
+	for (uint32_t i = 0; i < taskCount; i++)
+	{
+		m_visitedNodeCount += taskVisitedCounts[i];
+		results.insert(results.end(), taskResults[i].begin(), taskResults[i].end());
+	}
+}
+
+template <typename OverlapFunc>
+void BoundingVolumeHierarchy::QueryOverlap(OverlapFunc overlapFunc, std::vector<uint32_t>& results) const
+{
+	m_visitedNodeCount = 0;
+
+	if (m_nodes.size() == 0)
+		return;
+
+	std::vector<uint32_t> stack = { 0 };
+	while (stack.size() != 0)
+	{
+		uint32_t nodeIndex = stack.back();
+		const Node& node = m_nodes[nodeIndex];
+		stack.pop_back();
+
+		m_visitedNodeCount++;
+
+		if (!overlapFunc(node.bounds))
+			continue;
+
+		if (node.rightChild == 0)
+		{
+			for (uint32_t i = node.first; i < node.first + node.count; i++)
+			{
+				if (overlapFunc(m_itemBounds[m_itemIndices[i]]))
+					results.push_back(m_itemIndices[i]);
+			}
+			continue;
+		}
+
+		stack.push_back(node.rightChild);
+		stack.push_back(nodeIndex + 1);
+	}
+}
+
+void BoundingVolumeHierarchy::QueryRay(const Vector3d& origin, const Vector3d& direction, double maxDistance, std::vector<uint32_t>& results) const
+{
+	// Slab test, zero direction components produce infinities which are handled by the comparisons below
+	Vector3d invDirection = { 1.0 / direction.x, 1.0 / direction.y, 1.0 / direction.z };
+	double maxT = maxDistance / direction.Length();
+
+	QueryOverlap([&origin, &invDirection, maxT](const BoundingBoxd& box)
+	{
+		double tMin = 0;
+		double tMax = maxT;
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			double t0 = (box.min[i] - origin[i]) * invDirection[i];
+			double t1 = (box.max[i] - origin[i]) * invDirection[i];
+			if (t0 > t1)
+				std::swap(t0, t1);
+
+			// NaN comes from 0 * inf, when origin lies on a slab boundary and ray is parallel to it, treat it as inside
+			if (t0 == t0)
+				tMin = (std::max)(tMin, t0);
+			if (t1 == t1)
+				tMax = (std::min)(tMax, t1);
+
+			if (tMin > tMax)
+				return false;
+		}
+		return true;
+	}, results);
+}
+
+void BoundingVolumeHierarchy::QuerySphere(const Vector3d& center, double radius, std::vector<uint32_t>& results) const
+{
+	double squareRadius = radius * radius;
+
+	QueryOverlap([&center, squareRadius](const BoundingBoxd& box)
+	{
+		// Square distance from sphere center to the closest point of the box
+		double squareDistance = 0;
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			double v = center[i] < box.min[i] ? box.min[i] - center[i] : (center[i] > box.max[i] ? center[i] - box.max[i] : 0);
+			squareDistance += v * v;
+		}
+		return squareDistance <= squareRadius;
+	}, results);
+}
+
+void BoundingVolumeHierarchy::QueryAABB(const BoundingBoxd& queryBox, std::vector<uint32_t>& results) const
+{
+	QueryOverlap([&queryBox](const BoundingBoxd& box)
+	{
+		return box.min.x <= queryBox.max.x && box.max.x >= queryBox.min.x &&
+			box.min.y <= queryBox.max.y && box.max.y >= queryBox.min.y &&
+			box.min.z <= queryBox.max.z && box.max.z >= queryBox.min.z;
+	}, results);
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+#include <vector>
+#include "Vector.h"
+#include "BoundingBox.h"
+#include "PyramidFrustum.h"
+
+// Dynamic AABB tree over a set of items, an item is only an index into bounds provided by user
+// Nodes are split by item count median along the longest axis, so the shape of a sub tree only depends on its item count
+// This lets a degraded sub tree be rebuilt in place, without touching any other node
+// Typical usage per frame:
+// 1. UpdateItemBounds() for moved items
+// 2. Refit(), which also rebuilds sub trees that became too loose
+// 3. Queries
+// NOTE: Build/refit is single threaded, queries are read only except statistics, don't run 2 queries concurrently
+class BoundingVolumeHierarchy
+{
+public:
+	static const uint32_t MAX_LEAF_SIZE = 4;
+	// A sub tree gets rebuilt once its surface area grows beyond this ratio of the one it had when it was built
+	static const double REBUILD_SURFACE_AREA_RATIO;
+	// Frustum queries go parallel only if there're enough items to pay off waking up workers, small trees are queried serially
+	static const uint32_t PARALLEL_ITEM_THRESHOLD = 2048;
+
+	typedef struct _Node
+	{
+		BoundingBoxd	bounds;
+		uint32_t		first;				// First index into m_itemIndices
+		uint32_t		count;				// Amount of items under this node
+		uint32_t		rightChild;			// Left child is always the next node, 0 means leaf
+		double			buildSurfaceArea;
+	}Node;
+
+public:
+	// Item id equals to its index in "itemBounds"
+	void Build(const std::vector<BoundingBoxd>& itemBounds);
+	void Clear();
+
+	void UpdateItemBounds(uint32_t item, const BoundingBoxd& bounds) { m_itemBounds[item] = bounds; }
+	const BoundingBoxd& GetItemBounds(uint32_t item) const { return m_itemBounds[item]; }
+
+	// Refit node bounds bottom up, then rebuild loose sub trees, returns the amount of rebuilt sub trees
+	uint32_t Refit();
+
+	// Hierarchical frustum test, planes that fully contain a node aren't tested again for its children
+	void QueryFrustum(const PyramidFrustumd& frustum, std::vector<uint32_t>& results) const;
+	// Same as QueryFrustum, sub trees are distributed to persistent workers of WorkerPool if item count is large enough
+	void QueryFrustumParallel(const PyramidFrustumd& frustum, std::vector<uint32_t>& results) const;
+	// Items whose bounds are hit by the ray within "maxDistance", "direction" doesn't have to be normalized
+	void QueryRay(const Vector3d& origin, const Vector3d& direction, double maxDistance, std::vector<uint32_t>& results) const;
+	void QuerySphere(const Vector3d& center, double radius, std::vector<uint32_t>& results) const;
+	void QueryAABB(const BoundingBoxd& box, std::vector<uint32_t>& results) const;
+
+	uint32_t GetItemCount() const { return (uint32_t)m_itemBounds.size(); }
+	uint32_t GetNodeCount() const { return (uint32_t)m_nodes.size(); }
+	// Nodes visited by last query
+	uint32_t GetVisitedNodeCount() const { return m_visitedNodeCount; }
+	uint32_t GetTotalRebuildCount() const { return m_totalRebuildCount; }
+
+protected:
+	static uint32_t GetSubTreeNodeCount(uint32_t itemCount);
+	static double GetSurfaceArea(const BoundingBoxd& box);
+
+	void BuildNode(uint32_t nodeIndex, uint32_t first, uint32_t count);
+	void AppendSubTreeItems(const Node& node, std::vector<uint32_t>& results) const;
+
+	// Returns visited node count
+	uint32_t QueryFrustumSubTree(const PyramidFrustumd& frustum, uint32_t nodeIndex, uint32_t planeMask, std::vector<uint32_t>& results) const;
+
+	// 0: outside, 1: intersect, 2: inside, "planeMask" is updated to the planes that still need to be tested
+	static uint32_t TestAABB(const PyramidFrustumd& frustum, const BoundingBoxd& box, uint32_t& planeMask);
+
+	template <typename OverlapFunc>
+	void QueryOverlap(OverlapFunc overlapFunc, std::vector<uint32_t>& results) const;
+
+protected:
+	std::vector<Node>			m_nodes;
+	std::vector<BoundingBoxd>	m_itemBounds;
+	// Items are sorted so that each node covers a consecutive range
+	std::vector<uint32_t>		m_itemIndices;
+
+	mutable uint32_t			m_visitedNodeCount = 0;
+	uint32_t					m_totalRebuildCount = 0;
+};
\ No newline at end of file
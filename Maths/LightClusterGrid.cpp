@@ -0,0 +1,168 @@
+#include "LightClusterGrid.h"
+#include <xmmintrin.h>
+#include <algorithm>
+#include <cmath>
+
+static_assert(LightClusterGrid::TILE_COLUMN_COUNT < 32 && LightClusterGrid::TILE_ROW_COUNT < 32, "Tile masks are 32 bits");
+
+// Boundary i of "count" tiles sits at "2 * i / count - 1" in ndc, its plane goes through camera origin and "(ndc * tangent, -1)"
+// Normal of the plane is "(1, ndc * tangent)" normalized, along tile axis and z
+static void SetupBoundaryPlanes(uint32_t count, uint32_t paddedCount, float tangent, bool flip, float* pA, float* pB)
+{
+	for (uint32_t i = 0; i < paddedCount; i++)
+	{
+		if (i > count)
+		{
+			pA[i] = 0;
+			pB[i] = 0;
+			continue;
+		}
+
+		float ndc = 2.0f * i / count - 1.0f;
+		// Tile row 0 is top of the screen, while camera space y goes up
+		if (flip)
+			ndc = -ndc;
+
+		float t = ndc * tangent;
+		float invLength = 1.0f / std::sqrt(1.0f + t * t);
+		pA[i] = invLength;
+		pB[i] = t * invLength;
+	}
+}
+
+// Bit i of "negativeMask" is set if sphere is entirely on negative side of plane i, bit i of "positiveMask" if it's entirely on positive side
+static void TestBoundaryPlanes(const float* pA, const float* pB, uint32_t paddedCount, float axis, float z, float radius, uint32_t& negativeMask, uint32_t& positiveMask)
+{
+	__m128 axis4 = _mm_set1_ps(axis);
+	__m128 z4 = _mm_set1_ps(z);
+	__m128 radius4 = _mm_set1_ps(radius);
+	__m128 negRadius4 = _mm_set1_ps(-radius);
+
+	negativeMask = 0;
+	positiveMask = 0;
+	for (uint32_t i = 0; i < paddedCount; i += 4)
+	{
+		__m128 dist = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(pA + i), axis4), _mm_mul_ps(_mm_loadu_ps(pB + i), z4));
+		negativeMask |= (uint32_t)_mm_movemask_ps(_mm_cmple_ps(dist, negRadius4)) << i;
+		positiveMask |= (uint32_t)_mm_movemask_ps(_mm_cmpge_ps(dist, radius4)) << i;
+	}
+}
+
+void LightClusterGrid::SetFrustum(float tangentH, float tangentV, float clusterNear, float clusterFar)
+{
+	SetupBoundaryPlanes(TILE_COLUMN_COUNT, COLUMN_PLANE_COUNT, tangentH, false, m_columnPlaneA, m_columnPlaneB);
+	SetupBoundaryPlanes(TILE_ROW_COUNT, ROW_PLANE_COUNT, tangentV, true, m_rowPlaneA, m_rowPlaneB);
+
+	m_clusterNear = clusterNear;
+	m_sliceScale = SLICE_COUNT / std::log(clusterFar / clusterNear);
+}
+
+uint32_t LightClusterGrid::GetSliceIndex(float depth) const
+{
+	if (depth <= m_clusterNear)
+		return 0;
+
+	return (std::min)((uint32_t)(std::log(depth / m_clusterNear) * m_sliceScale), SLICE_COUNT - 1);
+}
+
+bool LightClusterGrid::ComputeFootprint(const Vector4f& lightSphere, LightFootprint& footprint) const
+{
+	float depth = -lightSphere.z;
+	float radius = lightSphere.w;
+
+	// Entirely behind camera
+	if (depth + radius <= 0)
+		return false;
+
+	uint32_t negativeMask, positiveMask;
+
+	// Column i lies between boundary i and i + 1, sphere must not be entirely left of the former, or entirely right of the latter
+	TestBoundaryPlanes(m_columnPlaneA, m_columnPlaneB, COLUMN_PLANE_COUNT, lightSphere.x, lightSphere.z, radius, negativeMask, positiveMask);
+	footprint.columnMask = ~negativeMask & ~(positiveMask >> 1) & ((1 << TILE_COLUMN_COUNT) - 1);
+
+	// Row i lies between boundary i(above) and i + 1(below), sphere must not be entirely above the former, or entirely below the latter
+	TestBoundaryPlanes(m_rowPlaneA, m_rowPlaneB, ROW_PLANE_COUNT, lightSphere.y, lightSphere.z, radius, negativeMask, positiveMask);
+	footprint.rowMask = ~positiveMask & ~(negativeMask >> 1) & ((1 << TILE_ROW_COUNT) - 1);
+
+	if (footprint.columnMask == 0 || footprint.rowMask == 0)
+		return false;
+
+	footprint.minSlice = GetSliceIndex(depth - radius);
+	footprint.maxSlice = GetSliceIndex(depth + radius);
+
+	return true;
+}
+
+void LightClusterGrid::Build(const std::vector<Vector4f>& lightSpheres, uint32_t maxLightIndexCount)
+{
+	m_clusters.assign(CLUSTER_COUNT, { 0, 0 });
+	m_footprints.resize(lightSpheres.size());
+	m_visible.resize(lightSpheres.size());
+
+	// 1. Count lights of each cluster
+	for (uint32_t i = 0; i < (uint32_t)lightSpheres.size(); i++)
+	{
+		m_visible[i] = ComputeFootprint(lightSpheres[i], m_footprints[i]) ? 1 : 0;
+		if (m_visible[i] == 0)
+			continue;
+
+		const LightFootprint& footprint = m_footprints[i];
+		for (uint32_t slice = footprint.minSlice; slice <= footprint.maxSlice; slice++)
+		{
+			for (uint32_t row = 0; row < TILE_ROW_COUNT; row++)
+			{
+				if ((footprint.rowMask & (1 << row)) == 0)
+					continue;
+
+				for (uint32_t column = 0; column < TILE_COLUMN_COUNT; column++)
+				{
+					if (footprint.columnMask & (1 << column))
+						m_clusters[GetClusterIndex(column, row, slice)].count++;
+				}
+			}
+		}
+	}
+
+	// 2. Prefix sum, clusters are truncated once index list is full
+	uint32_t offset = 0;
+	m_droppedLightIndexCount = 0;
+	for (auto& cluster : m_clusters)
+	{
+		uint32_t count = (std::min)(cluster.count, maxLightIndexCount - offset);
+		m_droppedLightIndexCount += cluster.count - count;
+
+		cluster.offset = offset;
+		cluster.count = count;
+		offset += count;
+	}
+
+	// 3. Fill light indices, lights keep their order within a cluster
+	m_lightIndices.resize(offset);
+	m_fillCounts.assign(CLUSTER_COUNT, 0);
+	for (uint32_t i = 0; i < (uint32_t)lightSpheres.size(); i++)
+	{
+		if (m_visible[i] == 0)
+			continue;
+
+		const LightFootprint& footprint = m_footprints[i];
+		for (uint32_t slice = footprint.minSlice; slice <= footprint.maxSlice; slice++)
+		{
+			for (uint32_t row = 0; row < TILE_ROW_COUNT; row++)
+			{
+				if ((footprint.rowMask & (1 << row)) == 0)
+					continue;
+
+				for (uint32_t column = 0; column < TILE_COLUMN_COUNT; column++)
+				{
+					if ((footprint.columnMask & (1 << column)) == 0)
+						continue;
+
+					uint32_t clusterIndex = GetClusterIndex(column, row, slice);
+					const ClusterRange& cluster = m_clusters[clusterIndex];
+					if (m_fillCounts[clusterIndex] < cluster.count)
+						m_lightIndices[cluster.offset + m_fillCounts[clusterIndex]++] = i;
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+#include <vector>
+#include "Vector.h"
+
+// Froxel grid for clustered shading of local lights
+// View frustum is split into screen tiles and depth slices, a cluster keeps a range of a compact light index list
+// Slices are distributed exponentially between cluster near and far distance, anything nearer falls into first slice and anything farther into last one
+// Lights are bounding spheres in camera space, camera looks towards -z with y up, tile row 0 is top of the screen
+// Tile boundaries are planes through camera origin, 4 of them are tested against a sphere at a time
+// Everything here is plain CPU code, so that cluster assignment could be verified without gpu
+class LightClusterGrid
+{
+public:
+	static const uint32_t TILE_COLUMN_COUNT = 16;
+	static const uint32_t TILE_ROW_COUNT = 9;
+	static const uint32_t SLICE_COUNT = 24;
+	static const uint32_t CLUSTER_COUNT = TILE_COLUMN_COUNT * TILE_ROW_COUNT * SLICE_COUNT;
+
+	typedef struct _ClusterRange
+	{
+		uint32_t	offset;		// Into light index list
+		uint32_t	count;
+	}ClusterRange;
+
+	// Clusters overlapped by a light sphere, bit i of a mask stands for column or row i, slices are inclusive
+	typedef struct _LightFootprint
+	{
+		uint32_t	columnMask;
+		uint32_t	rowMask;
+		uint32_t	minSlice;
+		uint32_t	maxSlice;
+	}LightFootprint;
+
+public:
+	LightClusterGrid() { SetFrustum(1.0f, 1.0f, 0.1f, 100.0f); }
+
+	// "tangentH" and "tangentV" are tangents of half horizontal and vertical fov
+	void SetFrustum(float tangentH, float tangentV, float clusterNear, float clusterFar);
+
+	// Light spheres: xyz for camera space center, w for radius
+	// Light indices beyond "maxLightIndexCount" are dropped, clusters filled last would then miss some of their lights
+	void Build(const std::vector<Vector4f>& lightSpheres, uint32_t maxLightIndexCount);
+
+	// Returns false if sphere doesn't overlap any cluster
+	bool ComputeFootprint(const Vector4f& lightSphere, LightFootprint& footprint) const;
+	// "depth" is camera space distance along view axis, shader picks slice in the same way
+	uint32_t GetSliceIndex(float depth) const;
+
+	static uint32_t GetClusterIndex(uint32_t column, uint32_t row, uint32_t slice) { return (slice * TILE_ROW_COUNT + row) * TILE_COLUMN_COUNT + column; }
+	const ClusterRange& GetCluster(uint32_t column, uint32_t row, uint32_t slice) const { return m_clusters[GetClusterIndex(column, row, slice)]; }
+	const std::vector<ClusterRange>& GetClusters() const { return m_clusters; }
+	const std::vector<uint32_t>& GetLightIndices() const { return m_lightIndices; }
+	uint32_t GetDroppedLightIndexCount() const { return m_droppedLightIndexCount; }
+
+	float GetClusterNear() const { return m_clusterNear; }
+	// Slice index is "log(depth / cluster near) * slice scale"
+	float GetSliceScale() const { return m_sliceScale; }
+
+protected:
+	// Padded to multiple of 4, padding planes always pass and are masked out
+	static const uint32_t COLUMN_PLANE_COUNT = (TILE_COLUMN_COUNT + 4) / 4 * 4;
+	static const uint32_t ROW_PLANE_COUNT = (TILE_ROW_COUNT + 4) / 4 * 4;
+
+	// Signed distance to boundary plane i is "A[i] * x + B[i] * z" for columns, "A[i] * y + B[i] * z" for rows
+	// Positive means right of column boundary, or above row boundary
+	float						m_columnPlaneA[COLUMN_PLANE_COUNT];
+	float						m_columnPlaneB[COLUMN_PLANE_COUNT];
+	float						m_rowPlaneA[ROW_PLANE_COUNT];
+	float						m_rowPlaneB[ROW_PLANE_COUNT];
+
+	float						m_clusterNear;
+	float						m_sliceScale;
+
+	std::vector<ClusterRange>	m_clusters;
+	std::vector<uint32_t>		m_lightIndices;
+	uint32_t					m_droppedLightIndexCount = 0;
+
+	// Scratch of build, kept to avoid per frame allocations
+	std::vector<LightFootprint>	m_footprints;
+	std::vector<uint8_t>		m_visible;
+	std::vector<uint32_t>		m_fillCounts;
+};
\ No newline at end of file
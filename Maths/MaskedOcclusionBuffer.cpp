@@ -0,0 +1,348 @@
+#include "MaskedOcclusionBuffer.h"
+#include "../thread/WorkerPool.hpp"
+#include <xmmintrin.h>
+#include <algorithm>
+#include <cmath>
+
+const float MaskedOcclusionBuffer::NEAR_CLIP_W = 0.01f;
+
+// Clip space planes, a vertex is inside if "dot(plane, v) >= D"
+enum ClipPlane
+{
+	ClipPlaneNear,
+	ClipPlaneLeft,
+	ClipPlaneRight,
+	ClipPlaneTop,
+	ClipPlaneBottom,
+	ClipPlaneCount
+};
+
+static const Vector4f g_clipPlanes[ClipPlaneCount] =
+{
+	{ 0, 0, 0, 1 },
+	{ 1, 0, 0, 1 },
+	{ -1, 0, 0, 1 },
+	{ 0, 1, 0, 1 },
+	{ 0, -1, 0, 1 },
+};
+
+static const float g_clipPlaneDs[ClipPlaneCount] = { MaskedOcclusionBuffer::NEAR_CLIP_W, 0, 0, 0, 0 };
+
+static uint32_t GetOutCode(const Vector4f& v)
+{
+	uint32_t code = 0;
+	for (uint32_t i = 0; i < ClipPlaneCount; i++)
+	{
+		if (g_clipPlanes[i] * v < g_clipPlaneDs[i])
+			code |= (1 << i);
+	}
+	return code;
+}
+
+void MaskedOcclusionBuffer::Clear()
+{
+	m_tiles.assign(TILE_COLUMN_COUNT * TILE_ROW_COUNT, { 0, 0, 0 });
+	m_triangles.clear();
+	m_totalTriangleCount = 0;
+}
+
+void MaskedOcclusionBuffer::AddOccluder(const Matrix4f& modelToClip, const std::vector<Vector3f>& positions, const std::vector<uint32_t>& indices)
+{
+	m_clipPositions.resize(positions.size());
+	for (uint32_t i = 0; i < (uint32_t)positions.size(); i++)
+		m_clipPositions[i] = modelToClip * Vector4f(positions[i], 1.0f);
+
+	// Clipping against 5 planes adds at most 5 vertices to a triangle
+	Vector4f polygon[8];
+	Vector4f clipped[8];
+
+	for (uint32_t i = 0; i + 2 < (uint32_t)indices.size(); i += 3)
+	{
+		polygon[0] = m_clipPositions[indices[i]];
+		polygon[1] = m_clipPositions[indices[i + 1]];
+		polygon[2] = m_clipPositions[indices[i + 2]];
+
+		uint32_t code0 = GetOutCode(polygon[0]);
+		uint32_t code1 = GetOutCode(polygon[1]);
+		uint32_t code2 = GetOutCode(polygon[2]);
+
+		// All vertices outside the same plane
+		if ((code0 & code1 & code2) != 0)
+			continue;
+
+		uint32_t count = 3;
+		uint32_t clipMask = code0 | code1 | code2;
+		for (uint32_t j = 0; j < ClipPlaneCount && count >= 3; j++)
+		{
+			if ((clipMask & (1 << j)) == 0)
+				continue;
+
+			count = ClipPolygon(polygon, count, g_clipPlanes[j], g_clipPlaneDs[j], clipped);
+			std::copy(clipped, clipped + count, polygon);
+		}
+
+		if (count < 3)
+			continue;
+
+		Vector3f screen[8];
+		for (uint32_t j = 0; j < count; j++)
+		{
+			float invW = 1.0f / polygon[j].w;
+			screen[j] = Vector3f
+			(
+				(polygon[j].x * invW * 0.5f + 0.5f) * WIDTH,
+				(polygon[j].y * invW * 0.5f + 0.5f) * HEIGHT,
+				invW
+			);
+		}
+
+		// Clipped polygon is convex, a fan keeps winding of original triangle
+		for (uint32_t j = 1; j + 1 < count; j++)
+			SetupTriangle(screen[0], screen[j], screen[j + 1]);
+	}
+}
+
+uint32_t MaskedOcclusionBuffer::ClipPolygon(const Vector4f* pInput, uint32_t inputCount, const Vector4f& plane, float D, Vector4f* pOutput)
+{
+	uint32_t outputCount = 0;
+	for (uint32_t i = 0; i < inputCount; i++)
+	{
+		const Vector4f& current = pInput[i];
+		const Vector4f& next = pInput[(i + 1) % inputCount];
+
+		float currentDist = plane * current - D;
+		float nextDist = plane * next - D;
+
+		if (currentDist >= 0)
+			pOutput[outputCount++] = current;
+
+		// Edge crosses plane
+		if ((currentDist >= 0) != (nextDist >= 0))
+		{
+			float t = currentDist / (currentDist - nextDist);
+			pOutput[outputCount++] = current + (next - current) * t;
+		}
+	}
+	return outputCount;
+}
+
+void MaskedOcclusionBuffer::SetupTriangle(const Vector3f& v0, const Vector3f& v1, const Vector3f& v2)
+{
+	// Vulkan treats triangles with positive "-cross" as counter clockwise, so front faces have negative cross here
+	float cross = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+	if (cross >= 0)
+		return;
+
+	// Swap to positive area, so that pixels inside have all edge functions positive
+	const Vector3f* vertices[3] = { &v0, &v2, &v1 };
+	float area = -cross;
+
+	Triangle triangle;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		const Vector3f& p0 = *vertices[i];
+		const Vector3f& p1 = *vertices[(i + 1) % 3];
+		triangle.edgeA[i] = p0.y - p1.y;
+		triangle.edgeB[i] = p1.x - p0.x;
+		triangle.edgeC[i] = -(triangle.edgeA[i] * p0.x + triangle.edgeB[i] * p0.y);
+	}
+
+	// 1/w is linear in screen space
+	const Vector3f& p0 = *vertices[0];
+	Vector3f d1 = *vertices[1] - p0;
+	Vector3f d2 = *vertices[2] - p0;
+	triangle.depthA = (d1.z * d2.y - d2.z * d1.y) / area;
+	triangle.depthB = (d1.x * d2.z - d2.x * d1.z) / area;
+	triangle.depthC = p0.z - triangle.depthA * p0.x - triangle.depthB * p0.y;
+	triangle.minDepth = (std::min)((std::min)(v0.z, v1.z), v2.z);
+
+	float minX = (std::max)(std::floor((std::min)((std::min)(v0.x, v1.x), v2.x)), 0.0f);
+	float minY = (std::max)(std::floor((std::min)((std::min)(v0.y, v1.y), v2.y)), 0.0f);
+	float maxX = (std::min)(std::ceil((std::max)((std::max)(v0.x, v1.x), v2.x)), (float)WIDTH);
+	float maxY = (std::min)(std::ceil((std::max)((std::max)(v0.y, v1.y), v2.y)), (float)HEIGHT);
+	if (minX >= maxX || minY >= maxY)
+		return;
+
+	triangle.minTileX = (uint32_t)minX / TILE_WIDTH;
+	triangle.minTileY = (uint32_t)minY / TILE_HEIGHT;
+	triangle.maxTileX = ((uint32_t)maxX - 1) / TILE_WIDTH;
+	triangle.maxTileY = ((uint32_t)maxY - 1) / TILE_HEIGHT;
+
+	m_triangles.push_back(triangle);
+	m_totalTriangleCount++;
+}
+
+void MaskedOcclusionBuffer::Rasterize()
+{
+	RasterizeTileRows(0, 1);
+	m_triangles.clear();
+}
+
+void MaskedOcclusionBuffer::RasterizeParallel()
+{
+	uint32_t workerCount = (std::min)(WorkerPool::GetInstance()->GetConcurrency(), (uint32_t)TILE_ROW_COUNT);
+	if ((uint32_t)m_triangles.size() < PARALLEL_TRIANGLE_THRESHOLD || workerCount == 1)
+	{
+		Rasterize();
+		return;
+	}
+
+	// Tile rows are interleaved, occluders usually gather in a horizontal band of screen, e.g. ground and buildings
+	// Each tile belongs to one worker, so no synchronization is needed, and result is the same as single threaded one
+	WorkerPool::GetInstance()->ParallelFor(workerCount, [this, workerCount](uint32_t i) { RasterizeTileRows(i, workerCount); });
+
+	m_triangles.clear();
+}
+
+void MaskedOcclusionBuffer::RasterizeTileRows(uint32_t firstTileY, uint32_t tileYStep)
+{
+	for (const Triangle& triangle : m_triangles)
+	{
+		uint32_t tileY = firstTileY;
+		if (tileY < triangle.minTileY)
+			tileY += (triangle.minTileY - tileY + tileYStep - 1) / tileYStep * tileYStep;
+
+		for (; tileY <= triangle.maxTileY; tileY += tileYStep)
+		{
+			for (uint32_t tileX = triangle.minTileX; tileX <= triangle.maxTileX; tileX++)
+			{
+				Tile& tile = m_tiles[tileY * TILE_COLUMN_COUNT + tileX];
+
+				// Farthest depth of triangle within tile, extremes of depth plane over a tile are at its corners
+				float x = (float)(tileX * TILE_WIDTH);
+				float y = (float)(tileY * TILE_HEIGHT);
+				float depth = triangle.depthA * x + triangle.depthB * y + triangle.depthC;
+				depth += (std::min)(triangle.depthA * TILE_WIDTH, 0.0f) + (std::min)(triangle.depthB * TILE_HEIGHT, 0.0f);
+				depth = (std::max)(depth, triangle.minDepth);
+
+				// Behind layer 0, nothing to improve
+				if (depth <= tile.depth0)
+					continue;
+
+				uint32_t coverage = ComputeCoverage(triangle, tileX, tileY);
+				if (coverage != 0)
+					MergeTile(tile, coverage, depth);
+			}
+		}
+	}
+}
+
+uint32_t MaskedOcclusionBuffer::ComputeCoverage(const Triangle& triangle, uint32_t tileX, uint32_t tileY)
+{
+	// Pixel centers
+	__m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	__m128 zero = _mm_setzero_ps();
+
+	uint32_t coverage = 0;
+	for (uint32_t i = 0; i < TILE_WIDTH; i += 4)
+	{
+		__m128 x = _mm_add_ps(_mm_set1_ps((float)(tileX * TILE_WIDTH + i)), offsets);
+
+		__m128 edges[3];
+		for (uint32_t j = 0; j < 3; j++)
+			edges[j] = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(triangle.edgeA[j])), _mm_set1_ps(triangle.edgeC[j]));
+
+		for (uint32_t row = 0; row < TILE_HEIGHT; row++)
+		{
+			float y = (float)(tileY * TILE_HEIGHT + row) + 0.5f;
+
+			// Pixels exactly on edges are left out, an occluder must not cover more than it actually does
+			__m128 inside = _mm_cmpgt_ps(_mm_add_ps(edges[0], _mm_set1_ps(triangle.edgeB[0] * y)), zero);
+			inside = _mm_and_ps(inside, _mm_cmpgt_ps(_mm_add_ps(edges[1], _mm_set1_ps(triangle.edgeB[1] * y)), zero));
+			inside = _mm_and_ps(inside, _mm_cmpgt_ps(_mm_add_ps(edges[2], _mm_set1_ps(triangle.edgeB[2] * y)), zero));
+
+			coverage |= (uint32_t)_mm_movemask_ps(inside) << (row * TILE_WIDTH + i);
+		}
+	}
+	return coverage;
+}
+
+void MaskedOcclusionBuffer::MergeTile(Tile& tile, uint32_t coverage, float depth)
+{
+	tile.depth1 = tile.mask == 0 ? depth : (std::min)(tile.depth1, depth);
+	tile.mask |= coverage;
+
+	// Whole tile is covered by working layer now
+	if (tile.mask == FULL_COVERAGE)
+	{
+		tile.depth0 = (std::max)(tile.depth0, tile.depth1);
+		tile.mask = 0;
+	}
+	// Working layer fell behind layer 0, it doesn't occlude anything layer 0 doesn't
+	else if (tile.depth1 <= tile.depth0)
+	{
+		tile.mask = 0;
+	}
+}
+
+bool MaskedOcclusionBuffer::TestAABB(const Matrix4d& worldToClip, const BoundingBoxd& box) const
+{
+	if (!box.IsValid())
+		return true;
+
+	double minX = WIDTH, minY = HEIGHT, maxX = 0, maxY = 0;
+	float depth = 0;
+	for (uint32_t i = 0; i < 8; i++)
+	{
+		Vector3d corner =
+		{
+			(i & 1) ? box.max.x : box.min.x,
+			(i & 2) ? box.max.y : box.min.y,
+			(i & 4) ? box.max.z : box.min.z
+		};
+		Vector4d clip = worldToClip * Vector4d(corner, 1.0);
+
+		// Box crosses near plane, its projection is unbounded
+		if (clip.w < NEAR_CLIP_W)
+			return true;
+
+		double x = (clip.x / clip.w * 0.5 + 0.5) * WIDTH;
+		double y = (clip.y / clip.w * 0.5 + 0.5) * HEIGHT;
+		minX = (std::min)(minX, x);
+		minY = (std::min)(minY, y);
+		maxX = (std::max)(maxX, x);
+		maxY = (std::max)(maxY, y);
+
+		// Box depth extremes are at its corners too, since w is linear
+		depth = (std::max)(depth, (float)(1.0 / clip.w));
+	}
+
+	// Every pixel box touches
+	uint32_t pixelMinX = (uint32_t)(std::max)(std::floor(minX), 0.0);
+	uint32_t pixelMinY = (uint32_t)(std::max)(std::floor(minY), 0.0);
+	uint32_t pixelMaxX = (uint32_t)(std::min)(std::ceil(maxX), (double)WIDTH);
+	uint32_t pixelMaxY = (uint32_t)(std::min)(std::ceil(maxY), (double)HEIGHT);
+	if (pixelMinX >= pixelMaxX || pixelMinY >= pixelMaxY)
+		return true;
+
+	for (uint32_t tileY = pixelMinY / TILE_HEIGHT; tileY <= (pixelMaxY - 1) / TILE_HEIGHT; tileY++)
+	{
+		uint32_t rowStart = (std::max)(pixelMinY, tileY * TILE_HEIGHT) - tileY * TILE_HEIGHT;
+		uint32_t rowEnd = (std::min)(pixelMaxY, (tileY + 1) * TILE_HEIGHT) - tileY * TILE_HEIGHT;
+
+		for (uint32_t tileX = pixelMinX / TILE_WIDTH; tileX <= (pixelMaxX - 1) / TILE_WIDTH; tileX++)
+		{
+			const Tile& tile = GetTile(tileX, tileY);
+
+			if (depth < tile.depth0)
+				continue;
+
+			// Pixels of box inside this tile
+			uint32_t columnStart = (std::max)(pixelMinX, tileX * TILE_WIDTH) - tileX * TILE_WIDTH;
+			uint32_t columnEnd = (std::min)(pixelMaxX, (tileX + 1) * TILE_WIDTH) - tileX * TILE_WIDTH;
+			uint32_t rowMask = ((1u << (columnEnd - columnStart)) - 1) << columnStart;
+
+			uint32_t boxMask = 0;
+			for (uint32_t row = rowStart; row < rowEnd; row++)
+				boxMask |= rowMask << (row * TILE_WIDTH);
+
+			// Box pixels have to be all covered by working layer, and box has to be behind it
+			if ((boxMask & ~tile.mask) == 0 && depth < tile.depth1)
+				continue;
+
+			return true;
+		}
+	}
+
+	return false;
+}
\ No newline at end of file
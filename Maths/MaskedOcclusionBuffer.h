@@ -0,0 +1,92 @@
+#pragma once
+#include <vector>
+#include "Vector.h"
+#include "Matrix.h"
+#include "BoundingBox.h"
+
+// Low resolution software depth buffer for CPU occlusion culling
+// Buffer is split into 8x4 pixel tiles, each tile keeps 2 depth layers instead of per pixel depth:
+// 1. Layer 0 covers the whole tile with a conservative depth
+// 2. Working layer covers pixels in coverage mask, with the farthest depth of occluders merged into it so far
+// Once coverage mask is full, working layer is merged into layer 0 and cleared
+// Depth is 1/w of reverse z infinite projection, larger means nearer, 0 means nothing occludes
+// Occluder triangles are set up once on this thread, then tile rows are rasterized by worker threads
+// Everything is single precision except occludee test, which projects box corners with double precision
+class MaskedOcclusionBuffer
+{
+public:
+	static const uint32_t WIDTH = 256;
+	static const uint32_t HEIGHT = 128;
+	static const uint32_t TILE_WIDTH = 8;
+	static const uint32_t TILE_HEIGHT = 4;
+	static const uint32_t TILE_COLUMN_COUNT = WIDTH / TILE_WIDTH;
+	static const uint32_t TILE_ROW_COUNT = HEIGHT / TILE_HEIGHT;
+	static const uint32_t FULL_COVERAGE = 0xffffffff;
+	// Triangles are rasterized in parallel only above this amount
+	static const uint32_t PARALLEL_TRIANGLE_THRESHOLD = 256;
+	// Geometry closer than this w is clipped, boxes crossing it are always visible
+	static const float NEAR_CLIP_W;
+
+	typedef struct _Tile
+	{
+		uint32_t	mask;		// Pixels covered by working layer, bit index is "y * TILE_WIDTH + x"
+		float		depth0;		// Depth of layer 0
+		float		depth1;		// Depth of working layer
+	}Tile;
+
+	// Screen space triangle, counter clockwise in a y down frame
+	typedef struct _Triangle
+	{
+		float		edgeA[3];	// Edge functions "A * x + B * y + C", pixels with all of them positive are covered
+		float		edgeB[3];
+		float		edgeC[3];
+		float		depthA;		// Depth plane "A * x + B * y + C"
+		float		depthB;
+		float		depthC;
+		float		minDepth;	// Farthest vertex depth
+		uint32_t	minTileX;	// Tiles overlapped by screen bounds, inclusive
+		uint32_t	minTileY;
+		uint32_t	maxTileX;
+		uint32_t	maxTileY;
+	}Triangle;
+
+public:
+	MaskedOcclusionBuffer() { Clear(); }
+
+	// Reset depth and drop occluder triangles
+	void Clear();
+
+	// Clip, project and set up triangles, "modelToClip" transforms "positions" into clip space, counter clockwise triangles are front faces
+	// Back faces are skipped, since scene materials cull them too
+	void AddOccluder(const Matrix4f& modelToClip, const std::vector<Vector3f>& positions, const std::vector<uint32_t>& indices);
+
+	// Rasterize triangles added since last rasterization
+	void Rasterize();
+	// Same as Rasterize, tile rows are distributed to worker threads if there're enough triangles to pay off thread overhead
+	void RasterizeParallel();
+
+	// Returns false only if box is fully hidden behind rasterized occluders
+	bool TestAABB(const Matrix4d& worldToClip, const BoundingBoxd& box) const;
+
+	uint32_t GetTriangleCount() const { return m_totalTriangleCount; }
+	const Tile& GetTile(uint32_t tileX, uint32_t tileY) const { return m_tiles[tileY * TILE_COLUMN_COUNT + tileX]; }
+
+protected:
+	// Vertices are screen space, z is depth
+	void SetupTriangle(const Vector3f& v0, const Vector3f& v1, const Vector3f& v2);
+	// Rasterize tile rows "firstTileY + n * tileYStep"
+	void RasterizeTileRows(uint32_t firstTileY, uint32_t tileYStep);
+	// Coverage mask of a triangle over a tile, computed 4 pixels at a time
+	static uint32_t ComputeCoverage(const Triangle& triangle, uint32_t tileX, uint32_t tileY);
+	static void MergeTile(Tile& tile, uint32_t coverage, float depth);
+
+	// Sutherland Hodgman against one clip space plane, keeps the side with "dot(plane, v) >= D", returns output vertex count
+	static uint32_t ClipPolygon(const Vector4f* pInput, uint32_t inputCount, const Vector4f& plane, float D, Vector4f* pOutput);
+
+protected:
+	std::vector<Tile>			m_tiles;
+	// Triangles waiting for rasterization
+	std::vector<Triangle>		m_triangles;
+	std::vector<Vector4f>		m_clipPositions;
+	uint32_t					m_totalTriangleCount = 0;
+};
\ No newline at end of file
@@ -50,9 +50,11 @@ void Plane<T>::Transform(const Matrix3x3<T>& matrix)
 template<typename T>
 void Plane<T>::Transform(const Matrix4x4<T>& matrix)
 {
+	// Normal * D is a point on the plane, it has to be acquired before normal is transformed
+	Vector3<T> p = matrix.TransformAsPoint(normal * D);
+
 	normal = matrix.TransformAsVector(normal);
 
-	// Normal * D is a point on the plane
 	// p dot with normal is D
-	D = matrix.TransformAsPoint(normal * D) * normal;
+	D = p * normal;
 }
\ No newline at end of file
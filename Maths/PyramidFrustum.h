@@ -12,6 +12,9 @@ class Matrix4x4;
 template <typename T>
 class Plane;
 
+template <typename T>
+class BoundingBox;
+
 template<typename T>
 class PyramidFrustum
 {
@@ -22,7 +25,10 @@ public:
 		FrustumFace_RIGHT,
 		FrustumFace_BOTTOM,
 		FrustumFace_TOP,
+		FrustumFace_NEAR,
+		FrustumFace_FAR,
 		FrustumFace_COUNT,
+		FrustumFace_SIDE_COUNT = FrustumFace_NEAR,
 	};
 
 public:
@@ -30,11 +36,25 @@ public:
 
 	PyramidFrustum(const Vector3<T>& head, const Vector3<T>& bottomLeft, const Vector3<T>& bottomRight, const Vector3<T>& topLeft, const Vector3<T>& topRight);
 
-	PyramidFrustum(const Vector3<T>& head, const Vector3<T>& lookAt, T fovv, T aspect);
+	// Far plane is omitted if "farPlane" is not larger than "nearPlane", which matches an infinite projection
+	PyramidFrustum(const Vector3<T>& head, const Vector3<T>& lookAt, T fovv, T aspect, T nearPlane = 0, T farPlane = 0);
+
+	// Parallel sided volume, box of "halfSize" centered at origin and transformed by "transform", e.g. orthographic shadow volume
+	static PyramidFrustum<T> OrthographicBox(const Matrix4x4<T>& transform, const Vector3<T>& halfSize);
 
 public:
 	bool Contain(const Vector3<T>& p) const;
 
+	// Conservative tests, true if the volume is at least partially inside
+	bool IntersectSphere(const Vector3<T>& center, T radius) const;
+	bool IntersectAABB(const BoundingBox<T>& box) const;
+
+	// Batched tests of "count" volumes in SoA layout, 4 volumes against one plane per SIMD instruction
+	// Results are written to "pVisible", 1 for intersected, 0 for culled
+	// Planes are converted to single precision, so volumes are better kept close to origin, e.g. relative to frustum head
+	void IntersectSpheres(const float* pCenterX, const float* pCenterY, const float* pCenterZ, const float* pRadius, uint32_t count, uint8_t* pVisible) const;
+	void IntersectAABBs(const float* pCenterX, const float* pCenterY, const float* pCenterZ, const float* pExtentX, const float* pExtentY, const float* pExtentZ, uint32_t count, uint8_t* pVisible) const;
+
 	// Matrix rotation part should be orthogonal
 	void Transform(const Matrix3x3<T>& matrix);
 	void Transform(const Matrix4x4<T>& matrix);
@@ -42,6 +62,9 @@ public:
 public:
 	Plane<T>	planes[FrustumFace_COUNT];
 	Vector3<T>	head;
+
+	// Amount of valid planes, side planes always come first
+	uint32_t	faceCount = FrustumFace_SIDE_COUNT;
 };
 
 #include "PyramidFrustum.inl"
@@ -5,6 +5,8 @@
 #include "Quaternion.h"
 #include "Matrix3x3.h"
 #include "Matrix4x4.h"
+#include "BoundingBox.h"
+#include <xmmintrin.h>
 
 template <typename T>
 PyramidFrustum<T>::PyramidFrustum(const Vector3<T>& head, const Vector3<T>& bottomLeft, const Vector3<T>& bottomRight, const Vector3<T>& topLeft, const Vector3<T>& topRight)
@@ -18,7 +20,7 @@ PyramidFrustum<T>::PyramidFrustum(const Vector3<T>& head, const Vector3<T>& bott
 }
 
 template <typename T>
-PyramidFrustum<T>::PyramidFrustum(const Vector3<T>& head, const Vector3<T>& lookAt, T fovv, T aspect)
+PyramidFrustum<T>::PyramidFrustum(const Vector3<T>& head, const Vector3<T>& lookAt, T fovv, T aspect, T nearPlane, T farPlane)
 {
 	T tangentFOV_2_v = std::tan(fovv);
 	T tangentFOV_2_h = aspect * tangentFOV_2_v;
@@ -36,23 +38,158 @@ PyramidFrustum<T>::PyramidFrustum(const Vector3<T>& head, const Vector3<T>& look
 	planes[FrustumFace_BOTTOM]	= Plane<T>(bottomLeft,	bottomRight, head, Vector3<T>(topLeft - bottomLeft).Normal());
 	planes[FrustumFace_TOP]		= Plane<T>(topLeft,		topRight,	 head, Vector3<T>(bottomLeft - topLeft).Normal());
 
+	Vector3<T> forward = lookAt.Normal();
+	planes[FrustumFace_NEAR] = Plane<T>(forward, head + forward * nearPlane);
+	faceCount = FrustumFace_NEAR + 1;
+
+	if (farPlane > nearPlane)
+	{
+		planes[FrustumFace_FAR] = Plane<T>(forward.Negative(), head + forward * farPlane);
+		faceCount = FrustumFace_FAR + 1;
+	}
+
 	this->head = head;
 }
 
+template <typename T>
+PyramidFrustum<T> PyramidFrustum<T>::OrthographicBox(const Matrix4x4<T>& transform, const Vector3<T>& halfSize)
+{
+	PyramidFrustum<T> frustum;
+
+	// Normals point inwards, D is negative half size
+	frustum.planes[FrustumFace_LEFT]	= Plane<T>(Vector3<T>( 1,  0,  0), -halfSize.x);
+	frustum.planes[FrustumFace_RIGHT]	= Plane<T>(Vector3<T>(-1,  0,  0), -halfSize.x);
+	frustum.planes[FrustumFace_BOTTOM]	= Plane<T>(Vector3<T>( 0,  1,  0), -halfSize.y);
+	frustum.planes[FrustumFace_TOP]		= Plane<T>(Vector3<T>( 0, -1,  0), -halfSize.y);
+	frustum.planes[FrustumFace_NEAR]	= Plane<T>(Vector3<T>( 0,  0,  1), -halfSize.z);
+	frustum.planes[FrustumFace_FAR]		= Plane<T>(Vector3<T>( 0,  0, -1), -halfSize.z);
+	frustum.faceCount = FrustumFace_COUNT;
+
+	frustum.Transform(transform);
+
+	return frustum;
+}
+
 template <typename T>
 bool PyramidFrustum<T>::Contain(const Vector3<T>& p) const
 {
-	for (uint32_t i = 0; i < FrustumFace_COUNT; i++)
+	for (uint32_t i = 0; i < faceCount; i++)
 		if (planes[i].PlaneTest(p) < 0)
 			return false;
 
 	return true;
 }
 
+template <typename T>
+bool PyramidFrustum<T>::IntersectSphere(const Vector3<T>& center, T radius) const
+{
+	for (uint32_t i = 0; i < faceCount; i++)
+		if (planes[i].PlaneTest(center) < -radius)
+			return false;
+
+	return true;
+}
+
+template <typename T>
+bool PyramidFrustum<T>::IntersectAABB(const BoundingBox<T>& box) const
+{
+	Vector3<T> center = box.Center();
+	Vector3<T> extent = box.Extent();
+
+	for (uint32_t i = 0; i < faceCount; i++)
+	{
+		// Distance of the box corner that lies furthest along plane normal
+		T r = std::abs(planes[i].normal.x) * extent.x + std::abs(planes[i].normal.y) * extent.y + std::abs(planes[i].normal.z) * extent.z;
+		if (planes[i].PlaneTest(center) < -r)
+			return false;
+	}
+
+	return true;
+}
+
+template <typename T>
+void PyramidFrustum<T>::IntersectSpheres(const float* pCenterX, const float* pCenterY, const float* pCenterZ, const float* pRadius, uint32_t count, uint8_t* pVisible) const
+{
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(pCenterX + i);
+		__m128 y = _mm_loadu_ps(pCenterY + i);
+		__m128 z = _mm_loadu_ps(pCenterZ + i);
+		__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(pRadius + i));
+
+		__m128 outside = _mm_setzero_ps();
+		for (uint32_t j = 0; j < faceCount; j++)
+		{
+			__m128 dist = _mm_mul_ps(x, _mm_set1_ps((float)planes[j].normal.x));
+			dist = _mm_add_ps(dist, _mm_mul_ps(y, _mm_set1_ps((float)planes[j].normal.y)));
+			dist = _mm_add_ps(dist, _mm_mul_ps(z, _mm_set1_ps((float)planes[j].normal.z)));
+			dist = _mm_sub_ps(dist, _mm_set1_ps((float)planes[j].D));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, negRadius));
+		}
+
+		int mask = _mm_movemask_ps(outside);
+		pVisible[i] = (mask & 1) ? 0 : 1;
+		pVisible[i + 1] = (mask & 2) ? 0 : 1;
+		pVisible[i + 2] = (mask & 4) ? 0 : 1;
+		pVisible[i + 3] = (mask & 8) ? 0 : 1;
+	}
+
+	// Tail
+	for (; i < count; i++)
+		pVisible[i] = IntersectSphere({ (T)pCenterX[i], (T)pCenterY[i], (T)pCenterZ[i] }, (T)pRadius[i]) ? 1 : 0;
+}
+
+template <typename T>
+void PyramidFrustum<T>::IntersectAABBs(const float* pCenterX, const float* pCenterY, const float* pCenterZ, const float* pExtentX, const float* pExtentY, const float* pExtentZ, uint32_t count, uint8_t* pVisible) const
+{
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(pCenterX + i);
+		__m128 y = _mm_loadu_ps(pCenterY + i);
+		__m128 z = _mm_loadu_ps(pCenterZ + i);
+		__m128 ex = _mm_loadu_ps(pExtentX + i);
+		__m128 ey = _mm_loadu_ps(pExtentY + i);
+		__m128 ez = _mm_loadu_ps(pExtentZ + i);
+
+		__m128 outside = _mm_setzero_ps();
+		for (uint32_t j = 0; j < faceCount; j++)
+		{
+			__m128 dist = _mm_mul_ps(x, _mm_set1_ps((float)planes[j].normal.x));
+			dist = _mm_add_ps(dist, _mm_mul_ps(y, _mm_set1_ps((float)planes[j].normal.y)));
+			dist = _mm_add_ps(dist, _mm_mul_ps(z, _mm_set1_ps((float)planes[j].normal.z)));
+			dist = _mm_sub_ps(dist, _mm_set1_ps((float)planes[j].D));
+
+			__m128 r = _mm_mul_ps(ex, _mm_set1_ps((float)std::abs(planes[j].normal.x)));
+			r = _mm_add_ps(r, _mm_mul_ps(ey, _mm_set1_ps((float)std::abs(planes[j].normal.y))));
+			r = _mm_add_ps(r, _mm_mul_ps(ez, _mm_set1_ps((float)std::abs(planes[j].normal.z))));
+
+			// dist + r < 0 means the whole box is on the negative side
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, r), _mm_setzero_ps()));
+		}
+
+		int mask = _mm_movemask_ps(outside);
+		pVisible[i] = (mask & 1) ? 0 : 1;
+		pVisible[i + 1] = (mask & 2) ? 0 : 1;
+		pVisible[i + 2] = (mask & 4) ? 0 : 1;
+		pVisible[i + 3] = (mask & 8) ? 0 : 1;
+	}
+
+	// Tail
+	for (; i < count; i++)
+	{
+		Vector3<T> center = { (T)pCenterX[i], (T)pCenterY[i], (T)pCenterZ[i] };
+		Vector3<T> extent = { (T)pExtentX[i], (T)pExtentY[i], (T)pExtentZ[i] };
+		pVisible[i] = IntersectAABB({ center - extent, center + extent }) ? 1 : 0;
+	}
+}
+
 template<typename T>
 void PyramidFrustum<T>::Transform(const Matrix3x3<T>& matrix)
 {
-	for (uint32_t i = 0; i < FrustumFace_COUNT; i++)
+	for (uint32_t i = 0; i < faceCount; i++)
 		planes[i].Transform(matrix);
 
 	head = matrix * head;
@@ -61,7 +198,7 @@ void PyramidFrustum<T>::Transform(const Matrix3x3<T>& matrix)
 template<typename T>
 void PyramidFrustum<T>::Transform(const Matrix4x4<T>& matrix)
 {
-	for (uint32_t i = 0; i < FrustumFace_COUNT; i++)
+	for (uint32_t i = 0; i < faceCount; i++)
 		planes[i].Transform(matrix);
 
 	head = matrix.TransformAsPoint(head);
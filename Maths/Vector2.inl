@@ -1,6 +1,7 @@
 #pragma once
 #include "Vector2.h"
 #include <algorithm>
+#include <cmath>
 
 template <typename T>
 const Vector2<T> Vector2<T>::operator + (const Vector2<T>& v) const
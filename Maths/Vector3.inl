@@ -1,6 +1,7 @@
 #pragma once
 #include "Vector3.h"
 #include <algorithm>
+#include <cmath>
 
 template <typename T>
 const Vector3<T> Vector3<T>::operator + (const Vector3<T>& v) const
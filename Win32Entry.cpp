@@ -15,9 +15,10 @@ int APIENTRY WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLin
 {
 	AppEntry::GetInstance()->InitVulkan(hInstance, WndProc);
 	AppEntry::GetInstance()->Update();
+	int exitCode = AppEntry::GetInstance()->GetExitCode();
 	SceneGenerator::Free();
 	AppEntry::Free();
 	GlobalDeviceObjects::GetInstance()->Free();
-	return 0;
+	return exitCode;
 }
 
@@ -14,6 +14,7 @@
 #include "../vulkan/StagingBuffer.h"
 #include "../vulkan/Queue.h"
 #include "../vulkan/StagingBufferManager.h"
+#include "../vulkan/InitCommandBatcher.h"
 #include "../class/FrameWorkManager.h"
 #include "../thread/ThreadWorker.hpp"
 #include <gli\gli.hpp>
@@ -40,8 +41,41 @@
 #include "../component/AnimationController.h"
 #include "../class/PerFrameData.h"
 #include "../class/FrameEventManager.h"
+#include "../class/CullingManager.h"
+#include "../common/AllocationTracker.h"
+#include "../class/FramePipeline.h"
+#include "../class/GPUProfiler.h"
+#include "../class/DynamicResolution.h"
+#include "../component/LocalLight.h"
 
 bool PREBAKE_CB = true;
+// Simulation of next frame overlaps render stage of current one, enabled by "-pipelined"
+bool PIPELINED_FRAME = false;
+// SSAO and its blurs run on a dedicated compute queue, overlapping shadow rendering, enabled by "-asynccompute"
+bool ASYNC_COMPUTE = false;
+// Per pass gpu timing, reported and exported to "GPUProfile.json" periodically, enabled by "-gpuprofile"
+bool GPU_PROFILE = false;
+// Scene viewport is scaled to keep gpu frame time within target, enabled by "-dynamicres", target could be overridden by "-dynamicrestarget MS"
+bool DYNAMIC_RESOLUTION = false;
+double DYNAMIC_RESOLUTION_TARGET_MS = DynamicResolution::DEFAULT_TARGET_FRAME_TIME;
+// Two phase gpu occlusion culling of gbuffer draws against Hi-Z, enabled by "-gpuculling"
+bool GPU_CULLING = false;
+// Screen space reflection rays are traced through Hi-Z instead of linear ray march, enabled by "-hizssr"
+bool HIZ_SSR = false;
+// Bloom downsample chain in one dispatch, enabled by "-bloomsinglepass"
+bool BLOOM_SINGLE_PASS = false;
+// SSAO blur and motion tile reduction in one dispatch each, enabled by "-fusedssaoblur" and "-fusedmotiontile"
+bool FUSED_SSAO_BLUR = false;
+bool FUSED_MOTION_TILE = false;
+// CPU occlusion culling against software rasterized occluders, enabled by "-softwareocclusion"
+bool SOFTWARE_OCCLUSION = false;
+// Point lights scattered over the scene to stress clustered shading, count is set by "-locallights N"
+uint32_t LOCAL_LIGHT_COUNT = 0;
+
+// Allocation benchmark, enabled by "-allocbenchmark", per frame budget could be overridden by "-allocbudget N"
+uint32_t ALLOC_BENCHMARK_WARMUP_FRAMES = 300;
+uint32_t ALLOC_BENCHMARK_MEASURE_FRAMES = 600;
+uint32_t ALLOC_BENCHMARK_BUDGET = 0;
 
 void AppEntry::InitVulkanInstance()
 {
@@ -304,6 +338,7 @@ void AppEntry::Update()
 			if (msg.message == WM_QUIT)
 			{
 				quitMessageReceived = true;
+				m_exitCode = (int)msg.wParam;
 				FrameWorkManager::GetInstance()->WaitForAllJobsDone();
 				return;
 			}
@@ -591,8 +626,22 @@ void AppEntry::InitMaterials()
 
 	m_pPlanetMaterialInstance = RenderWorkManager::GetInstance()->AcquirePBRPlanetMaterialInstance();
 
-	m_pShadowMapMaterialInstance = RenderWorkManager::GetInstance()->AcquireShadowMaterialInstance();
-	m_pSkinnedShadowMapMaterialInstance = RenderWorkManager::GetInstance()->AcquireSkinnedShadowMaterialInstance();
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		m_shadowMapMaterialInstances.push_back(RenderWorkManager::GetInstance()->AcquireShadowMaterialInstance(i));
+		m_skinnedShadowMapMaterialInstances.push_back(RenderWorkManager::GetInstance()->AcquireSkinnedShadowMaterialInstance(i));
+		m_staticShadowMapMaterialInstances.push_back(RenderWorkManager::GetInstance()->AcquireStaticShadowMaterialInstance(i));
+	}
+}
+
+std::vector<std::shared_ptr<MaterialInstance>> AppEntry::ShadowCastingMaterialInstances(const std::shared_ptr<MaterialInstance>& pMaterialInstance, bool skinned) const
+{
+	std::vector<std::shared_ptr<MaterialInstance>> materialInstances = { pMaterialInstance };
+	const std::vector<std::shared_ptr<MaterialInstance>>& shadowMapMaterialInstances = skinned ? m_skinnedShadowMapMaterialInstances : m_shadowMapMaterialInstances;
+	materialInstances.insert(materialInstances.end(), shadowMapMaterialInstances.begin(), shadowMapMaterialInstances.end());
+	if (!skinned)
+		materialInstances.insert(materialInstances.end(), m_staticShadowMapMaterialInstances.begin(), m_staticShadowMapMaterialInstances.end());
+	return materialInstances;
 }
 
 void AppEntry::AddBoneBox(const std::shared_ptr<BaseObject>& pObject)
@@ -720,12 +769,21 @@ void AppEntry::InitScene()
 	m_pBoxObject3 = BaseObject::Create();
 	m_pBoxObject4 = BaseObject::Create();
 
-	m_pQuadRenderer = MeshRenderer::Create(m_pPBRBoxMesh, { m_pQuadMaterialInstance, m_pShadowMapMaterialInstance });
-	m_pBoxRenderer0 = MeshRenderer::Create(m_pPBRBoxMesh, { m_pBoxMaterialInstance0, m_pShadowMapMaterialInstance });
-	m_pBoxRenderer1 = MeshRenderer::Create(m_pPBRBoxMesh, { m_pBoxMaterialInstance1, m_pShadowMapMaterialInstance });
-	m_pBoxRenderer2 = MeshRenderer::Create(m_pPBRBoxMesh, { m_pBoxMaterialInstance2, m_pShadowMapMaterialInstance });
+	m_pQuadRenderer = MeshRenderer::Create(m_pPBRBoxMesh, ShadowCastingMaterialInstances(m_pQuadMaterialInstance));
+	m_pBoxRenderer0 = MeshRenderer::Create(m_pPBRBoxMesh, ShadowCastingMaterialInstances(m_pBoxMaterialInstance0));
+	m_pBoxRenderer1 = MeshRenderer::Create(m_pPBRBoxMesh, ShadowCastingMaterialInstances(m_pBoxMaterialInstance1));
+	m_pBoxRenderer2 = MeshRenderer::Create(m_pPBRBoxMesh, ShadowCastingMaterialInstances(m_pBoxMaterialInstance2));
 	m_pBoxRenderer3 = MeshRenderer::Create(m_pPBRBoxMesh, { m_pBoxMaterialInstance3 });
 	m_pBoxRenderer4 = MeshRenderer::Create(m_pPBRBoxMesh, { m_pBoxMaterialInstance4 });
+	m_pQuadRenderer->SetStaticShadowCaster(true);
+	m_pBoxRenderer0->SetStaticShadowCaster(true);
+	m_pBoxRenderer1->SetStaticShadowCaster(true);
+	m_pBoxRenderer2->SetStaticShadowCaster(true);
+	// Large static boxes and ground hide most of the scene behind them
+	m_pQuadRenderer->SetOccluder(true);
+	m_pBoxRenderer0->SetOccluder(true);
+	m_pBoxRenderer1->SetOccluder(true);
+	m_pBoxRenderer2->SetOccluder(true);
 
 	m_pPlanetGenerator = PlanetGenerator::Create(m_pCameraComp, 6360000);
 
@@ -733,24 +791,28 @@ void AppEntry::InitScene()
 
 	m_pGunObject = AssimpSceneReader::ReadAndAssemblyScene("../data/textures/cerberus/cerberus.fbx", { VertexFormatPNTCT }, sceneInfo);
 	m_pGunMesh = sceneInfo.meshLinks[0].first;
-	m_pGunMeshRenderer = MeshRenderer::Create(m_pGunMesh, { m_pGunMaterialInstance, m_pShadowMapMaterialInstance });
+	m_pGunMeshRenderer = MeshRenderer::Create(m_pGunMesh, ShadowCastingMaterialInstances(m_pGunMaterialInstance));
+	m_pGunMeshRenderer->SetStaticShadowCaster(true);
 	sceneInfo.meshLinks[0].second->AddComponent(m_pGunMeshRenderer);
 	sceneInfo.meshLinks.clear();
 	m_pGunObject->SetPos({ -0.8f, -0.08f, 0 });
 	m_pGunObject->SetScale(0.01f);
 
 	m_pSphere0 = AssimpSceneReader::ReadAndAssemblyScene("../data/models/sphere.obj", { VertexFormatPNTCT }, sceneInfo);
-	m_pSphereRenderer0 = MeshRenderer::Create(sceneInfo.meshLinks[0].first, { m_pSphereMaterialInstance0, m_pShadowMapMaterialInstance });
+	m_pSphereRenderer0 = MeshRenderer::Create(sceneInfo.meshLinks[0].first, ShadowCastingMaterialInstances(m_pSphereMaterialInstance0));
+	m_pSphereRenderer0->SetStaticShadowCaster(true);
 	sceneInfo.meshLinks[0].second->AddComponent(m_pSphereRenderer0);
 	m_pSphere0->SetPos(0.4f, -0.15f, 0);
 	m_pSphere0->SetScale(0.01f);
 
-	m_pSphereRenderer1 = MeshRenderer::Create(sceneInfo.meshLinks[0].first, { m_pSphereMaterialInstance1, m_pShadowMapMaterialInstance });
+	m_pSphereRenderer1 = MeshRenderer::Create(sceneInfo.meshLinks[0].first, ShadowCastingMaterialInstances(m_pSphereMaterialInstance1));
+	m_pSphereRenderer1->SetStaticShadowCaster(true);
 	m_pSphere1->AddComponent(m_pSphereRenderer1);
 	m_pSphere1->SetPos(1, -0.15f, 0);
 	m_pSphere1->SetScale(0.01f);
 
-	m_pSphereRenderer2 = MeshRenderer::Create(sceneInfo.meshLinks[0].first, { m_pSphereMaterialInstance2, m_pShadowMapMaterialInstance });
+	m_pSphereRenderer2 = MeshRenderer::Create(sceneInfo.meshLinks[0].first, ShadowCastingMaterialInstances(m_pSphereMaterialInstance2));
+	m_pSphereRenderer2->SetStaticShadowCaster(true);
 	m_pSphere2->AddComponent(m_pSphereRenderer2);
 	m_pSphere2->SetPos(1, -0.15f, 0.6f);
 	m_pSphere2->SetScale(0.01f);
@@ -769,7 +831,8 @@ void AppEntry::InitScene()
 	m_pInnerBall = AssimpSceneReader::ReadAndAssemblyScene("../data/models/Sample.FBX", { VertexFormatPNTCT }, sceneInfo);
 	for (uint32_t i = 0; i < sceneInfo.meshLinks.size(); i++)
 	{
-		m_innerBallRenderers.push_back(MeshRenderer::Create(sceneInfo.meshLinks[i].first, { m_innerBallMaterialInstances[i], m_pShadowMapMaterialInstance }));
+		m_innerBallRenderers.push_back(MeshRenderer::Create(sceneInfo.meshLinks[i].first, ShadowCastingMaterialInstances(m_innerBallMaterialInstances[i])));
+		m_innerBallRenderers[i]->SetStaticShadowCaster(true);
 		sceneInfo.meshLinks[i].second->AddComponent(m_innerBallRenderers[i]);
 	}
 	m_pInnerBall->SetPos(-1.3f, -0.4f, 0);
@@ -807,7 +870,7 @@ void AppEntry::InitScene()
 	m_pSophiaMesh = sceneInfo.meshLinks[0].first;
 
 	std::shared_ptr<AnimationController> pAnimationController = m_pSophiaObject->GetComponent<AnimationController>();
-	m_pSophiaRenderer = MeshRenderer::Create(m_pSophiaMesh, { m_pSophiaMaterialInstance, m_pSkinnedShadowMapMaterialInstance });
+	m_pSophiaRenderer = MeshRenderer::Create(m_pSophiaMesh, ShadowCastingMaterialInstances(m_pSophiaMaterialInstance, true));
 	pAnimationController->SetMeshRenderer(m_pSophiaRenderer);
 	sceneInfo.meshLinks[0].second->AddComponent(m_pSophiaRenderer);
 	m_pSophiaRenderer->SetName(L"hehe");
@@ -837,6 +900,19 @@ void AppEntry::InitScene()
 	m_pSceneRootObject->AddChild(m_pBoxObject2);
 	m_pSceneRootObject->AddChild(m_pSophiaObject);
 	m_pSceneRootObject->AddChild(m_pDirLightObj);
+
+	// Spread with golden ratio sequences, so that lights cover the area evenly for any count
+	for (uint32_t i = 0; i < LOCAL_LIGHT_COUNT; i++)
+	{
+		double u = fmod(i * 0.618033988749895, 1.0);
+		double v = fmod(i * 0.754877666246693, 1.0);
+		double w = fmod(i * 0.569840290998053, 1.0);
+
+		std::shared_ptr<BaseObject> pLocalLightObj = BaseObject::Create();
+		pLocalLightObj->SetPos(u * 4.0 - 2.0, w * 0.8 - 0.35, v * 4.0 - 3.0);
+		pLocalLightObj->AddComponent(LocalLight::CreatePointLight({ 0.6 + 0.4 * sin(i * 2.4), 0.6 + 0.4 * sin(i * 2.4 + 2.1), 0.6 + 0.4 * sin(i * 2.4 + 4.2) }, 0.4));
+		m_pSceneRootObject->AddChild(pLocalLightObj);
+	}
 	m_pSceneRootObject->SetPosY(m_pPlanetGenerator->GetPlanetRadius() + 9000);
 
 	m_pRootObject = BaseObject::Create();
@@ -889,12 +965,83 @@ void AppEntry::EndSetup()
 {
 	GlobalDeviceObjects::GetInstance()->GetStagingBufferMgr()->FlushDataMainThread();
 	m_commandBufferList.resize(GetSwapChain()->GetSwapChainImageCount() * 2);
+	m_asyncComputeCommandBufferList.resize(GetSwapChain()->GetSwapChainImageCount() * 2);
+	m_postAsyncCommandBufferList.resize(GetSwapChain()->GetSwapChainImageCount() * 2);
+	m_recordedScaleLevels.resize(GetSwapChain()->GetSwapChainImageCount() * 2);
+
+	// Before any frame command buffer is recorded, dynamic resolution is driven by profiled frame time
+	GPUProfiler::GetInstance()->SetEnabled(GPU_PROFILE || DYNAMIC_RESOLUTION);
+	m_profilerRecordingBase = GPUProfiler::GetInstance()->ReserveRecordings((uint32_t)m_commandBufferList.size());
+	DynamicResolution::GetInstance()->SetTargetFrameTime(DYNAMIC_RESOLUTION_TARGET_MS);
+	DynamicResolution::GetInstance()->SetEnabled(DYNAMIC_RESOLUTION);
+	RenderWorkManager::GetInstance()->SetGPUCullingEnabled(GPU_CULLING);
+	if (GPU_CULLING && !RenderWorkManager::GetInstance()->IsGPUCullingEnabled())
+		std::cout << "Occlusion culling or Hi-Z shader isn't compiled, falling back to gbuffer draws without gpu culling\n";
+	RenderWorkManager::GetInstance()->SetHiZSSREnabled(HIZ_SSR);
+	if (HIZ_SSR && !RenderWorkManager::GetInstance()->IsHiZSSREnabled())
+		std::cout << "Hi-Z tracing or Hi-Z shader isn't compiled, falling back to linear ray march for screen space reflection\n";
+	RenderWorkManager::GetInstance()->SetBloomSinglePassEnabled(BLOOM_SINGLE_PASS);
+	if (BLOOM_SINGLE_PASS && !RenderWorkManager::GetInstance()->IsBloomSinglePassEnabled())
+		std::cout << "Single pass bloom shader isn't compiled, falling back to one dispatch per downsample\n";
+	RenderWorkManager::GetInstance()->SetFusedSSAOBlurEnabled(FUSED_SSAO_BLUR);
+	if (FUSED_SSAO_BLUR && !RenderWorkManager::GetInstance()->IsFusedSSAOBlurEnabled())
+		std::cout << "Fused SSAO blur shader isn't compiled, falling back to vertical and horizontal blur passes\n";
+	RenderWorkManager::GetInstance()->SetFusedMotionTileEnabled(FUSED_MOTION_TILE);
+	if (FUSED_MOTION_TILE && !RenderWorkManager::GetInstance()->IsFusedMotionTileEnabled())
+		std::cout << "Fused motion tile shader isn't compiled, falling back to tile max and neighbor max passes\n";
+
+	if (!RenderWorkManager::GetInstance()->IsShadowCacheEnabled())
+		std::cout << "Shadow cache clear shader isn't compiled, falling back to rendering static shadow casters every frame\n";
+	if (!RenderWorkManager::GetInstance()->IsPreSkinningEnabled())
+		std::cout << "Compute skinning shaders aren't compiled, falling back to skinning in vertex shaders of every pass\n";
+
+	m_asyncCompute = ASYNC_COMPUTE && RenderWorkManager::GetInstance()->IsAsyncComputeSupported();
+	if (ASYNC_COMPUTE && !m_asyncCompute)
+		std::cout << "Async compute requires a dedicated compute queue family and timeline semaphores, falling back to single queue\n";
 
 	m_pRootObject->Awake();
 	m_pRootObject->Start();
 
 	c = std::make_shared<VariableChanger>();
 	InputHub::GetInstance()->Register(c);
+
+	// Submit whatever one-time work left in setup batch
+	InitCmdBatcher()->EndBatch();
+	std::cout << "Setup gpu work: " << InitCmdBatcher()->GetRecordCount() << " recordings, "
+		<< InitCmdBatcher()->GetSubmissionCount() << " submissions, "
+		<< InitCmdBatcher()->GetSavedSubmissionCount() << " submissions saved\n";
+
+	FramePipeline::GetInstance()->SetPipelined(PIPELINED_FRAME);
+}
+
+void AppEntry::Simulate()
+{
+	if (c->sceneAltitude)
+	{
+		m_pSceneRootObject->SetPosY(m_pPlanetGenerator->GetPlanetRadius() + 9000);
+	}
+	else
+	{
+		m_pSceneRootObject->SetPosY(m_pPlanetGenerator->GetPlanetRadius() + 10);
+	}
+
+	m_pRootObject->Update();
+	m_pRootObject->OnAnimationUpdate();
+	m_pRootObject->LateUpdate();
+	m_pRootObject->UpdateCachedData();
+}
+
+void AppEntry::AllocateFrameCommandBuffers(uint32_t cbIndex, CommandPool::CBPersistancy persistancy)
+{
+	const std::shared_ptr<PerFrameResource>& pPerFrameRes = m_perFrameRes[FrameWorkManager::GetInstance()->FrameIndex()];
+
+	m_commandBufferList[cbIndex] = pPerFrameRes->AllocateCommandBuffer(PhysicalDevice::QueueFamily::ALL_ROUND, persistancy, CommandBuffer::CBLevel::PRIMARY);
+
+	if (!m_asyncCompute)
+		return;
+
+	m_asyncComputeCommandBufferList[cbIndex] = pPerFrameRes->AllocateCommandBuffer(PhysicalDevice::QueueFamily::COMPUTE, persistancy, CommandBuffer::CBLevel::PRIMARY);
+	m_postAsyncCommandBufferList[cbIndex] = pPerFrameRes->AllocateCommandBuffer(PhysicalDevice::QueueFamily::ALL_ROUND, persistancy, CommandBuffer::CBLevel::PRIMARY);
 }
 
 void AppEntry::Tick()
@@ -911,6 +1058,11 @@ void AppEntry::Tick()
 
 	FrameEventManager::GetInstance()->OnFrameBegin();
 
+	// Gpu time of frames done has been resolved at frame begin, scale picked here applies to the whole frame
+	DynamicResolution::GetInstance()->Update();
+	if (PREBAKE_CB && m_recordedScaleLevels[cbIndex] != DynamicResolution::GetInstance()->GetScaleLevel())
+		m_commandBufferList[cbIndex] = nullptr;
+
 	UniformData::GetInstance()->GetPerFrameUniforms()->SetDeltaTime(Timer::GetElapsedTime());
 	UniformData::GetInstance()->GetPerFrameUniforms()->SetSinTime(std::sin(Timer::GetTotalTime()));
 	UniformData::GetInstance()->GetPerFrameUniforms()->SetFrameIndex(frameIndex);
@@ -923,20 +1075,21 @@ void AppEntry::Tick()
 	m_pCameraComp->SetFocalLength((1.0 - c->var) * 0.02 + c->var * 0.2);
 	m_pPlanetGenerator->ToggleCameraInfoUpdate(c->updateCameraInfo);
 
-	if (c->sceneAltitude)
-	{
-		m_pSceneRootObject->SetPosY(m_pPlanetGenerator->GetPlanetRadius() + 9000);
-	}
-	else
+	// Frame to render might have been simulated during previous tick
+	FramePipeline* pFramePipeline = FramePipeline::GetInstance();
+	if (!pFramePipeline->IsSimulatedAhead())
 	{
-		m_pSceneRootObject->SetPosY(m_pPlanetGenerator->GetPlanetRadius() + 10);
+		Simulate();
+		m_pRootObject->PublishCachedData();
 	}
 
-	m_pRootObject->Update();
-	m_pRootObject->OnAnimationUpdate();
-	m_pRootObject->LateUpdate();
-	m_pRootObject->UpdateCachedData();
+	// Simulate next frame while this one is culled, recorded and submitted
+	if (pFramePipeline->IsPipelined())
+		pFramePipeline->KickSimulation(m_pRootObject, [this]() { Simulate(); });
+
 	m_pRootObject->OnPreRender();
+	CullingManager::GetInstance()->FrustumCull(m_pRootObject, m_pCameraComp);
+	CullingManager::GetInstance()->ShadowCasterCull(m_pDirLight);
 	m_pRootObject->OnRenderObject();
 
 	FrameEventManager::GetInstance()->OnPostSceneTraversal();
@@ -946,32 +1099,43 @@ void AppEntry::Tick()
 	static bool newCBCreated = false;
 	if (!PREBAKE_CB)
 	{
-		m_commandBufferList[cbIndex] = m_perFrameRes[FrameWorkManager::GetInstance()->FrameIndex()]->AllocateCommandBuffer
-		(
-			PhysicalDevice::QueueFamily::ALL_ROUND,
-			CommandPool::CBPersistancy::TRANSIENT,
-			CommandBuffer::CBLevel::PRIMARY
-		);
+		AllocateFrameCommandBuffers(cbIndex, CommandPool::CBPersistancy::TRANSIENT);
 		newCBCreated = true;
 	}
 	else if (m_commandBufferList[cbIndex] == nullptr)
 	{
-		m_commandBufferList[cbIndex] = m_perFrameRes[FrameWorkManager::GetInstance()->FrameIndex()]->AllocateCommandBuffer
-		(
-			PhysicalDevice::QueueFamily::ALL_ROUND,
-			CommandPool::CBPersistancy::PERSISTANT,
-			CommandBuffer::CBLevel::PRIMARY
-		);
+		AllocateFrameCommandBuffers(cbIndex, CommandPool::CBPersistancy::PERSISTANT);
 		newCBCreated = true;
 	}
 
 	if (newCBCreated)
 	{
-		m_commandBufferList[cbIndex]->StartPrimaryRecording();
+		m_recordedScaleLevels[cbIndex] = DynamicResolution::GetInstance()->GetScaleLevel();
+
+		if (m_asyncCompute)
+		{
+			m_commandBufferList[cbIndex]->StartPrimaryRecording();
+			m_asyncComputeCommandBufferList[cbIndex]->StartPrimaryRecording();
+			m_postAsyncCommandBufferList[cbIndex]->StartPrimaryRecording();
+
+			GPUProfiler::GetInstance()->BeginRecording(m_commandBufferList[cbIndex], m_profilerRecordingBase + cbIndex);
+			RenderWorkManager::GetInstance()->Draw(m_commandBufferList[cbIndex], m_asyncComputeCommandBufferList[cbIndex], m_postAsyncCommandBufferList[cbIndex], pingpong);
+			GPUProfiler::GetInstance()->EndRecording();
+
+			m_commandBufferList[cbIndex]->EndPrimaryRecording();
+			m_asyncComputeCommandBufferList[cbIndex]->EndPrimaryRecording();
+			m_postAsyncCommandBufferList[cbIndex]->EndPrimaryRecording();
+		}
+		else
+		{
+			m_commandBufferList[cbIndex]->StartPrimaryRecording();
 
-		RenderWorkManager::GetInstance()->Draw(m_commandBufferList[cbIndex], pingpong);
+			GPUProfiler::GetInstance()->BeginRecording(m_commandBufferList[cbIndex], m_profilerRecordingBase + cbIndex);
+			RenderWorkManager::GetInstance()->Draw(m_commandBufferList[cbIndex], pingpong);
+			GPUProfiler::GetInstance()->EndRecording();
 
-		m_commandBufferList[cbIndex]->EndPrimaryRecording();
+			m_commandBufferList[cbIndex]->EndPrimaryRecording();
+		}
 
 		newCBCreated = false;
 	}
@@ -980,24 +1144,84 @@ void AppEntry::Tick()
 
 	FrameEventManager::GetInstance()->OnPreCmdSubmission();
 
-	FrameWorkManager::GetInstance()->SubmitCommandBuffers(GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::ALL_ROUND), { m_commandBufferList[cbIndex] }, {}, false);
+	GPUProfiler::GetInstance()->SubmitRecording(m_profilerRecordingBase + cbIndex);
+
+	if (m_asyncCompute)
+	{
+		// Graphics work before SSAO -> SSAO and blurs on compute queue -> rest of graphics work
+		FrameWorkManager::SubmissionRef preAsync = FrameWorkManager::GetInstance()->SubmitDependentCommandBuffers(GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::ALL_ROUND), { m_commandBufferList[cbIndex] }, {}, {});
+		FrameWorkManager::SubmissionRef async = FrameWorkManager::GetInstance()->SubmitDependentCommandBuffers(GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::COMPUTE), { m_asyncComputeCommandBufferList[cbIndex] }, { preAsync }, { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT });
+		FrameWorkManager::GetInstance()->SubmitDependentCommandBuffers(GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::ALL_ROUND), { m_postAsyncCommandBufferList[cbIndex] }, { async }, { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT });
+	}
+	else
+		FrameWorkManager::GetInstance()->SubmitCommandBuffers(GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::ALL_ROUND), { m_commandBufferList[cbIndex] }, {}, false);
 	
 	FrameWorkManager::GetInstance()->QueuePresentImage();
 
 	FrameEventManager::GetInstance()->OnFrameEnd();
 
+	// Joined before input of next tick is processed
+	if (pFramePipeline->IsPipelined())
+		pFramePipeline->JoinSimulation();
+
 	pingpong = nextPingpong;
 	frameCount++;
+
+	// Benchmark run quits by itself, exit code tells if steady state allocations are within budget
+	if (AllocationTracker::IsBenchmarkDone())
+		PostQuitMessage(AllocationTracker::IsBenchmarkPassed() ? 0 : 1);
 }
 
 void AppEntry::InitVulkan(HINSTANCE hInstance, WNDPROC wndproc)
 {
 	SetupWindow(hInstance, wndproc);
+
+	bool allocBenchmark = false;
+	for (int32_t i = 0; i < __argc; i++)
+	{
+		if (__argv[i] == std::string("-allocbenchmark"))
+			allocBenchmark = true;
+		else if (__argv[i] == std::string("-allocbudget") && i + 1 < __argc)
+			ALLOC_BENCHMARK_BUDGET = (uint32_t)atoi(__argv[++i]);
+		else if (__argv[i] == std::string("-pipelined"))
+			PIPELINED_FRAME = true;
+		else if (__argv[i] == std::string("-asynccompute"))
+			ASYNC_COMPUTE = true;
+		else if (__argv[i] == std::string("-gpuprofile"))
+			GPU_PROFILE = true;
+		else if (__argv[i] == std::string("-dynamicres"))
+			DYNAMIC_RESOLUTION = true;
+		else if (__argv[i] == std::string("-dynamicrestarget") && i + 1 < __argc)
+			DYNAMIC_RESOLUTION_TARGET_MS = atof(__argv[++i]);
+		else if (__argv[i] == std::string("-gpuculling"))
+			GPU_CULLING = true;
+		else if (__argv[i] == std::string("-hizssr"))
+			HIZ_SSR = true;
+		else if (__argv[i] == std::string("-bloomsinglepass"))
+			BLOOM_SINGLE_PASS = true;
+		else if (__argv[i] == std::string("-fusedssaoblur"))
+			FUSED_SSAO_BLUR = true;
+		else if (__argv[i] == std::string("-fusedmotiontile"))
+			FUSED_MOTION_TILE = true;
+		else if (__argv[i] == std::string("-softwareocclusion"))
+			SOFTWARE_OCCLUSION = true;
+		else if (__argv[i] == std::string("-locallights") && i + 1 < __argc)
+			LOCAL_LIGHT_COUNT = (uint32_t)atoi(__argv[++i]);
+	}
+	if (allocBenchmark)
+		AllocationTracker::StartBenchmark(ALLOC_BENCHMARK_WARMUP_FRAMES, ALLOC_BENCHMARK_MEASURE_FRAMES, ALLOC_BENCHMARK_BUDGET);
+
 	InitVulkanInstance();
 	InitPhysicalDevice(m_hPlatformInst, m_hWindow);
 	InitVulkanDevice();
 	GlobalDeviceObjects::GetInstance()->InitObjects(m_pDevice);
 
+	// Batch one-time gpu work(layout transitions, uploads, precomputation) until setup is done
+	InitCmdBatcher()->BeginBatch();
+
+	// Meshes only keep data for occluder geometry if software occlusion culling is enabled
+	CullingManager::GetInstance()->SetOcclusionCullingEnabled(SOFTWARE_OCCLUSION);
+
 	InitVertices();
 	InitUniforms();
 	InitDrawCmdBuffers();
@@ -64,9 +64,12 @@ public:
 	void InitMaterials();
 	void InitScene();
 	void EndSetup();
+	void Simulate();
+	void AllocateFrameCommandBuffers(uint32_t cbIndex, CommandPool::CBPersistancy persistancy);
 
 	void Tick();
 	void Update();
+	int GetExitCode() const { return m_exitCode; }
 
 public:
 	std::shared_ptr<Instance>			m_pVulkanInstance;
@@ -168,8 +171,10 @@ public:
 	std::shared_ptr<MaterialInstance>	m_pSophiaMaterialInstance;
 	std::shared_ptr<MaterialInstance>   m_pPlanetMaterialInstance;
 
-	std::shared_ptr<MaterialInstance>	m_pShadowMapMaterialInstance;
-	std::shared_ptr<MaterialInstance>	m_pSkinnedShadowMapMaterialInstance;
+	// One per shadow cascade
+	std::vector<std::shared_ptr<MaterialInstance>> m_shadowMapMaterialInstances;
+	std::vector<std::shared_ptr<MaterialInstance>> m_skinnedShadowMapMaterialInstances;
+	std::vector<std::shared_ptr<MaterialInstance>> m_staticShadowMapMaterialInstances;
 
 	std::shared_ptr<BaseObject>			m_pSkyBoxObject;
 	std::shared_ptr<MeshRenderer>		m_pSkyBoxMeshRenderer;
@@ -189,11 +194,23 @@ public:
 	std::shared_ptr<BaseObject>			m_pSceneRootObject;
 
 	std::vector<std::shared_ptr<CommandBuffer>> m_commandBufferList;
+	std::vector<std::shared_ptr<CommandBuffer>> m_asyncComputeCommandBufferList;
+	std::vector<std::shared_ptr<CommandBuffer>> m_postAsyncCommandBufferList;
+	// Dynamic resolution scale level each prebaked command buffer is recorded with
+	std::vector<uint32_t>				m_recordedScaleLevels;
+	// Gpu profiler recording of frame command buffer "i" is "m_profilerRecordingBase + i"
+	uint32_t							m_profilerRecordingBase = 0;
+	bool								m_asyncCompute = false;
 
 #if defined(_WIN32)
 	HINSTANCE							m_hPlatformInst;
 	HWND								m_hWindow;
 #endif
 
+	int									m_exitCode = 0;
+
 	void AddBoneBox(const std::shared_ptr<BaseObject>& pObject);
+	// "pMaterialInstance" followed by shadow map material instances of all cascades, and static shadow cache ones if not skinned
+	// Renderer decides which ones are used by whether it's a static caster
+	std::vector<std::shared_ptr<MaterialInstance>> ShadowCastingMaterialInstances(const std::shared_ptr<MaterialInstance>& pMaterialInstance, bool skinned = false) const;
 };
\ No newline at end of file
@@ -0,0 +1,187 @@
+#include "AtmosphereLUTCache.h"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <limits>
+
+uint64_t AtmosphereLUTCache::FNV1a(const void* pData, std::size_t numBytes, uint64_t hash)
+{
+	const uint8_t* pBytes = (const uint8_t*)pData;
+	for (std::size_t i = 0; i < numBytes; i++)
+	{
+		hash ^= pBytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+uint64_t AtmosphereLUTCache::HashParameters(const AtmosphereParameters<float>& parameters)
+{
+	uint32_t settings[] =
+	{
+		CACHE_VERSION,
+		TRANSMITTANCE_TEXTURE_WIDTH, TRANSMITTANCE_TEXTURE_HEIGHT,
+		SCATTERING_TEXTURE_R_SIZE, SCATTERING_TEXTURE_MU_SIZE, SCATTERING_TEXTURE_MU_S_SIZE, SCATTERING_TEXTURE_NU_SIZE,
+		IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT,
+		ATMOSPHERE_MAX_SCATTER_ORDER
+	};
+
+	// Parameters are plain floats without any padding, hashing raw bytes is fine
+	uint64_t hash = FNV1a(&parameters, sizeof(parameters));
+	return FNV1a(settings, sizeof(settings), hash);
+}
+
+std::filesystem::path AtmosphereLUTCache::GetCacheDirectory()
+{
+	return std::filesystem::path("..") / "data" / "cache";
+}
+
+std::filesystem::path AtmosphereLUTCache::GetCachePath(uint64_t parameterHash)
+{
+	std::stringstream ss;
+	ss << "atmosphere_" << std::hex << std::setw(16) << std::setfill('0') << parameterHash << ".lut";
+	return GetCacheDirectory() / ss.str();
+}
+
+void AtmosphereLUTCache::AllocateLUTs(AtmosphereLUTs& luts)
+{
+	luts.transmittance.assign(TRANSMITTANCE_TEXTURE_WIDTH * TRANSMITTANCE_TEXTURE_HEIGHT * 4, 0.0f);
+	luts.scatter.assign(SCATTERING_TEXTURE_WIDTH * SCATTERING_TEXTURE_HEIGHT * SCATTERING_TEXTURE_DEPTH * 4, 0.0f);
+	luts.irradiance.assign(IRRADIANCE_TEXTURE_WIDTH * IRRADIANCE_TEXTURE_HEIGHT * 4, 0.0f);
+}
+
+bool AtmosphereLUTCache::Load(uint64_t parameterHash, AtmosphereLUTs& luts)
+{
+	std::ifstream ifs;
+	ifs.open(GetCachePath(parameterHash), std::ios::binary);
+	if (ifs.fail())
+		return false;
+
+	CacheHeader header = {};
+	ifs.read((char*)&header, sizeof(header));
+	if (ifs.fail())
+		return false;
+
+	if (header.magic != CACHE_MAGIC ||
+		header.version != CACHE_VERSION ||
+		header.parameterHash != parameterHash ||
+		header.transmittanceSize[0] != TRANSMITTANCE_TEXTURE_WIDTH || header.transmittanceSize[1] != TRANSMITTANCE_TEXTURE_HEIGHT ||
+		header.scatterSize[0] != SCATTERING_TEXTURE_WIDTH || header.scatterSize[1] != SCATTERING_TEXTURE_HEIGHT || header.scatterSize[2] != SCATTERING_TEXTURE_DEPTH ||
+		header.irradianceSize[0] != IRRADIANCE_TEXTURE_WIDTH || header.irradianceSize[1] != IRRADIANCE_TEXTURE_HEIGHT ||
+		header.maxScatterOrder != ATMOSPHERE_MAX_SCATTER_ORDER)
+		return false;
+
+	uint32_t transmittanceTexels = TRANSMITTANCE_TEXTURE_WIDTH * TRANSMITTANCE_TEXTURE_HEIGHT;
+	uint32_t scatterTexels = SCATTERING_TEXTURE_WIDTH * SCATTERING_TEXTURE_HEIGHT * SCATTERING_TEXTURE_DEPTH;
+	uint32_t irradianceTexels = IRRADIANCE_TEXTURE_WIDTH * IRRADIANCE_TEXTURE_HEIGHT;
+
+	uint64_t payloadFloats = transmittanceTexels * 3 + scatterTexels * 4 + irradianceTexels * 3;
+	if (header.payloadBytes != payloadFloats * sizeof(float))
+		return false;
+
+	std::vector<float> payload(payloadFloats);
+	ifs.read((char*)payload.data(), header.payloadBytes);
+	if (ifs.fail())
+		return false;
+
+	// A partially written file is rejected here
+	if (FNV1a(payload.data(), header.payloadBytes) != header.payloadChecksum)
+		return false;
+
+	AllocateLUTs(luts);
+
+	const float* pSrc = payload.data();
+	for (uint32_t i = 0; i < transmittanceTexels; i++, pSrc += 3)
+	{
+		luts.transmittance[i * 4 + 0] = pSrc[0];
+		luts.transmittance[i * 4 + 1] = pSrc[1];
+		luts.transmittance[i * 4 + 2] = pSrc[2];
+	}
+
+	memcpy(luts.scatter.data(), pSrc, scatterTexels * 4 * sizeof(float));
+	pSrc += scatterTexels * 4;
+
+	for (uint32_t i = 0; i < irradianceTexels; i++, pSrc += 3)
+	{
+		luts.irradiance[i * 4 + 0] = pSrc[0];
+		luts.irradiance[i * 4 + 1] = pSrc[1];
+		luts.irradiance[i * 4 + 2] = pSrc[2];
+	}
+
+	return true;
+}
+
+bool AtmosphereLUTCache::Save(uint64_t parameterHash, const AtmosphereLUTs& luts)
+{
+	uint32_t transmittanceTexels = TRANSMITTANCE_TEXTURE_WIDTH * TRANSMITTANCE_TEXTURE_HEIGHT;
+	uint32_t scatterTexels = SCATTERING_TEXTURE_WIDTH * SCATTERING_TEXTURE_HEIGHT * SCATTERING_TEXTURE_DEPTH;
+	uint32_t irradianceTexels = IRRADIANCE_TEXTURE_WIDTH * IRRADIANCE_TEXTURE_HEIGHT;
+
+	if (luts.transmittance.size() != transmittanceTexels * 4 ||
+		luts.scatter.size() != scatterTexels * 4 ||
+		luts.irradiance.size() != irradianceTexels * 4)
+		return false;
+
+	std::vector<float> payload;
+	payload.reserve(transmittanceTexels * 3 + scatterTexels * 4 + irradianceTexels * 3);
+
+	for (uint32_t i = 0; i < transmittanceTexels; i++)
+		payload.insert(payload.end(), luts.transmittance.begin() + i * 4, luts.transmittance.begin() + i * 4 + 3);
+	payload.insert(payload.end(), luts.scatter.begin(), luts.scatter.end());
+	for (uint32_t i = 0; i < irradianceTexels; i++)
+		payload.insert(payload.end(), luts.irradiance.begin() + i * 4, luts.irradiance.begin() + i * 4 + 3);
+
+	CacheHeader header =
+	{
+		CACHE_MAGIC,
+		CACHE_VERSION,
+		parameterHash,
+		{ TRANSMITTANCE_TEXTURE_WIDTH, TRANSMITTANCE_TEXTURE_HEIGHT },
+		{ SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT, SCATTERING_TEXTURE_DEPTH },
+		{ IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT },
+		ATMOSPHERE_MAX_SCATTER_ORDER,
+		payload.size() * sizeof(float),
+		0
+	};
+	header.payloadChecksum = FNV1a(payload.data(), header.payloadBytes);
+
+	// Nothing to do if it already exists, failing to create it shows up as failing to open the file
+	std::error_code error;
+	std::filesystem::create_directories(GetCacheDirectory(), error);
+
+	std::ofstream ofs;
+	ofs.open(GetCachePath(parameterHash), std::ios::binary | std::ios::trunc);
+	if (ofs.fail())
+		return false;
+
+	ofs.write((const char*)&header, sizeof(header));
+	ofs.write((const char*)payload.data(), header.payloadBytes);
+	return !ofs.fail();
+}
+
+double AtmosphereLUTCache::Compare(const AtmosphereLUTs& luts0, const AtmosphereLUTs& luts1)
+{
+	const std::vector<float>* tables0[] = { &luts0.transmittance, &luts0.scatter, &luts0.irradiance };
+	const std::vector<float>* tables1[] = { &luts1.transmittance, &luts1.scatter, &luts1.irradiance };
+
+	double maxError = 0;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		if (tables0[i]->size() != tables1[i]->size())
+			return (std::numeric_limits<double>::max)();
+
+		double maxMagnitude = 0;
+		double maxDiff = 0;
+		for (std::size_t j = 0; j < tables0[i]->size(); j++)
+		{
+			maxMagnitude = (std::max)(maxMagnitude, (double)std::abs((*tables0[i])[j]));
+			maxDiff = (std::max)(maxDiff, (double)std::abs((*tables0[i])[j] - (*tables1[i])[j]));
+		}
+
+		if (maxMagnitude > 0)
+			maxError = (std::max)(maxError, maxDiff / maxMagnitude);
+	}
+
+	return maxError;
+}
\ No newline at end of file
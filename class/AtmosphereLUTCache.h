@@ -0,0 +1,72 @@
+#pragma once
+
+#include "PerPlanetUniforms.h"
+#include <string>
+#include <filesystem>
+
+// Sizes of precomputed atmosphere tables, they have to match atmosphere/header.sh
+const static uint32_t TRANSMITTANCE_TEXTURE_WIDTH = 256;
+const static uint32_t TRANSMITTANCE_TEXTURE_HEIGHT = 64;
+const static uint32_t SCATTERING_TEXTURE_R_SIZE = 32;
+const static uint32_t SCATTERING_TEXTURE_MU_SIZE = 128;
+const static uint32_t SCATTERING_TEXTURE_MU_S_SIZE = 32;
+const static uint32_t SCATTERING_TEXTURE_NU_SIZE = 8;
+const static uint32_t SCATTERING_TEXTURE_WIDTH = SCATTERING_TEXTURE_NU_SIZE * SCATTERING_TEXTURE_MU_S_SIZE;
+const static uint32_t SCATTERING_TEXTURE_HEIGHT = SCATTERING_TEXTURE_MU_SIZE;
+const static uint32_t SCATTERING_TEXTURE_DEPTH = SCATTERING_TEXTURE_R_SIZE;
+const static uint32_t IRRADIANCE_TEXTURE_WIDTH = 64;
+const static uint32_t IRRADIANCE_TEXTURE_HEIGHT = 16;
+const static uint32_t ATMOSPHERE_MAX_SCATTER_ORDER = 4;
+
+// Final atmosphere tables of one planet, texels are tightly packed rgba floats, same as RGBA32F images precompute writes to
+class AtmosphereLUTs
+{
+public:
+	std::vector<float>	transmittance;
+	std::vector<float>	scatter;
+	std::vector<float>	irradiance;
+};
+
+// On disk cache of precomputed atmosphere tables
+// A cache file is keyed by a hash of single precision atmosphere parameters(exactly what precompute shaders consume),
+// table sizes, max scatter order and cache version, so any change of them simply leads to a cache miss
+// File layout:
+// 1. Header
+// 2. Transmittance, rgb only, alpha is always 0
+// 3. Scatter, rgba, alpha holds single mie scattering red channel
+// 4. Irradiance, rgb only, alpha is always 0
+class AtmosphereLUTCache
+{
+public:
+	// Bump it whenever precompute shaders change
+	static const uint32_t CACHE_VERSION = 1;
+	static const uint32_t CACHE_MAGIC = 0x54554C41;	// "ALUT"
+
+	typedef struct _CacheHeader
+	{
+		uint32_t	magic;
+		uint32_t	version;
+		uint64_t	parameterHash;
+		uint32_t	transmittanceSize[2];
+		uint32_t	scatterSize[3];
+		uint32_t	irradianceSize[2];
+		uint32_t	maxScatterOrder;
+		uint64_t	payloadBytes;
+		uint64_t	payloadChecksum;
+	}CacheHeader;
+
+public:
+	static uint64_t HashParameters(const AtmosphereParameters<float>& parameters);
+	// Directory shared by on disk caches, relative to working directory, created when a cache file is saved
+	static std::filesystem::path GetCacheDirectory();
+	static std::filesystem::path GetCachePath(uint64_t parameterHash);
+
+	static bool Load(uint64_t parameterHash, AtmosphereLUTs& luts);
+	static bool Save(uint64_t parameterHash, const AtmosphereLUTs& luts);
+
+	static void AllocateLUTs(AtmosphereLUTs& luts);
+	// Largest texel difference relative to largest texel magnitude, over all tables
+	static double Compare(const AtmosphereLUTs& luts0, const AtmosphereLUTs& luts1);
+
+	static uint64_t FNV1a(const void* pData, std::size_t numBytes, uint64_t hash = 0xcbf29ce484222325ull);
+};
\ No newline at end of file
@@ -0,0 +1,683 @@
+#include "AtmosphereReferenceBaker.h"
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <thread>
+
+static const float PI = 3.1415926535897932384626433832795f;
+
+static float ClampCosine(float mu)
+{
+	return (std::min)((std::max)(mu, -1.0f), 1.0f);
+}
+
+static float ClampDistance(float d)
+{
+	return (std::max)(d, 0.0f);
+}
+
+static float SafeSqrt(float a)
+{
+	return std::sqrt((std::max)(a, 0.0f));
+}
+
+static float SmoothStep(float edge0, float edge1, float x)
+{
+	float t = (std::min)((std::max)((x - edge0) / (edge1 - edge0), 0.0f), 1.0f);
+	return t * t * (3.0f - 2.0f * t);
+}
+
+static float GetTextureCoordFromUnitRange(float x, uint32_t textureSize)
+{
+	return 0.5f / float(textureSize) + x * (1.0f - 1.0f / float(textureSize));
+}
+
+static float GetUnitRangeFromTextureCoord(float u, uint32_t textureSize)
+{
+	return (u - 0.5f / float(textureSize)) / (1.0f - 1.0f / float(textureSize));
+}
+
+static void GetLinearSampleTexels(float coord, uint32_t size, uint32_t& i0, uint32_t& i1, float& frac)
+{
+	float t = coord * float(size) - 0.5f;
+	float fl = std::floor(t);
+	frac = t - fl;
+
+	int32_t i = (int32_t)fl;
+	i0 = (uint32_t)(std::min)((std::max)(i, 0), (int32_t)size - 1);
+	i1 = (uint32_t)(std::min)((std::max)(i + 1, 0), (int32_t)size - 1);
+}
+
+AtmosphereReferenceBaker::Spectrum AtmosphereReferenceBaker::Spectrum::Exp(const Spectrum& s)
+{
+	float f[4];
+	_mm_storeu_ps(f, s.v);
+	return _mm_setr_ps(std::exp(f[0]), std::exp(f[1]), std::exp(f[2]), std::exp(f[3]));
+}
+
+void AtmosphereReferenceBaker::Texture::Allocate(uint32_t _width, uint32_t _height, uint32_t _depth)
+{
+	width = _width;
+	height = _height;
+	depth = _depth;
+	texels.assign(width * height * depth * 4, 0.0f);
+}
+
+void AtmosphereReferenceBaker::Texture::Store(uint32_t x, uint32_t y, uint32_t z, const Spectrum& rgb, float a)
+{
+	float* pTexel = &texels[((z * height + y) * width + x) * 4];
+	_mm_storeu_ps(pTexel, rgb.v);
+	pTexel[3] = a;
+}
+
+void AtmosphereReferenceBaker::Texture::Load(uint32_t x, uint32_t y, uint32_t z, Spectrum& rgb, float& a) const
+{
+	const float* pTexel = &texels[((z * height + y) * width + x) * 4];
+	rgb = _mm_loadu_ps(pTexel);
+	a = pTexel[3];
+}
+
+AtmosphereReferenceBaker::Spectrum AtmosphereReferenceBaker::Texture::Sample(float u, float v) const
+{
+	uint32_t x0, x1, y0, y1;
+	float fx, fy;
+	GetLinearSampleTexels(u, width, x0, x1, fx);
+	GetLinearSampleTexels(v, height, y0, y1, fy);
+
+	__m128 t00 = _mm_loadu_ps(&texels[(y0 * width + x0) * 4]);
+	__m128 t10 = _mm_loadu_ps(&texels[(y0 * width + x1) * 4]);
+	__m128 t01 = _mm_loadu_ps(&texels[(y1 * width + x0) * 4]);
+	__m128 t11 = _mm_loadu_ps(&texels[(y1 * width + x1) * 4]);
+
+	__m128 wx = _mm_set1_ps(fx);
+	__m128 wy = _mm_set1_ps(fy);
+	__m128 t0 = _mm_add_ps(t00, _mm_mul_ps(_mm_sub_ps(t10, t00), wx));
+	__m128 t1 = _mm_add_ps(t01, _mm_mul_ps(_mm_sub_ps(t11, t01), wx));
+	return _mm_add_ps(t0, _mm_mul_ps(_mm_sub_ps(t1, t0), wy));
+}
+
+AtmosphereReferenceBaker::Spectrum AtmosphereReferenceBaker::Texture::Sample(float u, float v, float w, float* pAlpha) const
+{
+	uint32_t x0, x1, y0, y1, z0, z1;
+	float fx, fy, fz;
+	GetLinearSampleTexels(u, width, x0, x1, fx);
+	GetLinearSampleTexels(v, height, y0, y1, fy);
+	GetLinearSampleTexels(w, depth, z0, z1, fz);
+
+	__m128 wx = _mm_set1_ps(fx);
+	__m128 wy = _mm_set1_ps(fy);
+	__m128 wz = _mm_set1_ps(fz);
+
+	__m128 slices[2];
+	uint32_t zs[2] = { z0, z1 };
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		const float* pSlice = &texels[zs[i] * width * height * 4];
+		__m128 t00 = _mm_loadu_ps(pSlice + (y0 * width + x0) * 4);
+		__m128 t10 = _mm_loadu_ps(pSlice + (y0 * width + x1) * 4);
+		__m128 t01 = _mm_loadu_ps(pSlice + (y1 * width + x0) * 4);
+		__m128 t11 = _mm_loadu_ps(pSlice + (y1 * width + x1) * 4);
+
+		__m128 t0 = _mm_add_ps(t00, _mm_mul_ps(_mm_sub_ps(t10, t00), wx));
+		__m128 t1 = _mm_add_ps(t01, _mm_mul_ps(_mm_sub_ps(t11, t01), wx));
+		slices[i] = _mm_add_ps(t0, _mm_mul_ps(_mm_sub_ps(t1, t0), wy));
+	}
+
+	Spectrum result = _mm_add_ps(slices[0], _mm_mul_ps(_mm_sub_ps(slices[1], slices[0]), wz));
+	if (pAlpha)
+		*pAlpha = result[3];
+	return result;
+}
+
+AtmosphereReferenceBaker::AtmosphereReferenceBaker(const AtmosphereParameters<float>& parameters, uint32_t workerCount)
+	: m_atmosphere(parameters)
+{
+	m_workerCount = workerCount == 0 ? (std::max)(std::thread::hardware_concurrency(), 1u) : workerCount;
+}
+
+void AtmosphereReferenceBaker::Bake(const AtmosphereParameters<float>& parameters, AtmosphereLUTs& luts, uint32_t workerCount)
+{
+	AtmosphereReferenceBaker baker(parameters, workerCount);
+	baker.BakeAll(luts);
+}
+
+template <typename Func>
+void AtmosphereReferenceBaker::ExecutePass(const Texture& texture, Func func) const
+{
+	// 3d textures are split by depth slice, 2d ones by row
+	uint32_t sliceCount = texture.depth > 1 ? texture.depth : texture.height;
+	uint32_t taskCount = (std::min)(m_workerCount, sliceCount);
+
+	std::vector<std::future<void>> tasks;
+	for (uint32_t i = 0; i < taskCount; i++)
+	{
+		tasks.push_back(std::async(std::launch::async, [&texture, &func, i, taskCount, sliceCount]()
+		{
+			for (uint32_t slice = i; slice < sliceCount; slice += taskCount)
+			{
+				if (texture.depth > 1)
+				{
+					for (uint32_t y = 0; y < texture.height; y++)
+						for (uint32_t x = 0; x < texture.width; x++)
+							func(x, y, slice);
+				}
+				else
+				{
+					for (uint32_t x = 0; x < texture.width; x++)
+						func(x, slice, 0);
+				}
+			}
+		}));
+	}
+
+	for (auto& task : tasks)
+		task.wait();
+}
+
+void AtmosphereReferenceBaker::BakeAll(AtmosphereLUTs& luts)
+{
+	m_transmittance.Allocate(TRANSMITTANCE_TEXTURE_WIDTH, TRANSMITTANCE_TEXTURE_HEIGHT, 1);
+	m_scatter.Allocate(SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT, SCATTERING_TEXTURE_DEPTH);
+	m_irradiance.Allocate(IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT, 1);
+	m_deltaIrradiance.Allocate(IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT, 1);
+	m_deltaRayleigh.Allocate(SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT, SCATTERING_TEXTURE_DEPTH);
+	m_deltaMie.Allocate(SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT, SCATTERING_TEXTURE_DEPTH);
+	m_deltaScatterDensity.Allocate(SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT, SCATTERING_TEXTURE_DEPTH);
+	m_deltaMultiScatter.Allocate(SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT, SCATTERING_TEXTURE_DEPTH);
+
+	// 1. Transmittance
+	ExecutePass(m_transmittance, [this](uint32_t x, uint32_t y, uint32_t z)
+	{
+		float r, mu;
+		GetRMuFromTransmittanceTextureUv((x + 0.5f) / TRANSMITTANCE_TEXTURE_WIDTH, (y + 0.5f) / TRANSMITTANCE_TEXTURE_HEIGHT, r, mu);
+		m_transmittance.Store(x, y, z, ComputeTransmittanceToTopAtmosphereBoundary(r, mu));
+	});
+
+	// 2. Single scattering
+	ExecutePass(m_scatter, [this](uint32_t x, uint32_t y, uint32_t z)
+	{
+		float r, mu, muS, nu;
+		bool rayIntersectsGround;
+		GetRMuMuSNuFromScatteringTextureFragCoord(x, y, z, r, mu, muS, nu, rayIntersectsGround);
+
+		Spectrum rayleigh, mie;
+		ComputeSingleScattering(r, mu, muS, nu, rayIntersectsGround, rayleigh, mie);
+
+		m_deltaRayleigh.Store(x, y, z, rayleigh);
+		m_deltaMie.Store(x, y, z, mie);
+		m_scatter.Store(x, y, z, rayleigh, mie[0]);
+	});
+
+	// 3. Direct irradiance
+	ExecutePass(m_irradiance, [this](uint32_t x, uint32_t y, uint32_t z)
+	{
+		float r, muS;
+		GetRMuSFromIrradianceTextureUv((x + 0.5f) / IRRADIANCE_TEXTURE_WIDTH, (y + 0.5f) / IRRADIANCE_TEXTURE_HEIGHT, r, muS);
+		m_deltaIrradiance.Store(x, y, z, ComputeDirectIrradiance(r, muS));
+		m_irradiance.Store(x, y, z, Spectrum());
+	});
+
+	// 4. Multi scatter
+	for (int scatterOrder = 2; scatterOrder <= (int)ATMOSPHERE_MAX_SCATTER_ORDER; scatterOrder++)
+	{
+		// 4.1 Delta scatter density
+		ExecutePass(m_deltaScatterDensity, [this, scatterOrder](uint32_t x, uint32_t y, uint32_t z)
+		{
+			float r, mu, muS, nu;
+			bool rayIntersectsGround;
+			GetRMuMuSNuFromScatteringTextureFragCoord(x, y, z, r, mu, muS, nu, rayIntersectsGround);
+			m_deltaScatterDensity.Store(x, y, z, ComputeScatteringDensity(r, mu, muS, nu, scatterOrder));
+		});
+
+		// 4.2 Indirect irradiance
+		ExecutePass(m_deltaIrradiance, [this, scatterOrder](uint32_t x, uint32_t y, uint32_t z)
+		{
+			float r, muS;
+			GetRMuSFromIrradianceTextureUv((x + 0.5f) / IRRADIANCE_TEXTURE_WIDTH, (y + 0.5f) / IRRADIANCE_TEXTURE_HEIGHT, r, muS);
+			Spectrum deltaIrradiance = ComputeIndirectIrradiance(r, muS, scatterOrder - 1);
+
+			Spectrum accumulated;
+			float alpha;
+			m_irradiance.Load(x, y, z, accumulated, alpha);
+
+			m_deltaIrradiance.Store(x, y, z, deltaIrradiance);
+			m_irradiance.Store(x, y, z, accumulated + deltaIrradiance, alpha);
+		});
+
+		// 4.3 Multi scatter
+		ExecutePass(m_deltaMultiScatter, [this](uint32_t x, uint32_t y, uint32_t z)
+		{
+			float r, mu, muS, nu;
+			bool rayIntersectsGround;
+			GetRMuMuSNuFromScatteringTextureFragCoord(x, y, z, r, mu, muS, nu, rayIntersectsGround);
+			Spectrum deltaMultiScatter = ComputeMultipleScattering(r, mu, muS, nu, rayIntersectsGround);
+
+			Spectrum accumulated;
+			float alpha;
+			m_scatter.Load(x, y, z, accumulated, alpha);
+
+			m_deltaMultiScatter.Store(x, y, z, deltaMultiScatter);
+			m_scatter.Store(x, y, z, accumulated + deltaMultiScatter / RayleighPhaseFunction(nu), alpha);
+		});
+	}
+
+	luts.transmittance = m_transmittance.texels;
+	luts.scatter = m_scatter.texels;
+	luts.irradiance = m_irradiance.texels;
+}
+
+float AtmosphereReferenceBaker::ClampRadius(float r) const
+{
+	return (std::min)((std::max)(r, m_atmosphere.variables.x), m_atmosphere.variables.y);
+}
+
+float AtmosphereReferenceBaker::DistanceToTopAtmosphereBoundary(float r, float mu) const
+{
+	float discriminant = r * r * (mu * mu - 1.0f) + m_atmosphere.variables.y * m_atmosphere.variables.y;
+	return ClampDistance(-r * mu + SafeSqrt(discriminant));
+}
+
+float AtmosphereReferenceBaker::DistanceToBottomAtmosphereBoundary(float r, float mu) const
+{
+	float discriminant = r * r * (mu * mu - 1.0f) + m_atmosphere.variables.x * m_atmosphere.variables.x;
+	return ClampDistance(-r * mu - SafeSqrt(discriminant));
+}
+
+float AtmosphereReferenceBaker::DistanceToNearestAtmosphereBoundary(float r, float mu, bool rayIntersectsGround) const
+{
+	if (rayIntersectsGround)
+		return DistanceToBottomAtmosphereBoundary(r, mu);
+	else
+		return DistanceToTopAtmosphereBoundary(r, mu);
+}
+
+bool AtmosphereReferenceBaker::RayIntersectsGround(float r, float mu) const
+{
+	return mu < 0.0f && r * r * (mu * mu - 1.0f) + m_atmosphere.variables.x * m_atmosphere.variables.x >= 0.0f;
+}
+
+float AtmosphereReferenceBaker::GetLayerDensity(const DensityProfileLayerf& layer, float altitude)
+{
+	float density = layer.expTerm * std::exp(layer.expScale * altitude) + layer.linearTerm * altitude + layer.constantTerm;
+	return (std::min)((std::max)(density, 0.0f), 1.0f);
+}
+
+float AtmosphereReferenceBaker::GetProfileDensity(const DensityProfilef& profile, float altitude)
+{
+	return altitude < profile.layers[0].width ? GetLayerDensity(profile.layers[0], altitude) : GetLayerDensity(profile.layers[1], altitude);
+}
+
+float AtmosphereReferenceBaker::ComputeOpticalLengthToTopAtmosphereBoundary(const DensityProfilef& profile, float r, float mu) const
+{
+	const int SAMPLE_COUNT = 500;
+	float dx = DistanceToTopAtmosphereBoundary(r, mu) / float(SAMPLE_COUNT);
+
+	float result = 0.0f;
+	for (int i = 0; i <= SAMPLE_COUNT; ++i)
+	{
+		float d_i = float(i) * dx;
+		float r_i = std::sqrt(d_i * d_i + 2.0f * r * mu * d_i + r * r);
+		float y_i = GetProfileDensity(profile, r_i - m_atmosphere.variables.x);
+		float weight_i = i == 0 || i == SAMPLE_COUNT ? 0.5f : 1.0f;
+		result += y_i * weight_i * dx;
+	}
+	return result;
+}
+
+AtmosphereReferenceBaker::Spectrum AtmosphereReferenceBaker::ComputeTransmittanceToTopAtmosphereBoundary(float r, float mu) const
+{
+	Spectrum opticalDepth =
+		Spectrum(m_atmosphere.rayleighScattering) * ComputeOpticalLengthToTopAtmosphereBoundary(m_atmosphere.rayleighDensity, r, mu) +
+		Spectrum(m_atmosphere.mieExtinction) * ComputeOpticalLengthToTopAtmosphereBoundary(m_atmosphere.mieDensity, r, mu) +
+		Spectrum(m_atmosphere.absorptionExtinction) * ComputeOpticalLengthToTopAtmosphereBoundary(m_atmosphere.absorptionDensity, r, mu);
+	return Spectrum::Exp(Spectrum() - opticalDepth);
+}
+
+void AtmosphereReferenceBaker::GetTransmittanceTextureUvFromRMu(float r, float mu, float& u, float& v) const
+{
+	float H = std::sqrt(m_atmosphere.variables.y * m_atmosphere.variables.y - m_atmosphere.variables.x * m_atmosphere.variables.x);
+	float rho = SafeSqrt(r * r - m_atmosphere.variables.x * m_atmosphere.variables.x);
+	float d = DistanceToTopAtmosphereBoundary(r, mu);
+	float d_min = m_atmosphere.variables.y - r;
+	float d_max = rho + H;
+	float x_mu = (d - d_min) / (d_max - d_min);
+	float x_r = rho / H;
+	u = GetTextureCoordFromUnitRange(x_mu, TRANSMITTANCE_TEXTURE_WIDTH);
+	v = GetTextureCoordFromUnitRange(x_r, TRANSMITTANCE_TEXTURE_HEIGHT);
+}
+
+void AtmosphereReferenceBaker::GetRMuFromTransmittanceTextureUv(float u, float v, float& r, float& mu) const
+{
+	float x_mu = GetUnitRangeFromTextureCoord(u, TRANSMITTANCE_TEXTURE_WIDTH);
+	float x_r = GetUnitRangeFromTextureCoord(v, TRANSMITTANCE_TEXTURE_HEIGHT);
+	float H = std::sqrt(m_atmosphere.variables.y * m_atmosphere.variables.y - m_atmosphere.variables.x * m_atmosphere.variables.x);
+	float rho = H * x_r;
+	r = std::sqrt(rho * rho + m_atmosphere.variables.x * m_atmosphere.variables.x);
+	float d_min = m_atmosphere.variables.y - r;
+	float d_max = rho + H;
+	float d = d_min + x_mu * (d_max - d_min);
+	mu = d == 0.0f ? 1.0f : (H * H - rho * rho - d * d) / (2.0f * r * d);
+	mu = ClampCosine(mu);
+}
+
+AtmosphereReferenceBaker::Spectrum AtmosphereReferenceBaker::GetTransmittanceToTopAtmosphereBoundary(float r, float mu) const
+{
+	float u, v;
+	GetTransmittanceTextureUvFromRMu(r, mu, u, v);
+	return m_transmittance.Sample(u, v);
+}
+
+AtmosphereReferenceBaker::Spectrum AtmosphereReferenceBaker::GetTransmittance(float r, float mu, float d, bool rayIntersectsGround) const
+{
+	float r_d = ClampRadius(std::sqrt(d * d + 2.0f * r * mu * d + r * r));
+	float mu_d = ClampCosine((r * mu + d) / r_d);
+	if (rayIntersectsGround)
+		return Spectrum::Min(GetTransmittanceToTopAtmosphereBoundary(r_d, -mu_d) / GetTransmittanceToTopAtmosphereBoundary(r, -mu), 1.0f);
+	else
+		return Spectrum::Min(GetTransmittanceToTopAtmosphereBoundary(r, mu) / GetTransmittanceToTopAtmosphereBoundary(r_d, mu_d), 1.0f);
+}
+
+AtmosphereReferenceBaker::Spectrum AtmosphereReferenceBaker::GetTransmittanceToSun(float r, float muS) const
+{
+	float sin_theta_h = m_atmosphere.variables.x / r;
+	float cos_theta_h = -std::sqrt((std::max)(1.0f - sin_theta_h * sin_theta_h, 0.0f));
+	return GetTransmittanceToTopAtmosphereBoundary(r, muS) *
+		SmoothStep(-sin_theta_h * m_atmosphere.solarIrradiance.w, sin_theta_h * m_atmosphere.solarIrradiance.w, muS - cos_theta_h);
+}
+
+void AtmosphereReferenceBaker::ComputeSingleScattering(float r, float mu, float muS, float nu, bool rayIntersectsGround, Spectrum& rayleigh, Spectrum& mie) const
+{
+	const int SAMPLE_COUNT = 50;
+	float dx = DistanceToNearestAtmosphereBoundary(r, mu, rayIntersectsGround) / float(SAMPLE_COUNT);
+
+	Spectrum rayleigh_sum, mie_sum;
+	for (int i = 0; i <= SAMPLE_COUNT; ++i)
+	{
+		float d_i = float(i) * dx;
+
+		// ComputeSingleScatteringIntegrand
+		float r_d = ClampRadius(std::sqrt(d_i * d_i + 2.0f * r * mu * d_i + r * r));
+		float mu_s_d = ClampCosine((r * muS + d_i * nu) / r_d);
+		Spectrum transmittance = GetTransmittance(r, mu, d_i, rayIntersectsGround) * GetTransmittanceToSun(r_d, mu_s_d);
+		Spectrum rayleigh_i = transmittance * GetProfileDensity(m_atmosphere.rayleighDensity, r_d - m_atmosphere.variables.x);
+		Spectrum mie_i = transmittance * GetProfileDensity(m_atmosphere.mieDensity, r_d - m_atmosphere.variables.x);
+
+		float weight_i = (i == 0 || i == SAMPLE_COUNT) ? 0.5f : 1.0f;
+		rayleigh_sum += rayleigh_i * weight_i;
+		mie_sum += mie_i * weight_i;
+	}
+
+	rayleigh = rayleigh_sum * dx * Spectrum(m_atmosphere.solarIrradiance) * Spectrum(m_atmosphere.rayleighScattering);
+	mie = mie_sum * dx * Spectrum(m_atmosphere.solarIrradiance) * Spectrum(m_atmosphere.mieScattering);
+}
+
+float AtmosphereReferenceBaker::RayleighPhaseFunction(float nu)
+{
+	float k = 3.0f / (16.0f * PI);
+	return k * (1.0f + nu * nu);
+}
+
+float AtmosphereReferenceBaker::MiePhaseFunction(float g, float nu)
+{
+	float k = 3.0f / (8.0f * PI) * (1.0f - g * g) / (2.0f + g * g);
+	return k * (1.0f + nu * nu) / std::pow(1.0f + g * g - 2.0f * g * nu, 1.5f);
+}
+
+void AtmosphereReferenceBaker::GetScatteringTextureUvwzFromRMuMuSNu(float r, float mu, float muS, float nu, bool rayIntersectsGround, float uvwz[4]) const
+{
+	const float bottomRadius = m_atmosphere.variables.x;
+	const float topRadius = m_atmosphere.variables.y;
+
+	float H = std::sqrt(topRadius * topRadius - bottomRadius * bottomRadius);
+	float rho = SafeSqrt(r * r - bottomRadius * bottomRadius);
+	float u_r = GetTextureCoordFromUnitRange(rho / H, SCATTERING_TEXTURE_R_SIZE);
+
+	float r_mu = r * mu;
+	float discriminant = r_mu * r_mu - r * r + bottomRadius * bottomRadius;
+	float u_mu;
+	if (rayIntersectsGround)
+	{
+		float d = -r_mu - SafeSqrt(discriminant);
+		float d_min = r - bottomRadius;
+		float d_max = rho;
+		u_mu = 0.5f - 0.5f * GetTextureCoordFromUnitRange(d_max == d_min ? 0.0f : (d - d_min) / (d_max - d_min), SCATTERING_TEXTURE_MU_SIZE / 2);
+	}
+	else
+	{
+		float d = -r_mu + SafeSqrt(discriminant + H * H);
+		float d_min = topRadius - r;
+		float d_max = rho + H;
+		u_mu = 0.5f + 0.5f * GetTextureCoordFromUnitRange((d - d_min) / (d_max - d_min), SCATTERING_TEXTURE_MU_SIZE / 2);
+	}
+
+	float d = DistanceToTopAtmosphereBoundary(bottomRadius, muS);
+	float d_min = topRadius - bottomRadius;
+	float d_max = H;
+	float a = (d - d_min) / (d_max - d_min);
+	float A = -2.0f * m_atmosphere.variables.w * bottomRadius / (d_max - d_min);
+	float u_mu_s = GetTextureCoordFromUnitRange((std::max)(1.0f - a / A, 0.0f) / (1.0f + a), SCATTERING_TEXTURE_MU_S_SIZE);
+	float u_nu = (nu + 1.0f) / 2.0f;
+
+	uvwz[0] = u_nu;
+	uvwz[1] = u_mu_s;
+	uvwz[2] = u_mu;
+	uvwz[3] = u_r;
+}
+
+void AtmosphereReferenceBaker::GetRMuMuSNuFromScatteringTextureFragCoord(uint32_t x, uint32_t y, uint32_t z, float& r, float& mu, float& muS, float& nu, bool& rayIntersectsGround) const
+{
+	const float bottomRadius = m_atmosphere.variables.x;
+	const float topRadius = m_atmosphere.variables.y;
+
+	// Fragment coordinates are texel centers, same as gl_GlobalInvocationID + 0.5
+	float fragCoordX = x + 0.5f;
+	float fragCoordNu = std::floor(fragCoordX / float(SCATTERING_TEXTURE_MU_S_SIZE));
+	float fragCoordMuS = std::fmod(fragCoordX, float(SCATTERING_TEXTURE_MU_S_SIZE));
+
+	float uvwz[4] =
+	{
+		fragCoordNu / float(SCATTERING_TEXTURE_NU_SIZE - 1),
+		fragCoordMuS / float(SCATTERING_TEXTURE_MU_S_SIZE),
+		(y + 0.5f) / float(SCATTERING_TEXTURE_MU_SIZE),
+		(z + 0.5f) / float(SCATTERING_TEXTURE_R_SIZE)
+	};
+
+	// GetRMuMuSNuFromScatteringTextureUvwz
+	float H = std::sqrt(topRadius * topRadius - bottomRadius * bottomRadius);
+	float rho = H * GetUnitRangeFromTextureCoord(uvwz[3], SCATTERING_TEXTURE_R_SIZE);
+	r = std::sqrt(rho * rho + bottomRadius * bottomRadius);
+
+	if (uvwz[2] < 0.5f)
+	{
+		float d_min = r - bottomRadius;
+		float d_max = rho;
+		float d = d_min + (d_max - d_min) * GetUnitRangeFromTextureCoord(1.0f - 2.0f * uvwz[2], SCATTERING_TEXTURE_MU_SIZE / 2);
+		mu = d == 0.0f ? -1.0f : ClampCosine(-(rho * rho + d * d) / (2.0f * r * d));
+		rayIntersectsGround = true;
+	}
+	else
+	{
+		float d_min = topRadius - r;
+		float d_max = rho + H;
+		float d = d_min + (d_max - d_min) * GetUnitRangeFromTextureCoord(2.0f * uvwz[2] - 1.0f, SCATTERING_TEXTURE_MU_SIZE / 2);
+		mu = d == 0.0f ? 1.0f : ClampCosine((H * H - rho * rho - d * d) / (2.0f * r * d));
+		rayIntersectsGround = false;
+	}
+
+	float x_mu_s = GetUnitRangeFromTextureCoord(uvwz[1], SCATTERING_TEXTURE_MU_S_SIZE);
+	float d_min = topRadius - bottomRadius;
+	float d_max = H;
+	float A = -2.0f * m_atmosphere.variables.w * bottomRadius / (d_max - d_min);
+	float a = (A - x_mu_s * A) / (1.0f + x_mu_s * A);
+	float d = d_min + (std::min)(a, A) * (d_max - d_min);
+	muS = d == 0.0f ? 1.0f : ClampCosine((H * H - d * d) / (2.0f * bottomRadius * d));
+	nu = ClampCosine(uvwz[0] * 2.0f - 1.0f);
+
+	// Clamp nu to its valid range of values, given mu and mu_s
+	float range = std::sqrt((1.0f - mu * mu) * (1.0f - muS * muS));
+	nu = (std::min)((std::max)(nu, mu * muS - range), mu * muS + range);
+}
+
+AtmosphereReferenceBaker::Spectrum AtmosphereReferenceBaker::GetScattering(const Texture& scatteringTexture, float r, float mu, float muS, float nu, bool rayIntersectsGround) const
+{
+	float uvwz[4];
+	GetScatteringTextureUvwzFromRMuMuSNu(r, mu, muS, nu, rayIntersectsGround, uvwz);
+
+	float tex_coord_x = uvwz[0] * float(SCATTERING_TEXTURE_NU_SIZE - 1);
+	float tex_x = std::floor(tex_coord_x);
+	float lerp = tex_coord_x - tex_x;
+
+	Spectrum s0 = scatteringTexture.Sample((tex_x + uvwz[1]) / float(SCATTERING_TEXTURE_NU_SIZE), uvwz[2], uvwz[3]);
+	Spectrum s1 = scatteringTexture.Sample((tex_x + 1.0f + uvwz[1]) / float(SCATTERING_TEXTURE_NU_SIZE), uvwz[2], uvwz[3]);
+	return s0 * (1.0f - lerp) + s1 * lerp;
+}
+
+AtmosphereReferenceBaker::Spectrum AtmosphereReferenceBaker::GetScattering(float r, float mu, float muS, float nu, bool rayIntersectsGround, int scatteringOrder) const
+{
+	if (scatteringOrder == 1)
+	{
+		Spectrum rayleigh = GetScattering(m_deltaRayleigh, r, mu, muS, nu, rayIntersectsGround);
+		Spectrum mie = GetScattering(m_deltaMie, r, mu, muS, nu, rayIntersectsGround);
+		return rayleigh * RayleighPhaseFunction(nu) + mie * MiePhaseFunction(m_atmosphere.variables.z, nu);
+	}
+	else
+	{
+		return GetScattering(m_deltaMultiScatter, r, mu, muS, nu, rayIntersectsGround);
+	}
+}
+
+AtmosphereReferenceBaker::Spectrum AtmosphereReferenceBaker::ComputeScatteringDensity(float r, float mu, float muS, float nu, int scatteringOrder) const
+{
+	// Zenith is (0, 0, 1), view direction omega and sun direction omega_s are built so that they match mu, mu_s and nu
+	float omega[3] = { std::sqrt(1.0f - mu * mu), 0.0f, mu };
+	float sun_dir_x = omega[0] == 0.0f ? 0.0f : (nu - mu * muS) / omega[0];
+	float sun_dir_y = std::sqrt((std::max)(1.0f - sun_dir_x * sun_dir_x - muS * muS, 0.0f));
+	float omega_s[3] = { sun_dir_x, sun_dir_y, muS };
+
+	const int SAMPLE_COUNT = 16;
+	const float dphi = PI / float(SAMPLE_COUNT);
+	const float dtheta = PI / float(SAMPLE_COUNT);
+
+	// Density only depends on r, it's hoisted out of the loops
+	float rayleighDensity = GetProfileDensity(m_atmosphere.rayleighDensity, r - m_atmosphere.variables.x);
+	float mieDensity = GetProfileDensity(m_atmosphere.mieDensity, r - m_atmosphere.variables.x);
+	Spectrum rayleighScattering = Spectrum(m_atmosphere.rayleighScattering) * rayleighDensity;
+	Spectrum mieScattering = Spectrum(m_atmosphere.mieScattering) * mieDensity;
+
+	Spectrum rayleigh_mie;
+	for (int l = 0; l < SAMPLE_COUNT; ++l)
+	{
+		float theta = (float(l) + 0.5f) * dtheta;
+		float cos_theta = std::cos(theta);
+		float sin_theta = std::sin(theta);
+		bool ray_r_theta_intersects_ground = RayIntersectsGround(r, cos_theta);
+
+		float distance_to_ground = 0.0f;
+		Spectrum transmittance_to_ground;
+		Spectrum groundAlbedo;
+		if (ray_r_theta_intersects_ground)
+		{
+			distance_to_ground = DistanceToBottomAtmosphereBoundary(r, cos_theta);
+			transmittance_to_ground = GetTransmittance(r, cos_theta, distance_to_ground, true);
+			groundAlbedo = Spectrum(m_atmosphere.groundAlbedo);
+		}
+
+		for (int m = 0; m < 2 * SAMPLE_COUNT; ++m)
+		{
+			float phi = (float(m) + 0.5f) * dphi;
+			float omega_i[3] = { std::cos(phi) * sin_theta, std::sin(phi) * sin_theta, cos_theta };
+			float domega_i = dtheta * dphi * std::sin(theta);
+
+			float nu1 = omega_s[0] * omega_i[0] + omega_s[1] * omega_i[1] + omega_s[2] * omega_i[2];
+			Spectrum incident_radiance = GetScattering(r, omega_i[2], muS, nu1, ray_r_theta_intersects_ground, scatteringOrder - 1);
+
+			float ground_normal[3] = { omega_i[0] * distance_to_ground, omega_i[1] * distance_to_ground, r + omega_i[2] * distance_to_ground };
+			float length = std::sqrt(ground_normal[0] * ground_normal[0] + ground_normal[1] * ground_normal[1] + ground_normal[2] * ground_normal[2]);
+			float ground_mu_s = (ground_normal[0] * omega_s[0] + ground_normal[1] * omega_s[1] + ground_normal[2] * omega_s[2]) / length;
+			Spectrum ground_irradiance = GetIrradiance(m_atmosphere.variables.x, ground_mu_s);
+			incident_radiance += transmittance_to_ground * groundAlbedo * (1.0f / PI) * ground_irradiance;
+
+			float nu2 = omega[0] * omega_i[0] + omega[1] * omega_i[1] + omega[2] * omega_i[2];
+			rayleigh_mie += incident_radiance * (
+				rayleighScattering * RayleighPhaseFunction(nu2) +
+				mieScattering * MiePhaseFunction(m_atmosphere.variables.z, nu2)) * domega_i;
+		}
+	}
+	return rayleigh_mie;
+}
+
+AtmosphereReferenceBaker::Spectrum AtmosphereReferenceBaker::ComputeMultipleScattering(float r, float mu, float muS, float nu, bool rayIntersectsGround) const
+{
+	const int SAMPLE_COUNT = 50;
+	float dx = DistanceToNearestAtmosphereBoundary(r, mu, rayIntersectsGround) / float(SAMPLE_COUNT);
+
+	Spectrum rayleigh_mie_sum;
+	for (int i = 0; i <= SAMPLE_COUNT; ++i)
+	{
+		float d_i = float(i) * dx;
+		float r_i = ClampRadius(std::sqrt(d_i * d_i + 2.0f * r * mu * d_i + r * r));
+		float mu_i = ClampCosine((r * mu + d_i) / r_i);
+		float mu_s_i = ClampCosine((r * muS + d_i * nu) / r_i);
+
+		Spectrum rayleigh_mie_i =
+			GetScattering(m_deltaScatterDensity, r_i, mu_i, mu_s_i, nu, rayIntersectsGround) *
+			GetTransmittance(r, mu, d_i, rayIntersectsGround) * dx;
+
+		float weight_i = (i == 0 || i == SAMPLE_COUNT) ? 0.5f : 1.0f;
+		rayleigh_mie_sum += rayleigh_mie_i * weight_i;
+	}
+	return rayleigh_mie_sum;
+}
+
+AtmosphereReferenceBaker::Spectrum AtmosphereReferenceBaker::ComputeDirectIrradiance(float r, float muS) const
+{
+	float alpha_s = m_atmosphere.solarIrradiance.w;
+	float average_cosine_factor = muS < -alpha_s ? 0.0f : (muS > alpha_s ? muS : (muS + alpha_s) * (muS + alpha_s) / (4.0f * alpha_s));
+	return Spectrum(m_atmosphere.solarIrradiance) * GetTransmittanceToTopAtmosphereBoundary(r, muS) * average_cosine_factor;
+}
+
+AtmosphereReferenceBaker::Spectrum AtmosphereReferenceBaker::ComputeIndirectIrradiance(float r, float muS, int scatteringOrder) const
+{
+	const int SAMPLE_COUNT = 32;
+	const float dphi = PI / float(SAMPLE_COUNT);
+	const float dtheta = PI / float(SAMPLE_COUNT);
+
+	Spectrum result;
+	float omega_s[3] = { std::sqrt(1.0f - muS * muS), 0.0f, muS };
+	for (int j = 0; j < SAMPLE_COUNT / 2; ++j)
+	{
+		float theta = (float(j) + 0.5f) * dtheta;
+		for (int i = 0; i < 2 * SAMPLE_COUNT; ++i)
+		{
+			float phi = (float(i) + 0.5f) * dphi;
+			float omega[3] = { std::cos(phi) * std::sin(theta), std::sin(phi) * std::sin(theta), std::cos(theta) };
+			float domega = dtheta * dphi * std::sin(theta);
+			float nu = omega[0] * omega_s[0] + omega[1] * omega_s[1] + omega[2] * omega_s[2];
+			result += GetScattering(r, omega[2], muS, nu, false, scatteringOrder) * (omega[2] * domega);
+		}
+	}
+	return result;
+}
+
+void AtmosphereReferenceBaker::GetIrradianceTextureUvFromRMuS(float r, float muS, float& u, float& v) const
+{
+	float x_r = (r - m_atmosphere.variables.x) / (m_atmosphere.variables.y - m_atmosphere.variables.x);
+	float x_mu_s = muS * 0.5f + 0.5f;
+	u = GetTextureCoordFromUnitRange(x_mu_s, IRRADIANCE_TEXTURE_WIDTH);
+	v = GetTextureCoordFromUnitRange(x_r, IRRADIANCE_TEXTURE_HEIGHT);
+}
+
+void AtmosphereReferenceBaker::GetRMuSFromIrradianceTextureUv(float u, float v, float& r, float& muS) const
+{
+	float x_mu_s = GetUnitRangeFromTextureCoord(u, IRRADIANCE_TEXTURE_WIDTH);
+	float x_r = GetUnitRangeFromTextureCoord(v, IRRADIANCE_TEXTURE_HEIGHT);
+	r = m_atmosphere.variables.x + x_r * (m_atmosphere.variables.y - m_atmosphere.variables.x);
+	muS = ClampCosine(2.0f * x_mu_s - 1.0f);
+}
+
+AtmosphereReferenceBaker::Spectrum AtmosphereReferenceBaker::GetIrradiance(float r, float muS) const
+{
+	float u, v;
+	GetIrradianceTextureUvFromRMuS(r, muS, u, v);
+	return m_deltaIrradiance.Sample(u, v);
+}
\ No newline at end of file
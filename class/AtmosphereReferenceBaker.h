@@ -0,0 +1,120 @@
+#pragma once
+
+#include "AtmosphereLUTCache.h"
+#include <xmmintrin.h>
+
+// CPU reference of atmosphere precompute shaders
+// transmittance_gen, single_scatter_gen, direct_irradiance, delta_rayleigh_mie_gen, indirect_irradiance_gen and multi_scatter_gen
+// are ported function by function from atmosphere/functions.sh, and executed in the same order with the same single precision math,
+// so that caches can be built and gpu output can be verified offline, without a gpu
+// Texels of each pass are distributed over worker threads, rgb spectrums are evaluated in sse lanes
+// NOTE: Result is not bit exact to gpu, texture filtering and transcendental functions are not, use AtmosphereLUTCache::Compare() with a tolerance
+class AtmosphereReferenceBaker
+{
+public:
+	// "workerCount" 0 means hardware concurrency
+	static void Bake(const AtmosphereParameters<float>& parameters, AtmosphereLUTs& luts, uint32_t workerCount = 0);
+
+protected:
+	// Rgb spectrum in one sse register, w lane is kept but not meaningful
+	class Spectrum
+	{
+	public:
+		Spectrum() : v(_mm_setzero_ps()) {}
+		Spectrum(float s) : v(_mm_set1_ps(s)) {}
+		Spectrum(__m128 _v) : v(_v) {}
+		Spectrum(const Vector4f& _v) : v(_mm_setr_ps(_v.x, _v.y, _v.z, 0.0f)) {}
+
+		Spectrum operator + (const Spectrum& s) const { return _mm_add_ps(v, s.v); }
+		Spectrum operator - (const Spectrum& s) const { return _mm_sub_ps(v, s.v); }
+		Spectrum operator * (const Spectrum& s) const { return _mm_mul_ps(v, s.v); }
+		Spectrum operator / (const Spectrum& s) const { return _mm_div_ps(v, s.v); }
+		Spectrum& operator += (const Spectrum& s) { v = _mm_add_ps(v, s.v); return *this; }
+		float operator [] (uint32_t index) const { float f[4]; _mm_storeu_ps(f, v); return f[index]; }
+
+		static Spectrum Min(const Spectrum& s0, const Spectrum& s1) { return _mm_min_ps(s0.v, s1.v); }
+		static Spectrum Exp(const Spectrum& s);
+
+	public:
+		__m128 v;
+	};
+
+	// Rgba float texels with linear filtering and clamp to edge addressing, the same as samplers used by precompute shaders
+	class Texture
+	{
+	public:
+		void Allocate(uint32_t width, uint32_t height, uint32_t depth);
+
+		void Store(uint32_t x, uint32_t y, uint32_t z, const Spectrum& rgb, float a = 0.0f);
+		void Load(uint32_t x, uint32_t y, uint32_t z, Spectrum& rgb, float& a) const;
+		Spectrum Sample(float u, float v) const;
+		Spectrum Sample(float u, float v, float w, float* pAlpha = nullptr) const;
+
+	public:
+		uint32_t			width = 0;
+		uint32_t			height = 0;
+		uint32_t			depth = 0;
+		std::vector<float>	texels;
+	};
+
+	typedef DensityProfileLayer<float> DensityProfileLayerf;
+	typedef DensityProfile<float> DensityProfilef;
+
+protected:
+	AtmosphereReferenceBaker(const AtmosphereParameters<float>& parameters, uint32_t workerCount);
+
+	// Execute "func(x, y, z)" for every texel of "texture", slices are interleaved over workers
+	template <typename Func>
+	void ExecutePass(const Texture& texture, Func func) const;
+
+	void BakeAll(AtmosphereLUTs& luts);
+
+	// Ported from functions.sh
+	float DistanceToTopAtmosphereBoundary(float r, float mu) const;
+	float DistanceToBottomAtmosphereBoundary(float r, float mu) const;
+	float DistanceToNearestAtmosphereBoundary(float r, float mu, bool rayIntersectsGround) const;
+	bool RayIntersectsGround(float r, float mu) const;
+	float ClampRadius(float r) const;
+	static float GetLayerDensity(const DensityProfileLayerf& layer, float altitude);
+	static float GetProfileDensity(const DensityProfilef& profile, float altitude);
+	float ComputeOpticalLengthToTopAtmosphereBoundary(const DensityProfilef& profile, float r, float mu) const;
+	Spectrum ComputeTransmittanceToTopAtmosphereBoundary(float r, float mu) const;
+
+	void GetTransmittanceTextureUvFromRMu(float r, float mu, float& u, float& v) const;
+	void GetRMuFromTransmittanceTextureUv(float u, float v, float& r, float& mu) const;
+	Spectrum GetTransmittanceToTopAtmosphereBoundary(float r, float mu) const;
+	Spectrum GetTransmittance(float r, float mu, float d, bool rayIntersectsGround) const;
+	Spectrum GetTransmittanceToSun(float r, float muS) const;
+
+	void ComputeSingleScattering(float r, float mu, float muS, float nu, bool rayIntersectsGround, Spectrum& rayleigh, Spectrum& mie) const;
+	static float RayleighPhaseFunction(float nu);
+	static float MiePhaseFunction(float g, float nu);
+
+	void GetScatteringTextureUvwzFromRMuMuSNu(float r, float mu, float muS, float nu, bool rayIntersectsGround, float uvwz[4]) const;
+	void GetRMuMuSNuFromScatteringTextureFragCoord(uint32_t x, uint32_t y, uint32_t z, float& r, float& mu, float& muS, float& nu, bool& rayIntersectsGround) const;
+	Spectrum GetScattering(const Texture& scatteringTexture, float r, float mu, float muS, float nu, bool rayIntersectsGround) const;
+	Spectrum GetScattering(float r, float mu, float muS, float nu, bool rayIntersectsGround, int scatteringOrder) const;
+
+	Spectrum ComputeScatteringDensity(float r, float mu, float muS, float nu, int scatteringOrder) const;
+	Spectrum ComputeMultipleScattering(float r, float mu, float muS, float nu, bool rayIntersectsGround) const;
+	Spectrum ComputeDirectIrradiance(float r, float muS) const;
+	Spectrum ComputeIndirectIrradiance(float r, float muS, int scatteringOrder) const;
+
+	void GetIrradianceTextureUvFromRMuS(float r, float muS, float& u, float& v) const;
+	void GetRMuSFromIrradianceTextureUv(float u, float v, float& r, float& muS) const;
+	Spectrum GetIrradiance(float r, float muS) const;
+
+protected:
+	AtmosphereParameters<float>	m_atmosphere;
+	uint32_t					m_workerCount;
+
+	Texture						m_transmittance;
+	Texture						m_scatter;
+	Texture						m_irradiance;
+
+	Texture						m_deltaIrradiance;
+	Texture						m_deltaRayleigh;
+	Texture						m_deltaMie;
+	Texture						m_deltaScatterDensity;
+	Texture						m_deltaMultiScatter;
+};
\ No newline at end of file
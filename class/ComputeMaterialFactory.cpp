@@ -402,13 +402,217 @@ std::shared_ptr<Material> CreateNeighborMaxMaterial(const std::vector<std::share
 	return CustomizedComputeMaterial::CreateMaterial(variables);
 }
 
-std::shared_ptr<Material> CreateSSAOSSRMaterial()
+std::shared_ptr<Material> CreateTileNeighborMaxMaterial(const std::vector<std::shared_ptr<Image>>& inputImages, const std::vector<std::shared_ptr<Image>>& outputImages)
+{
+	std::vector<CombinedImage> _inputImages;
+	for (auto pImage : inputImages)
+	{
+		_inputImages.push_back
+		({
+			pImage,
+			pImage->CreateLinearClampToEdgeSampler(),
+			pImage->CreateDefaultImageView()
+		});
+	}
+
+	std::vector<CombinedImage> _outputImages;
+	for (auto pImage : outputImages)
+	{
+		_outputImages.push_back
+		({
+			pImage,
+			pImage->CreateLinearClampToEdgeSampler(),
+			pImage->CreateDefaultImageView()
+		});
+	}
+
+	std::vector<CustomizedComputeMaterial::TextureUnit> textureUnits;
+	textureUnits.push_back
+	(
+		{
+			0,
+
+			_inputImages,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			{ 0, 1, 0, 1 },
+			false,
+
+			CustomizedComputeMaterial::TextureUnit::BY_FRAME,
+
+			{
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				inputImages[0]->GetImageInfo().initialLayout,
+				VK_ACCESS_SHADER_READ_BIT
+			}
+		}
+	);
+
+	textureUnits.push_back
+	(
+		{
+			1,
+
+			_outputImages,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			{ 0, 1, 0, 1 },
+			true,
+
+			CustomizedComputeMaterial::TextureUnit::BY_FRAME,
+
+			{
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				outputImages[0]->GetImageInfo().initialLayout,
+				VK_ACCESS_SHADER_WRITE_BIT
+			}
+		}
+	);
+
+	Vector3ui groupNum =
+	{
+		(uint32_t)std::ceil((double)_outputImages[0].pImage->GetImageInfo().extent.width / (double)groupSize),
+		(uint32_t)std::ceil((double)_outputImages[0].pImage->GetImageInfo().extent.height / (double)groupSize),
+		1
+	};
+
+	std::vector<uint8_t> pushConstantData;
+
+	CustomizedComputeMaterial::Variables variables =
+	{
+		L"../data/shaders/tile_neighbor_max.comp.spv",
+		groupNum,
+		textureUnits,
+		pushConstantData
+	};
+
+	return CustomizedComputeMaterial::CreateMaterial(variables);
+}
+
+std::shared_ptr<Material> CreateHiZGenMaterial(uint32_t mipLevel)
+{
+	std::vector<CombinedImage> depthBuffer;
+	std::vector<CombinedImage> HiZ;
+	std::vector<CombinedImage> outHiZ;
+	for (uint32_t j = 0; j < GetSwapChain()->GetSwapChainImageCount(); j++)
+	{
+		std::shared_ptr<FrameBuffer> pGBufferFrameBuffer = FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_GBuffer)[j];
+		std::shared_ptr<Image> pHiZ = UniformData::GetInstance()->GetGlobalTextures()->GetHiZTexture(j);
+
+		depthBuffer.push_back
+		({
+			pGBufferFrameBuffer->GetDepthStencilTarget(),
+			pGBufferFrameBuffer->GetDepthStencilTarget()->CreateNearestRepeatSampler(),
+			pGBufferFrameBuffer->GetDepthStencilTarget()->CreateDepthSampleImageView()
+		});
+
+		HiZ.push_back
+		({
+			pHiZ,
+			pHiZ->CreateNearestRepeatSampler(),
+			pHiZ->CreateDefaultImageView()
+		});
+
+		outHiZ.push_back
+		({
+			pHiZ,
+			pHiZ->CreateNearestRepeatSampler(),
+			pHiZ->CreateImageView(mipLevel, true)
+		});
+	}
+
+	std::vector<CustomizedComputeMaterial::TextureUnit> textureUnits;
+	textureUnits.push_back
+	(
+		{
+			0,
+
+			depthBuffer,
+			VK_IMAGE_ASPECT_DEPTH_BIT,
+			{ 0, 1, 0, 1 },
+			false,
+
+			CustomizedComputeMaterial::TextureUnit::BY_FRAME,
+
+			{
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_ACCESS_SHADER_READ_BIT
+			}
+		}
+	);
+
+	// Previous mip level is read through a view of the whole pyramid
+	textureUnits.push_back
+	(
+		{
+			1,
+
+			HiZ,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			{ 0, HiZ[0].pImage->GetImageInfo().mipLevels, 0, 1 },
+			false,
+
+			CustomizedComputeMaterial::TextureUnit::BY_FRAME,
+
+			{
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_IMAGE_LAYOUT_GENERAL,
+				VK_ACCESS_SHADER_READ_BIT
+			}
+		}
+	);
+
+	textureUnits.push_back
+	(
+		{
+			2,
+
+			outHiZ,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			{ mipLevel, 1, 0, 1 },
+			true,
+
+			CustomizedComputeMaterial::TextureUnit::BY_FRAME,
+
+			{
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_IMAGE_LAYOUT_GENERAL,
+				VK_ACCESS_SHADER_WRITE_BIT
+			}
+		}
+	);
+
+	uint32_t mipSize = GlobalTextures::HIZ_SIZE >> mipLevel;
+	Vector3ui groupNum =
+	{
+		(uint32_t)std::ceil((double)mipSize / (double)groupSize),
+		(uint32_t)std::ceil((double)mipSize / (double)groupSize),
+		1
+	};
+
+	// Mip 0 is reduced from depth buffer, marked by -1
+	int srcMipLevel = (int)mipLevel - 1;
+	std::vector<uint8_t> pushConstantData;
+	TransferBytesToVector(pushConstantData, &srcMipLevel, 0, sizeof(srcMipLevel));
+
+	CustomizedComputeMaterial::Variables variables =
+	{
+		L"../data/shaders/hiz_gen.comp.spv",
+		groupNum,
+		textureUnits,
+		pushConstantData
+	};
+
+	return CustomizedComputeMaterial::CreateMaterial(variables);
+}
+
+std::shared_ptr<Material> CreateSSAOSSRMaterial(bool HiZTracing)
 {
 	std::vector<CombinedImage> gbuffer0;
 	std::vector<CombinedImage> gbuffer2;
 	std::vector<CombinedImage> depthBuffer;
 	std::vector<CombinedImage> outSSAOFactor;
 	std::vector<CombinedImage> outSSRInfo;
+	std::vector<CombinedImage> HiZ;
 	for (uint32_t j = 0; j < GetSwapChain()->GetSwapChainImageCount(); j++)
 	{
 		std::shared_ptr<FrameBuffer> pGBufferFrameBuffer = FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_GBuffer)[j];
@@ -449,6 +653,15 @@ std::shared_ptr<Material> CreateSSAOSSRMaterial()
 			pSSAOSSRFrameBuffer->GetColorTarget(1)->CreateLinearClampToEdgeSampler(),
 			pSSAOSSRFrameBuffer->GetColorTarget(1)->CreateDefaultImageView()
 		});
+
+		std::shared_ptr<Image> pHiZ = UniformData::GetInstance()->GetGlobalTextures()->GetHiZTexture(j);
+
+		HiZ.push_back
+		({
+			pHiZ,
+			pHiZ->CreateNearestRepeatSampler(),
+			pHiZ->CreateDefaultImageView()
+		});
 	}
 
 	std::vector<CustomizedComputeMaterial::TextureUnit> textureUnits;
@@ -552,6 +765,29 @@ std::shared_ptr<Material> CreateSSAOSSRMaterial()
 		}
 	);
 
+	if (HiZTracing)
+	{
+		textureUnits.push_back
+		(
+			{
+				5,
+
+				HiZ,
+				VK_IMAGE_ASPECT_COLOR_BIT,
+				{ 0, HiZ[0].pImage->GetImageInfo().mipLevels, 0, 1 },
+				false,
+
+				CustomizedComputeMaterial::TextureUnit::BY_FRAME,
+
+				{
+					VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					VK_IMAGE_LAYOUT_GENERAL,
+					VK_ACCESS_SHADER_READ_BIT
+				}
+			}
+		);
+	}
+
 	uint32_t index;
 	UniformData::GetInstance()->GetGlobalTextures()->GetTextureIndex(RGBA8_1024, "BlueNoise", index);
 	float floatIndex = (float)index;
@@ -568,7 +804,7 @@ std::shared_ptr<Material> CreateSSAOSSRMaterial()
 
 	CustomizedComputeMaterial::Variables variables =
 	{
-		L"../data/shaders/ssao_ssr_gen.comp.spv",
+		HiZTracing ? L"../data/shaders/ssao_ssr_hiz_gen.comp.spv" : L"../data/shaders/ssao_ssr_gen.comp.spv",
 		groupNum,
 		textureUnits,
 		pushConstantData
@@ -663,6 +899,95 @@ std::shared_ptr<Material> CreateGaussianBlurMaterial(const std::vector<std::shar
 	return CustomizedComputeMaterial::CreateMaterial(variables);
 }
 
+std::shared_ptr<Material> CreateSeparableBlurMaterial(const std::vector<std::shared_ptr<Image>>& inputImages, const std::vector<std::shared_ptr<Image>>& outputImages, const GaussianBlurParams& params)
+{
+	// Taps are fetched from shared memory by whole texels
+	ASSERTION(params.scale == 1.0f);
+
+	std::vector<CombinedImage> _inputImages;
+	for (auto pImage : inputImages)
+	{
+		_inputImages.push_back
+		({
+			pImage,
+			pImage->CreateLinearClampToEdgeSampler(),
+			pImage->CreateDefaultImageView()
+		});
+	}
+
+	std::vector<CombinedImage> _outputImages;
+	for (auto pImage : outputImages)
+	{
+		_outputImages.push_back
+		({
+			pImage,
+			pImage->CreateLinearClampToEdgeSampler(),
+			pImage->CreateDefaultImageView()
+		});
+	}
+
+	std::vector<CustomizedComputeMaterial::TextureUnit> textureUnits;
+	textureUnits.push_back
+	(
+		{
+			0,
+
+			_inputImages,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			{ 0, 1, 0, 1 },
+			false,
+
+			CustomizedComputeMaterial::TextureUnit::BY_FRAME,
+
+			{
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				inputImages[0]->GetImageInfo().initialLayout,
+				VK_ACCESS_SHADER_READ_BIT
+			}
+		}
+	);
+
+	textureUnits.push_back
+	(
+		{
+			1,
+
+			_outputImages,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			{ 0, 1, 0, 1 },
+			true,
+
+			CustomizedComputeMaterial::TextureUnit::BY_FRAME,
+
+			{
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				outputImages[0]->GetImageInfo().initialLayout,
+				VK_ACCESS_SHADER_WRITE_BIT
+			}
+		}
+	);
+
+	Vector3ui groupNum =
+	{
+		(uint32_t)std::ceil((double)_outputImages[0].pImage->GetImageInfo().extent.width / (double)groupSize),
+		(uint32_t)std::ceil((double)_outputImages[0].pImage->GetImageInfo().extent.height / (double)groupSize),
+		1
+	};
+
+	std::vector<uint8_t> pushConstantData;
+	TransferBytesToVector(pushConstantData, &params.strength, 0, sizeof(params.strength));
+
+	CustomizedComputeMaterial::Variables variables =
+	{
+		L"../data/shaders/separable_blur.comp.spv",
+		groupNum,
+		textureUnits,
+		pushConstantData
+	};
+
+	return CustomizedComputeMaterial::CreateMaterial(variables);
+}
+
 std::shared_ptr<Material> CreateDeferredShadingMaterial()
 {
 	std::vector<CustomizedComputeMaterial::TextureUnit> textureUnits;
@@ -1771,8 +2096,148 @@ std::shared_ptr<Material> CreateDOFMaterial(DOFPass dofPass)
 	return CustomizedComputeMaterial::CreateMaterial(variables);
 }
 
-std::shared_ptr<Material> CreateBloomMaterial(BloomPass bloomPass, uint32_t iterIndex)
+// Shader reduces a 32x32 tile of layer 1 down to 2x2 of the last layer
+static const uint32_t BLOOM_SINGLE_PASS_ITER_COUNT = 5;
+static const uint32_t BLOOM_SINGLE_PASS_TILE_SIZE = 32;
+
+static std::shared_ptr<Material> CreateBloomSinglePassMaterial(uint32_t iterCount, uint32_t fusedUpsampleCount)
 {
+	ASSERTION(iterCount == BLOOM_SINGLE_PASS_ITER_COUNT);
+	// Layer 0 isn't bound by this pass
+	ASSERTION(fusedUpsampleCount < iterCount);
+
+	std::vector<CustomizedComputeMaterial::TextureUnit> textureUnits;
+
+	std::vector<CombinedImage> DOFResults;
+	for (uint32_t j = 0; j < GetSwapChain()->GetSwapChainImageCount(); j++)
+	{
+		std::shared_ptr<FrameBuffer> pDOFResult = FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_DOF, FrameBufferDiction::CombineLayer)[j];
+		DOFResults.push_back
+		({
+			pDOFResult->GetColorTarget(0),
+			pDOFResult->GetColorTarget(0)->CreateLinearClampToEdgeSampler(),
+			pDOFResult->GetColorTarget(0)->CreateDefaultImageView()
+		});
+	}
+
+	textureUnits.push_back
+	(
+		{
+			0,
+
+			DOFResults,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			{ 0, 1, 0, 1 },
+			false,
+
+			CustomizedComputeMaterial::TextureUnit::BY_FRAME,
+
+			{
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_IMAGE_LAYOUT_GENERAL,
+				VK_ACCESS_SHADER_READ_BIT
+			}
+		}
+	);
+
+	// Every layer is both written and read(by fused upsample) within this pass
+	for (uint32_t i = 1; i <= iterCount; i++)
+	{
+		std::vector<CombinedImage> bloomLayers;
+		for (uint32_t j = 0; j < GetSwapChain()->GetSwapChainImageCount(); j++)
+		{
+			std::shared_ptr<FrameBuffer> pTarget = FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_Bloom, i)[j];
+			bloomLayers.push_back
+			({
+				pTarget->GetColorTarget(0),
+				pTarget->GetColorTarget(0)->CreateLinearClampToEdgeSampler(),
+				pTarget->GetColorTarget(0)->CreateDefaultImageView()
+			});
+		}
+
+		textureUnits.push_back
+		(
+			{
+				i,
+
+				bloomLayers,
+				VK_IMAGE_ASPECT_COLOR_BIT,
+				{ 0, 1, 0, 1 },
+				true,
+
+				CustomizedComputeMaterial::TextureUnit::BY_FRAME,
+
+				{
+					VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+					VK_IMAGE_LAYOUT_GENERAL,
+					VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+				}
+			}
+		);
+	}
+
+	// Global atomic counter to find out the last finished workgroup, which resets it to 0 for next use
+	std::vector<CombinedImage> atomicCounters;
+	uint32_t zero = 0;
+	for (uint32_t j = 0; j < GetSwapChain()->GetSwapChainImageCount(); j++)
+	{
+		std::shared_ptr<Image> pCounter = Image::CreateEmptyTexture2DForCompute(GetDevice(), { 1, 1 }, VK_FORMAT_R32_UINT);
+		pCounter->UpdateByteStream(&zero, sizeof(zero));
+		atomicCounters.push_back
+		({
+			pCounter,
+			pCounter->CreateNearestRepeatSampler(),
+			pCounter->CreateDefaultImageView()
+		});
+	}
+
+	textureUnits.push_back
+	(
+		{
+			iterCount + 1,
+
+			atomicCounters,
+			VK_IMAGE_ASPECT_COLOR_BIT,
+			{ 0, 1, 0, 1 },
+			true,
+
+			CustomizedComputeMaterial::TextureUnit::BY_FRAME,
+
+			{
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_IMAGE_LAYOUT_GENERAL,
+				VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+			}
+		}
+	);
+
+	VkExtent3D layer1Extent = textureUnits[1].textures[0].pImage->GetImageInfo().extent;
+	Vector3ui groupNum =
+	{
+		(uint32_t)std::ceil((double)layer1Extent.width / (double)BLOOM_SINGLE_PASS_TILE_SIZE),
+		(uint32_t)std::ceil((double)layer1Extent.height / (double)BLOOM_SINGLE_PASS_TILE_SIZE),
+		1
+	};
+
+	std::vector<uint8_t> pushConstantData;
+	TransferBytesToVector(pushConstantData, &fusedUpsampleCount, 0, sizeof(fusedUpsampleCount));
+
+	CustomizedComputeMaterial::Variables variables =
+	{
+		L"../data/shaders/bloom_downsample_single_pass.comp.spv",
+		groupNum,
+		textureUnits,
+		pushConstantData
+	};
+
+	return CustomizedComputeMaterial::CreateMaterial(variables);
+}
+
+std::shared_ptr<Material> CreateBloomMaterial(BloomPass bloomPass, uint32_t iterIndex, uint32_t fusedUpsampleCount)
+{
+	if (bloomPass == BloomPass::SINGLE_PASS_DOWNSAMPLE)
+		return CreateBloomSinglePassMaterial(iterIndex, fusedUpsampleCount);
+
 	std::wstring shaderPath;
 	switch (bloomPass)
 	{
@@ -11,6 +11,7 @@ enum class BloomPass
 	PREFILTER,
 	DOWNSAMPLE,
 	UPSAMPLE,
+	SINGLE_PASS_DOWNSAMPLE,	// All downsample iterations within one dispatch, optionally with last few upsample iterations fused
 	COUNT
 };
 
@@ -35,10 +36,19 @@ std::shared_ptr<Material> CreateIrradianceGenMaterial(const std::vector<std::sha
 std::shared_ptr<Material> CreateReflectionGenMaterial(const std::vector<std::shared_ptr<Image>>& inputImages, const std::vector<std::shared_ptr<Image>>& outputImages, uint32_t outMipLevel);
 std::shared_ptr<Material> CreateTileMaxMaterial(const std::vector<std::shared_ptr<Image>>& inputImages, const std::vector<std::shared_ptr<Image>>& outputImages);
 std::shared_ptr<Material> CreateNeighborMaxMaterial(const std::vector<std::shared_ptr<Image>>& inputImages, const std::vector<std::shared_ptr<Image>>& outputImages);
-std::shared_ptr<Material> CreateSSAOSSRMaterial();
+// Tile max and neighbor max within one dispatch, from motion vector directly to neighbor max
+std::shared_ptr<Material> CreateTileNeighborMaxMaterial(const std::vector<std::shared_ptr<Image>>& inputImages, const std::vector<std::shared_ptr<Image>>& outputImages);
+// Reduces gbuffer depth into one mip level of Hi-Z, keeping the farthest and the nearest depth
+std::shared_ptr<Material> CreateHiZGenMaterial(uint32_t mipLevel);
+// Reflection rays are either linearly marched in gbuffer depth, or traced hierarchically through Hi-Z of current frame
+std::shared_ptr<Material> CreateSSAOSSRMaterial(bool HiZTracing = false);
 std::shared_ptr<Material> CreateGaussianBlurMaterial(const std::vector<std::shared_ptr<Image>>& inputImages, const std::vector<std::shared_ptr<Image>>& outputImages, const GaussianBlurParams& params);
+// Vertical and horizontal gaussian blur within one dispatch through shared memory, direction of "params" is ignored, and scale has to be 1
+std::shared_ptr<Material> CreateSeparableBlurMaterial(const std::vector<std::shared_ptr<Image>>& inputImages, const std::vector<std::shared_ptr<Image>>& outputImages, const GaussianBlurParams& params);
 std::shared_ptr<Material> CreateDeferredShadingMaterial();
 std::shared_ptr<Material> CreateTemporalResolveMaterial(uint32_t pingpong);
 std::shared_ptr<Material> CreateDOFMaterial(DOFPass dofPass);
-std::shared_ptr<Material> CreateBloomMaterial(BloomPass bloomPass, uint32_t iterIndex);
+// For "SINGLE_PASS_DOWNSAMPLE", "iterIndex" is the count of downsample iterations it covers,
+// and upsample iterations from "iterIndex - 1" down to "iterIndex - fusedUpsampleCount" are done by it as well
+std::shared_ptr<Material> CreateBloomMaterial(BloomPass bloomPass, uint32_t iterIndex, uint32_t fusedUpsampleCount = 0);
 std::shared_ptr<Material> CreateCombineMaterial();
@@ -0,0 +1,302 @@
+#include "CullingManager.h"
+#include "../Base/BaseObject.h"
+#include "../component/MeshRenderer.h"
+#include "../component/PhysicalCamera.h"
+#include "../component/DirectionLight.h"
+#include "Mesh.h"
+#include "UniformData.h"
+#include "FrameWorkManager.h"
+#include "RenderWorkManager.h"
+
+bool CullingManager::Init()
+{
+	if (!Singleton<CullingManager>::Init())
+		return false;
+
+	return true;
+}
+
+void CullingManager::FrustumCull(const std::shared_ptr<BaseObject>& pRootObject, const std::shared_ptr<PhysicalCamera>& pCamera)
+{
+	m_stats = {};
+	m_testedRenderers.clear();
+
+	bool cullingAvailable = m_frustumCullingEnabled && pCamera != nullptr && pCamera->GetBaseObject() != nullptr;
+
+	pRootObject->GetComponentStorage()->ForEach<MeshRenderer>([&](MeshRenderer* pRenderer)
+	{
+		m_stats.rendererCount++;
+
+		// Not tested renderers are always visible and cast shadow
+		pRenderer->SetVisible(true);
+		pRenderer->SetShadowCascadeMask(0xffffffff);
+
+		if (!cullingAvailable || !pRenderer->IsFrustumCullable())
+			return;
+
+		m_testedRenderers.push_back(pRenderer);
+	});
+
+	m_stats.testedCount = (uint32_t)m_testedRenderers.size();
+
+	if (!cullingAvailable)
+	{
+		m_bvhRenderers.clear();
+		m_bvh.Clear();
+		m_stats.visibleCount = m_stats.rendererCount;
+		return;
+	}
+
+	if (m_bvhEnabled)
+	{
+		UpdateBVH();
+
+		// World space frustum
+		PyramidFrustumd frustum = pCamera->GetCameraFrustum();
+		frustum.Transform(pCamera->GetBaseObject()->GetCachedWorldTransform());
+
+		m_queryResults.clear();
+		m_bvh.QueryFrustumParallel(frustum, m_queryResults);
+		m_stats.visitedNodeCount = m_bvh.GetVisitedNodeCount();
+
+		for (auto pRenderer : m_bvhRenderers)
+			pRenderer->SetVisible(false);
+		for (auto item : m_queryResults)
+			m_bvhRenderers[item]->SetVisible(true);
+
+		m_stats.aabbCulledCount = m_stats.testedCount - (uint32_t)m_queryResults.size();
+	}
+	else
+	{
+		// Frustum only rotates with camera, bounds are moved to camera relative space instead
+		PyramidFrustumd frustum = pCamera->GetCameraFrustum();
+		frustum.Transform(pCamera->GetBaseObject()->GetCachedWorldTransform().RotationMatrix());
+
+		FlatFrustumCull(frustum, pCamera->GetBaseObject()->GetCachedWorldPosition());
+	}
+
+	if (m_occlusionCullingEnabled)
+		OcclusionCull(pCamera);
+
+	m_stats.visibleCount = m_stats.rendererCount - m_stats.aabbCulledCount - m_stats.occlusionCulledCount;
+}
+
+void CullingManager::UpdateBVH()
+{
+	// Renderer set changed, build from scratch, otherwise refit and let BVH rebuild loose sub trees
+	if (m_testedRenderers != m_bvhRenderers)
+	{
+		m_bvhRenderers = m_testedRenderers;
+
+		std::vector<BoundingBoxd> bounds(m_bvhRenderers.size());
+		for (uint32_t i = 0; i < (uint32_t)m_bvhRenderers.size(); i++)
+			bounds[i] = m_bvhRenderers[i]->GetWorldBounds();
+
+		m_bvh.Build(bounds);
+		m_stats.rebuiltSubTreeCount = 1;
+		return;
+	}
+
+	for (uint32_t i = 0; i < (uint32_t)m_bvhRenderers.size(); i++)
+		m_bvh.UpdateItemBounds(i, m_bvhRenderers[i]->GetWorldBounds());
+
+	m_stats.rebuiltSubTreeCount = m_bvh.Refit();
+}
+
+void CullingManager::FlatFrustumCull(const PyramidFrustumd& frustum, const Vector3d& cameraPosition)
+{
+	m_centerX.clear();
+	m_centerY.clear();
+	m_centerZ.clear();
+	m_extentX.clear();
+	m_extentY.clear();
+	m_extentZ.clear();
+
+	for (auto pRenderer : m_testedRenderers)
+	{
+		BoundingBoxd bounds = pRenderer->GetWorldBounds();
+		Vector3d center = bounds.Center() - cameraPosition;
+		Vector3d extent = bounds.Extent();
+
+		m_centerX.push_back((float)center.x);
+		m_centerY.push_back((float)center.y);
+		m_centerZ.push_back((float)center.z);
+		m_extentX.push_back((float)extent.x);
+		m_extentY.push_back((float)extent.y);
+		m_extentZ.push_back((float)extent.z);
+	}
+
+	if (m_stats.testedCount == 0)
+		return;
+
+	m_aabbVisible.resize(m_stats.testedCount);
+
+	// No sphere pre-test, batched tests run over every item anyway, and whatever a sphere rejects AABB rejects too
+	frustum.IntersectAABBs(m_centerX.data(), m_centerY.data(), m_centerZ.data(), m_extentX.data(), m_extentY.data(), m_extentZ.data(), m_stats.testedCount, m_aabbVisible.data());
+
+	for (uint32_t i = 0; i < m_stats.testedCount; i++)
+	{
+		if (!m_aabbVisible[i])
+			m_stats.aabbCulledCount++;
+
+		m_testedRenderers[i]->SetVisible(m_aabbVisible[i] != 0);
+	}
+}
+
+void CullingManager::OcclusionCull(const std::shared_ptr<PhysicalCamera>& pCamera)
+{
+	Matrix4d view = pCamera->GetBaseObject()->GetCachedWorldTransform();
+	view.Inverse();
+	Matrix4d worldToClip = UniformData::GetInstance()->GetGlobalUniforms()->GetProjectionMatrix() * view;
+
+	m_occlusionBuffer.Clear();
+
+	// Model to clip is combined with double precision, so that single precision clip positions stay accurate far from origin
+	for (auto pRenderer : m_testedRenderers)
+	{
+		if (!pRenderer->IsVisible() || !pRenderer->IsOccluder())
+			continue;
+
+		std::shared_ptr<Mesh> pMesh = pRenderer->GetMesh();
+		m_occlusionBuffer.AddOccluder((worldToClip * pRenderer->GetModelMatrix()).SinglePrecision(), pMesh->GetOccluderPositions(), pMesh->GetOccluderIndices());
+		m_stats.occluderCount++;
+	}
+
+	if (m_stats.occluderCount == 0)
+		return;
+
+	m_occlusionBuffer.RasterizeParallel();
+	m_stats.occluderTriangleCount = m_occlusionBuffer.GetTriangleCount();
+
+	// Occluders aren't tested, their own surfaces are in occlusion buffer, precision error could hide them behind themselves
+	for (auto pRenderer : m_testedRenderers)
+	{
+		if (!pRenderer->IsVisible() || pRenderer->IsOccluder())
+			continue;
+
+		if (!m_occlusionBuffer.TestAABB(worldToClip, pRenderer->GetWorldBounds()))
+		{
+			pRenderer->SetVisible(false);
+			m_stats.occlusionCulledCount++;
+		}
+	}
+}
+
+void CullingManager::ShadowCasterCull(const std::shared_ptr<DirectionLight>& pLight)
+{
+	uint32_t allCascades = (1 << SHADOW_CASCADE_COUNT) - 1;
+
+	if (pLight == nullptr || pLight->GetBaseObject() == nullptr || !m_bvhEnabled || m_bvhRenderers.size() == 0)
+	{
+		// Every caster is selected, so static shadow cache is fully re-rendered, and nothing cached could be trusted afterwards
+		InvalidateShadowCache(allCascades);
+		m_staticShadowCasters.clear();
+		m_pShadowCacheLight = nullptr;
+
+		UniformData::GetInstance()->GetPerFrameUniforms()->SetShadowCacheDirtyMask(allCascades);
+		m_stats.dirtyShadowCacheCount = SHADOW_CASCADE_COUNT;
+		m_stats.shadowCasterCount = m_stats.testedCount;
+		return;
+	}
+
+	for (auto pRenderer : m_bvhRenderers)
+		pRenderer->SetShadowCascadeMask(0);
+
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		m_queryResults.clear();
+		m_bvh.QueryFrustumParallel(pLight->GetCascadeVolume(i), m_queryResults);
+
+		for (auto item : m_queryResults)
+			m_bvhRenderers[item]->SetShadowCascadeMask(m_bvhRenderers[item]->GetShadowCascadeMask() | (1 << i));
+	}
+
+	m_stats.shadowCasterCount = 0;
+	for (auto pRenderer : m_bvhRenderers)
+	{
+		if (pRenderer->IsShadowCaster())
+			m_stats.shadowCasterCount++;
+	}
+
+	uint32_t dirtyMask = UpdateShadowCache(pLight);
+
+	// Cache is cleared every frame without its clear shader, so it's always re-rendered
+	if (!RenderWorkManager::GetInstance()->IsShadowCacheEnabled())
+		dirtyMask = allCascades;
+
+	// Static casters of valid caches are already there
+	for (auto pRenderer : m_currentStaticShadowCasters)
+		pRenderer->SetShadowCascadeMask(pRenderer->GetShadowCascadeMask() & dirtyMask);
+
+	UniformData::GetInstance()->GetPerFrameUniforms()->SetShadowCacheDirtyMask(dirtyMask);
+
+	m_stats.dirtyShadowCacheCount = 0;
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		if (dirtyMask & (1 << i))
+			m_stats.dirtyShadowCacheCount++;
+	}
+}
+
+uint32_t CullingManager::UpdateShadowCache(const std::shared_ptr<DirectionLight>& pLight)
+{
+	uint32_t allCascades = (1 << SHADOW_CASCADE_COUNT) - 1;
+
+	m_currentStaticShadowCasters.clear();
+	for (auto pRenderer : m_bvhRenderers)
+	{
+		if (pRenderer->IsStaticShadowCaster())
+			m_currentStaticShadowCasters.push_back(pRenderer);
+	}
+
+	if (m_pShadowCacheLight != pLight.get() || m_currentStaticShadowCasters != m_staticShadowCasters)
+	{
+		// Can't tell where removed casters were, simply start over
+		InvalidateShadowCache(allCascades);
+		m_staticShadowCasters = m_currentStaticShadowCasters;
+		m_pShadowCacheLight = pLight.get();
+	}
+	else
+	{
+		// A moved static caster invalidates cascades it leaves, and the ones it enters, which are already in its cascade mask
+		uint32_t invalidMask = 0;
+		for (auto pRenderer : m_currentStaticShadowCasters)
+		{
+			if (!pRenderer->IsWorldBoundsChanged())
+				continue;
+
+			invalidMask |= pRenderer->GetShadowCascadeMask();
+			for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+			{
+				if ((invalidMask & (1 << i)) == 0 && pLight->GetCascadeVolume(i).IntersectAABB(pRenderer->GetPrevWorldBounds()))
+					invalidMask |= (1 << i);
+			}
+		}
+		InvalidateShadowCache(invalidMask);
+	}
+
+	// Cache of this frame index is rendered within this frame, its state is up to date from now on
+	ShadowCacheState& state = m_shadowCacheStates[FrameWorkManager::GetInstance()->FrameIndex()];
+
+	uint32_t dirtyMask = state.invalidMask;
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		if (state.cascadeVersions[i] != pLight->GetCascadeVersion(i))
+			dirtyMask |= (1 << i);
+
+		state.cascadeVersions[i] = pLight->GetCascadeVersion(i);
+	}
+	state.invalidMask = 0;
+
+	return dirtyMask;
+}
+
+void CullingManager::InvalidateShadowCache(uint32_t cascadeMask)
+{
+	// Every frame index has its own cache, and each of them missed this change
+	if (m_shadowCacheStates.size() < FrameWorkManager::GetInstance()->MaxFrameCount())
+		m_shadowCacheStates.resize(FrameWorkManager::GetInstance()->MaxFrameCount(), { {}, (uint32_t)(1 << SHADOW_CASCADE_COUNT) - 1 });
+
+	for (auto& state : m_shadowCacheStates)
+		state.invalidMask |= cascadeMask;
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../common/Singleton.h"
+#include "../Maths/PyramidFrustum.h"
+#include "../Maths/BoundingVolumeHierarchy.h"
+#include "../Maths/MaskedOcclusionBuffer.h"
+#include "PerFrameUniforms.h"
+#include <vector>
+
+class BaseObject;
+class MeshRenderer;
+class PhysicalCamera;
+class DirectionLight;
+
+// Culling stage between OnPreRender and OnRenderObject
+// Renderers outside camera view frustum are marked invisible, so that they don't get inserted into scene render queue
+// Bounds of cullable renderers are kept in a BVH, which is refitted every frame and rebuilt when renderer set changes
+// Optionally, renderers passing frustum test are tested against a software occlusion buffer, which visible occluders are rasterized into
+// Static shadow cache of every frame index is tracked here too, a cascade of it is re-rendered only if cascade volume changes,
+// or static casters inside the volume move, appear or disappear
+class CullingManager : public Singleton<CullingManager>
+{
+public:
+	typedef struct _CullingStats
+	{
+		uint32_t	rendererCount = 0;		// All renderers under root object
+		uint32_t	testedCount = 0;		// Renderers that are tested against frustum
+		uint32_t	aabbCulledCount = 0;	// Culled by AABB test, includes culled by BVH
+		uint32_t	visibleCount = 0;		// Renderers that are submitted, including ones not tested
+		uint32_t	visitedNodeCount = 0;	// BVH nodes visited by camera query
+		uint32_t	rebuiltSubTreeCount = 0;// BVH sub trees rebuilt by refit this frame
+		uint32_t	shadowCasterCount = 0;	// Tested renderers inside volume of any shadow cascade
+		uint32_t	dirtyShadowCacheCount = 0;	// Cascades of static shadow cache re-rendered this frame
+		uint32_t	occluderCount = 0;			// Visible occluders rasterized into software occlusion buffer
+		uint32_t	occluderTriangleCount = 0;	// Occluder triangles left after clipping and back face culling
+		uint32_t	occlusionCulledCount = 0;	// Culled by software occlusion test
+	}CullingStats;
+
+public:
+	bool Init() override;
+
+public:
+	// Update BVH with published renderer bounds, then test every renderer under "pRootObject" against camera frustum
+	void FrustumCull(const std::shared_ptr<BaseObject>& pRootObject, const std::shared_ptr<PhysicalCamera>& pCamera);
+	// Select shadow casters of every cascade with its volume, has to be called after FrustumCull() in the same frame
+	// Static casters are only selected for cascades whose static shadow cache is re-rendered this frame
+	void ShadowCasterCull(const std::shared_ptr<DirectionLight>& pLight);
+
+	void SetFrustumCullingEnabled(bool flag) { m_frustumCullingEnabled = flag; }
+	bool IsFrustumCullingEnabled() const { return m_frustumCullingEnabled; }
+	// Without BVH, renderers are tested with flat batched SIMD tests
+	void SetBVHEnabled(bool flag) { m_bvhEnabled = flag; }
+	bool IsBVHEnabled() const { return m_bvhEnabled; }
+	// Only takes effect with frustum culling, occlusion culled renderers still cast shadow
+	void SetOcclusionCullingEnabled(bool flag) { m_occlusionCullingEnabled = flag; }
+	bool IsOcclusionCullingEnabled() const { return m_occlusionCullingEnabled; }
+
+	const CullingStats& GetStats() const { return m_stats; }
+	// Item id of BVH is index into GetBVHRenderers()
+	const BoundingVolumeHierarchy& GetBVH() const { return m_bvh; }
+	const std::vector<MeshRenderer*>& GetBVHRenderers() const { return m_bvhRenderers; }
+	const MaskedOcclusionBuffer& GetOcclusionBuffer() const { return m_occlusionBuffer; }
+
+protected:
+	typedef struct _ShadowCacheState
+	{
+		uint32_t	cascadeVersions[SHADOW_CASCADE_COUNT];	// Light cascade versions the cache is rendered with
+		uint32_t	invalidMask;							// Cascades invalidated by static casters since then
+	}ShadowCacheState;
+
+protected:
+	void UpdateBVH();
+	void FlatFrustumCull(const PyramidFrustumd& frustum, const Vector3d& cameraPosition);
+	// Rasterize visible occluders, then hide visible renderers behind them
+	void OcclusionCull(const std::shared_ptr<PhysicalCamera>& pCamera);
+	// Returns mask of cascades whose static shadow cache of current frame index has to be re-rendered
+	uint32_t UpdateShadowCache(const std::shared_ptr<DirectionLight>& pLight);
+	void InvalidateShadowCache(uint32_t cascadeMask);
+
+protected:
+	bool						m_frustumCullingEnabled = true;
+	bool						m_bvhEnabled = true;
+	bool						m_occlusionCullingEnabled = false;
+	CullingStats				m_stats;
+
+	// Cullable renderers of this frame, and the ones BVH was built with
+	std::vector<MeshRenderer*>	m_testedRenderers;
+	std::vector<MeshRenderer*>	m_bvhRenderers;
+	BoundingVolumeHierarchy		m_bvh;
+	std::vector<uint32_t>		m_queryResults;
+
+	// SoA bounds for flat path, camera relative to keep single precision accurate
+	std::vector<float>			m_centerX;
+	std::vector<float>			m_centerY;
+	std::vector<float>			m_centerZ;
+	std::vector<float>			m_extentX;
+	std::vector<float>			m_extentY;
+	std::vector<float>			m_extentZ;
+	std::vector<uint8_t>		m_aabbVisible;
+
+	MaskedOcclusionBuffer		m_occlusionBuffer;
+
+	// Shadow cache of each frame index, and static casters of last frame
+	std::vector<ShadowCacheState>	m_shadowCacheStates;
+	std::vector<MeshRenderer*>		m_staticShadowCasters;
+	std::vector<MeshRenderer*>		m_currentStaticShadowCasters;
+	const DirectionLight*			m_pShadowCacheLight = nullptr;
+};
\ No newline at end of file
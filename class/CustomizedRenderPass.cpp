@@ -18,7 +18,7 @@ bool CustomizedRenderPass::Init(const std::shared_ptr<CustomizedRenderPass>& pSe
 		attachmentDescs[i].initialLayout = attachList[i].initialLayout;
 		attachmentDescs[i].finalLayout = attachList[i].finalLayout;
 		attachmentDescs[i].format = attachList[i].format;
-		attachmentDescs[i].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachmentDescs[i].loadOp = attachList[i].loadOp;
 		attachmentDescs[i].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 		attachmentDescs[i].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		attachmentDescs[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
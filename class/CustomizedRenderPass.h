@@ -13,6 +13,7 @@ public:
 		VkImageLayout	initialLayout;
 		VkImageLayout	finalLayout;
 		VkClearValue	clearValue;
+		VkAttachmentLoadOp	loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;	// Load to render on top of previous content
 	}RenderPassAttachDesc;
 
 protected:
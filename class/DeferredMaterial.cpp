@@ -5,6 +5,7 @@
 #include "../vulkan/Framebuffer.h"
 #include "../vulkan/GlobalVulkanStates.h"
 #include "../vulkan/SharedIndirectBuffer.h"
+#include "../vulkan/SharedBufferManager.h"
 #include "../vulkan/DescriptorSet.h"
 #include "../vulkan/Image.h"
 #include "../vulkan/GraphicPipeline.h"
@@ -20,7 +21,7 @@
 #include "FrameBufferDiction.h"
 #include "../common/Util.h"
 
-std::shared_ptr<GBufferMaterial> GBufferMaterial::CreateDefaultMaterial(bool skinned)
+std::shared_ptr<GBufferMaterial> GBufferMaterial::CreateDefaultMaterial(bool skinned, bool preSkinned)
 {
 	std::vector<UniformVar> vars =
 	{
@@ -49,16 +50,21 @@ std::shared_ptr<GBufferMaterial> GBufferMaterial::CreateDefaultMaterial(bool ski
 	};
 
 	SimpleMaterialCreateInfo simpleMaterialInfo = {};
-	std::wstring vert = skinned ? L"../data/shaders/pbr_gbuffer_gen_skinned.vert.spv" : L"../data/shaders/pbr_gbuffer_gen.vert.spv";
+	bool vertexSkinned = skinned && !preSkinned;
+	std::wstring vert = L"../data/shaders/pbr_gbuffer_gen.vert.spv";
+	if (skinned)
+		vert = preSkinned ? L"../data/shaders/pbr_gbuffer_gen_preskinned.vert.spv" : L"../data/shaders/pbr_gbuffer_gen_skinned.vert.spv";
 	simpleMaterialInfo.shaderPaths = { vert, L"", L"", L"", L"../data/shaders/pbr_gbuffer_gen.frag.spv", L"" };
 	simpleMaterialInfo.materialUniformVars = vars;
-	simpleMaterialInfo.vertexFormat = skinned ? VertexFormatPNTCTB : VertexFormatPNTCT;
-	simpleMaterialInfo.vertexFormatInMem = skinned ? VertexFormatPNTCTB : VertexFormatPNTCT;
+	simpleMaterialInfo.vertexFormat = vertexSkinned ? VertexFormatPNTCTB : VertexFormatPNTCT;
+	simpleMaterialInfo.vertexFormatInMem = vertexSkinned ? VertexFormatPNTCTB : VertexFormatPNTCT;
 	simpleMaterialInfo.subpassIndex = 0;
 	simpleMaterialInfo.frameBufferType = FrameBufferDiction::FrameBufferType_GBuffer;
 	simpleMaterialInfo.pRenderPass = RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassGBuffer);
 
 	std::shared_ptr<GBufferMaterial> pGbufferMaterial = std::make_shared<GBufferMaterial>();
+	// Layout customization depends on it
+	pGbufferMaterial->m_skinned = skinned && preSkinned;
 
 	VkGraphicsPipelineCreateInfo createInfo = {};
 
@@ -159,7 +165,18 @@ std::shared_ptr<GBufferMaterial> GBufferMaterial::CreateDefaultMaterial(bool ski
 	createInfo.subpass = simpleMaterialInfo.subpassIndex;
 	createInfo.renderPass = simpleMaterialInfo.pRenderPass->GetRenderPass()->GetDeviceHandle();
 
-	if (pGbufferMaterial.get() && pGbufferMaterial->Init(pGbufferMaterial, simpleMaterialInfo.shaderPaths, simpleMaterialInfo.pRenderPass, createInfo, simpleMaterialInfo.materialUniformVars, simpleMaterialInfo.vertexFormat, simpleMaterialInfo.vertexFormatInMem, true))
-		return pGbufferMaterial;
-	return nullptr;
+	if (!pGbufferMaterial->Init(pGbufferMaterial, simpleMaterialInfo.shaderPaths, simpleMaterialInfo.pRenderPass, createInfo, simpleMaterialInfo.materialUniformVars, simpleMaterialInfo.vertexFormat, simpleMaterialInfo.vertexFormatInMem, true))
+		return nullptr;
+
+	// Binding right after material uniforms
+	if (pGbufferMaterial->m_skinned)
+		pGbufferMaterial->GetDescriptorSet()->UpdateShaderStorageBuffer(MaterialUniformStorageTypeCount, VertexAttribBufferMgr(VertexFormatP)->GetBuffer());
+
+	return pGbufferMaterial;
+}
+
+void GBufferMaterial::CustomizeMaterialLayout(std::vector<UniformVarList>& materialLayout)
+{
+	if (m_skinned)
+		materialLayout.push_back({ StorageBuffer, "PrevPositions", {} });
 }
\ No newline at end of file
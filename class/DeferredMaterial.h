@@ -6,11 +6,19 @@ class RenderPassBase;
 class GBufferMaterial : public Material
 {
 public:
-	static std::shared_ptr<GBufferMaterial> CreateDefaultMaterial(bool skinned = false);
+	// Skinned material draws skinning targets written by "SkinningMaterial", with previous positions for motion vectors
+	// Without "preSkinned" it skins in vertex shader instead, with bones of both frames
+	static std::shared_ptr<GBufferMaterial> CreateDefaultMaterial(bool skinned = false, bool preSkinned = true);
 
 public:
 	void Draw(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false) override
 	{
 		DrawIndirect(pCmdBuf, pFrameBuffer, pingpong, overrideVP);
 	}
+
+protected:
+	void CustomizeMaterialLayout(std::vector<UniformVarList>& materialLayout) override;
+
+protected:
+	bool	m_skinned = false;
 };
\ No newline at end of file
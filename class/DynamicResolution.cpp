@@ -0,0 +1,97 @@
+#include "DynamicResolution.h"
+#include "GPUProfiler.h"
+#include "UniformData.h"
+#include "GlobalUniforms.h"
+#include "FrameBufferDiction.h"
+#include "../vulkan/GlobalDeviceObjects.h"
+#include "../vulkan/GlobalVulkanStates.h"
+#include "../common/Macros.h"
+
+const double DynamicResolution::SCALE_STEP = 0.05;
+const double DynamicResolution::DEFAULT_TARGET_FRAME_TIME = 1000.0 / 60.0;
+const double DynamicResolution::HEADROOM = 0.15;
+
+bool DynamicResolution::Init()
+{
+	if (!Singleton<DynamicResolution>::Init())
+		return false;
+
+	m_renderWidth = FrameBufferDiction::WINDOW_WIDTH;
+	m_renderHeight = FrameBufferDiction::WINDOW_HEIGHT;
+
+	return true;
+}
+
+void DynamicResolution::SetEnabled(bool enabled)
+{
+	m_enabled = enabled;
+	ASSERTION(!m_enabled || GPUProfiler::GetInstance()->IsEnabled());
+
+	m_lastResolvedFrameCount = GPUProfiler::GetInstance()->GetResolvedFrameCount();
+	m_pendingDirection = 0;
+	m_pendingFrameCount = 0;
+
+	if (!m_enabled)
+		m_scaleLevel = 0;
+}
+
+void DynamicResolution::Update()
+{
+	uint32_t resolvedFrameCount = GPUProfiler::GetInstance()->GetResolvedFrameCount();
+	if (m_enabled && resolvedFrameCount != m_lastResolvedFrameCount)
+	{
+		m_lastResolvedFrameCount = resolvedFrameCount;
+
+		double frameTimeMs = GPUProfiler::GetInstance()->GetLatestScopeTime("Frame");
+		if (frameTimeMs >= 0)
+			UpdateScaleLevel(frameTimeMs);
+	}
+
+	ApplyScaleLevel();
+}
+
+void DynamicResolution::UpdateScaleLevel(double frameTimeMs)
+{
+	// 1: lower scale, -1: raise scale
+	int32_t direction = 0;
+	if (frameTimeMs > m_targetFrameTimeMs)
+		direction = 1;
+	else if (frameTimeMs < m_targetFrameTimeMs * (1.0 - HEADROOM))
+		direction = -1;
+
+	if (direction != m_pendingDirection)
+	{
+		m_pendingDirection = direction;
+		m_pendingFrameCount = 0;
+	}
+
+	// Results lag behind by frames in flight, settle count covers that, so a step isn't taken twice for the same load
+	if (direction == 0 || ++m_pendingFrameCount < SETTLE_FRAME_COUNT)
+		return;
+
+	m_pendingFrameCount = 0;
+
+	if (direction > 0 && m_scaleLevel < MAX_SCALE_LEVEL)
+		m_scaleLevel++;
+	else if (direction < 0 && m_scaleLevel > 0)
+		m_scaleLevel--;
+}
+
+void DynamicResolution::ApplyScaleLevel()
+{
+	// Keep it even, so that half sized SSAO and SSR targets cover it exactly
+	uint32_t width = (uint32_t)(FrameBufferDiction::WINDOW_WIDTH * GetScale() + 0.5) & ~1u;
+	uint32_t height = (uint32_t)(FrameBufferDiction::WINDOW_HEIGHT * GetScale() + 0.5) & ~1u;
+
+	if (width == m_renderWidth && height == m_renderHeight)
+		return;
+
+	m_renderWidth = width;
+	m_renderHeight = height;
+
+	UniformData::GetInstance()->GetGlobalUniforms()->SetRenderWindowSize({ (double)m_renderWidth, (double)m_renderHeight });
+
+	// Materials drawing scene with overridden viewport pick this up when they're recorded
+	GetGlobalVulkanStates()->SetViewport({ 0, 0, (float)m_renderWidth, (float)m_renderHeight, 0, 1 });
+	GetGlobalVulkanStates()->SetScissorRect({ { 0, 0 }, { m_renderWidth, m_renderHeight } });
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "../common/Singleton.h"
+#include <cstdint>
+
+// Dynamic resolution
+// GBuffer and every pass up to temporal resolve work on a viewport of "scale" times output size, within targets of output size,
+// temporal resolve reconstructs output resolution from jittered history, nothing else is needed to upscale
+// Scale follows gpu frame time measured by GPUProfiler:
+// 1. It's quantized by "SCALE_STEP", since a change of it means prebaked command buffers have to be recorded again
+// 2. It moves one step only after frame time has been out of the band around target for "SETTLE_FRAME_COUNT" resolved frames in a row
+class DynamicResolution : public Singleton<DynamicResolution>
+{
+public:
+	static const double SCALE_STEP;
+	static const uint32_t MAX_SCALE_LEVEL = 10;		// Lowest scale is 1 - MAX_SCALE_LEVEL * SCALE_STEP
+	static const uint32_t SETTLE_FRAME_COUNT = 8;
+	static const double DEFAULT_TARGET_FRAME_TIME;	// In ms
+	static const double HEADROOM;					// Scale goes up only if frame time is this portion below target
+
+public:
+	bool Init();
+
+public:
+	// Frame time comes from GPUProfiler, so it has to be enabled as well
+	void SetEnabled(bool enabled);
+	bool IsEnabled() const { return m_enabled; }
+
+	void SetTargetFrameTime(double frameTimeMs) { m_targetFrameTimeMs = frameTimeMs; }
+	double GetTargetFrameTime() const { return m_targetFrameTimeMs; }
+
+	// Pick scale of current frame, and apply it to window size uniforms and global viewport
+	// Has to be done before anything of current frame is recorded
+	void Update();
+
+	// Level 0 is full resolution, command buffers recorded at a different level have to be recorded again
+	uint32_t GetScaleLevel() const { return m_scaleLevel; }
+	double GetScale() const { return 1.0 - m_scaleLevel * SCALE_STEP; }
+	uint32_t GetRenderWidth() const { return m_renderWidth; }
+	uint32_t GetRenderHeight() const { return m_renderHeight; }
+
+protected:
+	void UpdateScaleLevel(double frameTimeMs);
+	void ApplyScaleLevel();
+
+protected:
+	bool		m_enabled = false;
+	double		m_targetFrameTimeMs = DEFAULT_TARGET_FRAME_TIME;
+
+	uint32_t	m_scaleLevel = 0;
+	uint32_t	m_renderWidth = 0;
+	uint32_t	m_renderHeight = 0;
+
+	uint32_t	m_lastResolvedFrameCount = 0;
+	int32_t		m_pendingDirection = 0;
+	uint32_t	m_pendingFrameCount = 0;
+};
\ No newline at end of file
@@ -31,6 +31,8 @@ FrameBufferDiction::FrameBufferCombo FrameBufferDiction::CreateFrameBuffer(Frame
 		return CreateMotionNeighborMaxFrameBuffer(layer);
 	case  FrameBufferType_ShadowMap:
 		return CreateShadowMapFrameBuffer(layer);
+	case  FrameBufferType_ShadowCache:
+		return CreateShadowCacheFrameBuffer(layer);
 	case FrameBufferType_SSAOSSR:
 		return CreateSSAOSSRFrameBuffer(layer);
 	case FrameBufferType_SSAOBlurV:
@@ -189,7 +191,25 @@ FrameBufferDiction::FrameBufferCombo FrameBufferDiction::CreateShadowMapFrameBuf
 
 	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
 	{
-		std::shared_ptr<Image> pDepthStencilBuffer = Image::CreateDepthStencilSampledAttachment(GetDevice(), OFFSCREEN_DEPTH_FORMAT, { (uint32_t)windowSize.x, (uint32_t)windowSize.y });
+		// Static shadow cache is copied into it before dynamic casters are rendered
+		std::shared_ptr<Image> pDepthStencilBuffer = Image::CreateDepthStencilBuffer(GetDevice(), OFFSCREEN_DEPTH_FORMAT, { (uint32_t)windowSize.x, (uint32_t)windowSize.y }, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT);
+
+		frameBuffers.push_back(FrameBuffer::Create(GetDevice(), std::vector<std::shared_ptr<Image>>(), pDepthStencilBuffer, RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShadowMap)->GetRenderPass()));
+	}
+
+	return frameBuffers;
+}
+
+FrameBufferDiction::FrameBufferCombo FrameBufferDiction::CreateShadowCacheFrameBuffer(uint32_t layer)
+{
+	Vector2d windowSize = UniformData::GetInstance()->GetGlobalUniforms()->GetShadowGenWindowSize();
+
+	FrameBufferCombo frameBuffers;
+
+	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
+	{
+		// Same layout as shadow map, static casters only, it's kept across frames and shares render pass with shadow map
+		std::shared_ptr<Image> pDepthStencilBuffer = Image::CreateDepthStencilBuffer(GetDevice(), OFFSCREEN_DEPTH_FORMAT, { (uint32_t)windowSize.x, (uint32_t)windowSize.y }, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
 
 		frameBuffers.push_back(FrameBuffer::Create(GetDevice(), std::vector<std::shared_ptr<Image>>(), pDepthStencilBuffer, RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShadowMap)->GetRenderPass()));
 	}
@@ -25,7 +25,8 @@ public:
 	static const uint32_t WINDOW_WIDTH = 1440;
 	static const uint32_t WINDOW_HEIGHT = 1024;
 	static const uint32_t ENV_GEN_WINDOW_SIZE = 512;
-	static const uint32_t SHADOW_GEN_WINDOW_SIZE = 1024;
+	static const uint32_t SHADOW_GEN_WINDOW_SIZE = 1024;		// Size of one shadow cascade
+	static const uint32_t SHADOW_CASCADE_ATLAS_DIM = 2;			// Shadow cascades are tiled 2x2 in shadow map
 	static const uint32_t SSAO_SSR_WINDOW_WIDTH = WINDOW_WIDTH / 2;
 	static const uint32_t SSAO_SSR_WINDOW_HEIGHT = WINDOW_HEIGHT / 2;
 	static const uint32_t BLOOM_WINDOW_SIZE = 256;
@@ -40,6 +41,7 @@ public:
 		FrameBufferType_MotionTileMax,
 		FrameBufferType_MotionNeighborMax,
 		FrameBufferType_ShadowMap,
+		FrameBufferType_ShadowCache,
 		FrameBufferType_SSAOSSR,
 		FrameBufferType_SSAOBlurV,
 		FrameBufferType_SSAOBlurH,
@@ -97,6 +99,7 @@ public:
 	FrameBufferCombo CreateMotionTileMaxFrameBuffer(uint32_t layer = 0);
 	FrameBufferCombo CreateMotionNeighborMaxFrameBuffer(uint32_t layer = 0);
 	FrameBufferCombo CreateShadowMapFrameBuffer(uint32_t layer = 0);
+	FrameBufferCombo CreateShadowCacheFrameBuffer(uint32_t layer = 0);
 	FrameBufferCombo CreateSSAOSSRFrameBuffer(uint32_t layer = 0);
 	FrameBufferCombo CreateSSAOBlurFrameBufferV(uint32_t layer = 0);
 	FrameBufferCombo CreateSSAOBlurFrameBufferH(uint32_t layer = 0);
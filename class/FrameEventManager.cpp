@@ -1,7 +1,11 @@
 #include "FrameEventManager.h"
+#include "../common/AllocationTracker.h"
 
 void FrameEventManager::OnFrameBegin()
 {
+	AllocationTracker::NewFrame();
+	AllocationTracker::SetPhase(AllocationTracker::FrameBegin);
+
 	for each(auto pListener in m_Listeners)
 	{
 		pListener->OnFrameBegin();
@@ -10,6 +14,8 @@ void FrameEventManager::OnFrameBegin()
 
 void FrameEventManager::OnPostSceneTraversal()
 {
+	AllocationTracker::SetPhase(AllocationTracker::PostSceneTraversal);
+
 	for each(auto pListener in m_Listeners)
 	{
 		pListener->OnPostSceneTraversal();
@@ -18,6 +24,8 @@ void FrameEventManager::OnPostSceneTraversal()
 
 void FrameEventManager::OnPreCmdPreparation()
 {
+	AllocationTracker::SetPhase(AllocationTracker::PreCmdPreparation);
+
 	for each(auto pListener in m_Listeners)
 	{
 		pListener->OnPreCmdPreparation();
@@ -26,6 +34,8 @@ void FrameEventManager::OnPreCmdPreparation()
 
 void FrameEventManager::OnPreCmdSubmission()
 {
+	AllocationTracker::SetPhase(AllocationTracker::PreCmdSubmission);
+
 	for each(auto pListener in m_Listeners)
 	{
 		pListener->OnPreCmdSubmission();
@@ -34,6 +44,8 @@ void FrameEventManager::OnPreCmdSubmission()
 
 void FrameEventManager::OnFrameEnd()
 {
+	AllocationTracker::SetPhase(AllocationTracker::FrameEnd);
+
 	for each(auto pListener in m_Listeners)
 	{
 		pListener->OnFrameEnd();
@@ -0,0 +1,76 @@
+#include "FramePipeline.h"
+#include "FrameWorkManager.h"
+#include "../Base/BaseObject.h"
+#include "../thread/ThreadWorker.hpp"
+#include "../vulkan/GlobalDeviceObjects.h"
+
+thread_local bool FramePipeline::m_isSimulationThread = false;
+
+bool FramePipeline::Init()
+{
+	return true;
+}
+
+void FramePipeline::SetPipelined(bool pipelined)
+{
+	ASSERTION(m_pSimulatingSceneRoot == nullptr);
+
+	m_pipelined = pipelined;
+	m_simulatedAhead = false;
+
+	// Simulation worker is created only when it's needed
+	if (m_pipelined && m_pSimulationWorker == nullptr)
+		m_pSimulationWorker = std::make_shared<ThreadWorker>(GetDevice(), FrameWorkManager::GetInstance()->MaxFrameCount());
+}
+
+void FramePipeline::KickSimulation(const std::shared_ptr<BaseObject>& pSceneRoot, const std::function<void()>& simulationFunc)
+{
+	ASSERTION(m_pipelined && m_pSimulatingSceneRoot == nullptr);
+
+	// Build pools here if needed, they can't be rebuilt while 2 stages iterate them
+	pSceneRoot->GetComponentStorage()->EnsurePools();
+	pSceneRoot->GetComponentStorage()->SetPoolsLocked(true);
+	m_pSimulatingSceneRoot = pSceneRoot;
+
+	ThreadWorker::ThreadJob job;
+	job.job = [simulationFunc](const std::shared_ptr<PerFrameResource>& pPerFrameRes)
+	{
+		m_isSimulationThread = true;
+		simulationFunc();
+		m_isSimulationThread = false;
+	};
+	job.frameIndex = FrameWorkManager::GetInstance()->FrameIndex();
+	m_pSimulationWorker->AppendJob(job);
+}
+
+void FramePipeline::JoinSimulation()
+{
+	if (m_pSimulatingSceneRoot == nullptr)
+		return;
+
+	m_pSimulationWorker->WaitForFree();
+
+	m_pSimulatingSceneRoot->GetComponentStorage()->SetPoolsLocked(false);
+
+	// Nothing else is running at this point
+	for (auto& updateFunc : m_pendingRenderStateUpdates)
+		updateFunc();
+	m_pendingRenderStateUpdates.clear();
+
+	m_pSimulatingSceneRoot->PublishCachedData();
+	m_pSimulatingSceneRoot = nullptr;
+
+	m_simulatedAhead = true;
+}
+
+void FramePipeline::UpdateRenderState(const std::function<void()>& updateFunc)
+{
+	if (!m_isSimulationThread)
+	{
+		updateFunc();
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(m_renderStateMutex);
+	m_pendingRenderStateUpdates.push_back(updateFunc);
+}
\ No newline at end of file
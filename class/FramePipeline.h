@@ -0,0 +1,53 @@
+#pragma once
+
+#include "../common/Singleton.h"
+#include <memory>
+#include <functional>
+#include <vector>
+#include <mutex>
+
+class BaseObject;
+class ThreadWorker;
+
+// Pipelined frame mode
+// Simulation of frame N+1(Update, OnAnimationUpdate, LateUpdate and UpdateCachedData) runs on a dedicated worker,
+// concurrently with culling, render data extraction, command recording and submission of frame N on main thread
+// State is handed from simulation to render stage in two ways:
+// 1. Cached world transforms are double buffered in BaseObject, simulation writes back buffers, render stage reads front ones,
+//    they're swapped when both stages are joined
+// 2. Other render state simulation changes(material parameters, camera jitter, etc.) goes through "UpdateRenderState()",
+//    it's queued and applied when both stages are joined, before render stage of next frame reads it
+// Frame N is still submitted within the tick it's rendered, so gpu latency is unchanged, simulation is simply one tick ahead
+class FramePipeline : public Singleton<FramePipeline>
+{
+public:
+	bool Init();
+
+public:
+	// Takes effect from next tick
+	void SetPipelined(bool pipelined);
+	bool IsPipelined() const { return m_pipelined; }
+	// If simulation of frame about to render has been done in previous tick
+	bool IsSimulatedAhead() const { return m_pipelined && m_simulatedAhead; }
+
+	// Start simulating next frame on worker, component pools of "pSceneRoot" are locked until joined
+	void KickSimulation(const std::shared_ptr<BaseObject>& pSceneRoot, const std::function<void()>& simulationFunc);
+	// Wait for simulation kicked, apply queued render state and publish cached data of scene root
+	void JoinSimulation();
+
+	// Applied immediately, unless it's called by simulation running concurrently with render stage
+	void UpdateRenderState(const std::function<void()>& updateFunc);
+	static bool IsConcurrentSimulation() { return m_isSimulationThread; }
+
+protected:
+	std::shared_ptr<ThreadWorker>		m_pSimulationWorker;
+	std::shared_ptr<BaseObject>			m_pSimulatingSceneRoot;
+
+	std::mutex							m_renderStateMutex;
+	std::vector<std::function<void()>>	m_pendingRenderStateUpdates;
+
+	bool								m_pipelined = false;
+	bool								m_simulatedAhead = false;
+
+	static thread_local bool			m_isSimulationThread;
+};
\ No newline at end of file
@@ -10,16 +10,44 @@
 #include "../vulkan/Semaphore.h"
 #include "../vulkan/CommandBuffer.h"
 #include "../vulkan/Queue.h"
+#include "../vulkan/TimelineSemaphore.h"
 #include "../thread/ThreadTaskQueue.hpp"
 #include <algorithm>
 #include "../vulkan/Semaphore.h"
 #include "PerFrameResource.h"
+#include "../common/FrameArena.h"
 #include <stack>
 
+// Stages and values are kept aligned with semaphores, values are only needed if there's a timeline semaphore
+static void AppendWait(Queue::SubmissionBatch& batch, const std::shared_ptr<Semaphore>& pSemaphore, VkPipelineStageFlags waitStage, uint64_t value = 0)
+{
+	batch.waitStages.resize(batch.waitSemaphores.size(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+	batch.waitSemaphores.push_back(pSemaphore);
+	batch.waitStages.push_back(waitStage);
+
+	if (value != 0)
+	{
+		batch.waitValues.resize(batch.waitSemaphores.size(), 0);
+		batch.waitValues.back() = value;
+	}
+}
+
+static void AppendSignal(Queue::SubmissionBatch& batch, const std::shared_ptr<Semaphore>& pSemaphore, uint64_t value = 0)
+{
+	batch.signalSemaphores.push_back(pSemaphore);
+
+	if (value != 0)
+	{
+		batch.signalValues.resize(batch.signalSemaphores.size(), 0);
+		batch.signalValues.back() = value;
+	}
+}
+
 bool FrameWorkManager::Init()
 {
 	m_currentSemaphoreIndex = 0;
 	m_maxFrameCount = GetSwapChain()->GetSwapChainImageCount();
+	ASSERTION(m_maxFrameCount <= FrameArena::MAX_FRAME_COUNT);
 
 	for (uint32_t i = 0; i < m_maxFrameCount; i++)
 	{
@@ -27,10 +55,20 @@ bool FrameWorkManager::Init()
 		m_frameFences.push_back(Fence::Create(GetDevice()));
 		m_extraFrameFences.push_back(ExtraFences::Create());
 		m_acquireDoneSemaphores.push_back(Semaphore::Create(GetDevice()));
+		m_renderDoneSemaphores.push_back(Semaphore::Create(GetDevice()));
+		m_pendingSubmissionInfoTable[i].resize((uint32_t)PhysicalDevice::QueueFamily::COUNT, { {}, {}, false });
+		m_submissionInfoTable[i].resize((uint32_t)PhysicalDevice::QueueFamily::COUNT, { {}, {}, false });
 	}
 
-	m_renderDoneSemaphores.resize(m_maxFrameCount);
-	m_renderDoneSemaphoreIndex = 0;
+	m_timelineSemaphoreEnabled = GetDevice()->IsTimelineSemaphoreEnabled();
+	m_queueTimelines.resize((uint32_t)PhysicalDevice::QueueFamily::COUNT);
+	m_queueTimelineValues.resize((uint32_t)PhysicalDevice::QueueFamily::COUNT, 0);
+	m_frameTimelineValues.resize(m_maxFrameCount, std::vector<uint64_t>((uint32_t)PhysicalDevice::QueueFamily::COUNT, 0));
+	if (m_timelineSemaphoreEnabled)
+	{
+		for (uint32_t i = 0; i < (uint32_t)PhysicalDevice::QueueFamily::COUNT; i++)
+			m_queueTimelines[i] = TimelineSemaphore::Create(GetDevice());
+	}
 
 	for (uint32_t i = 0; i < m_maxFrameCount; i++)
 		m_mainThreadPerFrameRes.push_back(FrameWorkManager::GetInstance()->AllocatePerFrameResource(i));
@@ -113,6 +151,23 @@ void FrameWorkManager::WaitForFence(uint32_t frameIndex)
 	m_extraFrameFences[frameIndex]->Reset();
 }
 
+void FrameWorkManager::WaitForTimeline(uint32_t frameIndex)
+{
+	for (uint32_t i = 0; i < (uint32_t)PhysicalDevice::QueueFamily::COUNT; i++)
+	{
+		if (m_frameTimelineValues[frameIndex][i] != 0)
+			m_queueTimelines[i]->Wait(m_frameTimelineValues[frameIndex][i]);
+	}
+}
+
+uint64_t FrameWorkManager::NextTimelineValue(PhysicalDevice::QueueFamily queueFamily)
+{
+	// Submissions to a queue family are made in order under "m_mutex", so values are always increasing
+	uint64_t value = ++m_queueTimelineValues[(uint32_t)queueFamily];
+	m_frameTimelineValues[m_currentFrameIndex][(uint32_t)queueFamily] = value;
+	return value;
+}
+
 void FrameWorkManager::WaitForAllJobsDone()
 {
 	GlobalThreadTaskQueue()->WaitForFree();
@@ -143,6 +198,9 @@ void FrameWorkManager::AfterAcquire(uint32_t index)
 	std::unique_lock<std::mutex> lock(m_mutex);
 	WaitForGPUWork(index);
 	m_currentFrameIndex = index;
+
+	// Transient cpu data of this frame index is released long ago, it's safe to rewind its arenas
+	FrameArena::BeginFrame(index);
 }
 
 void FrameWorkManager::AcquireNextImage()
@@ -159,7 +217,7 @@ void FrameWorkManager::QueuePresentImage()
 	// Flush pending submissions before present
 	EndJobSubmission();
 
-	GetSwapChain()->QueuePresentImage(GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::ALL_ROUND), GetRenderDoneSemaphores(), m_currentFrameIndex);
+	GetSwapChain()->QueuePresentImage(GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::ALL_ROUND), { GetRenderDoneSemaphore() }, m_currentFrameIndex);
 }
 
 void FrameWorkManager::SubmitCommandBuffers(
@@ -196,31 +254,28 @@ void FrameWorkManager::SubmitCommandBuffersInternal(
 	bool waitUtilQueueIdle,
 	bool cache)
 {
+	uint32_t queueFamily = (uint32_t)pQueue->GetQueueFamily();
+	Queue::SubmissionBatch batch = { cmdBuffer, waitSemaphores, {}, waitStages, signalSemaphores, {} };
+
 	if (cache)
 	{
-		// Attach acquire done semaphore to waiting list
-		std::vector<std::shared_ptr<Semaphore>> _waitSemaphores = waitSemaphores;
-		_waitSemaphores.push_back(GetAcqurieDoneSemaphore());
+		// Cached ones are submitted together when frame ends, see "FlushCachedSubmission()"
+		QueueSubmissions& submissions = m_pendingSubmissionInfoTable[m_currentFrameIndex][queueFamily];
+		submissions.batches.push_back(batch);
+		submissions.waitUtilQueueIdle |= waitUtilQueueIdle;
+	}
+	else if (m_timelineSemaphoreEnabled)
+	{
+		uint64_t value = NextTimelineValue(pQueue->GetQueueFamily());
+		AppendSignal(batch, m_queueTimelines[queueFamily], value);
 
-		std::vector<VkPipelineStageFlags> _waitStages;
-		_waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		pQueue->SubmitBatches({ batch }, nullptr);
 
-		// Attach render done semaphores to signal list
-		std::vector<std::shared_ptr<Semaphore>> _signalSemaphores = signalSemaphores;
-		_signalSemaphores.insert(_signalSemaphores.end(), signalSemaphores.begin(), signalSemaphores.end());
-		_signalSemaphores.push_back(GetRenderDoneSemaphore());
+		if (waitUtilQueueIdle)
+			m_queueTimelines[queueFamily]->Wait(value);
 
-		SubmissionInfo info =
-		{
-			pQueue,
-			cmdBuffer,
-			_waitSemaphores,
-			_waitStages,
-			_signalSemaphores,
-			waitUtilQueueIdle,
-		};
-
-		m_pendingSubmissionInfoTable[m_currentFrameIndex].push_back(info);
+		// Objects used for this submission are held until frame's timeline values are reached
+		m_submissionInfoTable[m_currentFrameIndex][queueFamily].batches.push_back(batch);
 	}
 	else
 	{
@@ -239,26 +294,105 @@ void FrameWorkManager::SubmitCommandBuffersInternal(
 	}
 }
 
+// All cached work of a frame goes to each queue with one vkQueueSubmit
+// Present queue always gets a submission, its first batch waits for acquire done and its last batch signals render done
+// With timeline semaphores, each batch signals the next value of its queue's timeline, the last one of a frame is what cpu waits for
+// Otherwise present queue signals frame fence and other queues signal extra fences
 void FrameWorkManager::FlushCachedSubmission(uint32_t frameIndex)
 {
-	if (m_pendingSubmissionInfoTable[frameIndex].size() == 0)
-		return;
+	std::vector<QueueSubmissions>& pendingSubmissions = m_pendingSubmissionInfoTable[frameIndex];
 
-	// Flush pending cmd buffers
-	std::for_each(m_pendingSubmissionInfoTable[frameIndex].begin(), m_pendingSubmissionInfoTable[frameIndex].end(), [this, frameIndex](SubmissionInfo & info)
+	std::vector<Queue::SubmissionBatch>& presentBatches = pendingSubmissions[(uint32_t)PhysicalDevice::QueueFamily::ALL_ROUND].batches;
+	if (presentBatches.size() == 0)
+		presentBatches.push_back({});
+
+	AppendWait(presentBatches.front(), GetAcqurieDoneSemaphore(), VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+	AppendSignal(presentBatches.back(), GetRenderDoneSemaphore());
+
+	// Values are assigned to all queues up front, so that a batch could wait for one of another queue submitted after it
+	uint64_t baseValues[(uint32_t)PhysicalDevice::QueueFamily::COUNT] = {};
+	if (m_timelineSemaphoreEnabled)
 	{
-		m_frameFences[frameIndex]->Reset();
-		info.pQueue->SubmitCommandBuffers(info.cmdBuffers, info.waitSemaphores, info.waitStages, info.signalSemaphores, GetFrameFence(frameIndex), info.waitUtilQueueIdle);
-	});
-
-	// Add submitted cmd buffer references here, just to make sure they won't be deleted util this submission finished
-	m_submissionInfoTable[frameIndex].insert(
-		m_submissionInfoTable[frameIndex].end(),
-		m_pendingSubmissionInfoTable[frameIndex].begin(),
-		m_pendingSubmissionInfoTable[frameIndex].end());
-
-	// Clear pending submissions
-	m_pendingSubmissionInfoTable[frameIndex].clear();
+		for (uint32_t i = 0; i < (uint32_t)PhysicalDevice::QueueFamily::COUNT; i++)
+		{
+			if (pendingSubmissions[i].batches.size() == 0)
+				continue;
+
+			baseValues[i] = m_queueTimelineValues[i];
+			m_queueTimelineValues[i] += pendingSubmissions[i].batches.size();
+			m_frameTimelineValues[frameIndex][i] = m_queueTimelineValues[i];
+		}
+	}
+
+	for (uint32_t i = 0; i < (uint32_t)PhysicalDevice::QueueFamily::COUNT; i++)
+	{
+		QueueSubmissions& submissions = pendingSubmissions[i];
+		if (submissions.batches.size() == 0)
+			continue;
+
+		PhysicalDevice::QueueFamily queueFamily = (PhysicalDevice::QueueFamily)i;
+		const std::shared_ptr<Queue>& pQueue = GlobalObjects()->GetQueue(queueFamily);
+
+		std::shared_ptr<Fence> pFence;
+		if (m_timelineSemaphoreEnabled)
+		{
+			for (uint32_t j = 0; j < (uint32_t)submissions.batches.size(); j++)
+				AppendSignal(submissions.batches[j], m_queueTimelines[i], baseValues[i] + j + 1);
+
+			for (auto& wait : submissions.waits)
+			{
+				uint32_t waitQueueFamily = (uint32_t)wait.waitFor.queueFamily;
+				ASSERTION(wait.waitFor.index < pendingSubmissions[waitQueueFamily].batches.size());
+				AppendWait(submissions.batches[wait.batchIndex], m_queueTimelines[waitQueueFamily], wait.waitStage, baseValues[waitQueueFamily] + wait.waitFor.index + 1);
+			}
+		}
+		else if (queueFamily == PhysicalDevice::QueueFamily::ALL_ROUND)
+		{
+			m_frameFences[frameIndex]->Reset();
+			pFence = GetFrameFence(frameIndex);
+		}
+		else
+			pFence = m_extraFrameFences[frameIndex]->GetNewFence();
+
+		pQueue->SubmitBatches(submissions.batches, pFence);
+
+		if (submissions.waitUtilQueueIdle)
+		{
+			if (m_timelineSemaphoreEnabled)
+				m_queueTimelines[i]->Wait(m_frameTimelineValues[frameIndex][i]);
+			else
+				pQueue->WaitForIdle();
+		}
+
+		// Add submitted batches here, just to make sure objects they use won't be deleted until this submission finished
+		std::vector<Queue::SubmissionBatch>& submittedBatches = m_submissionInfoTable[frameIndex][i].batches;
+		submittedBatches.insert(submittedBatches.end(), std::make_move_iterator(submissions.batches.begin()), std::make_move_iterator(submissions.batches.end()));
+
+		// Clear pending submissions
+		submissions.batches.clear();
+		submissions.waits.clear();
+		submissions.waitUtilQueueIdle = false;
+	}
+}
+
+FrameWorkManager::SubmissionRef FrameWorkManager::SubmitDependentCommandBuffers(
+	const std::shared_ptr<Queue>& pQueue,
+	const std::vector<std::shared_ptr<CommandBuffer>>& cmdBuffer,
+	const std::vector<SubmissionRef>& waitSubmissions,
+	const std::vector<VkPipelineStageFlags>& waitStages)
+{
+	ASSERTION(m_timelineSemaphoreEnabled && waitSubmissions.size() == waitStages.size());
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	QueueSubmissions& submissions = m_pendingSubmissionInfoTable[m_currentFrameIndex][(uint32_t)pQueue->GetQueueFamily()];
+	uint32_t batchIndex = (uint32_t)submissions.batches.size();
+
+	submissions.batches.push_back({ cmdBuffer, {}, {}, {}, {}, {} });
+	for (uint32_t i = 0; i < (uint32_t)waitSubmissions.size(); i++)
+		submissions.waits.push_back({ batchIndex, waitSubmissions[i], waitStages[i] });
+
+	return { pQueue->GetQueueFamily(), batchIndex };
 }
 
 // Add job to current frame
@@ -271,8 +405,13 @@ void FrameWorkManager::AddJobToFrame(ThreadJobFunc jobFunc)
 // Wait until those gpu work of this frame finished
 void FrameWorkManager::WaitForGPUWork(uint32_t frameIndex)
 {
-	WaitForFence(frameIndex);
-	m_submissionInfoTable[frameIndex].clear();
+	if (m_timelineSemaphoreEnabled)
+		WaitForTimeline(frameIndex);
+	else
+		WaitForFence(frameIndex);
+
+	for (auto& submissions : m_submissionInfoTable[frameIndex])
+		submissions.batches.clear();
 }
 
 // End work submission, which means that current frame's work has been submitted completely
@@ -283,9 +422,6 @@ void FrameWorkManager::EndJobSubmission()
 	std::unique_lock<std::mutex> lock(m_mutex);
 	// Flush cached submission after all cpu work done
 	FlushCachedSubmission(m_currentFrameIndex);
-
-	// Reset
-	m_renderDoneSemaphoreIndex = 0;
 }
 
 std::shared_ptr<Semaphore> FrameWorkManager::GetAcqurieDoneSemaphore() const
@@ -298,18 +434,7 @@ std::shared_ptr<Semaphore> FrameWorkManager::GetAcqurieDoneSemaphore(uint32_t fr
 	return m_acquireDoneSemaphores[frameIndex];
 }
 
-std::shared_ptr<Semaphore> FrameWorkManager::GetRenderDoneSemaphore()
-{
-	// Cached semaphores not enough? create a new one
-	if (m_renderDoneSemaphoreIndex >= m_renderDoneSemaphores[m_currentFrameIndex].size())
-		m_renderDoneSemaphores[m_currentFrameIndex].push_back(Semaphore::Create(GetDevice()));
-
-	return m_renderDoneSemaphores[m_currentFrameIndex][m_renderDoneSemaphoreIndex++];
-}
-
-std::vector<std::shared_ptr<Semaphore>> FrameWorkManager::GetRenderDoneSemaphores()
+std::shared_ptr<Semaphore> FrameWorkManager::GetRenderDoneSemaphore() const
 {
-	std::vector<std::shared_ptr<Semaphore>> semaphores;
-	semaphores.insert(semaphores.end(), m_renderDoneSemaphores[m_currentFrameIndex].begin(), m_renderDoneSemaphores[m_currentFrameIndex].begin() + m_renderDoneSemaphoreIndex + 1);
-	return semaphores;
+	return m_renderDoneSemaphores[m_currentFrameIndex];
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "../vulkan/DeviceObjectBase.h"
 #include "../common/Singleton.h"
 #include "../thread/ThreadWorker.hpp"
+#include "../vulkan/Queue.h"
 #include <map>
 #include <functional>
 #include <mutex>
@@ -13,24 +14,37 @@ class Fence;
 class PerFrameResource;
 class CommandBuffer;
 class Semaphore;
-class Queue;
+class TimelineSemaphore;
 class ThreadTaskQueue;
 
 class FrameWorkManager : public Singleton<FrameWorkManager>
 {
-	typedef struct _SubmissionInfo
+public:
+	// Refers to a cached submission of current frame
+	typedef struct _SubmissionRef
+	{
+		PhysicalDevice::QueueFamily	queueFamily;
+		uint32_t					index;			// Index among cached submissions of this queue family
+	}SubmissionRef;
+
+private:
+	typedef struct _SubmissionWait
+	{
+		uint32_t					batchIndex;
+		SubmissionRef				waitFor;
+		VkPipelineStageFlags		waitStage;
+	}SubmissionWait;
+
+	// Submissions of a frame, grouped by queue family
+	typedef struct _QueueSubmissions
 	{
-		std::shared_ptr<Queue>						pQueue;
-		std::vector<std::shared_ptr<CommandBuffer>> cmdBuffers;
-		std::vector<std::shared_ptr<Semaphore>>		waitSemaphores;
-		std::vector<VkPipelineStageFlags>			waitStages;
-		std::vector<std::shared_ptr<Semaphore>>		signalSemaphores;
+		std::vector<Queue::SubmissionBatch>			batches;
+		std::vector<SubmissionWait>					waits;			// Waits for cached submissions, resolved to timeline values when flushed
 		bool										waitUtilQueueIdle;
-		bool										submitted;
-	}SubmissionInfo;
+	}QueueSubmissions;
 
 	typedef std::map<uint32_t, std::vector<std::shared_ptr<PerFrameResource>>> FrameResourceTable;
-	typedef std::map<uint32_t, std::vector<SubmissionInfo>> SubmissionInfoTable;
+	typedef std::map<uint32_t, std::vector<QueueSubmissions>> SubmissionInfoTable;
 
 public:
 	bool Init();
@@ -56,6 +70,14 @@ public:
 		bool waitUtilQueueIdle,
 		bool cache = true);
 
+	// Cached submission waiting for other cached submissions of current frame, which could be on other queues
+	// Requires timeline semaphores, returns reference of this submission for others to wait for
+	SubmissionRef SubmitDependentCommandBuffers(
+		const std::shared_ptr<Queue>& pQueue,
+		const std::vector<std::shared_ptr<CommandBuffer>>& cmdBuffer,
+		const std::vector<SubmissionRef>& waitSubmissions,
+		const std::vector<VkPipelineStageFlags>& waitStages);
+
 	// Thread related
 	void AddJobToFrame(ThreadJobFunc jobFunc);
 	void BeforeAcquire();
@@ -68,11 +90,20 @@ public:
 
 	const std::shared_ptr<PerFrameResource>& GetMainThreadPerFrameRes() const;
 
+	// Each queue family has a timeline, signaled by each submission to it
+	// Null if timeline semaphore isn't supported, fences are used instead
+	bool IsTimelineSemaphoreEnabled() const { return m_timelineSemaphoreEnabled; }
+	std::shared_ptr<TimelineSemaphore> GetQueueTimeline(PhysicalDevice::QueueFamily queueFamily) const { return m_queueTimelines[(uint32_t)queueFamily]; }
+	// Value signaled by the last submission to this queue family so far
+	uint64_t GetQueueTimelineValue(PhysicalDevice::QueueFamily queueFamily) const { return m_queueTimelineValues[(uint32_t)queueFamily]; }
+
 protected:
 	std::shared_ptr<Fence> GetCurrentFrameFence() const { return m_frameFences[m_currentFrameIndex]; }
 	std::shared_ptr<Fence> GetFrameFence(uint32_t frameIndex) const { return m_frameFences[frameIndex]; }
 	void WaitForFence();
 	void WaitForFence(uint32_t frameIndex);
+	void WaitForTimeline(uint32_t frameIndex);
+	uint64_t NextTimelineValue(PhysicalDevice::QueueFamily queueFamily);
 
 	void FlushCachedSubmission(uint32_t frameIndex);
 	void EndJobSubmission();
@@ -81,8 +112,7 @@ protected:
 
 	std::shared_ptr<Semaphore> GetAcqurieDoneSemaphore() const;
 	std::shared_ptr<Semaphore> GetAcqurieDoneSemaphore(uint32_t frameIndex) const;
-	std::shared_ptr<Semaphore> GetRenderDoneSemaphore();
-	std::vector<std::shared_ptr<Semaphore>> GetRenderDoneSemaphores();
+	std::shared_ptr<Semaphore> GetRenderDoneSemaphore() const;
 
 	void SubmitCommandBuffersInternal(
 		const std::shared_ptr<Queue>& pQueue,
@@ -119,8 +149,12 @@ private:
 	std::vector<std::shared_ptr<ExtraFences>>	m_extraFrameFences;	// For those CBs submitting immediately
 	std::vector<std::shared_ptr<Semaphore>>		m_acquireDoneSemaphores;
 
-	std::vector<std::vector<std::shared_ptr<Semaphore>>>	m_renderDoneSemaphores;
-	uint32_t												m_renderDoneSemaphoreIndex;
+	std::vector<std::shared_ptr<Semaphore>>	m_renderDoneSemaphores;
+
+	bool											m_timelineSemaphoreEnabled;
+	std::vector<std::shared_ptr<TimelineSemaphore>>	m_queueTimelines;
+	std::vector<uint64_t>							m_queueTimelineValues;
+	std::vector<std::vector<uint64_t>>				m_frameTimelineValues;	// Values each frame has to wait for, per queue family
 
 	std::vector<std::shared_ptr<PerFrameResource>>			m_mainThreadPerFrameRes;
 
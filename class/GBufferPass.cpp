@@ -6,7 +6,7 @@
 #include "../vulkan/CommandBuffer.h"
 #include "FrameBufferDiction.h"
 
-bool GBufferPass::Init(const std::shared_ptr<GBufferPass>& pSelf)
+bool GBufferPass::Init(const std::shared_ptr<GBufferPass>& pSelf, bool loadContents)
 {
 	std::vector<VkAttachmentDescription> attachmentDescs(5);
 
@@ -55,6 +55,15 @@ bool GBufferPass::Init(const std::shared_ptr<GBufferPass>& pSelf)
 	attachmentDescs[4].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	attachmentDescs[4].samples = VK_SAMPLE_COUNT_1_BIT;
 
+	if (loadContents)
+	{
+		for (auto& attachmentDesc : attachmentDescs)
+		{
+			attachmentDesc.initialLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			attachmentDesc.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		}
+	}
+
 	std::vector<VkAttachmentReference> GBufferPassColorAttach(4);
 	GBufferPassColorAttach[0].attachment = 0;
 	GBufferPassColorAttach[0].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
@@ -138,10 +147,10 @@ bool GBufferPass::Init(const std::shared_ptr<GBufferPass>& pSelf)
 	return true;
 }
 
-std::shared_ptr<GBufferPass> GBufferPass::Create()
+std::shared_ptr<GBufferPass> GBufferPass::Create(bool loadContents)
 {
 	std::shared_ptr<GBufferPass> pDeferredRenderPass = std::make_shared<GBufferPass>();
-	if (pDeferredRenderPass != nullptr && pDeferredRenderPass->Init(pDeferredRenderPass))
+	if (pDeferredRenderPass != nullptr && pDeferredRenderPass->Init(pDeferredRenderPass, loadContents))
 		return pDeferredRenderPass;
 	return nullptr;
 }
@@ -7,10 +7,12 @@ class CommandBuffer;
 class GBufferPass : public RenderPassBase
 {
 protected:
-	bool Init(const std::shared_ptr<GBufferPass>& pSelf);
+	bool Init(const std::shared_ptr<GBufferPass>& pSelf, bool loadContents);
 
 public:
-	static std::shared_ptr<GBufferPass> Create();
+	// With "loadContents", attachments keep what a previous gbuffer pass left, for draws added on top of it
+	// It's still compatible with the one clears them, so that the same materials and frame buffers work with both
+	static std::shared_ptr<GBufferPass> Create(bool loadContents = false);
 
 public:
 	std::vector<VkClearValue> GetClearValue() override;
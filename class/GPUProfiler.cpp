@@ -0,0 +1,439 @@
+#include "GPUProfiler.h"
+#include "FrameEventManager.h"
+#include "FrameWorkManager.h"
+#include "../vulkan/GlobalDeviceObjects.h"
+#include "../vulkan/PhysicalDevice.h"
+#include "../vulkan/CommandBuffer.h"
+#include "../vulkan/CommandPool.h"
+#include "../vulkan/QueryPool.h"
+#include <algorithm>
+#include <iostream>
+#include <fstream>
+#include <cmath>
+
+static const char* CPU_PHASE_NAMES[] = { "FrameBegin", "PostSceneTraversal", "PreCmdPreparation", "PreCmdSubmission" };
+
+thread_local int32_t GPUProfiler::m_currentRecording = -1;
+
+bool GPUProfiler::Init()
+{
+	if (!Singleton<GPUProfiler>::Init())
+		return false;
+
+	FrameEventManager::GetInstance()->Register(m_pInstance);
+	m_startTime = std::chrono::steady_clock::now();
+
+	return true;
+}
+
+void GPUProfiler::SetEnabled(bool enabled)
+{
+	ASSERTION(m_recordings.empty());
+
+	m_enabled = enabled;
+	if (!m_enabled)
+		return;
+
+	m_timestampPeriodNs = GetPhysicalDevice()->GetPhysicalDeviceProperties().limits.timestampPeriod;
+
+	m_pendingFrames.resize(FrameWorkManager::GetInstance()->MaxFrameCount());
+	for (auto& frame : m_pendingFrames)
+		frame.recordingIndices.reserve(4);
+
+	// Reserved upfront, so that steady state frames don't allocate
+	m_traceFrames.resize(TRACE_FRAME_COUNT);
+	for (auto& frame : m_traceFrames)
+		frame.gpuEvents.reserve(MAX_SCOPE_COUNT);
+}
+
+uint32_t GPUProfiler::ReserveRecordings(uint32_t count)
+{
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+	uint32_t firstIndex = m_reservedRecordingCount;
+	m_reservedRecordingCount += count;
+	return firstIndex;
+}
+
+uint32_t GPUProfiler::GetNameIndex(const std::string& name)
+{
+	auto iter = m_scopeNameLookup.find(name);
+	if (iter != m_scopeNameLookup.end())
+		return iter->second;
+
+	uint32_t nameIndex = (uint32_t)m_scopeNames.size();
+	m_scopeNames.push_back(name);
+	m_scopeNameLookup[name] = nameIndex;
+
+	m_scopeHistories.push_back({ 0, std::vector<double>(STATS_WINDOW_SIZE), 0, 0 });
+	m_frameScopeTimes.push_back(-1.0);
+
+	return nameIndex;
+}
+
+uint64_t GPUProfiler::GetTimestampMask(const std::shared_ptr<CommandBuffer>& pCmdBuffer) const
+{
+	uint32_t queueFamilyIndex = pCmdBuffer->GetCommandPool()->GetInfo().queueFamilyIndex;
+	uint32_t validBits = GetPhysicalDevice()->GetQueueProperties()[queueFamilyIndex].timestampValidBits;
+
+	if (validBits == 0)
+		return 0;
+	if (validBits >= 64)
+		return ~0ull;
+	return (1ull << validBits) - 1;
+}
+
+double GPUProfiler::GetCPUTimeUs() const
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_startTime).count();
+}
+
+void GPUProfiler::BeginRecording(const std::shared_ptr<CommandBuffer>& pCmdBuffer, uint32_t recordingIndex)
+{
+	if (!m_enabled)
+		return;
+
+	ASSERTION(m_currentRecording < 0 && recordingIndex < m_reservedRecordingCount);
+
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+	if (recordingIndex >= (uint32_t)m_recordings.size())
+		m_recordings.resize(recordingIndex + 1);
+
+	Recording& recording = m_recordings[recordingIndex];
+	if (recording.pQueryPool == nullptr)
+	{
+		recording.pQueryPool = QueryPool::Create(GetDevice(), VK_QUERY_TYPE_TIMESTAMP, MAX_SCOPE_COUNT * 2);
+		recording.openScopes.reserve(MAX_SCOPE_COUNT);
+	}
+
+	pCmdBuffer->ResetQueryPool(recording.pQueryPool, 0, MAX_SCOPE_COUNT * 2);
+	recording.scopes.clear();
+	recording.queryCount = 0;
+
+	m_currentRecording = recordingIndex;
+}
+
+void GPUProfiler::EndRecording()
+{
+	if (!m_enabled)
+		return;
+
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+	ASSERTION(m_currentRecording >= 0 && m_recordings[m_currentRecording].openScopes.empty());
+	m_currentRecording = -1;
+}
+
+uint32_t GPUProfiler::GetScopeNameIndex(const std::string& name)
+{
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
+	return GetNameIndex(name);
+}
+
+void GPUProfiler::BeginScope(const std::shared_ptr<CommandBuffer>& pCmdBuffer, const char* pName)
+{
+	if (!m_enabled || m_currentRecording < 0)
+		return;
+
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+	auto iter = m_scopeLiteralLookup.find(pName);
+	if (iter == m_scopeLiteralLookup.end())
+		iter = m_scopeLiteralLookup.insert({ pName, GetNameIndex(pName) }).first;
+
+	BeginScope(pCmdBuffer, iter->second);
+}
+
+void GPUProfiler::BeginScope(const std::shared_ptr<CommandBuffer>& pCmdBuffer, uint32_t nameIndex)
+{
+	if (!m_enabled || m_currentRecording < 0)
+		return;
+
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+	Recording& recording = m_recordings[m_currentRecording];
+
+	RecordedScope scope = {};
+	scope.nameIndex = nameIndex;
+	scope.depth = (uint32_t)recording.openScopes.size();
+	scope.timestampMask = GetTimestampMask(pCmdBuffer);
+	scope.valid = scope.timestampMask != 0 && recording.queryCount + 2 <= MAX_SCOPE_COUNT * 2;
+
+	if (scope.valid)
+	{
+		scope.beginQuery = recording.queryCount;
+		recording.queryCount += 2;
+		pCmdBuffer->WriteTimestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, recording.pQueryPool, scope.beginQuery);
+	}
+
+	m_scopeHistories[scope.nameIndex].depth = scope.depth;
+	recording.openScopes.push_back((uint32_t)recording.scopes.size());
+	recording.scopes.push_back(scope);
+}
+
+void GPUProfiler::EndScope(const std::shared_ptr<CommandBuffer>& pCmdBuffer)
+{
+	if (!m_enabled || m_currentRecording < 0)
+		return;
+
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+	Recording& recording = m_recordings[m_currentRecording];
+	ASSERTION(!recording.openScopes.empty());
+
+	RecordedScope& scope = recording.scopes[recording.openScopes.back()];
+	recording.openScopes.pop_back();
+
+	if (!scope.valid)
+		return;
+
+	// Ending on a queue without timestamps, begin query is simply left unused
+	uint64_t timestampMask = GetTimestampMask(pCmdBuffer);
+	if (timestampMask == 0)
+	{
+		scope.valid = false;
+		return;
+	}
+
+	scope.timestampMask &= timestampMask;
+	pCmdBuffer->WriteTimestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, recording.pQueryPool, scope.beginQuery + 1);
+}
+
+void GPUProfiler::SubmitRecording(uint32_t recordingIndex)
+{
+	if (!m_enabled)
+		return;
+
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+	ASSERTION(recordingIndex < (uint32_t)m_recordings.size());
+	m_pendingFrames[FrameWorkManager::GetInstance()->FrameIndex()].recordingIndices.push_back(recordingIndex);
+}
+
+void GPUProfiler::ResolveFrame(uint32_t frameIndex)
+{
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+	FrameRecord& frame = m_pendingFrames[frameIndex];
+	if (frame.recordingIndices.empty())
+		return;
+
+	FrameRecord& traceFrame = m_traceFrames[m_nextTraceFrame];
+	traceFrame.frameNumber = frame.frameNumber;
+	for (uint32_t i = 0; i < CPUPhaseCount; i++)
+		traceFrame.cpuPhaseUs[i] = frame.cpuPhaseUs[i];
+	traceFrame.gpuEvents.clear();
+
+	for (uint32_t recordingIndex : frame.recordingIndices)
+		ResolveRecording(frame, m_recordings[recordingIndex], traceFrame);
+	frame.recordingIndices.clear();
+
+	if (traceFrame.gpuEvents.empty())
+		return;
+
+	for (uint32_t i = 0; i < (uint32_t)m_frameScopeTimes.size(); i++)
+	{
+		if (m_frameScopeTimes[i] < 0)
+			continue;
+
+		ScopeHistory& history = m_scopeHistories[i];
+		history.samples[history.nextSample] = m_frameScopeTimes[i];
+		history.nextSample = (history.nextSample + 1) % STATS_WINDOW_SIZE;
+		history.sampleCount++;
+
+		m_frameScopeTimes[i] = -1.0;
+	}
+
+	m_nextTraceFrame = (m_nextTraceFrame + 1) % TRACE_FRAME_COUNT;
+	if (m_traceFrameCount < TRACE_FRAME_COUNT)
+		m_traceFrameCount++;
+
+	if (++m_resolvedFrameCount % REPORT_FRAME_INTERVAL == 0)
+	{
+		Report();
+		ExportTrace("GPUProfile.json");
+	}
+}
+
+void GPUProfiler::ResolveRecording(const FrameRecord& frame, Recording& recording, FrameRecord& traceFrame)
+{
+	// Gpu clock isn't calibrated against cpu one, gpu spans of a recording are anchored at submission of its frame
+	// Offsets within a recording are exact
+	bool baseTimestampValid = false;
+	uint64_t baseTimestamp = 0;
+
+	for (auto& scope : recording.scopes)
+	{
+		if (!scope.valid)
+			continue;
+
+		uint64_t timestamps[2];
+		if (!recording.pQueryPool->GetResults(scope.beginQuery, 2, timestamps))
+			continue;
+
+		uint64_t begin = timestamps[0] & scope.timestampMask;
+		uint64_t ticks = (timestamps[1] - timestamps[0]) & scope.timestampMask;
+		double durationUs = ticks * m_timestampPeriodNs / 1000.0;
+
+		if (!baseTimestampValid)
+		{
+			baseTimestamp = begin;
+			baseTimestampValid = true;
+		}
+
+		double offsetUs = (double)(int64_t)(begin - baseTimestamp) * m_timestampPeriodNs / 1000.0;
+		traceFrame.gpuEvents.push_back({ scope.nameIndex, scope.depth, frame.cpuPhaseUs[PreCmdSubmission] + offsetUs, durationUs });
+
+		// Scopes of the same name within a frame add up
+		double& scopeTime = m_frameScopeTimes[scope.nameIndex];
+		scopeTime = (std::max)(scopeTime, 0.0) + durationUs / 1000.0;
+	}
+}
+
+void GPUProfiler::GetStats(std::vector<ScopeStats>& stats) const
+{
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+	stats.clear();
+
+	std::vector<double> samples;
+	for (uint32_t i = 0; i < (uint32_t)m_scopeHistories.size(); i++)
+	{
+		const ScopeHistory& history = m_scopeHistories[i];
+		if (history.sampleCount == 0)
+			continue;
+
+		uint32_t sampleCount = history.sampleCount < STATS_WINDOW_SIZE ? history.sampleCount : STATS_WINDOW_SIZE;
+		samples.assign(history.samples.begin(), history.samples.begin() + sampleCount);
+		std::sort(samples.begin(), samples.end());
+
+		double sum = 0;
+		for (double sample : samples)
+			sum += sample;
+
+		uint32_t p99Index = (uint32_t)std::ceil(sampleCount * 0.99) - 1;
+		stats.push_back({ m_scopeNames[i], history.depth, sampleCount, samples[0], sum / sampleCount, samples[p99Index] });
+	}
+}
+
+double GPUProfiler::GetLatestScopeTime(const std::string& name) const
+{
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+	auto iter = m_scopeNameLookup.find(name);
+	if (iter == m_scopeNameLookup.end())
+		return -1.0;
+
+	const ScopeHistory& history = m_scopeHistories[iter->second];
+	if (history.sampleCount == 0)
+		return -1.0;
+
+	return history.samples[(history.nextSample + STATS_WINDOW_SIZE - 1) % STATS_WINDOW_SIZE];
+}
+
+uint32_t GPUProfiler::GetScopeSampleCount(const std::string& name) const
+{
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+	auto iter = m_scopeNameLookup.find(name);
+	if (iter == m_scopeNameLookup.end())
+		return 0;
+
+	return m_scopeHistories[iter->second].sampleCount;
+}
+
+void GPUProfiler::Report() const
+{
+	std::vector<ScopeStats> stats;
+	GetStats(stats);
+
+	std::cout << "GPU time per pass over last " << STATS_WINDOW_SIZE << " frames(min / avg / p99, ms):\n";
+	for (auto& scopeStats : stats)
+	{
+		std::cout << "\t";
+		for (uint32_t i = 0; i < scopeStats.depth; i++)
+			std::cout << "  ";
+		std::cout << scopeStats.name << ": " << scopeStats.minMs << " / " << scopeStats.avgMs << " / " << scopeStats.p99Ms << "\n";
+	}
+}
+
+bool GPUProfiler::ExportTrace(const std::string& path) const
+{
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
+
+	std::ofstream ofs;
+	ofs.open(path, std::ios::trunc);
+	if (ofs.fail())
+		return false;
+
+	ofs << "{\"traceEvents\":[\n";
+	ofs << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+	ofs << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+
+	uint32_t firstTraceFrame = (m_nextTraceFrame + TRACE_FRAME_COUNT - m_traceFrameCount) % TRACE_FRAME_COUNT;
+	for (uint32_t i = 0; i < m_traceFrameCount; i++)
+	{
+		const FrameRecord& frame = m_traceFrames[(firstTraceFrame + i) % TRACE_FRAME_COUNT];
+
+		for (uint32_t j = 0; j < FrameEnd; j++)
+		{
+			ofs << ",\n{\"name\":\"" << CPU_PHASE_NAMES[j] << "\",\"ph\":\"X\",\"pid\":0,\"tid\":0"
+				<< ",\"ts\":" << frame.cpuPhaseUs[j] << ",\"dur\":" << frame.cpuPhaseUs[j + 1] - frame.cpuPhaseUs[j]
+				<< ",\"args\":{\"frame\":" << frame.frameNumber << "}}";
+		}
+
+		for (auto& gpuEvent : frame.gpuEvents)
+		{
+			ofs << ",\n{\"name\":\"" << m_scopeNames[gpuEvent.nameIndex] << "\",\"ph\":\"X\",\"pid\":0,\"tid\":1"
+				<< ",\"ts\":" << gpuEvent.beginUs << ",\"dur\":" << gpuEvent.durationUs
+				<< ",\"args\":{\"frame\":" << frame.frameNumber << "}}";
+		}
+	}
+
+	ofs << "\n]}\n";
+	return !ofs.fail();
+}
+
+void GPUProfiler::SetCPUPhase(CPUPhase phase)
+{
+	if (!m_enabled)
+		return;
+
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
+	m_pendingFrames[FrameWorkManager::GetInstance()->FrameIndex()].cpuPhaseUs[phase] = GetCPUTimeUs();
+}
+
+void GPUProfiler::OnFrameBegin()
+{
+	if (!m_enabled)
+		return;
+
+	// Gpu work of this frame index has been waited before acquire returns, results are ready
+	uint32_t frameIndex = FrameWorkManager::GetInstance()->FrameIndex();
+	ResolveFrame(frameIndex);
+
+	std::unique_lock<std::recursive_mutex> lock(m_mutex);
+	m_pendingFrames[frameIndex].frameNumber = m_frameNumber++;
+	SetCPUPhase(FrameBegin);
+}
+
+void GPUProfiler::OnPostSceneTraversal()
+{
+	SetCPUPhase(PostSceneTraversal);
+}
+
+void GPUProfiler::OnPreCmdPreparation()
+{
+	SetCPUPhase(PreCmdPreparation);
+}
+
+void GPUProfiler::OnPreCmdSubmission()
+{
+	SetCPUPhase(PreCmdSubmission);
+}
+
+void GPUProfiler::OnFrameEnd()
+{
+	SetCPUPhase(FrameEnd);
+}
\ No newline at end of file
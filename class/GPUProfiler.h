@@ -0,0 +1,170 @@
+#pragma once
+
+#include "../common/Singleton.h"
+#include "FrameEventListener.h"
+#include <memory>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <chrono>
+#include <mutex>
+
+class CommandBuffer;
+class QueryPool;
+
+// Per pass gpu timing with timestamp queries
+// Each recording(a command buffer, or a few of them submitted within one frame) owns a query pool, which is reset at the beginning of recording,
+// so prebaked command buffers could be resubmitted as is
+// Recordings could be made on different threads at the same time, scopes go to the recording begun on the same thread
+// A frame could submit several recordings, e.g. frame command buffers and async ibl generation
+// Results of a frame are read back when its frame index comes around again, gpu work of it is waited anyway by then, so read back never stalls
+// Rolling min/avg/p99 of every scope are kept over last "STATS_WINDOW_SIZE" frames,
+// reported and exported along with cpu frame phases as a chrome trace("chrome://tracing") every "REPORT_FRAME_INTERVAL" frames
+class GPUProfiler : public Singleton<GPUProfiler>, public IFrameEventListener
+{
+public:
+	static const uint32_t MAX_SCOPE_COUNT = 256;
+	static const uint32_t STATS_WINDOW_SIZE = 256;
+	static const uint32_t TRACE_FRAME_COUNT = 120;
+	static const uint32_t REPORT_FRAME_INTERVAL = 600;
+
+	typedef struct _ScopeStats
+	{
+		std::string	name;
+		uint32_t	depth;
+		uint32_t	sampleCount;
+		double		minMs;
+		double		avgMs;
+		double		p99Ms;
+	}ScopeStats;
+
+public:
+	bool Init();
+
+public:
+	// Has to be done before anything's recorded, prebaked command buffers won't be recorded again
+	void SetEnabled(bool enabled);
+	bool IsEnabled() const { return m_enabled; }
+
+	// Reserve "count" consecutive recording indices for a producer of command buffers, returns the first one
+	uint32_t ReserveRecordings(uint32_t count);
+	// Scopes recorded in between go to query pool of "recordingIndex", "pCmdBuffer" must be outside of render pass
+	void BeginRecording(const std::shared_ptr<CommandBuffer>& pCmdBuffer, uint32_t recordingIndex);
+	void EndRecording();
+	// Scopes could be nested, and could begin and end in different command buffers of the same recording
+	// Scopes on queues without timestamp support are skipped
+	// "pName" has to be a string literal, it's looked up by address after first use, so that recording doesn't allocate
+	void BeginScope(const std::shared_ptr<CommandBuffer>& pCmdBuffer, const char* pName);
+	// Names composed at runtime are registered once with GetScopeNameIndex(), and scopes are begun with their index
+	void BeginScope(const std::shared_ptr<CommandBuffer>& pCmdBuffer, uint32_t nameIndex);
+	uint32_t GetScopeNameIndex(const std::string& name);
+	void EndScope(const std::shared_ptr<CommandBuffer>& pCmdBuffer);
+	// Recording submitted in current frame, it mustn't be recorded again until this frame index comes around
+	void SubmitRecording(uint32_t recordingIndex);
+
+	void GetStats(std::vector<ScopeStats>& stats) const;
+	// Time of a scope in latest resolved frame, in ms, negative if it's never been measured
+	double GetLatestScopeTime(const std::string& name) const;
+	// Increased every time a frame with the scope in it is resolved, tells if GetLatestScopeTime() has a new sample
+	uint32_t GetScopeSampleCount(const std::string& name) const;
+	// Increased every time a frame's results are resolved
+	uint32_t GetResolvedFrameCount() const { return m_resolvedFrameCount; }
+	void Report() const;
+	bool ExportTrace(const std::string& path) const;
+
+public:
+	void OnFrameBegin() override;
+	void OnPostSceneTraversal() override;
+	void OnPreCmdPreparation() override;
+	void OnPreCmdSubmission() override;
+	void OnFrameEnd() override;
+
+protected:
+	enum CPUPhase
+	{
+		FrameBegin,
+		PostSceneTraversal,
+		PreCmdPreparation,
+		PreCmdSubmission,
+		FrameEnd,
+		CPUPhaseCount
+	};
+
+	typedef struct _RecordedScope
+	{
+		uint32_t	nameIndex;
+		uint32_t	depth;
+		uint32_t	beginQuery;
+		uint64_t	timestampMask;
+		bool		valid;
+	}RecordedScope;
+
+	typedef struct _Recording
+	{
+		std::shared_ptr<QueryPool>	pQueryPool;
+		std::vector<RecordedScope>	scopes;
+		std::vector<uint32_t>		openScopes;
+		uint32_t					queryCount;
+	}Recording;
+
+	typedef struct _TraceEvent
+	{
+		uint32_t	nameIndex;
+		uint32_t	depth;
+		double		beginUs;
+		double		durationUs;
+	}TraceEvent;
+
+	typedef struct _FrameRecord
+	{
+		uint64_t				frameNumber;
+		std::vector<uint32_t>	recordingIndices;
+		double					cpuPhaseUs[CPUPhaseCount];
+		std::vector<TraceEvent>	gpuEvents;
+	}FrameRecord;
+
+	typedef struct _ScopeHistory
+	{
+		uint32_t				depth;
+		std::vector<double>		samples;
+		uint32_t				sampleCount;
+		uint32_t				nextSample;
+	}ScopeHistory;
+
+	uint32_t GetNameIndex(const std::string& name);
+	uint64_t GetTimestampMask(const std::shared_ptr<CommandBuffer>& pCmdBuffer) const;
+	double GetCPUTimeUs() const;
+	void SetCPUPhase(CPUPhase phase);
+	void ResolveFrame(uint32_t frameIndex);
+	void ResolveRecording(const FrameRecord& frame, Recording& recording, FrameRecord& traceFrame);
+
+protected:
+	bool									m_enabled = false;
+	double									m_timestampPeriodNs = 1.0;
+
+	// Guards everything below, recursive since reporting reads stats while resolving
+	mutable std::recursive_mutex			m_mutex;
+
+	std::vector<Recording>					m_recordings;
+	uint32_t								m_reservedRecordingCount = 0;
+	// Recording begun on this thread
+	static thread_local int32_t				m_currentRecording;
+
+	std::vector<std::string>				m_scopeNames;
+	std::unordered_map<std::string, uint32_t>	m_scopeNameLookup;
+	std::unordered_map<const char*, uint32_t>	m_scopeLiteralLookup;
+	std::vector<ScopeHistory>				m_scopeHistories;
+	std::vector<double>						m_frameScopeTimes;
+
+	// Frames in flight, indexed by frame index
+	std::vector<FrameRecord>				m_pendingFrames;
+	uint64_t								m_frameNumber = 0;
+
+	// Resolved frames kept for trace export, ring buffer
+	std::vector<FrameRecord>				m_traceFrames;
+	uint32_t								m_traceFrameCount = 0;
+	uint32_t								m_nextTraceFrame = 0;
+	uint32_t								m_resolvedFrameCount = 0;
+
+	std::chrono::steady_clock::time_point	m_startTime;
+};
\ No newline at end of file
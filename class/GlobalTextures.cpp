@@ -12,6 +12,7 @@
 #include "../vulkan/SwapChainImage.h"
 #include "../vulkan/SwapChain.h"
 #include "../vulkan/Semaphore.h"
+#include "../vulkan/InitCommandBatcher.h"
 #include "FrameWorkManager.h"
 #include "../class/RenderWorkManager.h"
 #include "../class/Mesh.h"
@@ -30,12 +31,40 @@
 #include "PerFrameResource.h"
 #include "../Maths/Vector.h"
 #include "FrameBufferDiction.h"
+#include "AtmosphereLUTCache.h"
+#include "IBLCache.h"
+#include "GPUProfiler.h"
+#include "../vulkan/DeviceMemoryManager.h"
 #include <random>
+#include <algorithm>
+#include <iostream>
 #include <gli\gli.hpp>
 
 // FIXME: Refactor
 static uint32_t PLANET_COUNT = 4;
 static uint32_t GROUP_SIZE = 16;
+// Final scatter and irradiance tables are stored in RGBA16F, precompute still accumulates in RGBA32F scratch images
+static bool ATMOSPHERE_HALF_PRECISION = true;
+
+// Time sliced image based lighting regeneration: each frame records generation jobs(a skybox face, an irradiance chunk
+// or one mip level of a reflection face) until their estimated cost reaches the budget, then the round continues next frame
+// Cost is counted in texture samples, once gpu profiler measures generation, the budget is derived from "IBL_GEN_BUDGET_MS"
+// with measured time per sample, otherwise it falls back to "IBL_GEN_BUDGET_PER_FRAME", one full resolution reflection face
+// Without time slicing it's one job per frame, and a reflection job covers a whole mip chain
+static bool IBL_GEN_TIME_SLICED = true;
+static double IBL_GEN_BUDGET_MS = 0.5;
+static uint64_t IBL_GEN_BUDGET_PER_FRAME = GlobalTextures::ENV_MAP_SIZE * GlobalTextures::ENV_MAP_SIZE * 16;
+// Weight of the latest measurement in smoothed time per sample
+static double IBL_GEN_MEASUREMENT_WEIGHT = 0.25;
+// Newly generated environment textures fade in over this many frames
+static uint32_t IBL_BLEND_FRAME_COUNT = 30;
+
+// Estimated texture samples per texel of ibl generation shaders
+static uint32_t SKYBOX_GEN_SAMPLES = 8;			// env_skybox_gen.comp: transmittance and scattering lookups
+static uint32_t IRRADIANCE_GEN_SAMPLES = 248;	// env_irradiance_gen.comp: (2pi / 0.2) * (0.5pi / 0.2)
+static uint32_t REFLECTION_GEN_SAMPLES = 16;	// env_reflection_gen.comp: numSamples
+// Group count of one irradiance gen dispatch per border, has to match CreateIrradianceGenMaterial()
+static uint32_t IRRADIANCE_GROUP_COUNT_BORDER = 8;
 
 bool GlobalTextures::Init(const std::shared_ptr<GlobalTextures>& pSelf)
 {
@@ -46,6 +75,7 @@ bool GlobalTextures::Init(const std::shared_ptr<GlobalTextures>& pSelf)
 	InitScreenSizeTextureDiction();
 	InitIBLTextures();
 	InitSSAORandomRotationTexture();
+	InitHiZTextures();
 	InitTransmittanceTextureDiction();
 	InitSkyboxGenParameters();
 
@@ -108,7 +138,7 @@ void GlobalTextures::InitIBLTextures()
 						1,
 						FrameBufferDiction::OFFSCREEN_HDR_COLOR_FORMAT,
 						VK_IMAGE_LAYOUT_GENERAL,
-						VK_IMAGE_USAGE_STORAGE_BIT)
+						(VkImageUsageFlagBits)(VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
 				);
 			break;
 		case RGBA16_512_SkyBoxIrradiance:
@@ -121,7 +151,7 @@ void GlobalTextures::InitIBLTextures()
 						1,
 						FrameBufferDiction::OFFSCREEN_HDR_COLOR_FORMAT,
 						VK_IMAGE_LAYOUT_GENERAL,
-						VK_IMAGE_USAGE_STORAGE_BIT)
+						(VkImageUsageFlagBits)(VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
 				);
 			break;
 
@@ -135,7 +165,7 @@ void GlobalTextures::InitIBLTextures()
 						(uint32_t)std::log2(512) + 1,
 						FrameBufferDiction::OFFSCREEN_HDR_COLOR_FORMAT,
 						VK_IMAGE_LAYOUT_GENERAL,
-						VK_IMAGE_USAGE_STORAGE_BIT)
+						(VkImageUsageFlagBits)(VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
 				);
 			break;
 		default:
@@ -226,177 +256,330 @@ void GlobalTextures::InitSkyboxGenParameters()
 	m_pScheduler = ResourceBarrierScheduler::Create();
 }
 
-void GlobalTextures::GenerateSkyBox(uint32_t chunkIndex)
+// Names of cached environment textures, in order of IBLTextureType
+static const char* ENV_CACHE_TEXTURE_NAMES[] = { "skybox", "irradiance", "reflection" };
+
+bool GlobalTextures::BeginEnvGenRound(uint32_t chunkIndex)
 {
-	if (m_pIBLGenCmdBuffer != nullptr && m_lastEnvGenState != EnvGenState::WAITING_FOR_COMPLETE)
+	// Record world space camera and main ligh direction
+	// This info remains unchanged until next round of skybox gen
+	m_wsCameraPosition = UniformData::GetInstance()->GetPerFrameUniforms()->GetCameraPosition().SinglePrecision();
+	m_wsMainLightDir = UniformData::GetInstance()->GetPerFrameUniforms()->GetWorldSpaceMainLightDir().SinglePrecision();
+
+	uint64_t envKey = IBLCache::HashEnvironment
+	(
+		UniformData::GetInstance()->GetPerPerPlanetUniforms()->GetAtmosphereParameters(chunkIndex),
+		m_wsCameraPosition,
+		m_wsMainLightDir,
+		ENV_MAP_SIZE
+	);
+
+	// Published textures are still up to date
+	if (envKey == m_publishedEnvKey)
+		return false;
+
+	bool cacheLookup = m_IBLCacheEnabled && m_envCacheLookup;
+	m_envCacheLookup = false;
+
+	if (cacheLookup && LoadEnvCache(envKey))
+		return false;
+
+	m_generatingEnvKey = envKey;
+	m_envCacheSaveRound = cacheLookup;
+	return true;
+}
+
+bool GlobalTextures::LoadEnvCache(uint64_t envKey)
+{
+	// Load into the slot next round would generate to, published one might still be in use
+	for (uint32_t i = 0; i < IBLCubeTextureTypeCount; i++)
 	{
-		FrameWorkManager::GetInstance()->SubmitCommandBuffers
-		(
-			GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::COMPUTE), 
-			{ m_pIBLGenCmdBuffer }, 
-			{}, 
-			{}, 
-			{},
-			false, false
-		);
+		if (!IBLCache::Load(IBLCache::GetEnvCachePath(envKey, ENV_CACHE_TEXTURE_NAMES[i]), m_IBLCubeTextures[i][m_envTexturePingpongIndex]))
+			return false;
 	}
 
-	GlobalObjects()->GetThreadTaskQueue()->AddJobA(
-	[this, chunkIndex](const std::shared_ptr<PerFrameResource>& pPerFrameRes)
+	UniformData::GetInstance()->GetPerFrameUniforms()->SetEnvPingpongIndex(m_envTexturePingpongIndex);
+	m_envTexturePingpongIndex = (m_envTexturePingpongIndex + 1) % 2;
+	m_publishedEnvKey = envKey;
+
+	std::cout << "IBL environment textures loaded from cache\n";
+	return true;
+}
+
+void GlobalTextures::SaveEnvCache(uint64_t envKey, uint32_t pingpongIndex)
+{
+	for (uint32_t i = 0; i < IBLCubeTextureTypeCount; i++)
 	{
-		if (m_envGenState != EnvGenState::WAITING_FOR_COMPLETE)
+		if (!IBLCache::Save(IBLCache::GetEnvCachePath(envKey, ENV_CACHE_TEXTURE_NAMES[i]), m_IBLCubeTextures[i][pingpongIndex]))
 		{
-			m_pIBLGenCmdBuffer = pPerFrameRes->AllocateCommandBuffer
+			std::cout << "Failed to save IBL environment textures to cache\n";
+			return;
+		}
+	}
+}
+
+uint64_t GlobalTextures::EstimateEnvGenJobCost() const
+{
+	uint64_t faceTexels = ENV_MAP_SIZE * ENV_MAP_SIZE;
+
+	switch (m_envGenState)
+	{
+	case EnvGenState::SKYBOX_GEN:
+		return faceTexels * SKYBOX_GEN_SAMPLES;
+	case EnvGenState::IRRADIANCE_GEN:
+		return (uint64_t)IRRADIANCE_GROUP_COUNT_BORDER * IRRADIANCE_GROUP_COUNT_BORDER * GROUP_SIZE * GROUP_SIZE * IRRADIANCE_GEN_SAMPLES;
+	case EnvGenState::REFLECTION_GEN:
+	{
+		// A whole mip chain costs 4/3 of its first level
+		if (!IBL_GEN_TIME_SLICED)
+			return faceTexels * REFLECTION_GEN_SAMPLES * 4 / 3;
+
+		uint32_t mipLevels = (uint32_t)std::log2((double)ENV_MAP_SIZE) + 1;
+		uint64_t mipSize = (std::max)(1u, ENV_MAP_SIZE >> (m_envJobCounter % mipLevels));
+		return mipSize * mipSize * REFLECTION_GEN_SAMPLES;
+	}
+	default:
+		return 0;
+	}
+}
+
+void GlobalTextures::RecordEnvGenJob(uint32_t chunkIndex)
+{
+	if (m_envGenState == EnvGenState::SKYBOX_GEN)
+	{
+		if (m_pSkyboxGenMaterial == nullptr)
+		{
+			m_pSkyboxGenMaterial = CreateSkyboxGenMaterial
 			(
-				PhysicalDevice::QueueFamily::COMPUTE, 
-				CommandPool::CBPersistancy::TRANSIENT, 
-				CommandBuffer::CBLevel::PRIMARY
+				m_IBLCubeTextures[RGBA16_512_SkyBox]
 			);
-			m_pIBLGenCmdBuffer->StartPrimaryRecording();
 		}
 
-		if (m_envGenState == EnvGenState::SKYBOX_GEN)
-		{
-			m_lastEnvGenState = m_envGenState;
-			// Record world space camera and main ligh direction
-			// This info remains unchanged until next round of skybox gen
-			if (m_envJobCounter == 0)
-			{
-				m_wsCameraPosition = UniformData::GetInstance()->GetPerFrameUniforms()->GetCameraPosition().SinglePrecision();
-				m_wsMainLightDir = UniformData::GetInstance()->GetPerFrameUniforms()->GetWorldSpaceMainLightDir().SinglePrecision();
-			}
+		m_cubeFaces[m_envJobCounter][0].w = (float)m_envJobCounter;
+		m_cubeFaces[m_envJobCounter][1].w = (float)chunkIndex;
+		m_cubeFaces[m_envJobCounter][3].w = (float)m_envTexturePingpongIndex;
 
-			if (m_pSkyboxGenMaterial == nullptr)
-			{
-				m_pSkyboxGenMaterial = CreateSkyboxGenMaterial
-				(
-					m_IBLCubeTextures[RGBA16_512_SkyBox]
-				);
-			}
+		m_pSkyboxGenMaterial->UpdatePushConstantData(&m_cubeFaces[m_envJobCounter][0], 0, sizeof(m_cubeFaces[m_envJobCounter]));
+		m_pSkyboxGenMaterial->UpdatePushConstantData
+		(
+			&m_wsCameraPosition,
+			sizeof(m_cubeFaces[m_envJobCounter]), 
+			sizeof(m_wsCameraPosition)
+		);
+		m_pSkyboxGenMaterial->UpdatePushConstantData
+		(
+			&m_wsMainLightDir,
+			sizeof(m_cubeFaces[m_envJobCounter]) + sizeof(Vector4f),
+			sizeof(m_wsMainLightDir)
+		);
+		m_pSkyboxGenMaterial->BeforeRenderPass(m_pIBLGenCmdBuffer, m_pScheduler);
+		m_pSkyboxGenMaterial->Dispatch(m_pIBLGenCmdBuffer);
+		m_pSkyboxGenMaterial->AfterRenderPass(m_pIBLGenCmdBuffer);
 
-			m_cubeFaces[m_envJobCounter][0].w = (float)m_envJobCounter;
-			m_cubeFaces[m_envJobCounter][1].w = (float)chunkIndex;
-			m_cubeFaces[m_envJobCounter][3].w = (float)m_envTexturePingpongIndex;
+		m_envJobCounter++;
 
-			m_pSkyboxGenMaterial->UpdatePushConstantData(&m_cubeFaces[m_envJobCounter][0], 0, sizeof(m_cubeFaces[m_envJobCounter]));
-			m_pSkyboxGenMaterial->UpdatePushConstantData
+		if (m_envJobCounter == 6)
+		{
+			m_envGenState = EnvGenState::IRRADIANCE_GEN;
+			m_envJobCounter = 0;
+		}
+	}
+	else if (m_envGenState == EnvGenState::IRRADIANCE_GEN)
+	{
+		static uint32_t groupCountOneDispatchBorder = IRRADIANCE_GROUP_COUNT_BORDER;
+		static uint32_t groupCountOneDispatch = groupCountOneDispatchBorder * groupCountOneDispatchBorder;
+		static uint32_t dispatchCountPerBorder = ENV_MAP_SIZE / GROUP_SIZE / groupCountOneDispatchBorder;
+		static uint32_t dispatchCountPerFace = dispatchCountPerBorder * dispatchCountPerBorder;
+
+		uint32_t faceID = m_envJobCounter / dispatchCountPerFace;
+		uint32_t groupOffset = m_envJobCounter % dispatchCountPerFace;
+		uint32_t groupOffsetX = groupOffset % dispatchCountPerBorder;
+		uint32_t groupOffsetY = groupOffset / dispatchCountPerBorder;
+
+		if (m_pIrradianceGenMaterial == nullptr)
+		{
+			m_pIrradianceGenMaterial = CreateIrradianceGenMaterial
 			(
-				&m_wsCameraPosition,
-				sizeof(m_cubeFaces[m_envJobCounter]), 
-				sizeof(m_wsCameraPosition)
+				m_IBLCubeTextures[RGBA16_512_SkyBox],
+				m_IBLCubeTextures[RGBA16_512_SkyBoxIrradiance]
 			);
-			m_pSkyboxGenMaterial->UpdatePushConstantData
+		}
+
+		m_cubeFaces[faceID][0].w = (float)faceID;
+		m_cubeFaces[faceID][1].w = (float)groupOffsetX * groupCountOneDispatchBorder * GROUP_SIZE;
+		m_cubeFaces[faceID][2].w = (float)groupOffsetY * groupCountOneDispatchBorder * GROUP_SIZE;
+		m_cubeFaces[faceID][3].w = (float)m_envTexturePingpongIndex;
+		m_pIrradianceGenMaterial->UpdatePushConstantData(&m_cubeFaces[faceID][0], 0, sizeof(m_cubeFaces[faceID]));
+		m_pIrradianceGenMaterial->BeforeRenderPass(m_pIBLGenCmdBuffer, m_pScheduler);
+		m_pIrradianceGenMaterial->Dispatch(m_pIBLGenCmdBuffer);
+		m_pIrradianceGenMaterial->AfterRenderPass(m_pIBLGenCmdBuffer);
+
+		m_envJobCounter++;
+
+		if (m_envJobCounter == dispatchCountPerFace * 6)
+		{
+			m_envGenState = EnvGenState::REFLECTION_GEN;
+			m_envJobCounter = 0;
+		}
+	}
+	else if (m_envGenState == EnvGenState::REFLECTION_GEN)
+	{
+		static uint32_t mipLevels = (uint32_t)std::log2((double)ENV_MAP_SIZE) + 1;
+		while ((uint32_t)m_reflectionGenMaterials.size() < mipLevels)
+		{
+			m_reflectionGenMaterials.push_back
 			(
-				&m_wsMainLightDir,
-				sizeof(m_cubeFaces[m_envJobCounter]) + sizeof(Vector4f),
-				sizeof(m_wsMainLightDir)
+				CreateReflectionGenMaterial
+				(
+					m_IBLCubeTextures[RGBA16_512_SkyBox],
+					m_IBLCubeTextures[RGBA16_512_SkyBoxReflection],
+					(uint32_t)m_reflectionGenMaterials.size()
+				)
 			);
-			m_pSkyboxGenMaterial->BeforeRenderPass(m_pIBLGenCmdBuffer, m_pScheduler);
-			m_pSkyboxGenMaterial->Dispatch(m_pIBLGenCmdBuffer);
-			m_pSkyboxGenMaterial->AfterRenderPass(m_pIBLGenCmdBuffer);
+		}
 
-			m_envJobCounter++;
+		// Time sliced: one mip level of a face per job, otherwise all mip levels of a face
+		uint32_t jobCount = IBL_GEN_TIME_SLICED ? 6 * mipLevels : 6;
+		uint32_t faceID = IBL_GEN_TIME_SLICED ? m_envJobCounter / mipLevels : m_envJobCounter;
+		uint32_t firstMipLevel = IBL_GEN_TIME_SLICED ? m_envJobCounter % mipLevels : 0;
+		uint32_t lastMipLevel = IBL_GEN_TIME_SLICED ? firstMipLevel + 1 : mipLevels;
 
-			if (m_envJobCounter == 6)
-			{
-				m_envGenState = EnvGenState::IRRADIANCE_GEN;
-				m_envJobCounter = 0;
-			}
-		}
-		else if (m_envGenState == EnvGenState::IRRADIANCE_GEN)
+		for (uint32_t i = firstMipLevel; i < lastMipLevel; i++)
 		{
-			m_lastEnvGenState = m_envGenState;
+			std::shared_ptr<Material> pMaterial = m_reflectionGenMaterials[i];
 
-			static uint32_t groupCountOneDispatchBorder = 8;
-			static uint32_t groupCountOneDispatch = groupCountOneDispatchBorder * groupCountOneDispatchBorder;
-			static uint32_t dispatchCountPerBorder = ENV_MAP_SIZE / GROUP_SIZE / groupCountOneDispatchBorder;
-			static uint32_t dispatchCountPerFace = dispatchCountPerBorder * dispatchCountPerBorder;
+			m_cubeFaces[faceID][0].w = (float)faceID;
+			m_cubeFaces[faceID][1].w = i / (float)(mipLevels - 1);	// Roughness
+			m_cubeFaces[faceID][3].w = (float)m_envTexturePingpongIndex;
+			pMaterial->UpdatePushConstantData(&m_cubeFaces[faceID][0], 0, sizeof(m_cubeFaces[faceID]));
+			pMaterial->BeforeRenderPass(m_pIBLGenCmdBuffer, m_pScheduler);
+			pMaterial->Dispatch(m_pIBLGenCmdBuffer);
+			pMaterial->AfterRenderPass(m_pIBLGenCmdBuffer);
+		}
+
+		m_envJobCounter++;
 
-			uint32_t faceID = m_envJobCounter / dispatchCountPerFace;
-			uint32_t groupOffset = m_envJobCounter % dispatchCountPerFace;
-			uint32_t groupOffsetX = groupOffset % dispatchCountPerBorder;
-			uint32_t groupOffsetY = groupOffset / dispatchCountPerBorder;
+		if (m_envJobCounter == jobCount)
+		{
+			m_envGenState = EnvGenState::WAITING_FOR_COMPLETE;
+			m_envJobCounter = 0;
 
-			if (m_pIrradianceGenMaterial == nullptr)
+			for (uint32_t i = 0; i < IBLCubeTextureTypeCount; i++)
 			{
-				m_pIrradianceGenMaterial = CreateIrradianceGenMaterial
+				m_pScheduler->ReleaseQueueOwnership
 				(
-					m_IBLCubeTextures[RGBA16_512_SkyBox],
-					m_IBLCubeTextures[RGBA16_512_SkyBoxIrradiance]
+					m_pIBLGenCmdBuffer,
+					m_IBLCubeTextures[i][m_envTexturePingpongIndex],
+					PhysicalDevice::QueueFamily::COMPUTE,
+					PhysicalDevice::QueueFamily::ALL_ROUND
 				);
 			}
+		}
+	}
+}
 
-			m_cubeFaces[faceID][0].w = (float)faceID;
-			m_cubeFaces[faceID][1].w = (float)groupOffsetX * groupCountOneDispatchBorder * GROUP_SIZE;
-			m_cubeFaces[faceID][2].w = (float)groupOffsetY * groupCountOneDispatchBorder * GROUP_SIZE;
-			m_cubeFaces[faceID][3].w = (float)m_envTexturePingpongIndex;
-			m_pIrradianceGenMaterial->UpdatePushConstantData(&m_cubeFaces[faceID][0], 0, sizeof(m_cubeFaces[faceID]));
-			m_pIrradianceGenMaterial->BeforeRenderPass(m_pIBLGenCmdBuffer, m_pScheduler);
-			m_pIrradianceGenMaterial->Dispatch(m_pIBLGenCmdBuffer);
-			m_pIrradianceGenMaterial->AfterRenderPass(m_pIBLGenCmdBuffer);
+void GlobalTextures::GenerateSkyBox(uint32_t chunkIndex)
+{
+	uint32_t frameIndex = FrameWorkManager::GetInstance()->FrameIndex();
 
-			m_envJobCounter++;
+	// One recording more than frames in flight, so that a recording is never reset before it's resolved
+	if (m_envGenRecordingBase == UINT32_MAX)
+	{
+		m_envGenRecordingBase = GPUProfiler::GetInstance()->ReserveRecordings(FrameWorkManager::GetInstance()->MaxFrameCount() + 1);
+		m_envGenSubmittedCosts.resize(FrameWorkManager::GetInstance()->MaxFrameCount(), 0);
+	}
 
-			if (m_envJobCounter == dispatchCountPerFace * 6)
-			{
-				m_envGenState = EnvGenState::REFLECTION_GEN;
-				m_envJobCounter = 0;
-			}
+	// Generation submitted by this frame index last time has been resolved at frame begin, calibrate time per sample with it
+	uint32_t sampleCount = GPUProfiler::GetInstance()->GetScopeSampleCount("IBLGen");
+	if (sampleCount != m_envGenSampleCount && m_envGenSubmittedCosts[frameIndex] != 0)
+	{
+		double msPerCost = GPUProfiler::GetInstance()->GetLatestScopeTime("IBLGen") / m_envGenSubmittedCosts[frameIndex];
+		m_envGenMsPerCost = m_envGenMsPerCost > 0 ? m_envGenMsPerCost * (1.0 - IBL_GEN_MEASUREMENT_WEIGHT) + msPerCost * IBL_GEN_MEASUREMENT_WEIGHT : msPerCost;
+	}
+	m_envGenSampleCount = sampleCount;
+	m_envGenSubmittedCosts[frameIndex] = 0;
+
+	if (m_pIBLGenCmdBuffer != nullptr && m_lastEnvGenState != EnvGenState::WAITING_FOR_COMPLETE)
+	{
+		FrameWorkManager::GetInstance()->SubmitCommandBuffers
+		(
+			GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::COMPUTE), 
+			{ m_pIBLGenCmdBuffer }, 
+			{}, 
+			{}, 
+			{},
+			false, false
+		);
+
+		if (GPUProfiler::GetInstance()->IsEnabled())
+		{
+			GPUProfiler::GetInstance()->SubmitRecording(m_envGenRecordingIndex);
+			m_envGenSubmittedCosts[frameIndex] = m_envGenRecordedCost;
 		}
-		else if (m_envGenState == EnvGenState::REFLECTION_GEN)
+	}
+
+	// Textures published by generation job, blending states are only touched here on main thread
+	int32_t publishedPingpongIndex = m_pendingEnvPingpongIndex.exchange(-1);
+	if (publishedPingpongIndex >= 0)
+	{
+		UniformData::GetInstance()->GetPerFrameUniforms()->SetEnvPingpongIndex((uint32_t)publishedPingpongIndex);
+		if (m_pendingEnvBlend)
 		{
-			m_lastEnvGenState = m_envGenState;
+			UniformData::GetInstance()->GetPerFrameUniforms()->SetEnvBlendFactor(0.0);
+			m_envBlendFrameCounter = 0;
+		}
+	}
 
-			static uint32_t mipLevels = (uint32_t)std::log2((double)ENV_MAP_SIZE) + 1;
-			for (uint32_t i = 0; i < mipLevels; i++)
-			{
-				if (i == m_reflectionGenMaterials.size())
-				{
-					m_reflectionGenMaterials.push_back
-					(
-						CreateReflectionGenMaterial
-						(
-							m_IBLCubeTextures[RGBA16_512_SkyBox],
-							m_IBLCubeTextures[RGBA16_512_SkyBoxReflection],
-							i
-						)
-					);
-				}
+	// Result of last round has been acquired by now, it's safe to read it back
+	if (m_envCacheSavePending)
+	{
+		SaveEnvCache(m_publishedEnvKey, m_envCacheSaveIndex);
+		m_envCacheSavePending = false;
+	}
 
-				std::shared_ptr<Material> pMaterial = m_reflectionGenMaterials[i];
+	bool roundStarting = m_envGenState == EnvGenState::SKYBOX_GEN && m_envJobCounter == 0;
 
-				m_cubeFaces[m_envJobCounter][0].w = (float)m_envJobCounter;
-				m_cubeFaces[m_envJobCounter][1].w = i / (float)(mipLevels - 1);	// Roughness
-				m_cubeFaces[m_envJobCounter][3].w = (float)m_envTexturePingpongIndex;
-				pMaterial->UpdatePushConstantData(&m_cubeFaces[m_envJobCounter][0], 0, sizeof(m_cubeFaces[m_envJobCounter]));
-				pMaterial->BeforeRenderPass(m_pIBLGenCmdBuffer, m_pScheduler);
-				pMaterial->Dispatch(m_pIBLGenCmdBuffer);
-				pMaterial->AfterRenderPass(m_pIBLGenCmdBuffer);
-			}
+	// Previous textures are sampled until blending is done and frames in flight are retired,
+	// next round writes to them, so it has to wait till then
+	uint32_t blendRetireFrameCount = IBL_BLEND_FRAME_COUNT + GetSwapChain()->GetSwapChainImageCount();
+	if (m_envBlendFrameCounter < blendRetireFrameCount)
+	{
+		m_envBlendFrameCounter++;
+		UniformData::GetInstance()->GetPerFrameUniforms()->SetEnvBlendFactor((std::min)(1.0, m_envBlendFrameCounter / (double)IBL_BLEND_FRAME_COUNT));
 
-			m_envJobCounter++;
+		if (roundStarting)
+			return;
+	}
 
-			if (m_envJobCounter == 6)
-			{
-				m_envGenState = EnvGenState::WAITING_FOR_COMPLETE;
-				m_envJobCounter = 0;
+	// Skip the whole round if environment stays the same, or it's loaded from cache
+	if (roundStarting && !BeginEnvGenRound(chunkIndex))
+		return;
 
-				for (uint32_t i = 0; i < IBLCubeTextureTypeCount; i++)
-				{
-					m_pScheduler->ReleaseQueueOwnership
-					(
-						m_pIBLGenCmdBuffer,
-						m_IBLCubeTextures[i][m_envTexturePingpongIndex],
-						PhysicalDevice::QueueFamily::COMPUTE,
-						PhysicalDevice::QueueFamily::ALL_ROUND
-					);
-				}
-			}
+	// Measured gpu time drives the budget once generation has been profiled
+	uint64_t costBudget = m_envGenMsPerCost > 0 ? (uint64_t)(IBL_GEN_BUDGET_MS / m_envGenMsPerCost) : IBL_GEN_BUDGET_PER_FRAME;
+
+	GlobalObjects()->GetThreadTaskQueue()->AddJobA(
+	[this, chunkIndex, costBudget](const std::shared_ptr<PerFrameResource>& pPerFrameRes)
+	{
+		if (m_envGenState != EnvGenState::WAITING_FOR_COMPLETE)
+		{
+			m_pIBLGenCmdBuffer = pPerFrameRes->AllocateCommandBuffer
+			(
+				PhysicalDevice::QueueFamily::COMPUTE, 
+				CommandPool::CBPersistancy::TRANSIENT, 
+				CommandBuffer::CBLevel::PRIMARY
+			);
+			m_pIBLGenCmdBuffer->StartPrimaryRecording();
+
+			m_envGenRecordingIndex = m_envGenRecordingBase + m_envGenRecordingCounter++ % (FrameWorkManager::GetInstance()->MaxFrameCount() + 1);
+			GPUProfiler::GetInstance()->BeginRecording(m_pIBLGenCmdBuffer, m_envGenRecordingIndex);
+			GPUProfiler::GetInstance()->BeginScope(m_pIBLGenCmdBuffer, "IBLGen");
 		}
+
 		// Wait for another circle to ensure last batch of generating work is done
 		// This is ensured by mechanism of FrameManager
 		// FIXME: However, I think I should create another mechanism to handle all of this kind of async resource preparation
-		else if (m_envGenState == EnvGenState::WAITING_FOR_COMPLETE)
+		if (m_envGenState == EnvGenState::WAITING_FOR_COMPLETE)
 		{
 			m_lastEnvGenState = m_envGenState;
 
@@ -442,16 +625,45 @@ void GlobalTextures::GenerateSkyBox(uint32_t chunkIndex)
 					false, false
 				);
 
-				// Set ping pong index of the completed
-				UniformData::GetInstance()->GetPerFrameUniforms()->SetEnvPingpongIndex(m_envTexturePingpongIndex);
+				// Publish ping pong index of the completed, and blend it in unless there's nothing valid to blend from
+				// Main thread applies them next frame
+				m_pendingEnvBlend = m_publishedEnvKey != 0;
+				m_pendingEnvPingpongIndex = (int32_t)m_envTexturePingpongIndex;
+				m_publishedEnvKey = m_generatingEnvKey;
+
+				// Saved on main thread later
+				if (m_envCacheSaveRound)
+				{
+					m_envCacheSavePending = true;
+					m_envCacheSaveIndex = m_envTexturePingpongIndex;
+					m_envCacheSaveRound = false;
+				}
 
 				// Start next ping pong
 				m_envTexturePingpongIndex = (m_envTexturePingpongIndex + 1) % 2;
 			}
 		}
 
+		else
+		{
+			// Time sliced: record jobs until estimated cost reaches budget of this frame, at least one job per frame
+			uint64_t cost = 0;
+			do
+			{
+				m_lastEnvGenState = m_envGenState;
+				cost += EstimateEnvGenJobCost();
+				RecordEnvGenJob(chunkIndex);
+			} while (IBL_GEN_TIME_SLICED && m_envGenState != EnvGenState::WAITING_FOR_COMPLETE && cost + EstimateEnvGenJobCost() <= costBudget);
+
+			m_envGenRecordedCost = cost;
+		}
+
 		if (m_lastEnvGenState != EnvGenState::WAITING_FOR_COMPLETE)
+		{
+			GPUProfiler::GetInstance()->EndScope(m_pIBLGenCmdBuffer);
+			GPUProfiler::GetInstance()->EndRecording();
 			m_pIBLGenCmdBuffer->EndPrimaryRecording();
+		}
 	}, FrameWorkManager::GetInstance()->FrameIndex());
 }
 
@@ -474,14 +686,39 @@ void GlobalTextures::InitSSAORandomRotationTexture()
 	m_pSSAORandomRotations = Image::CreateTexture2D(GetDevice(), { {tex} }, VK_FORMAT_R32G32B32A32_SFLOAT);
 }
 
+void GlobalTextures::InitHiZTextures()
+{
+	// Start with far plane(reversed z) all over, so that nothing is occluded before the first pyramid is built
+	gli::texture2d tex = gli::texture2d(gli::FORMAT_RG32_SFLOAT_PACK32, { HIZ_SIZE, HIZ_SIZE }, GetHiZMipLevelCount());
+	std::memset(tex.data(), 0, tex.size());
+
+	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
+	{
+		m_HiZTextures.push_back(Image::CreateTextureWithGLIImage
+		(
+			GetDevice(),
+			{ { tex } },
+			VK_FORMAT_R32G32_SFLOAT,
+			VK_IMAGE_LAYOUT_GENERAL,
+			VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+		));
+	}
+}
+
 void GlobalTextures::GenerateBRDFLUTTexture()
 {
+	const VkExtent3D& lutExtent = m_IBL2DTextures[RGBA16_512_BRDFLut]->GetImageInfo().extent;
+	std::string cachePath = IBLCache::GetBRDFLUTCachePath({ lutExtent.width, lutExtent.height });
+
+	if (m_IBLCacheEnabled && IBLCache::Load(cachePath, m_IBL2DTextures[RGBA16_512_BRDFLut]))
+		return;
+
 	SceneGenerator::GetInstance()->GenerateBRDFLUTGenScene();
 
 	RenderWorkManager::GetInstance()->SetRenderStateMask(RenderWorkManager::BrdfLutGen);
 
-	std::shared_ptr<CommandBuffer> pDrawCmdBuffer = MainThreadCommandPool(PhysicalDevice::QueueFamily::ALL_ROUND)->AllocateCommandBuffer(CommandBuffer::CBLevel::PRIMARY);
-
 	std::vector<VkClearValue> clearValues =
 	{
 		{ 0.0f, 0.0f, 0.0f, 0.0f },
@@ -504,6 +741,7 @@ void GlobalTextures::GenerateBRDFLUTTexture()
 	SceneGenerator::GetInstance()->GetRootObject()->Update();
 	SceneGenerator::GetInstance()->GetRootObject()->LateUpdate();
 	SceneGenerator::GetInstance()->GetRootObject()->UpdateCachedData();
+	SceneGenerator::GetInstance()->GetRootObject()->PublishCachedData();
 	SceneGenerator::GetInstance()->GetRootObject()->OnPreRender();
 	SceneGenerator::GetInstance()->GetRootObject()->OnRenderObject();
 	SceneGenerator::GetInstance()->GetRootObject()->OnPostRender();
@@ -511,36 +749,147 @@ void GlobalTextures::GenerateBRDFLUTTexture()
 	SceneGenerator::GetInstance()->GetMaterial0()->SyncBufferData();
 
 	SceneGenerator::GetInstance()->GetMaterial0()->OnFrameBegin();
-	pDrawCmdBuffer->StartPrimaryRecording();
 
-	SceneGenerator::GetInstance()->GetMaterial0()->BeforeRenderPass(pDrawCmdBuffer, nullptr);
-	RenderPassDiction::GetInstance()->GetForwardRenderPassOffScreen()->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_EnvGenOffScreen)[0]);
-	SceneGenerator::GetInstance()->GetMaterial0()->DrawScreenQuad(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_EnvGenOffScreen));
-	RenderPassDiction::GetInstance()->GetForwardRenderPassOffScreen()->EndRenderPass(pDrawCmdBuffer);
-	SceneGenerator::GetInstance()->GetMaterial0()->AfterRenderPass(pDrawCmdBuffer);
+	InitCmdBatcher()->Record([](const std::shared_ptr<CommandBuffer>& pDrawCmdBuffer)
+	{
+		SceneGenerator::GetInstance()->GetMaterial0()->BeforeRenderPass(pDrawCmdBuffer, nullptr);
+		RenderPassDiction::GetInstance()->GetForwardRenderPassOffScreen()->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_EnvGenOffScreen)[0]);
+		SceneGenerator::GetInstance()->GetMaterial0()->DrawScreenQuad(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_EnvGenOffScreen));
+		RenderPassDiction::GetInstance()->GetForwardRenderPassOffScreen()->EndRenderPass(pDrawCmdBuffer);
+		SceneGenerator::GetInstance()->GetMaterial0()->AfterRenderPass(pDrawCmdBuffer);
+	});
 
-	pDrawCmdBuffer->EndPrimaryRecording();
 	SceneGenerator::GetInstance()->GetMaterial0()->OnFrameEnd();
 
-	GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::ALL_ROUND)->SubmitCommandBuffer(pDrawCmdBuffer, nullptr, true);
-
 	FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_EnvGenOffScreen)[0]->ExtractContent(m_IBL2DTextures[RGBA16_512_BRDFLut]);
+
+	// Brdf lut scene and its uniforms are purged right after, flush batched work here
+	InitCmdBatcher()->Flush();
+
+	if (m_IBLCacheEnabled && !IBLCache::Save(cachePath, m_IBL2DTextures[RGBA16_512_BRDFLut]))
+		std::cout << "Failed to save brdf lut to cache\n";
 }
 
 void GlobalTextures::InitTransmittanceTextureDiction()
 {
-	// FIXME: Size of these textures are hard-coded for now
+	VkFormat tableFormat = ATMOSPHERE_HALF_PRECISION ? VK_FORMAT_R16G16B16A16_SFLOAT : VK_FORMAT_R32G32B32A32_SFLOAT;
+
+	uint64_t tableBytes = 0;
 	for (uint32_t i = 0; i < PLANET_COUNT; i++)
 	{
-		m_transmittanceTextureDiction.push_back(Image::CreateEmptyTexture2DForCompute(GetDevice(), { 256, 64 }, VK_FORMAT_R32G32B32A32_SFLOAT));
-		m_scatterTextureDiction.push_back(Image::CreateEmptyTexture3D(GetDevice(), { 256, 128, 32 }, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_GENERAL));
-		m_irradianceTextureDiction.push_back(Image::CreateEmptyTexture2DForCompute(GetDevice(), { 64, 16 }, VK_FORMAT_R32G32B32A32_SFLOAT));
-		m_pDeltaIrradiance = Image::CreateEmptyTexture2DForCompute(GetDevice(), { 64, 16 }, VK_FORMAT_R32G32B32A32_SFLOAT);
-		m_pDeltaRayleigh = Image::CreateEmptyTexture3D(GetDevice(), { 256, 128, 32 }, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_GENERAL);
-		m_pDeltaMie = Image::CreateEmptyTexture3D(GetDevice(), { 256, 128, 32 }, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_GENERAL);
-		m_pDeltaScatterDensity = Image::CreateEmptyTexture3D(GetDevice(), { 256, 128, 32 }, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_GENERAL);
-		m_pDeltaMultiScatter = Image::CreateEmptyTexture3D(GetDevice(), { 256, 128, 32 }, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_GENERAL);
+		// Transmittance is sampled by later precompute passes through global bindings, it's tiny, keep it in full precision
+		m_transmittanceTextureDiction.push_back(Image::CreateEmptyTexture2DForCompute(GetDevice(), { TRANSMITTANCE_TEXTURE_WIDTH, TRANSMITTANCE_TEXTURE_HEIGHT }, VK_FORMAT_R32G32B32A32_SFLOAT));
+		m_scatterTextureDiction.push_back(Image::CreateEmptyTexture3D(GetDevice(), { SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT, SCATTERING_TEXTURE_DEPTH }, tableFormat, VK_IMAGE_LAYOUT_GENERAL));
+		m_irradianceTextureDiction.push_back(Image::CreateEmptyTexture2DForCompute(GetDevice(), { IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT }, tableFormat));
+
+		tableBytes += m_transmittanceTextureDiction[i]->GetMemoryReqirments().size;
+		tableBytes += m_scatterTextureDiction[i]->GetMemoryReqirments().size;
+		tableBytes += m_irradianceTextureDiction[i]->GetMemoryReqirments().size;
+	}
+
+	// Shared by all planets, placeholders are bound until precompute acquires real ones
+	InitAtmosphereScratchImages(true);
+
+	std::cout << "Atmosphere tables: " << tableBytes / (1024 * 1024) << "MB for " << PLANET_COUNT << " planets, "
+		<< (ATMOSPHERE_HALF_PRECISION ? "half" : "full") << " precision\n";
+}
+
+void GlobalTextures::InitAtmosphereScratchImages(bool placeholder)
+{
+	// Placeholders keep global bindings valid while no precompute is running
+	Vector3ui scatterSize = { 1, 1, 1 };
+	Vector2ui irradianceSize = { 1, 1 };
+	if (!placeholder)
+	{
+		scatterSize = { SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT, SCATTERING_TEXTURE_DEPTH };
+		irradianceSize = { IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT };
 	}
+
+	// Precompute shaders write them as rgba32f storage images
+	m_pDeltaIrradiance = Image::CreateEmptyTexture2DForCompute(GetDevice(), irradianceSize, VK_FORMAT_R32G32B32A32_SFLOAT);
+	m_pDeltaRayleigh = Image::CreateEmptyTexture3D(GetDevice(), scatterSize, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_GENERAL);
+	m_pDeltaMie = Image::CreateEmptyTexture3D(GetDevice(), scatterSize, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_GENERAL);
+	m_pDeltaScatterDensity = Image::CreateEmptyTexture3D(GetDevice(), scatterSize, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_GENERAL);
+	m_pDeltaMultiScatter = Image::CreateEmptyTexture3D(GetDevice(), scatterSize, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_GENERAL);
+
+	m_pScatterAccumulation = nullptr;
+	m_pIrradianceAccumulation = nullptr;
+	if (!placeholder && ATMOSPHERE_HALF_PRECISION)
+	{
+		m_pScatterAccumulation = Image::CreateEmptyTexture3D(GetDevice(), scatterSize, VK_FORMAT_R32G32B32A32_SFLOAT, VK_IMAGE_LAYOUT_GENERAL);
+		m_pIrradianceAccumulation = Image::CreateEmptyTexture2DForCompute(GetDevice(), irradianceSize, VK_FORMAT_R32G32B32A32_SFLOAT);
+	}
+}
+
+void GlobalTextures::AcquireAtmosphereScratchImages()
+{
+	if (m_atmosphereScratchAcquired)
+		return;
+
+	// Global descriptor set is about to change, nothing recorded against it could be pending
+	InitCmdBatcher()->Flush();
+	GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::ALL_ROUND)->WaitForIdle();
+
+	InitAtmosphereScratchImages(false);
+	UniformData::GetInstance()->UpdateGlobalTextureDescriptors();
+
+	m_atmosphereScratchAcquired = true;
+}
+
+void GlobalTextures::ReleaseAtmosphereScratchImages()
+{
+	if (!m_atmosphereScratchAcquired)
+		return;
+
+	InitCmdBatcher()->Flush();
+	GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::ALL_ROUND)->WaitForIdle();
+
+	uint64_t imageBytesBefore = DeviceMemMgr()->GetAllocatedImageBytes();
+
+	// Scratch images are freed as soon as global bindings no longer reference them
+	InitAtmosphereScratchImages(true);
+	UniformData::GetInstance()->UpdateGlobalTextureDescriptors();
+
+	std::cout << "Atmosphere precompute scratch released, image memory: " << imageBytesBefore / (1024 * 1024) << "MB before, "
+		<< DeviceMemMgr()->GetAllocatedImageBytes() / (1024 * 1024) << "MB after\n";
+
+	m_atmosphereScratchAcquired = false;
+}
+
+void GlobalTextures::ResolveAtmosphereTables(uint32_t planetIndex, const std::shared_ptr<ResourceBarrierScheduler>& pScheduler)
+{
+	if (m_pScatterAccumulation == nullptr)
+		return;
+
+	std::shared_ptr<Image> accumulations[] = { m_pScatterAccumulation, m_pIrradianceAccumulation };
+	std::shared_ptr<Image> tables[] = { m_scatterTextureDiction[planetIndex], m_irradianceTextureDiction[planetIndex] };
+
+	InitCmdBatcher()->Record([&](const std::shared_ptr<CommandBuffer>& pCommandBuffer)
+	{
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			// Make last compute write visible, image stays in its own layout, blit transitions it afterwards
+			pScheduler->ClaimResourceUsage
+			(
+				pCommandBuffer,
+				accumulations[i],
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_IMAGE_LAYOUT_GENERAL,
+				VK_ACCESS_TRANSFER_READ_BIT
+			);
+
+			VkExtent3D extent = accumulations[i]->GetImageInfo().extent;
+
+			// Same size blit, only converts format
+			VkImageBlit blit = {};
+			blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+			blit.srcOffsets[1] = { (int32_t)extent.width, (int32_t)extent.height, (int32_t)extent.depth };
+			blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+			blit.dstOffsets[1] = { (int32_t)extent.width, (int32_t)extent.height, (int32_t)extent.depth };
+
+			pCommandBuffer->BlitImage(accumulations[i], tables[i], blit);
+		}
+	});
 }
 
 std::shared_ptr<GlobalTextures> GlobalTextures::Create()
@@ -4,6 +4,7 @@
 #include <gli\gli.hpp>
 #include <map>
 #include <mutex>
+#include <atomic>
 
 class Texture2D;
 class TextureCube;
@@ -57,6 +58,8 @@ class GlobalTextures : public SelfRefBase<GlobalTextures>, public IMaterialUnifo
 public:
 	const static uint32_t SSAO_RANDOM_ROTATION_COUNT = 16;
 	const static uint32_t ENV_MAP_SIZE = 512;
+	// Hi-Z is a fixed size pow2 pyramid, mip 0 covers rendered viewport of gbuffer depth, regardless of dynamic resolution
+	const static uint32_t HIZ_SIZE = 512;
 
 public:
 	static std::shared_ptr<GlobalTextures> Create();
@@ -70,28 +73,53 @@ public:
 	std::shared_ptr<Image> GetTransmittanceTextureDiction(uint32_t planetIndex) const { return m_transmittanceTextureDiction[planetIndex]; }
 	std::shared_ptr<Image> GetScatterTextureDiction(uint32_t planetIndex) const { return m_scatterTextureDiction[planetIndex]; }
 	std::shared_ptr<Image> GetIrradianceTextureDiction(uint32_t planetIndex) const { return m_irradianceTextureDiction[planetIndex]; }
+	// Per frame depth pyramid of gbuffer pass, r: farthest depth, g: nearest depth
+	std::shared_ptr<Image> GetHiZTexture(uint32_t frameIndex) const { return m_HiZTextures[frameIndex]; }
+	uint32_t GetHiZMipLevelCount() const { return (uint32_t)std::log2(HIZ_SIZE) + 1; }
 	std::shared_ptr<Image> GetDeltaIrradiance() const { return m_pDeltaIrradiance; }
 	std::shared_ptr<Image> GetDeltaRayleigh() const { return m_pDeltaRayleigh; }
 	std::shared_ptr<Image> GetDeltaMie() const { return m_pDeltaMie; }
 	std::shared_ptr<Image> GetDeltaScatterDensity() const { return m_pDeltaScatterDensity; }
 	std::shared_ptr<Image> GetDeltaMultiScatter() const { return m_pDeltaMultiScatter; }
+	// Precompute passes accumulate scatter and irradiance here, it's the table itself in full precision, or a shared scratch image resolved into the table later
+	std::shared_ptr<Image> GetScatterAccumulation(uint32_t planetIndex) const { return m_pScatterAccumulation != nullptr ? m_pScatterAccumulation : m_scatterTextureDiction[planetIndex]; }
+	std::shared_ptr<Image> GetIrradianceAccumulation(uint32_t planetIndex) const { return m_pIrradianceAccumulation != nullptr ? m_pIrradianceAccumulation : m_irradianceTextureDiction[planetIndex]; }
 	bool GetTextureIndex(InGameTextureType type, const std::string& textureName, uint32_t& textureIndex);
 	bool GetScreenSizeTextureIndex(const std::string& textureName, uint32_t& textureIndex);
 
 	virtual std::vector<UniformVarList> PrepareUniformVarList() const override;
 	uint32_t SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const override;
 
+	// Brdf lut and environment textures are loaded from ibl cache at startup when possible, otherwise they're generated and saved
+	void SetIBLCacheEnabled(bool flag) { m_IBLCacheEnabled = flag; }
+
 	void GenerateBRDFLUTTexture();
 	void GenerateSkyBox(uint32_t chunkIndex);
 
+	// Atmosphere precompute scratch images are shared by all planets, and only alive between acquire and release
+	// Both rewrite global texture bindings, so they flush setup work and wait for gpu idle first
+	void AcquireAtmosphereScratchImages();
+	void ReleaseAtmosphereScratchImages();
+	// Copy accumulated scatter and irradiance into tables of a planet, nothing to do in full precision
+	void ResolveAtmosphereTables(uint32_t planetIndex, const std::shared_ptr<ResourceBarrierScheduler>& pScheduler);
+
 protected:
 	bool Init(const std::shared_ptr<GlobalTextures>& pSelf);
 	void InitTextureDiction();
 	void InitScreenSizeTextureDiction();
 	void InitIBLTextures();
 	void InitSSAORandomRotationTexture();
+	void InitHiZTextures();
 	void InitTransmittanceTextureDiction();
+	void InitAtmosphereScratchImages(bool placeholder);
 	void InitSkyboxGenParameters();
+	// Main thread, as a new round of skybox gen is about to start, false if there's nothing to generate
+	bool BeginEnvGenRound(uint32_t chunkIndex);
+	bool LoadEnvCache(uint64_t envKey);
+	void SaveEnvCache(uint64_t envKey, uint32_t pingpongIndex);
+	// One job of current env gen state, and its estimated cost in texture samples
+	void RecordEnvGenJob(uint32_t chunkIndex);
+	uint64_t EstimateEnvGenJobCost() const;
 	void InsertTextureDesc(const TextureDesc& desc, TextureArrayDesc& textureArr, uint32_t& emptySlot);
 	bool GetTextureIndex(const TextureArrayDesc& textureArr, const std::string& textureName, uint32_t& textureIndex);
 
@@ -101,6 +129,7 @@ protected:
 	std::vector<std::shared_ptr<Image>>			m_IBL2DTextures;
 	std::vector<std::shared_ptr<Image>>			m_IBLCubeTextures[IBLCubeTextureTypeCount];
 	std::shared_ptr<Image>						m_pSSAORandomRotations;
+	std::vector<std::shared_ptr<Image>>			m_HiZTextures;
 
 	std::vector<std::shared_ptr<Image>>			m_transmittanceTextureDiction;
 	std::vector<std::shared_ptr<Image>>			m_scatterTextureDiction;
@@ -112,6 +141,10 @@ protected:
 	std::shared_ptr<Image>						m_pDeltaMie;
 	std::shared_ptr<Image>						m_pDeltaScatterDensity;
 	std::shared_ptr<Image>						m_pDeltaMultiScatter;
+	// Only exist while scratch images are acquired in half precision
+	std::shared_ptr<Image>						m_pScatterAccumulation;
+	std::shared_ptr<Image>						m_pIrradianceAccumulation;
+	bool										m_atmosphereScratchAcquired = false;
 
 	// Skybox generation related
 	enum class EnvGenState
@@ -136,4 +169,28 @@ protected:
 	// as soon as skybox gen starts
 	Vector3f									m_wsCameraPosition;
 	Vector4f									m_wsMainLightDir;
+	// Environment key of published ping pong textures, and of the round in progress
+	// Nothing is generated as long as key of a new round stays the same
+	uint64_t									m_publishedEnvKey = 0;
+	uint64_t									m_generatingEnvKey = 0;
+	// Only the first round looks up and fills the cache, disk io in the middle of a frame costs more than async generation
+	bool										m_IBLCacheEnabled = true;
+	bool										m_envCacheLookup = true;
+	bool										m_envCacheSaveRound = false;
+	bool										m_envCacheSavePending = false;
+	uint32_t									m_envCacheSaveIndex = 0;
+	// Frames since newly generated textures were published, they're blended in meanwhile, main thread only
+	uint32_t									m_envBlendFrameCounter = UINT32_MAX;
+	// Ping pong index published by generation job and whether to blend it in, -1 if nothing is published since main thread last checked
+	std::atomic<int32_t>						m_pendingEnvPingpongIndex = { -1 };
+	std::atomic<bool>							m_pendingEnvBlend = { false };
+	// Generation is profiled with recordings of its own, index and estimated cost of the one recorded by job are read as it's submitted
+	uint32_t									m_envGenRecordingBase = UINT32_MAX;
+	uint32_t									m_envGenRecordingCounter = 0;
+	uint32_t									m_envGenRecordingIndex = 0;
+	uint64_t									m_envGenRecordedCost = 0;
+	// Estimated cost submitted by each frame index, and smoothed gpu time per unit of it, 0 until measured
+	std::vector<uint64_t>						m_envGenSubmittedCosts;
+	uint32_t									m_envGenSampleCount = 0;
+	double										m_envGenMsPerCost = 0;
 };
\ No newline at end of file
@@ -19,9 +19,10 @@ bool GlobalUniforms::Init(const std::shared_ptr<GlobalUniforms>& pSelf)
 
 	SetGameWindowSize({ (double)GetDevice()->GetPhysicalDevice()->GetSurfaceCap().currentExtent.width, (double)GetDevice()->GetPhysicalDevice()->GetSurfaceCap().currentExtent.height });
 	SetEnvGenWindowSize({ (double)FrameBufferDiction::ENV_GEN_WINDOW_SIZE, (double)FrameBufferDiction::ENV_GEN_WINDOW_SIZE });
-	SetShadowGenWindowSize({ (double)FrameBufferDiction::SHADOW_GEN_WINDOW_SIZE, (double)FrameBufferDiction::SHADOW_GEN_WINDOW_SIZE });
+	SetShadowGenWindowSize({ (double)FrameBufferDiction::SHADOW_GEN_WINDOW_SIZE * FrameBufferDiction::SHADOW_CASCADE_ATLAS_DIM, (double)FrameBufferDiction::SHADOW_GEN_WINDOW_SIZE * FrameBufferDiction::SHADOW_CASCADE_ATLAS_DIM });
 	SetSSAOSSRWindowSize({ (double)FrameBufferDiction::SSAO_SSR_WINDOW_WIDTH, (double)FrameBufferDiction::SSAO_SSR_WINDOW_HEIGHT });
 	SetBloomWindowSize({ (double)FrameBufferDiction::BLOOM_WINDOW_SIZE, (double)FrameBufferDiction::BLOOM_WINDOW_SIZE });
+	SetRenderWindowSize({ (double)GetDevice()->GetPhysicalDevice()->GetSurfaceCap().currentExtent.width, (double)GetDevice()->GetPhysicalDevice()->GetSurfaceCap().currentExtent.height });
 	SetMotionTileSize({ (double)FrameBufferDiction::MOTION_TILE_SIZE, (double)FrameBufferDiction::MOTION_TILE_SIZE });
 
 	InitSSAORandomSample();
@@ -107,12 +108,26 @@ void GlobalUniforms::SetMotionTileSize(const Vector2d& size)
 {
 	m_globalVariables.motionTileWindowSize.x = size.x;
 	m_globalVariables.motionTileWindowSize.y = size.y;
-	m_globalVariables.motionTileWindowSize.z = (uint32_t)m_globalVariables.gameWindowSize.x / (uint32_t)size.x + (((uint32_t)m_globalVariables.gameWindowSize.x % (uint32_t)size.x) > 0 ? 1 : 0);
-	m_globalVariables.motionTileWindowSize.w = (uint32_t)m_globalVariables.gameWindowSize.y / (uint32_t)size.y + (((uint32_t)m_globalVariables.gameWindowSize.y % (uint32_t)size.y) > 0 ? 1 : 0);
+	m_globalVariables.motionTileWindowSize.z = (uint32_t)m_globalVariables.renderWindowSize.x / (uint32_t)size.x + (((uint32_t)m_globalVariables.renderWindowSize.x % (uint32_t)size.x) > 0 ? 1 : 0);
+	m_globalVariables.motionTileWindowSize.w = (uint32_t)m_globalVariables.renderWindowSize.y / (uint32_t)size.y + (((uint32_t)m_globalVariables.renderWindowSize.y % (uint32_t)size.y) > 0 ? 1 : 0);
 	CONVERT2SINGLE(m_globalVariables, m_singlePrecisionGlobalVariables, motionTileWindowSize);
 	SetDirty();
 }
 
+void GlobalUniforms::SetRenderWindowSize(const Vector2d& size)
+{
+	m_globalVariables.renderWindowSize.x = size.x;
+	m_globalVariables.renderWindowSize.y = size.y;
+	m_globalVariables.renderWindowSize.z = 1.0 / size.x;
+	m_globalVariables.renderWindowSize.w = 1.0 / size.y;
+	CONVERT2SINGLE(m_globalVariables, m_singlePrecisionGlobalVariables, renderWindowSize);
+
+	if (m_globalVariables.motionTileWindowSize.x > 0)
+		SetMotionTileSize({ m_globalVariables.motionTileWindowSize.x, m_globalVariables.motionTileWindowSize.y });
+
+	SetDirty();
+}
+
 void GlobalUniforms::UpdateUniformDataInternal()
 {
 	m_globalVariables.DOFSettings0.z = m_globalVariables.mainCameraSettings0.w * m_globalVariables.mainCameraSettings0.w / 
@@ -644,6 +659,10 @@ std::vector<UniformVarList> GlobalUniforms::PrepareUniformVarList() const
 					Vec4Unit,
 					"MotionWindowSize"
 				},
+				{
+					Vec4Unit,
+					"RenderWindowSize"
+				},
 				{
 					Vec4Unit,
 					"Main Camera settings0"
@@ -31,6 +31,7 @@ public:
 	Vector4<T>		SSAOSSRWindowSize;
 	Vector4<T>		bloomWindowSize;
 	Vector4<T>		motionTileWindowSize;	// xy: tile size, zw: window size
+	Vector4<T>		renderWindowSize;		// xy: viewport scene is rendered to within game window sized targets, zw: reciprocal of xy
 
 	/*******************************************************************
 	* DESCRIPTION: Camera parameters
@@ -246,6 +247,9 @@ public:
 	void SetMotionTileSize(const Vector2d& size);
 	Vector2d GetMotionTileSize() const { return { m_globalVariables.motionTileWindowSize.x, m_globalVariables.motionTileWindowSize.y }; }
 	Vector2d GetMotionTileWindowSize() const { return { m_globalVariables.motionTileWindowSize.z, m_globalVariables.motionTileWindowSize.w }; }
+	// Motion tile window size follows it, since motion tiles only cover rendered region
+	void SetRenderWindowSize(const Vector2d& size);
+	Vector2d GetRenderWindowSize() const { return { m_globalVariables.renderWindowSize.x, m_globalVariables.renderWindowSize.y }; }
 
 	void SetMainCameraSettings0(const Vector4d& settings);
 	Vector4d GetMainCameraSettings0() const { return m_globalVariables.mainCameraSettings0; }
@@ -0,0 +1,93 @@
+#include "IBLCache.h"
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+
+uint64_t IBLCache::HashEnvironment(const AtmosphereParameters<float>& atmosphere, const Vector3f& wsCameraPosition, const Vector4f& wsMainLightDir, uint32_t envMapSize)
+{
+	int64_t quantized[] =
+	{
+		CACHE_VERSION,
+		envMapSize,
+		(int64_t)std::round(wsCameraPosition.x),
+		(int64_t)std::round(wsCameraPosition.y),
+		(int64_t)std::round(wsCameraPosition.z),
+		(int64_t)std::round(wsMainLightDir.x * LIGHT_DIR_QUANTIZATION),
+		(int64_t)std::round(wsMainLightDir.y * LIGHT_DIR_QUANTIZATION),
+		(int64_t)std::round(wsMainLightDir.z * LIGHT_DIR_QUANTIZATION)
+	};
+
+	uint64_t hash = AtmosphereLUTCache::HashParameters(atmosphere);
+	return AtmosphereLUTCache::FNV1a(quantized, sizeof(quantized), hash);
+}
+
+std::string IBLCache::GetEnvCachePath(uint64_t envHash, const std::string& textureName)
+{
+	std::stringstream ss;
+	ss << "ibl_" << std::hex << std::setw(16) << std::setfill('0') << envHash << "_" << textureName << ".ktx";
+	return (AtmosphereLUTCache::GetCacheDirectory() / ss.str()).string();
+}
+
+std::string IBLCache::GetBRDFLUTCachePath(const Vector2ui& size)
+{
+	std::stringstream ss;
+	ss << "brdf_lut_v" << CACHE_VERSION << "_" << size.x << "x" << size.y << ".ktx";
+	return (AtmosphereLUTCache::GetCacheDirectory() / ss.str()).string();
+}
+
+gli::format IBLCache::AcquireGliFormat(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_R16G16B16A16_SFLOAT: return gli::FORMAT_RGBA16_SFLOAT_PACK16;
+	case VK_FORMAT_R32G32B32A32_SFLOAT: return gli::FORMAT_RGBA32_SFLOAT_PACK32;
+	case VK_FORMAT_R8G8B8A8_UNORM: return gli::FORMAT_RGBA8_UNORM_PACK8;
+	default: return gli::FORMAT_UNDEFINED;
+	}
+}
+
+bool IBLCache::Load(const std::string& path, const std::shared_ptr<Image>& pImage)
+{
+	const VkImageCreateInfo& info = pImage->GetImageInfo();
+
+	gli::format format = AcquireGliFormat(info.format);
+	if (format == gli::FORMAT_UNDEFINED)
+		return false;
+
+	// Empty if file doesn't exist or is broken
+	gli::texture tex = gli::load(path);
+	if (tex.empty())
+		return false;
+
+	if (tex.format() != format ||
+		(uint32_t)tex.extent().x != info.extent.width || (uint32_t)tex.extent().y != info.extent.height ||
+		tex.levels() != info.mipLevels ||
+		tex.layers() * tex.faces() != info.arrayLayers)
+		return false;
+
+	pImage->UpdateByteStream({ { tex } });
+	return true;
+}
+
+bool IBLCache::Save(const std::string& path, const std::shared_ptr<Image>& pImage)
+{
+	const VkImageCreateInfo& info = pImage->GetImageInfo();
+
+	gli::format format = AcquireGliFormat(info.format);
+	if (format == gli::FORMAT_UNDEFINED)
+		return false;
+
+	GliImageWrapper wrapper;
+	if (info.flags & VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT)
+		wrapper.textures.push_back(gli::texture_cube(format, gli::extent2d(info.extent.width, info.extent.height), info.mipLevels));
+	else
+		wrapper.textures.push_back(gli::texture2d(format, gli::extent2d(info.extent.width, info.extent.height), info.mipLevels));
+
+	pImage->ReadByteStream(wrapper);
+
+	// Nothing to do if it already exists, failing to create it shows up as failing to save
+	std::error_code error;
+	std::filesystem::create_directories(AtmosphereLUTCache::GetCacheDirectory(), error);
+
+	return gli::save_ktx(wrapper.textures[0], path);
+}
\ No newline at end of file
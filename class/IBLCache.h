@@ -0,0 +1,33 @@
+#pragma once
+
+#include "AtmosphereLUTCache.h"
+#include "../vulkan/Image.h"
+#include <string>
+
+// On disk cache of generated image based lighting textures, one ktx file per texture
+// Environment cubes are keyed by a hash of everything skybox generation consumes: atmosphere parameters,
+// quantized camera position and main light direction, map size and cache version
+// Brdf lut depends on nothing but its size, so its file is named after size only
+// Files go to the same directory as atmosphere cache, see AtmosphereLUTCache::GetCacheDirectory()
+class IBLCache
+{
+public:
+	// Bump it whenever ibl generation shaders change
+	static const uint32_t CACHE_VERSION = 1;
+
+	// Camera position is snapped to world units, light direction to 1/1024, small jitter doesn't invalidate the key
+	static const uint32_t LIGHT_DIR_QUANTIZATION = 1024;
+
+public:
+	static uint64_t HashEnvironment(const AtmosphereParameters<float>& atmosphere, const Vector3f& wsCameraPosition, const Vector4f& wsMainLightDir, uint32_t envMapSize);
+	static std::string GetEnvCachePath(uint64_t envHash, const std::string& textureName);
+	static std::string GetBRDFLUTCachePath(const Vector2ui& size);
+
+	// Upload cached texels into "pImage", fails if file is missing or doesn't match format, size, mip levels and layers of it
+	static bool Load(const std::string& path, const std::shared_ptr<Image>& pImage);
+	// Blocking readback of "pImage", work recorded to init command batcher so far is flushed
+	static bool Save(const std::string& path, const std::shared_ptr<Image>& pImage);
+
+protected:
+	static gli::format AcquireGliFormat(VkFormat format);
+};
\ No newline at end of file
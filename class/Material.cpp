@@ -33,6 +33,7 @@
 #include "Mesh.h"
 #include "RenderWorkManager.h"
 #include "FrameWorkManager.h"
+#include "OcclusionCullingMaterial.h"
 
 void Material::GeneralInit
 (
@@ -121,6 +122,17 @@ void Material::GeneralInit
 				nullptr
 				});
 
+			break;
+		case StorageBuffer:
+			bindings.push_back
+			({
+				(uint32_t)bindings.size(),
+				VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+				var.count,
+				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT,
+				nullptr
+				});
+
 			break;
 		case CombinedSampler:
 			bindings.push_back
@@ -409,7 +421,9 @@ uint32_t Material::GetUniformBufferSize() const
 
 void Material::SyncBufferData()
 {
-	if (m_indirectBuffers.size() > 0)
+	if (m_indirectBuffers.size() > 0 && IsGPUCullingEnabled())
+		SyncCullingData();
+	else if (m_indirectBuffers.size() > 0)
 	{
 		uint32_t drawID = 0;
 		uint32_t offset = 0;
@@ -446,6 +460,60 @@ void Material::SyncBufferData()
 	for (auto & var : m_materialUniforms)
 		if (var != nullptr)
 			var->SyncBufferData();
+
+	if (IsGPUCullingEnabled())
+		m_pPerMaterialCullingUniforms->SyncBufferData();
+}
+
+void Material::SyncCullingData()
+{
+	uint32_t offset = 0;
+	VkDrawIndexedIndirectCommand cmd;
+
+	// Draw commands are built by culling shader, one for each instance survived
+	// So an instance is located by "firstInstance" alone, and indirect offsets stay 0
+	for each(auto& meshRenderData in m_cachedMeshRenderData)
+	{
+		// Manually instanced draws share one per object index, there's no way to cull their instances separately
+		ASSERTION(meshRenderData.instanceCount == (uint32_t)meshRenderData.indirectIndices.size());
+
+		meshRenderData.pMesh->PrepareIndirectCmd(cmd);
+
+		PerInstanceCullingData cullingData;
+		cullingData.indexCount = cmd.indexCount;
+		cullingData.firstIndex = cmd.firstIndex;
+		cullingData.vertexOffset = cmd.vertexOffset;
+
+		const BoundingBoxd& bounds = meshRenderData.pMesh->GetBounds();
+		if (bounds.IsValid())
+		{
+			cullingData.boundsMin = { (float)bounds.min.x, (float)bounds.min.y, (float)bounds.min.z, 1.0f };
+			cullingData.boundsMax = { (float)bounds.max.x, (float)bounds.max.y, (float)bounds.max.z, 1.0f };
+		}
+
+		for (uint32_t instanceCount = 0; instanceCount < meshRenderData.indirectIndices.size(); instanceCount++)
+		{
+			ASSERTION(offset < OcclusionCullingMaterial::MAX_INSTANCE_COUNT);
+
+			m_pPerMaterialIndirectUniforms->SetPerObjectIndex(offset, meshRenderData.indirectIndices[instanceCount].perObjectIndex);
+			m_pPerMaterialIndirectUniforms->SetPerMaterialIndex(offset, meshRenderData.indirectIndices[instanceCount].perMaterialIndex);
+			m_pPerMaterialIndirectUniforms->SetPerMeshIndex(offset, meshRenderData.indirectIndices[instanceCount].perMeshIndex);
+			m_pPerMaterialIndirectUniforms->SetUtilityIndex(offset, meshRenderData.indirectIndices[instanceCount].utilityIndex);
+
+			cullingData.perObjectIndex = meshRenderData.indirectIndices[instanceCount].perObjectIndex;
+			m_pPerMaterialCullingUniforms->SetCullingData(offset, cullingData);
+
+			if (m_pPerMaterialIndirectOffset->GetIndirectOffset(offset) != 0)
+				m_pPerMaterialIndirectOffset->SetIndirectOffset(offset, 0);
+
+			offset++;
+		}
+	}
+
+	// Slots used last time but not now are marked unused, so that culling shader skips them
+	for (uint32_t i = offset; i < m_culledInstanceCount; i++)
+		m_pPerMaterialCullingUniforms->SetCullingData(i, PerInstanceCullingData());
+	m_culledInstanceCount = offset;
 }
 
 void Material::BindPipeline(const std::shared_ptr<CommandBuffer>& pCmdBuffer)
@@ -477,13 +545,13 @@ void Material::InsertIntoRenderQueue(const std::shared_ptr<Mesh>& pMesh, uint32_
 {
 	ASSERTION(instanceCount > 0);
 
-	auto iter = m_perFrameMeshRefTable.find(pMesh);
+	auto iter = m_perFrameMeshRefTable.find(pMesh.get());
 
 	// Instance count greater than 1 means manually instanced rendering
 	bool manualInstance = instanceCount > 1;
 
 	// If a mesh is not yet added to ref table of current frame
-	if (iter == m_perFrameMeshRefTable.end() || manualInstance)
+	if (iter == m_perFrameMeshRefTable.end() || iter->second.frameStamp != m_meshRefFrameStamp || manualInstance)
 	{
 		// First all the info into cached mesh render data
 		m_cachedMeshRenderData.push_back
@@ -492,7 +560,7 @@ void Material::InsertIntoRenderQueue(const std::shared_ptr<Mesh>& pMesh, uint32_
 				pMesh,
 				instanceCount,
 				startInstance,
-				std::vector<PerMaterialIndirectVariables>(1, {perObjectIndex, perMaterialIndex, perMeshIndex, utilityIndex })
+				FrameVector<PerMaterialIndirectVariables>(1, {perObjectIndex, perMaterialIndex, perMeshIndex, utilityIndex })
 			}
 		);
 
@@ -501,13 +569,13 @@ void Material::InsertIntoRenderQueue(const std::shared_ptr<Mesh>& pMesh, uint32_
 		// Or there's no need to search this mesh and add it to instance count
 		// NOTE: Only add to ref table if it's not manual instanced rendering
 		if (!manualInstance)
-			m_perFrameMeshRefTable[pMesh] = (uint32_t)m_cachedMeshRenderData.size() - 1;
+			m_perFrameMeshRefTable[pMesh.get()] = { m_meshRefFrameStamp, (uint32_t)m_cachedMeshRenderData.size() - 1 };
 
 		return;
 	}
 
 	// If a mesh is already recorded, add instance count by 1
-	auto& renderData = m_cachedMeshRenderData[iter->second];
+	auto& renderData = m_cachedMeshRenderData[iter->second.renderDataIndex];
 	renderData.instanceCount += 1;
 	renderData.indirectIndices.push_back({ perObjectIndex, perMaterialIndex, perMeshIndex, utilityIndex });
 }
@@ -570,6 +638,50 @@ void Material::DrawIndirect(const std::shared_ptr<CommandBuffer>& pCmdBuf, const
 	if (m_indirectBuffers.size() == 0)
 		return;
 
+	uint32_t frameIndex = FrameWorkManager::GetInstance()->FrameIndex();
+
+	if (IsGPUCullingEnabled())
+	{
+		RecordIndirectDraw
+		(
+			pCmdBuf, pFrameBuffer,
+			m_pCulledIndirectBuffer, OcclusionCullingMaterial::GetCulledIndirectOffset(frameIndex, OcclusionCullingMaterial::EarlyPhase),
+			m_pCulledIndirectCmdCountBuffer, OcclusionCullingMaterial::GetCulledCountOffset(frameIndex, OcclusionCullingMaterial::EarlyPhase),
+			pingpong, overrideVP
+		);
+	}
+	else
+		RecordIndirectDraw(pCmdBuf, pFrameBuffer, m_indirectBuffers[frameIndex], 0, m_indirectCmdCountBuffers[frameIndex], 0, pingpong, overrideVP);
+}
+
+void Material::DrawLateIndirect(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong, bool overrideVP)
+{
+	if (!IsGPUCullingEnabled())
+		return;
+
+	uint32_t frameIndex = FrameWorkManager::GetInstance()->FrameIndex();
+
+	RecordIndirectDraw
+	(
+		pCmdBuf, pFrameBuffer,
+		m_pCulledIndirectBuffer, OcclusionCullingMaterial::GetCulledIndirectOffset(frameIndex, OcclusionCullingMaterial::LatePhase),
+		m_pCulledIndirectCmdCountBuffer, OcclusionCullingMaterial::GetCulledCountOffset(frameIndex, OcclusionCullingMaterial::LatePhase),
+		pingpong, overrideVP
+	);
+}
+
+void Material::RecordIndirectDraw
+(
+	const std::shared_ptr<CommandBuffer>& pCmdBuf,
+	const std::shared_ptr<FrameBuffer>& pFrameBuffer,
+	const std::shared_ptr<SharedIndirectBuffer>& pIndirectBuffer,
+	uint32_t indirectOffset,
+	const std::shared_ptr<SharedIndirectBuffer>& pIndirectCmdCountBuffer,
+	uint32_t indirectCountOffset,
+	uint32_t pingpong,
+	bool overrideVP
+)
+{
 	std::shared_ptr<CommandBuffer> pSecondaryCmd = FrameWorkManager::GetInstance()->GetMainThreadPerFrameRes()->AllocateCommandBuffer
 	(
 		PhysicalDevice::QueueFamily::ALL_ROUND,
@@ -581,13 +693,70 @@ void Material::DrawIndirect(const std::shared_ptr<CommandBuffer>& pCmdBuf, const
 
 	PrepareCommandBuffer(pSecondaryCmd, pFrameBuffer, false, pingpong, overrideVP);
 
-	pSecondaryCmd->DrawIndexedIndirectCount(m_indirectBuffers[FrameWorkManager::GetInstance()->FrameIndex()], 0, m_indirectCmdCountBuffers[FrameWorkManager::GetInstance()->FrameIndex()], 0);
+	pSecondaryCmd->DrawIndexedIndirectCount(pIndirectBuffer, indirectOffset, pIndirectCmdCountBuffer, indirectCountOffset);
 
 	pSecondaryCmd->EndSecondaryRecording();
 
 	pCmdBuf->Execute({ pSecondaryCmd });
 }
 
+void Material::EnableGPUCulling()
+{
+	if (IsGPUCullingEnabled() || m_indirectBuffers.size() == 0)
+		return;
+
+	uint32_t frameCount = GetSwapChain()->GetSwapChainImageCount();
+
+	m_pPerMaterialCullingUniforms = PerMaterialCullingUniforms::Create();
+
+	m_pCulledIndirectBuffer = SharedIndirectBuffer::Create(GetDevice(), sizeof(VkDrawIndexedIndirectCommand) * OcclusionCullingMaterial::MAX_INSTANCE_COUNT * OcclusionCullingMaterial::CullingPhaseCount * frameCount);
+
+	// Counts are reset by culling shader itself, they start from 0
+	std::vector<uint32_t> zeros(OcclusionCullingMaterial::CullingPhaseCount * frameCount);
+	m_pCulledIndirectCmdCountBuffer = SharedIndirectBuffer::Create(GetDevice(), sizeof(uint32_t) * (uint32_t)zeros.size());
+	m_pCulledIndirectCmdCountBuffer->UpdateByteStream(zeros.data(), 0, sizeof(uint32_t) * (uint32_t)zeros.size());
+
+	zeros.resize(OcclusionCullingMaterial::MAX_INSTANCE_COUNT * frameCount);
+	m_pCullingCandidateBuffer = ShaderStorageBuffer::Create(GetDevice(), sizeof(uint32_t) * (uint32_t)zeros.size());
+	m_pCullingCandidateBuffer->UpdateByteStream(zeros.data(), 0, sizeof(uint32_t) * (uint32_t)zeros.size());
+
+	for (uint32_t i = 0; i < OcclusionCullingMaterial::CullingPhaseCount; i++)
+	{
+		m_occlusionCullingMaterials.push_back(OcclusionCullingMaterial::CreateMaterial
+		(
+			(OcclusionCullingMaterial::CullingPhase)i,
+			m_pPerMaterialCullingUniforms,
+			m_pCulledIndirectBuffer,
+			m_pCulledIndirectCmdCountBuffer,
+			m_pCullingCandidateBuffer
+		));
+	}
+}
+
+void Material::DispatchCulling(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<ResourceBarrierScheduler>& pScheduler, uint32_t cullingPhase)
+{
+	if (!IsGPUCullingEnabled())
+		return;
+
+	m_occlusionCullingMaterials[cullingPhase]->BeforeRenderPass(pCmdBuf, pScheduler);
+	m_occlusionCullingMaterials[cullingPhase]->Dispatch(pCmdBuf);
+	m_occlusionCullingMaterials[cullingPhase]->AfterRenderPass(pCmdBuf);
+
+	// Culled draw commands and counts are consumed by indirect draws right after
+	std::vector<std::shared_ptr<VKGPUSyncRes>> buffers = { m_pCulledIndirectBuffer, m_pCulledIndirectCmdCountBuffer };
+	for (auto& pBuffer : buffers)
+	{
+		pScheduler->ClaimResourceUsage
+		(
+			pCmdBuf,
+			pBuffer,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+		);
+	}
+}
+
 void Material::DrawScreenQuad(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong, bool overrideVP)
 {
 	std::shared_ptr<CommandBuffer> pSecondaryCmd = FrameWorkManager::GetInstance()->GetMainThreadPerFrameRes()->AllocateCommandBuffer
@@ -623,7 +792,8 @@ void Material::OnFrameEnd()
 	//m_indirectIndex = 0;
 
 	// Clear tables that are used to construct indirect buffer of current frame
-	m_perFrameMeshRefTable.clear();
+	// Ref table is invalidated by stamp, and render data keeps its capacity, so neither of them allocates next frame
+	m_meshRefFrameStamp++;
 	m_cachedMeshRenderData.clear();
 }
 
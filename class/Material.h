@@ -7,6 +7,7 @@
 #include <map>
 #include  <unordered_map>
 #include "../common/Enums.h"
+#include "../common/FrameArena.h"
 #include "../Maths/Vector3.h"
 #include "PerMaterialIndirectUniforms.h"
 #include "ResourceBarrierScheduler.h"
@@ -27,6 +28,7 @@ class CommandBuffer;
 class Image;
 class SharedIndirectBuffer;
 class FrameBuffer;
+class OcclusionCullingMaterial;
 class RenderPassBase;
 
 // More to add
@@ -34,6 +36,7 @@ enum MaterialVariableType
 {
 	DynamicUniformBuffer,
 	DynamicShaderStorageBuffer,
+	StorageBuffer,
 	CombinedSampler,
 	InputAttachment,
 	StorageImage,
@@ -127,6 +130,16 @@ public:
 	virtual void Dispatch(const std::shared_ptr<CommandBuffer>& pCmdBuf, uint32_t pingpong = 0);
 	virtual void AfterRenderPass(const std::shared_ptr<CommandBuffer>& pCmdBuf, uint32_t pingpong = 0);
 
+	// Gpu culling of indirectly drawn instances, see "OcclusionCullingMaterial"
+	// Once enabled, "DrawIndirect" draws instances survived early phase, and "DrawLateIndirect" draws the ones survived late phase
+	// It has to be enabled before any command buffer is recorded, and only works with auto instanced rendering
+	void EnableGPUCulling();
+	bool IsGPUCullingEnabled() const { return m_pPerMaterialCullingUniforms != nullptr; }
+	// Outside of render pass, indirect buffers of "cullingPhase" are ready for draws after it
+	void DispatchCulling(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<ResourceBarrierScheduler>& pScheduler, uint32_t cullingPhase);
+	// Render pass has to be compatible with the one of this material
+	void DrawLateIndirect(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false);
+
 	virtual void OnFrameBegin();
 	virtual void OnFrameEnd();
 
@@ -141,6 +154,17 @@ protected:
 	virtual void ClaimResourceUsage(const std::shared_ptr<CommandBuffer>& pCmdBuffer, const std::shared_ptr<ResourceBarrierScheduler>& pScheduler, uint32_t pingpong = 0) {}
 
 	virtual void PrepareCommandBuffer(const std::shared_ptr<CommandBuffer>& pSecondaryCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, bool isCompute, uint32_t pingpong = 0, bool overrideVP = false);
+	void RecordIndirectDraw
+	(
+		const std::shared_ptr<CommandBuffer>& pCmdBuf,
+		const std::shared_ptr<FrameBuffer>& pFrameBuffer,
+		const std::shared_ptr<SharedIndirectBuffer>& pIndirectBuffer,
+		uint32_t indirectOffset,
+		const std::shared_ptr<SharedIndirectBuffer>& pIndirectCmdCountBuffer,
+		uint32_t indirectCountOffset,
+		uint32_t pingpong,
+		bool overrideVP
+	);
 	virtual void CustomizeCommandBuffer(const std::shared_ptr<CommandBuffer>& pSecondaryCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0) {}
 
 protected:
@@ -192,6 +216,7 @@ protected:
 
 	static uint32_t GetByteSize(std::vector<UniformVar>& UBOLayout);
 	void InsertIntoRenderQueue(const std::shared_ptr<Mesh>& pMesh, uint32_t perObjectIndex, uint32_t perMaterialIndex, uint32_t perMeshIndex, uint32_t utilityIndex, uint32_t instanceCount, uint32_t startInstance);
+	void SyncCullingData();
 
 protected:
 	typedef struct _MeshRenderData
@@ -199,9 +224,15 @@ protected:
 		std::shared_ptr<Mesh>						pMesh;
 		uint32_t									instanceCount;
 		uint32_t									instanceDataOffset;
-		std::vector<PerMaterialIndirectVariables>	indirectIndices;
+		FrameVector<PerMaterialIndirectVariables>	indirectIndices;
 	}MeshRenderData;
 
+	typedef struct _MeshRef
+	{
+		uint32_t	frameStamp;
+		uint32_t	renderDataIndex;
+	}MeshRef;
+
 	std::shared_ptr<RenderPassBase>						m_pRenderPass;
 
 	std::shared_ptr<PipelineLayout>						m_pPipelineLayout;
@@ -222,7 +253,10 @@ protected:
 	std::shared_ptr<PerMaterialUniforms>				m_pPerMaterialUniforms;
 
 	// key: mesh, value: mesh index at "m_cachedMeshRenderData"
-	std::unordered_map<std::shared_ptr<Mesh>, uint32_t>	m_perFrameMeshRefTable;
+	// Table isn't cleared per frame to avoid node allocations, an entry is only valid if its stamp equals to "m_meshRefFrameStamp"
+	// Raw pointer is fine as key, since "m_cachedMeshRenderData" keeps mesh alive within the frame
+	std::unordered_map<Mesh*, MeshRef>					m_perFrameMeshRefTable;
+	uint32_t											m_meshRefFrameStamp = 0;
 
 	std::vector<MeshRenderData>							m_cachedMeshRenderData;
 
@@ -232,6 +266,14 @@ protected:
 
 	std::vector<std::shared_ptr<SharedIndirectBuffer>>	m_indirectBuffers;
 	std::vector<std::shared_ptr<SharedIndirectBuffer>>	m_indirectCmdCountBuffers;
+
+	// Gpu culling, culled indirect buffers hold draw commands and counts of both phases of all frames
+	std::shared_ptr<PerMaterialCullingUniforms>				m_pPerMaterialCullingUniforms;
+	std::shared_ptr<SharedIndirectBuffer>					m_pCulledIndirectBuffer;
+	std::shared_ptr<SharedIndirectBuffer>					m_pCulledIndirectCmdCountBuffer;
+	std::shared_ptr<ShaderStorageBuffer>					m_pCullingCandidateBuffer;
+	std::vector<std::shared_ptr<OcclusionCullingMaterial>>	m_occlusionCullingMaterials;
+	uint32_t												m_culledInstanceCount = 0;
 	
 	uint32_t											m_vertexFormat;
 	uint32_t											m_vertexFormatInMem;
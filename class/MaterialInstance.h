@@ -1,6 +1,7 @@
 #pragma once
 #include "../Base/BaseComponent.h"
 #include "GlobalTextures.h"
+#include "FramePipeline.h"
 
 class DescriptorSet;
 class DescriptorPool;
@@ -17,15 +18,28 @@ public:
 	std::shared_ptr<Material> GetMaterial() const { return m_pMaterial; }
 	uint32_t GetRenderMask() const { return m_renderMask; }
 	void SetRenderMask(uint32_t renderMask) { m_renderMask = renderMask; }
+	// Shadow cascades this material instance renders to, see MeshRenderer::SetShadowCascadeMask()
+	uint32_t GetShadowCascadeMask() const { return m_shadowCascadeMask; }
+	void SetShadowCascadeMask(uint32_t mask) { m_shadowCascadeMask = mask; }
 	void SetMaterialTexture(uint32_t parameterIndex, InGameTextureType type, const std::string& textureName);
 	void SetMaterialTexture(const std::string& paramName, InGameTextureType type, const std::string& textureName);
 	void PrepareMaterial(const std::shared_ptr<CommandBuffer>& pCmdBuffer);
 
 	// FIXME: should add name based functions to ease of use
+	// Parameters set by pipelined simulation are handed over to render stage at frame boundary, see FramePipeline
 	template <typename T>
 	void SetParameter(uint32_t parameterIndex, T val)
 	{
-		m_pMaterial->SetParameter(m_materialBufferChunkIndex, parameterIndex, val);
+		if (!FramePipeline::IsConcurrentSimulation())
+		{
+			m_pMaterial->SetParameter(m_materialBufferChunkIndex, parameterIndex, val);
+			return;
+		}
+
+		FramePipeline::GetInstance()->UpdateRenderState([pMaterial = m_pMaterial, chunkIndex = m_materialBufferChunkIndex, parameterIndex, val]()
+		{
+			pMaterial->SetParameter(chunkIndex, parameterIndex, val);
+		});
 	}
 
 	template <typename T>
@@ -37,7 +51,16 @@ public:
 	template <typename T>
 	void SetParameter(const std::string& paramName, T val)
 	{
-		m_pMaterial->SetParameter(m_materialBufferChunkIndex, paramName, val);
+		if (!FramePipeline::IsConcurrentSimulation())
+		{
+			m_pMaterial->SetParameter(m_materialBufferChunkIndex, paramName, val);
+			return;
+		}
+
+		FramePipeline::GetInstance()->UpdateRenderState([pMaterial = m_pMaterial, chunkIndex = m_materialBufferChunkIndex, paramName, val]()
+		{
+			pMaterial->SetParameter(chunkIndex, paramName, val);
+		});
 	}
 
 	template <typename T>
@@ -57,6 +80,7 @@ protected:
 	std::shared_ptr<Material>					m_pMaterial;
 	std::vector<uint32_t>						m_materialVariables;
 	uint32_t									m_renderMask = 0xffffffff;
+	uint32_t									m_shadowCascadeMask = 0xffffffff;
 	uint32_t									m_materialBufferChunkIndex;
 
 	friend class Material;
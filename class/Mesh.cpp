@@ -5,12 +5,15 @@
 #include "../vulkan/CommandBuffer.h"
 #include "../Maths/AssimpDataConverter.h"
 #include "UniformData.h"
+#include "CullingManager.h"
 #include "Importer.hpp"
 #include "postprocess.h"
 #include <string>
 #include "../common/Util.h"
 #include <codecvt>
 #include <locale>
+#include <algorithm>
+#include <unordered_map>
 
 bool Mesh::Init
 (
@@ -26,6 +29,36 @@ bool Mesh::Init
 	m_verticesCount = verticesCount;
 	m_indicesCount = indicesCount;
 
+	// Position is always the first attribute
+	if (vertexFormat & (1 << VAFPosition))
+	{
+		for (uint32_t i = 0; i < verticesCount; i++)
+		{
+			const float* pPosition = (const float*)((const uint8_t*)pVertices + i * m_vertexBytes);
+			m_bounds.Merge({ pPosition[0], pPosition[1], pPosition[2] });
+		}
+
+		// Occluder geometry is built later, only for meshes whose renderers are tagged as occluders
+		if (CullingManager::GetInstance()->IsOcclusionCullingEnabled())
+		{
+			m_occluderSourcePositions.resize(verticesCount);
+			for (uint32_t i = 0; i < verticesCount; i++)
+			{
+				const float* pPosition = (const float*)((const uint8_t*)pVertices + i * m_vertexBytes);
+				m_occluderSourcePositions[i] = { pPosition[0], pPosition[1], pPosition[2] };
+			}
+
+			m_occluderSourceIndices.resize(indicesCount);
+			for (uint32_t i = 0; i < indicesCount; i++)
+			{
+				if (indexType == VK_INDEX_TYPE_UINT16)
+					m_occluderSourceIndices[i] = ((const uint16_t*)pIndices)[i];
+				else
+					m_occluderSourceIndices[i] = ((const uint32_t*)pIndices)[i];
+			}
+		}
+	}
+
 	m_pVertexBuffer = SharedVertexBuffer::Create(GetDevice(), m_verticesCount * m_vertexBytes, vertexFormat);
 	m_pVertexBuffer->UpdateByteStream(pVertices, 0, m_verticesCount * m_vertexBytes);
 	m_pIndexBuffer = SharedIndexBuffer::Create(GetDevice(), indicesCount * GetIndexBytes(indexType), indexType);
@@ -34,6 +67,86 @@ bool Mesh::Init
 	return true;
 }
 
+bool Mesh::InitSkinningTarget(const std::shared_ptr<Mesh>& pSelf, const std::shared_ptr<Mesh>& pSkinnedMesh)
+{
+	if (!SelfRefBase<Mesh>::Init(pSelf))
+		return false;
+
+	m_vertexBytes = ::GetVertexBytes(VertexFormatPNTCT);
+	m_verticesCount = pSkinnedMesh->m_verticesCount;
+	m_indicesCount = pSkinnedMesh->m_indicesCount;
+	m_meshChunkIndex = pSkinnedMesh->m_meshChunkIndex;
+
+	// Bounds stay invalid, animated vertices go beyond bind pose ones
+	m_pVertexBuffer = SharedVertexBuffer::Create(GetDevice(), m_verticesCount * m_vertexBytes, VertexFormatPNTCT);
+	m_pIndexBuffer = pSkinnedMesh->m_pIndexBuffer;
+
+	return true;
+}
+
+void Mesh::SetOccluderGeometry(const std::vector<Vector3f>& positions, const std::vector<uint32_t>& indices)
+{
+	m_occluderPositions = positions;
+	m_occluderIndices = indices;
+
+	std::vector<Vector3f>().swap(m_occluderSourcePositions);
+	std::vector<uint32_t>().swap(m_occluderSourceIndices);
+}
+
+void Mesh::PrepareOccluderGeometry()
+{
+	// Already built or assigned, or nothing to build from
+	if (!m_occluderIndices.empty() || m_occluderSourceIndices.empty())
+		return;
+
+	BuildOccluderGeometry();
+
+	std::vector<Vector3f>().swap(m_occluderSourcePositions);
+	std::vector<uint32_t>().swap(m_occluderSourceIndices);
+}
+
+void Mesh::BuildOccluderGeometry()
+{
+	auto getIndex = [&](uint32_t i) { return m_occluderSourceIndices[i]; };
+	auto getPosition = [&](uint32_t index) { return m_occluderSourcePositions[index]; };
+
+	// Keep the largest triangles, they're the ones most likely to hide something
+	std::vector<std::pair<float, uint32_t>> triangles;
+	for (uint32_t i = 0; i + 2 < (uint32_t)m_occluderSourceIndices.size(); i += 3)
+	{
+		Vector3f p0 = getPosition(getIndex(i));
+		Vector3f edge0 = getPosition(getIndex(i + 1)) - p0;
+		Vector3f edge1 = getPosition(getIndex(i + 2)) - p0;
+		// Squared area is enough for sorting
+		float squareArea = (edge0 ^ edge1).SquareLength();
+		if (squareArea > 0)
+			triangles.push_back({ squareArea, i });
+	}
+
+	uint32_t triangleCount = (std::min)((uint32_t)triangles.size(), MAX_OCCLUDER_TRIANGLE_COUNT);
+	std::partial_sort(triangles.begin(), triangles.begin() + triangleCount, triangles.end(),
+		[](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b) { return a.first > b.first; });
+
+	// Re-index vertices kept
+	std::unordered_map<uint32_t, uint32_t> remap;
+	m_occluderPositions.clear();
+	m_occluderIndices.clear();
+	for (uint32_t i = 0; i < triangleCount; i++)
+	{
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			uint32_t index = getIndex(triangles[i].second + j);
+			auto it = remap.find(index);
+			if (it == remap.end())
+			{
+				it = remap.insert({ index, (uint32_t)m_occluderPositions.size() }).first;
+				m_occluderPositions.push_back(getPosition(index));
+			}
+			m_occluderIndices.push_back(it->second);
+		}
+	}
+}
+
 std::shared_ptr<Mesh> Mesh::Create
 (
 	const void* pVertices, uint32_t verticesCount, uint32_t vertexFormat,
@@ -51,6 +164,14 @@ std::shared_ptr<Mesh> Mesh::Create
 	return nullptr;
 }
 
+std::shared_ptr<Mesh> Mesh::CreateSkinningTarget(const std::shared_ptr<Mesh>& pSkinnedMesh)
+{
+	std::shared_ptr<Mesh> pRetMesh = std::make_shared<Mesh>();
+	if (pRetMesh.get() && pRetMesh->InitSkinningTarget(pRetMesh, pSkinnedMesh))
+		return pRetMesh;
+	return nullptr;
+}
+
 std::shared_ptr<Mesh> Mesh::Create(const std::string& filePath, uint32_t meshIndex, uint32_t argumentedVertexFormat)
 {
 	Assimp::Importer imp;
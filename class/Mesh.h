@@ -1,6 +1,8 @@
 #pragma once
 #include "../Base/BaseComponent.h"
+#include "../Maths/Vector.h"
 #include "../Maths/Matrix.h"
+#include "../Maths/BoundingBox.h"
 #include "../vulkan/DeviceObjectBase.h"
 #include <string>
 #include "../common/Enums.h"
@@ -13,6 +15,9 @@ class CommandBuffer;
 class Mesh : public SelfRefBase<Mesh>
 {
 public:
+	// Budget of occluder geometry built from mesh data
+	static const uint32_t MAX_OCCLUDER_TRIANGLE_COUNT = 256;
+
 	static std::shared_ptr<Mesh> Create(const aiMesh* pMesh, uint32_t argumentedVertexFormat = 0);
 	static std::shared_ptr<Mesh> Create(const std::string& filePath, uint32_t meshIndex, uint32_t argumentedVertexFormat = 0);
 	static std::vector<std::shared_ptr<Mesh>> CreateMeshes(const std::string& filePath, uint32_t argumentedVertexFormat = 0);
@@ -21,6 +26,9 @@ public:
 		const void* pVertices, uint32_t verticesCount, uint32_t vertexFormat,
 		const void* pIndices, uint32_t indicesCount, VkIndexType indexType
 	);
+	// Mesh of PNTCT format with vertices uninitialized, skinned vertices of "pSkinnedMesh" are written into it every frame by compute skinning
+	// Indices and per mesh chunk are shared with "pSkinnedMesh"
+	static std::shared_ptr<Mesh> CreateSkinningTarget(const std::shared_ptr<Mesh>& pSkinnedMesh);
 
 public:
 	std::shared_ptr<SharedVertexBuffer> GetVertexBuffer() const { return m_pVertexBuffer; }
@@ -32,6 +40,17 @@ public:
 	uint32_t GetMeshBoneChunkIndexOffset() const { return m_meshBoneChunkIndexOffset; }
 	uint32_t ContainBoneData() const { return m_meshChunkIndex != -1; }
 	uint32_t GetBoneCount() const { return m_boneCount; }
+	// Object space bounds of vertex positions, invalid if vertex format doesn't contain position
+	const BoundingBoxd& GetBounds() const { return m_bounds; }
+	// Object space triangles rasterized by software occlusion culling, if renderers of this mesh are occluders
+	// By default it's the largest triangles of mesh, a subset of real surfaces never occludes anything mesh itself doesn't
+	// A hand made simplified hull could be assigned instead, as long as it stays inside the mesh
+	void SetOccluderGeometry(const std::vector<Vector3f>& positions, const std::vector<uint32_t>& indices);
+	// Default occluder geometry is built when a renderer of this mesh is tagged as occluder
+	// Positions and indices to build it from are only kept while software occlusion culling is enabled, and dropped once it's built
+	void PrepareOccluderGeometry();
+	const std::vector<Vector3f>& GetOccluderPositions() const { return m_occluderPositions; }
+	const std::vector<uint32_t>& GetOccluderIndices() const { return m_occluderIndices; }
 	void PrepareIndirectCmd(VkDrawIndexedIndirectCommand& cmd);
 
 protected:
@@ -41,6 +60,8 @@ protected:
 		const void* pVertices, uint32_t verticesCount, uint32_t vertexFormat,
 		const void* pIndices, uint32_t indicesCount, VkIndexType indexType
 	);
+	bool InitSkinningTarget(const std::shared_ptr<Mesh>& pSelf, const std::shared_ptr<Mesh>& pSkinnedMesh);
+	void BuildOccluderGeometry();
 
 protected:
 	std::shared_ptr<SharedVertexBuffer>	m_pVertexBuffer;
@@ -50,5 +71,10 @@ protected:
 	uint32_t							m_indicesCount;
 	uint32_t							m_meshChunkIndex = -1;
 	uint32_t							m_meshBoneChunkIndexOffset;
-	uint32_t							m_boneCount;
+	uint32_t							m_boneCount = 0;
+	BoundingBoxd						m_bounds;
+	std::vector<Vector3f>				m_occluderPositions;
+	std::vector<uint32_t>				m_occluderIndices;
+	std::vector<Vector3f>				m_occluderSourcePositions;
+	std::vector<uint32_t>				m_occluderSourceIndices;
 };
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "OcclusionCullingMaterial.h"
+#include "../vulkan/DescriptorSet.h"
+#include "../vulkan/SwapChain.h"
+#include "../vulkan/GlobalDeviceObjects.h"
+#include "../vulkan/Image.h"
+#include "../vulkan/Sampler.h"
+#include "../vulkan/ImageView.h"
+#include "../vulkan/CommandBuffer.h"
+#include "../vulkan/ShaderStorageBuffer.h"
+#include "../vulkan/SharedIndirectBuffer.h"
+#include "PerMaterialIndirectUniforms.h"
+#include "GlobalTextures.h"
+#include "UniformData.h"
+#include "FrameWorkManager.h"
+
+std::shared_ptr<OcclusionCullingMaterial> OcclusionCullingMaterial::CreateMaterial
+(
+	CullingPhase cullingPhase,
+	const std::shared_ptr<PerMaterialCullingUniforms>& pCullingUniforms,
+	const std::shared_ptr<SharedIndirectBuffer>& pCulledIndirectBuffer,
+	const std::shared_ptr<SharedIndirectBuffer>& pCulledIndirectCmdCountBuffer,
+	const std::shared_ptr<ShaderStorageBuffer>& pCandidateBuffer
+)
+{
+	std::shared_ptr<OcclusionCullingMaterial> pMaterial = std::make_shared<OcclusionCullingMaterial>();
+	if (pMaterial.get() && pMaterial->Init(pMaterial, cullingPhase, pCullingUniforms, pCulledIndirectBuffer, pCulledIndirectCmdCountBuffer, pCandidateBuffer))
+		return pMaterial;
+	return nullptr;
+}
+
+bool OcclusionCullingMaterial::Init
+(
+	const std::shared_ptr<OcclusionCullingMaterial>& pSelf,
+	CullingPhase cullingPhase,
+	const std::shared_ptr<PerMaterialCullingUniforms>& pCullingUniforms,
+	const std::shared_ptr<SharedIndirectBuffer>& pCulledIndirectBuffer,
+	const std::shared_ptr<SharedIndirectBuffer>& pCulledIndirectCmdCountBuffer,
+	const std::shared_ptr<ShaderStorageBuffer>& pCandidateBuffer
+)
+{
+	// Layout customization below depends on these
+	m_cullingPhase = cullingPhase;
+	m_pCullingUniforms = pCullingUniforms;
+	m_pCulledIndirectBuffer = pCulledIndirectBuffer;
+	m_pCulledIndirectCmdCountBuffer = pCulledIndirectCmdCountBuffer;
+	m_pCandidateBuffer = pCandidateBuffer;
+
+	VkComputePipelineCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+
+	std::vector<VkPushConstantRange> pushConstants =
+	{
+		{
+			VK_SHADER_STAGE_COMPUTE_BIT,
+			0,
+			sizeof(uint32_t)
+		}
+	};
+
+	if (!Material::Init(pSelf, L"../data/shaders/occlusion_culling.comp.spv", createInfo, pushConstants, {}, { MAX_INSTANCE_COUNT / GROUP_SIZE, 1, 1 }))
+		return false;
+
+	uint32_t bindingIndex = m_pCullingUniforms->SetupDescriptorSet(m_pUniformStorageDescriptorSet, 0);
+	m_pUniformStorageDescriptorSet->UpdateShaderStorageBuffer(bindingIndex++, m_pCulledIndirectBuffer);
+	m_pUniformStorageDescriptorSet->UpdateShaderStorageBuffer(bindingIndex++, m_pCulledIndirectCmdCountBuffer);
+	m_pUniformStorageDescriptorSet->UpdateShaderStorageBuffer(bindingIndex++, m_pCandidateBuffer);
+
+	std::vector<CombinedImage> HiZTextures;
+	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
+	{
+		std::shared_ptr<Image> pHiZ = UniformData::GetInstance()->GetGlobalTextures()->GetHiZTexture(i);
+		HiZTextures.push_back({ pHiZ, pHiZ->CreateNearestRepeatSampler(), pHiZ->CreateDefaultImageView() });
+	}
+	m_pUniformStorageDescriptorSet->UpdateImages(bindingIndex++, HiZTextures);
+
+	// Compute materials only have offsets of global uniforms, culling data is dynamic too
+	for (uint32_t frameIndex = 0; frameIndex < GetSwapChain()->GetSwapChainImageCount(); frameIndex++)
+		m_cachedFrameOffsets[frameIndex].push_back(m_pCullingUniforms->GetFrameOffset() * frameIndex);
+
+	return true;
+}
+
+void OcclusionCullingMaterial::CustomizeMaterialLayout(std::vector<UniformVarList>& materialLayout)
+{
+	materialLayout.push_back(m_pCullingUniforms->PrepareUniformVarList()[0]);
+	materialLayout.push_back({ StorageBuffer, "CulledDrawCommands", {} });
+	materialLayout.push_back({ StorageBuffer, "CulledDrawCounts", {} });
+	materialLayout.push_back({ StorageBuffer, "CullingCandidates", {} });
+	materialLayout.push_back({ CombinedSampler, "HiZ", {}, GetSwapChain()->GetSwapChainImageCount() });
+}
+
+void OcclusionCullingMaterial::CustomizePoolSize(std::vector<uint32_t>& counts)
+{
+	counts[VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER] += GetSwapChain()->GetSwapChainImageCount();
+}
+
+void OcclusionCullingMaterial::CustomizeCommandBuffer(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong)
+{
+	uint32_t cullingPhase = m_cullingPhase;
+	pCmdBuf->PushConstants(m_pPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &cullingPhase);
+}
+
+void OcclusionCullingMaterial::ClaimResourceUsage(const std::shared_ptr<CommandBuffer>& pCmdBuffer, const std::shared_ptr<ResourceBarrierScheduler>& pScheduler, uint32_t pingpong)
+{
+	if (pScheduler == nullptr)
+		return;
+
+	// Early phase reads pyramid of previous frame, late phase reads the one just built
+	uint32_t frameCount = GetSwapChain()->GetSwapChainImageCount();
+	uint32_t HiZIndex = FrameWorkManager::GetInstance()->FrameIndex();
+	if (m_cullingPhase == EarlyPhase)
+		HiZIndex = (HiZIndex + frameCount - 1) % frameCount;
+
+	pScheduler->ClaimResourceUsage
+	(
+		pCmdBuffer,
+		UniformData::GetInstance()->GetGlobalTextures()->GetHiZTexture(HiZIndex),
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_IMAGE_LAYOUT_GENERAL,
+		VK_ACCESS_SHADER_READ_BIT
+	);
+
+	std::vector<std::shared_ptr<VKGPUSyncRes>> buffers = { m_pCulledIndirectBuffer, m_pCulledIndirectCmdCountBuffer, m_pCandidateBuffer };
+	for (auto& pBuffer : buffers)
+	{
+		pScheduler->ClaimResourceUsage
+		(
+			pCmdBuffer,
+			pBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+		);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+#include "Material.h"
+
+class PerMaterialCullingUniforms;
+
+// Two phase occlusion culling of indirectly drawn instances of a material, a thread per instance
+// Early phase: instances are tested against Hi-Z of previous frame, with previous frame's transforms
+// Survivors are drawn to gbuffer, the rest are recorded as candidates
+// Late phase: Hi-Z is rebuilt from depth of early draws, and candidates are tested against it with current transforms
+// Survivors of late phase are drawn on top, so that instances that get disoccluded this frame won't pop in a frame late
+// Each survivor gets a draw command of its own(instanceCount 1, firstInstance its indirect index), with draw count counted atomically
+class OcclusionCullingMaterial : public Material
+{
+public:
+	enum CullingPhase
+	{
+		EarlyPhase,
+		LatePhase,
+		CullingPhaseCount
+	};
+
+	static const uint32_t MAX_INSTANCE_COUNT = 256;
+	static const uint32_t GROUP_SIZE = 64;
+
+public:
+	static std::shared_ptr<OcclusionCullingMaterial> CreateMaterial
+	(
+		CullingPhase cullingPhase,
+		const std::shared_ptr<PerMaterialCullingUniforms>& pCullingUniforms,
+		const std::shared_ptr<SharedIndirectBuffer>& pCulledIndirectBuffer,
+		const std::shared_ptr<SharedIndirectBuffer>& pCulledIndirectCmdCountBuffer,
+		const std::shared_ptr<ShaderStorageBuffer>& pCandidateBuffer
+	);
+
+	// Byte offsets of culled draw commands and count of a phase within the buffers shared by all frames
+	static uint32_t GetCulledIndirectOffset(uint32_t frameIndex, uint32_t cullingPhase) { return (frameIndex * CullingPhaseCount + cullingPhase) * MAX_INSTANCE_COUNT * sizeof(VkDrawIndexedIndirectCommand); }
+	static uint32_t GetCulledCountOffset(uint32_t frameIndex, uint32_t cullingPhase) { return (frameIndex * CullingPhaseCount + cullingPhase) * sizeof(uint32_t); }
+
+public:
+	void Draw(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false) override {}
+
+protected:
+	bool Init
+	(
+		const std::shared_ptr<OcclusionCullingMaterial>& pSelf,
+		CullingPhase cullingPhase,
+		const std::shared_ptr<PerMaterialCullingUniforms>& pCullingUniforms,
+		const std::shared_ptr<SharedIndirectBuffer>& pCulledIndirectBuffer,
+		const std::shared_ptr<SharedIndirectBuffer>& pCulledIndirectCmdCountBuffer,
+		const std::shared_ptr<ShaderStorageBuffer>& pCandidateBuffer
+	);
+
+	void CustomizeMaterialLayout(std::vector<UniformVarList>& materialLayout) override;
+	void CustomizePoolSize(std::vector<uint32_t>& counts) override;
+	void CustomizeCommandBuffer(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0) override;
+	void ClaimResourceUsage(const std::shared_ptr<CommandBuffer>& pCmdBuffer, const std::shared_ptr<ResourceBarrierScheduler>& pScheduler, uint32_t pingpong = 0) override;
+
+protected:
+	CullingPhase								m_cullingPhase;
+	std::shared_ptr<PerMaterialCullingUniforms>	m_pCullingUniforms;
+	std::shared_ptr<SharedIndirectBuffer>		m_pCulledIndirectBuffer;
+	std::shared_ptr<SharedIndirectBuffer>		m_pCulledIndirectCmdCountBuffer;
+	std::shared_ptr<ShaderStorageBuffer>		m_pCandidateBuffer;
+};
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "PerFrameLightUniforms.h"
+#include "../vulkan/DescriptorSet.h"
+#include "../vulkan/ShaderStorageBuffer.h"
+#include "UniformData.h"
+#include "Material.h"
+#include <algorithm>
+#include <cstring>
+
+const double PerFrameLightUniforms::CLUSTER_NEAR_DISTANCE = 0.1;
+const double PerFrameLightUniforms::CLUSTER_FAR_DISTANCE = 200.0;
+
+bool PerFrameLightUniforms::Init(const std::shared_ptr<PerFrameLightUniforms>& pSelf)
+{
+	if (!UniformDataStorage::Init(pSelf, sizeof(LightClusterVariables), PerFrameDataStorage::ShaderStorage))
+		return false;
+
+	m_localLights.reserve(MAX_LOCAL_LIGHT_COUNT);
+	m_lightSpheres.reserve(MAX_LOCAL_LIGHT_COUNT);
+
+	// Empty clusters have to be in buffer before first light shows up
+	memset(&m_lightClusterVariables, 0, sizeof(LightClusterVariables));
+	SetDirty();
+	return true;
+}
+
+std::shared_ptr<PerFrameLightUniforms> PerFrameLightUniforms::Create()
+{
+	std::shared_ptr<PerFrameLightUniforms> pPerFrameLightUniforms = std::make_shared<PerFrameLightUniforms>();
+	if (pPerFrameLightUniforms.get() && pPerFrameLightUniforms->Init(pPerFrameLightUniforms))
+		return pPerFrameLightUniforms;
+	return nullptr;
+}
+
+void PerFrameLightUniforms::AddLocalLight(const Vector3d& wsPosition, double radius, const Vector3d& color, const Vector3d& wsSpotDirection, double spotScale, double spotOffset)
+{
+	if (m_localLights.size() >= MAX_LOCAL_LIGHT_COUNT)
+		return;
+
+	m_localLights.push_back({ wsPosition, radius, color, wsSpotDirection, spotScale, spotOffset });
+}
+
+void PerFrameLightUniforms::BuildClusters()
+{
+	// Clusters follow camera, so they're rebuilt every frame, unless there's nothing to clear either
+	if (m_localLights.empty() && m_lastLightCount == 0)
+		return;
+
+	std::shared_ptr<PerFrameUniforms> pPerFrameUniforms = UniformData::GetInstance()->GetPerFrameUniforms();
+	Matrix4d view = pPerFrameUniforms->GetViewMatrix();
+
+	// Same frustum as the one deferred shading reconstructs view rays with
+	double nearPlane = pPerFrameUniforms->GetNearFarAB().x;
+	double farPlane = pPerFrameUniforms->GetNearFarAB().y;
+	Vector2d tangents = pPerFrameUniforms->GetEyeSpaceSize() * (0.5 / nearPlane);
+	double clusterNear = (std::max)(CLUSTER_NEAR_DISTANCE, nearPlane);
+	double clusterFar = (std::max)((std::min)(CLUSTER_FAR_DISTANCE, farPlane), clusterNear * 2.0);
+	m_clusterGrid.SetFrustum((float)tangents.x, (float)tangents.y, (float)clusterNear, (float)clusterFar);
+
+	m_lightSpheres.clear();
+	for (uint32_t i = 0; i < (uint32_t)m_localLights.size(); i++)
+	{
+		const LocalLight& light = m_localLights[i];
+		Vector3f csPosition = view.TransformAsPoint(light.wsPosition).SinglePrecision();
+		Vector3f csSpotDirection = view.TransformAsVector(light.wsSpotDirection).SinglePrecision();
+
+		m_lightClusterVariables.localLights[i].csPositionRadius = Vector4f(csPosition, (float)light.radius);
+		m_lightClusterVariables.localLights[i].colorSpotScale = Vector4f(light.color.SinglePrecision(), (float)light.spotScale);
+		m_lightClusterVariables.localLights[i].csSpotDirectionOffset = Vector4f(csSpotDirection, (float)light.spotOffset);
+
+		m_lightSpheres.push_back(m_lightClusterVariables.localLights[i].csPositionRadius);
+	}
+
+	m_clusterGrid.Build(m_lightSpheres, MAX_LIGHT_INDEX_COUNT);
+
+	std::copy(m_clusterGrid.GetClusters().begin(), m_clusterGrid.GetClusters().end(), m_lightClusterVariables.clusters);
+	std::copy(m_clusterGrid.GetLightIndices().begin(), m_clusterGrid.GetLightIndices().end(), m_lightClusterVariables.lightIndices);
+	m_lightClusterVariables.clusterParams = { m_clusterGrid.GetClusterNear(), m_clusterGrid.GetSliceScale(), (float)m_localLights.size(), 0 };
+
+	m_lastLightCount = (uint32_t)m_localLights.size();
+	m_localLights.clear();
+
+	SetDirty();
+}
+
+std::vector<UniformVarList> PerFrameLightUniforms::PrepareUniformVarList() const
+{
+	return
+	{
+		{
+			DynamicShaderStorageBuffer,
+			"PerFrameLightUniforms",
+			{
+				{ Vec4Unit, "Cluster near, slice scale, light count" },
+				{ Vec4Unit, "Local light data", MAX_LOCAL_LIGHT_COUNT * 3 },
+				{ Vec2Unit, "Cluster offset and count", LightClusterGrid::CLUSTER_COUNT },
+				{ OneUnit, "Light indices", MAX_LIGHT_INDEX_COUNT },
+			}
+		}
+	};
+}
+
+uint32_t PerFrameLightUniforms::SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const
+{
+	pDescriptorSet->UpdateShaderStorageBufferDynamic(bindingIndex++, std::dynamic_pointer_cast<ShaderStorageBuffer>(GetBuffer()));
+
+	return bindingIndex;
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "../Maths/Matrix.h"
+#include "../Maths/LightClusterGrid.h"
+#include "UniformDataStorage.h"
+
+class DescriptorSet;
+
+typedef struct _LocalLightData
+{
+	Vector4f	csPositionRadius;		// xyz: camera space position, w: distance where light fades out
+	Vector4f	colorSpotScale;			// rgb: light color, a: scale of spot cone attenuation
+	Vector4f	csSpotDirectionOffset;	// xyz: camera space direction spot light shines towards, w: offset of spot cone attenuation
+}LocalLightData;
+
+// Spot cone attenuation is "clamp(dot(spot direction, -light vector) * scale + offset, 0, 1)", point lights have 0 scale and 1 offset
+typedef struct _LightClusterVariables
+{
+	Vector4f						clusterParams;	// x: cluster near distance, y: slice scale, z: light count, w: unused
+	LocalLightData					localLights[256];
+	LightClusterGrid::ClusterRange	clusters[LightClusterGrid::CLUSTER_COUNT];
+	uint32_t						lightIndices[1024 * 16];
+}LightClusterVariables;
+
+// Local lights of current frame and their clusters
+// Lights are collected in world space during scene traversal, then transformed into camera space and assigned to clusters at once
+class PerFrameLightUniforms : public UniformDataStorage
+{
+public:
+	static const uint32_t MAX_LOCAL_LIGHT_COUNT = sizeof(LightClusterVariables::localLights) / sizeof(LocalLightData);
+	static const uint32_t MAX_LIGHT_INDEX_COUNT = sizeof(LightClusterVariables::lightIndices) / sizeof(uint32_t);
+	// Camera space depth range that slices cover
+	static const double CLUSTER_NEAR_DISTANCE;
+	static const double CLUSTER_FAR_DISTANCE;
+
+protected:
+	bool Init(const std::shared_ptr<PerFrameLightUniforms>& pSelf);
+
+public:
+	static std::shared_ptr<PerFrameLightUniforms> Create();
+
+public:
+	// Lights more than "MAX_LOCAL_LIGHT_COUNT" in a frame are ignored
+	void AddLocalLight(const Vector3d& wsPosition, double radius, const Vector3d& color, const Vector3d& wsSpotDirection, double spotScale, double spotOffset);
+	uint32_t GetLocalLightCount() const { return (uint32_t)m_localLights.size(); }
+	// Called once all lights are added, light list is cleared for next frame
+	void BuildClusters();
+	const LightClusterGrid& GetClusterGrid() const { return m_clusterGrid; }
+
+	std::vector<UniformVarList> PrepareUniformVarList() const override;
+	uint32_t SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const override;
+
+protected:
+	void UpdateUniformDataInternal() override {}
+	void SetDirtyInternal() override {}
+	const void* AcquireDataPtr() const override { return &m_lightClusterVariables; }
+	uint32_t AcquireDataSize() const override { return sizeof(LightClusterVariables); }
+
+protected:
+	typedef struct _LocalLight
+	{
+		Vector3d	wsPosition;
+		double		radius;
+		Vector3d	color;
+		Vector3d	wsSpotDirection;
+		double		spotScale;
+		double		spotOffset;
+	}LocalLight;
+
+	std::vector<LocalLight>		m_localLights;
+	std::vector<Vector4f>		m_lightSpheres;
+	LightClusterGrid			m_clusterGrid;
+	LightClusterVariables		m_lightClusterVariables;
+	uint32_t					m_lastLightCount = 0;
+};
\ No newline at end of file
@@ -12,6 +12,9 @@ bool PerFrameUniforms::Init(const std::shared_ptr<PerFrameUniforms>& pSelf)
 {
 	if (!UniformDataStorage::Init(pSelf, sizeof(m_singlePrecisionPerFrameVariables), PerFrameDataStorage::Uniform))
 		return false;
+
+	// Nothing to blend from until env textures get regenerated
+	SetEnvBlendFactor(1.0);
 	return true;
 }
 
@@ -37,12 +40,37 @@ void PerFrameUniforms::SetViewCoordinateSystem(const Matrix4d& viewCoordinateSys
 	SetDirty();
 }
 
-void PerFrameUniforms::SetMainLightVP(const Matrix4d& vp)
+void PerFrameUniforms::SetMainLightVP(uint32_t cascadeIndex, const Matrix4d& vp)
 {
-	m_perFrameVariables.mainLightVP = vp;
+	ASSERTION(cascadeIndex < SHADOW_CASCADE_COUNT);
+	m_perFrameVariables.mainLightVP[cascadeIndex] = vp;
 	SetDirty();
 }
 
+void PerFrameUniforms::SetShadowCascadeSplits(const Vector4d& splits)
+{
+	m_perFrameVariables.shadowCascadeSplits = splits;
+	SetDirty();
+}
+
+void PerFrameUniforms::SetShadowCacheDirtyMask(uint32_t mask)
+{
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+		m_perFrameVariables.shadowCacheDirty[i] = (mask & (1 << i)) ? 1.0 : 0.0;
+	SetDirty();
+}
+
+uint32_t PerFrameUniforms::GetShadowCacheDirtyMask() const
+{
+	uint32_t mask = 0;
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		if (m_perFrameVariables.shadowCacheDirty[i] != 0)
+			mask |= (1 << i);
+	}
+	return mask;
+}
+
 void PerFrameUniforms::SetCameraPosition(const Vector3d& camPos)
 {
 	m_perFrameVariables.cameraDeltaPosition = camPos - m_perFrameVariables.cameraPosition.xyz();
@@ -146,9 +174,9 @@ void PerFrameUniforms::SetEnvPingpongIndex(double val)
 	SetDirty();
 }
 
-void PerFrameUniforms::SetPadding1(double val)
+void PerFrameUniforms::SetEnvBlendFactor(double val)
 {
-	m_perFrameVariables.padding1 = val;
+	m_perFrameVariables.envBlendFactor = val;
 	SetDirty();
 }
 
@@ -158,7 +186,8 @@ void PerFrameUniforms::UpdateUniformDataInternal()
 	CONVERT2SINGLE(m_perFrameVariables, m_singlePrecisionPerFrameVariables, viewMatrix);
 	CONVERT2SINGLE(m_perFrameVariables, m_singlePrecisionPerFrameVariables, viewCoordSystem);
 	CONVERT2SINGLE(m_perFrameVariables, m_singlePrecisionPerFrameVariables, prevView);
-	CONVERT2SINGLE(m_perFrameVariables, m_singlePrecisionPerFrameVariables, mainLightVP);
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+		CONVERT2SINGLE(m_perFrameVariables, m_singlePrecisionPerFrameVariables, mainLightVP[i]);
 	CONVERT2SINGLE(m_perFrameVariables, m_singlePrecisionPerFrameVariables, cameraPosition);
 	CONVERT2SINGLE(m_perFrameVariables, m_singlePrecisionPerFrameVariables, cameraDeltaPosition);
 	CONVERT2SINGLE(m_perFrameVariables, m_singlePrecisionPerFrameVariables, cameraDirection);
@@ -167,6 +196,8 @@ void PerFrameUniforms::UpdateUniformDataInternal()
 	CONVERT2SINGLE(m_perFrameVariables, m_singlePrecisionPerFrameVariables, wsMainLightDir);
 	CONVERT2SINGLE(m_perFrameVariables, m_singlePrecisionPerFrameVariables, mainLightDir);
 	CONVERT2SINGLE(m_perFrameVariables, m_singlePrecisionPerFrameVariables, mainLightColor);
+	CONVERT2SINGLE(m_perFrameVariables, m_singlePrecisionPerFrameVariables, shadowCascadeSplits);
+	CONVERT2SINGLE(m_perFrameVariables, m_singlePrecisionPerFrameVariables, shadowCacheDirty);
 	CONVERT2SINGLE(m_perFrameVariables, m_singlePrecisionPerFrameVariables, cameraJitterOffset);
 	CONVERT2SINGLE(m_perFrameVariables, m_singlePrecisionPerFrameVariables, time);
 	CONVERT2SINGLE(m_perFrameVariables, m_singlePrecisionPerFrameVariables, haltonX8Jitter);
@@ -176,7 +207,7 @@ void PerFrameUniforms::UpdateUniformDataInternal()
 	CONVERT2SINGLEVAL(m_perFrameVariables, m_singlePrecisionPerFrameVariables, frameIndex);
 	CONVERT2SINGLEVAL(m_perFrameVariables, m_singlePrecisionPerFrameVariables, pingpongIndex);
 	CONVERT2SINGLEVAL(m_perFrameVariables, m_singlePrecisionPerFrameVariables, envPingpongIndex);
-	CONVERT2SINGLEVAL(m_perFrameVariables, m_singlePrecisionPerFrameVariables, padding1);
+	CONVERT2SINGLEVAL(m_perFrameVariables, m_singlePrecisionPerFrameVariables, envBlendFactor);
 }
 
 void PerFrameUniforms::SetDirtyInternal()
@@ -194,7 +225,7 @@ std::vector<UniformVarList> PerFrameUniforms::PrepareUniformVarList() const
 				{ Mat4Unit, "ViewMatrix" },
 				{ Mat4Unit, "ViewCoordSystem" },
 				{ Mat4Unit, "prevViewMatrix" },
-				{ Mat4Unit, "MainLightVP" },
+				{ Mat4Unit, "MainLightVP", SHADOW_CASCADE_COUNT },
 				{ Vec4Unit, "CameraPosition_Padding" },
 				{ Vec4Unit, "CameraDeltaPosition_Padding" },
 				{ Vec4Unit, "CameraDirection_FrameIndex" },
@@ -202,6 +233,8 @@ std::vector<UniformVarList> PerFrameUniforms::PrepareUniformVarList() const
 				{ Vec4Unit, "NearFarAB" },
 				{ Vec4Unit, "MainLightDir" },
 				{ Vec4Unit, "MainLightColor" },
+				{ Vec4Unit, "ShadowCascadeSplits" },
+				{ Vec4Unit, "ShadowCacheDirty" },
 				{ Vec2Unit, "CameraJitterOffset" },
 				{ Vec2Unit, "Time, x:time, y:sin(time)" },
 				{ Vec2Unit, "HaltonX8 Jitter" },
@@ -210,8 +243,8 @@ std::vector<UniformVarList> PerFrameUniforms::PrepareUniformVarList() const
 				{ Vec2Unit, "HaltonX256 Jitter" },
 				{ OneUnit, "Frame Index" },
 				{ OneUnit, "Pingpong Index" },
-				{ OneUnit, "Reserved padding0" },
-				{ OneUnit, "Reserved padding1" },
+				{ OneUnit, "Env Pingpong Index" },
+				{ OneUnit, "Env Blend Factor" },
 			}
 		}
 	};
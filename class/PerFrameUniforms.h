@@ -7,6 +7,8 @@
 
 class DescriptorSet;
 
+const static uint32_t SHADOW_CASCADE_COUNT = 4;
+
 template <typename T>
 class PerFrameVariables
 {
@@ -14,7 +16,7 @@ public:
 	Matrix4x4<T>	viewMatrix;
 	Matrix4x4<T>	viewCoordSystem;
 	Matrix4x4<T>	prevView;
-	Matrix4x4<T>	mainLightVP;
+	Matrix4x4<T>	mainLightVP[SHADOW_CASCADE_COUNT];	// From camera space to light ndc of each shadow cascade
 	Vector4<T>		cameraPosition;
 	Vector4<T>		cameraDeltaPosition;	// Camera position delta between 2 consecutive frames
 	Vector4<T>		cameraDirection;
@@ -23,6 +25,8 @@ public:
 	Vector4<T>		wsMainLightDir;
 	Vector4<T>		mainLightDir;
 	Vector4<T>		mainLightColor;
+	Vector4<T>		shadowCascadeSplits;	// Camera space far distance of each shadow cascade
+	Vector4<T>		shadowCacheDirty;		// 1 if static shadow cache of a cascade is re-rendered this frame, 0 if it's kept
 	Vector2<T>		cameraJitterOffset;
 	Vector2<T>		time;					//x: delta time, y: SineTime
 
@@ -34,7 +38,7 @@ public:
 	T				frameIndex;
 	T				pingpongIndex;
 	T				envPingpongIndex;
-	T				padding1;
+	T				envBlendFactor;			// Weight of env textures at envPingpongIndex, the other slot takes the rest
 };
 
 typedef PerFrameVariables<float> PerFrameVariablesf;
@@ -53,8 +57,13 @@ public:
 	Matrix4d GetViewMatrix() const { return m_perFrameVariables.viewMatrix; }
 	void SetViewCoordinateSystem(const Matrix4d& viewCoordinateSystem);	// Maybe I should add this to reduce an extra matrix inverse
 	Matrix4d GetViewCoordinateSystem() const { return m_perFrameVariables.viewCoordSystem; }
-	void SetMainLightVP(const Matrix4d& vp);
-	Matrix4d GetmainLightVP() const { return m_perFrameVariables.mainLightVP; }
+	void SetMainLightVP(uint32_t cascadeIndex, const Matrix4d& vp);
+	Matrix4d GetmainLightVP(uint32_t cascadeIndex) const { return m_perFrameVariables.mainLightVP[cascadeIndex]; }
+	void SetShadowCascadeSplits(const Vector4d& splits);
+	Vector4d GetShadowCascadeSplits() const { return m_perFrameVariables.shadowCascadeSplits; }
+	// Bit i is set if static shadow cache of cascade i is re-rendered this frame
+	void SetShadowCacheDirtyMask(uint32_t mask);
+	uint32_t GetShadowCacheDirtyMask() const;
 	void SetCameraPosition(const Vector3d& camPos);
 	Vector3d GetCameraPosition() const { return m_perFrameVariables.cameraPosition.xyz(); }
 	void SetCameraDirection(const Vector3d& camDir);
@@ -86,8 +95,8 @@ public:
 	double GetPingpongIndex() const { return m_perFrameVariables.pingpongIndex; }
 	void SetEnvPingpongIndex(double val);
 	double GetEnvPingpongIndex() const { return m_perFrameVariables.envPingpongIndex; }
-	void SetPadding1(double val);
-	double GetPadding1() const { return m_perFrameVariables.padding1; }
+	void SetEnvBlendFactor(double val);
+	double GetEnvBlendFactor() const { return m_perFrameVariables.envBlendFactor; }
 
 	std::vector<UniformVarList> PrepareUniformVarList() const override;
 	uint32_t SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const override;
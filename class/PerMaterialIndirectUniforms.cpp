@@ -91,5 +91,47 @@ uint32_t PerMaterialIndirectUniforms::SetupDescriptorSet(const std::shared_ptr<D
 	return bindingIndex;
 }
 
+bool PerMaterialCullingUniforms::Init(const std::shared_ptr<PerMaterialCullingUniforms>& pSelf)
+{
+	if (!UniformDataStorage::Init(pSelf, sizeof(m_perInstanceCullingData), PerFrameDataStorage::ShaderStorage))
+		return false;
+	return true;
+}
+
+std::shared_ptr<PerMaterialCullingUniforms> PerMaterialCullingUniforms::Create()
+{
+	std::shared_ptr<PerMaterialCullingUniforms> pPerMaterialCullingUniforms = std::make_shared<PerMaterialCullingUniforms>();
+	if (pPerMaterialCullingUniforms.get() && pPerMaterialCullingUniforms->Init(pPerMaterialCullingUniforms))
+		return pPerMaterialCullingUniforms;
+	return nullptr;
+}
+
+void PerMaterialCullingUniforms::UpdateDirtyChunkInternal(uint32_t index)
+{
+}
+
+std::vector<UniformVarList> PerMaterialCullingUniforms::PrepareUniformVarList() const
+{
+	return
+	{
+		{
+			DynamicShaderStorageBuffer,
+			"PerMaterialCullingData",
+			{
+				{ OneUnit, "Index count" },
+				{ OneUnit, "First index" },
+				{ OneUnit, "Vertex offset" },
+				{ OneUnit, "Per-object chunk index" },
+				{ Vec4Unit, "Object space bounds min" },
+				{ Vec4Unit, "Object space bounds max" },
+			}
+		}
+	};
+}
 
+uint32_t PerMaterialCullingUniforms::SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const
+{
+	pDescriptorSet->UpdateShaderStorageBufferDynamic(bindingIndex++, std::dynamic_pointer_cast<ShaderStorageBuffer>(GetBuffer()));
 
+	return bindingIndex;
+}
\ No newline at end of file
@@ -23,6 +23,18 @@ typedef struct _PerMaterialIndirectVariables
 	uint32_t utilityIndex = 0;
 }PerMaterialIndirectVariables;
 
+// Geometry and object space bounds of an instance, indexed the same as "PerMaterialIndirectVariables"
+// Gpu culling builds a draw command of an instance from it, if the instance survives
+typedef struct _PerInstanceCullingData
+{
+	uint32_t indexCount = 0;	// 0 means this slot isn't used in current frame
+	uint32_t firstIndex = 0;
+	int32_t vertexOffset = 0;
+	uint32_t perObjectIndex = 0;
+	Vector4f boundsMin;			// w: 1 if bounds are valid, or instance is never culled
+	Vector4f boundsMax;
+}PerInstanceCullingData;
+
 class PerMaterialIndirectOffsetUniforms : public ChunkBasedUniforms
 {
 public:
@@ -72,4 +84,27 @@ protected:
 
 protected:
 	PerMaterialIndirectVariables	m_perMaterialIndirectIndex[MAXIMUM_OBJECTS];
+};
+
+
+class PerMaterialCullingUniforms : public ChunkBasedUniforms
+{
+public:
+	bool Init(const std::shared_ptr<PerMaterialCullingUniforms>& pSelf);
+	static std::shared_ptr<PerMaterialCullingUniforms> Create();
+
+public:
+	void SetCullingData(uint32_t indirectIndex, const PerInstanceCullingData& data) { m_perInstanceCullingData[indirectIndex] = data; SetChunkDirty(indirectIndex); }
+	const PerInstanceCullingData& GetCullingData(uint32_t indirectIndex) const { return m_perInstanceCullingData[indirectIndex]; }
+
+	std::vector<UniformVarList> PrepareUniformVarList() const override;
+	uint32_t SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const override;
+
+protected:
+	void UpdateDirtyChunkInternal(uint32_t index) override;
+	const void* AcquireDataPtr() const override { return &m_perInstanceCullingData[0]; }
+	uint32_t AcquireDataSize() const override { return sizeof(m_perInstanceCullingData); }
+
+protected:
+	PerInstanceCullingData	m_perInstanceCullingData[MAXIMUM_OBJECTS];
 };
\ No newline at end of file
@@ -7,11 +7,16 @@
 #include "../vulkan/Queue.h"
 #include "../vulkan/CommandBuffer.h"
 #include "../vulkan/Image.h"
+#include "../vulkan/InitCommandBatcher.h"
 #include "ResourceBarrierScheduler.h"
 #include "GlobalTextures.h"
 #include "UniformData.h"
 #include "Material.h"
 #include "CustomizedComputeMaterial.h"
+#include "AtmosphereLUTCache.h"
+#include "AtmosphereReferenceBaker.h"
+#include <iostream>
+#include <glm/gtc/packing.hpp>
 
 bool PerPlanetUniforms::Init(const std::shared_ptr<PerPlanetUniforms>& pSelf)
 {
@@ -127,6 +132,19 @@ uint32_t PerPlanetUniforms::AllocatePlanetChunk()
 	// THIS IS NOT NORMAL FRAME RENDERING, I NEED TO DO IT HERE MANUALLY
 	UniformData::GetInstance()->SyncDataBuffer();
 
+	uint64_t parameterHash = AtmosphereLUTCache::HashParameters(m_singlePrecisionPerPlanetVariables[chunkIndex].AtmosphereParameters);
+
+	AtmosphereLUTs luts;
+	if (m_atmosphereLUTCacheEnabled && AtmosphereLUTCache::Load(parameterHash, luts))
+	{
+		UploadAtmosphereLUTs(chunkIndex, luts);
+
+		if (m_atmosphereLUTVerificationEnabled)
+			VerifyAtmosphereLUTs(chunkIndex, luts);
+
+		return chunkIndex;
+	}
+
 	std::vector<uint8_t> data;
 	data.push_back(*((uint8_t*)&chunkIndex + 0));
 	data.push_back(*((uint8_t*)&chunkIndex + 1));
@@ -135,6 +153,8 @@ uint32_t PerPlanetUniforms::AllocatePlanetChunk()
 
 	std::shared_ptr<ResourceBarrierScheduler> pScheduler = ResourceBarrierScheduler::Create();
 
+	UniformData::GetInstance()->GetGlobalTextures()->AcquireAtmosphereScratchImages();
+
 	// Precompute required data for atmosphere rendering
 	// 1. Transmittance
 	PreComputeAtmosphereData
@@ -165,7 +185,7 @@ uint32_t PerPlanetUniforms::AllocatePlanetChunk()
 		{
 			UniformData::GetInstance()->GetGlobalTextures()->GetDeltaRayleigh(),
 			UniformData::GetInstance()->GetGlobalTextures()->GetDeltaMie(),
-			UniformData::GetInstance()->GetGlobalTextures()->GetScatterTextureDiction(chunkIndex)
+			UniformData::GetInstance()->GetGlobalTextures()->GetScatterAccumulation(chunkIndex)
 		},
 		data,
 		chunkIndex
@@ -182,7 +202,7 @@ uint32_t PerPlanetUniforms::AllocatePlanetChunk()
 		},
 		{
 			UniformData::GetInstance()->GetGlobalTextures()->GetDeltaIrradiance(),
-			UniformData::GetInstance()->GetGlobalTextures()->GetIrradianceTextureDiction(chunkIndex)
+			UniformData::GetInstance()->GetGlobalTextures()->GetIrradianceAccumulation(chunkIndex)
 		},
 		data,
 		chunkIndex
@@ -190,7 +210,7 @@ uint32_t PerPlanetUniforms::AllocatePlanetChunk()
 
 	// 4. Multi scatter
 	// FIXME: Hard-code 2nd order multi scatter, for test
-	for (uint32_t scatterOrder = 2; scatterOrder <= 4; scatterOrder++)
+	for (uint32_t scatterOrder = 2; scatterOrder <= ATMOSPHERE_MAX_SCATTER_ORDER; scatterOrder++)
 	{
 		data.push_back(*((uint8_t*)&scatterOrder + 0));
 		data.push_back(*((uint8_t*)&scatterOrder + 1));
@@ -236,7 +256,7 @@ uint32_t PerPlanetUniforms::AllocatePlanetChunk()
 			},
 			{
 				UniformData::GetInstance()->GetGlobalTextures()->GetDeltaIrradiance(),
-				UniformData::GetInstance()->GetGlobalTextures()->GetIrradianceTextureDiction(chunkIndex)
+				UniformData::GetInstance()->GetGlobalTextures()->GetIrradianceAccumulation(chunkIndex)
 			},
 			data,
 			chunkIndex
@@ -259,7 +279,7 @@ uint32_t PerPlanetUniforms::AllocatePlanetChunk()
 			},
 			{
 				UniformData::GetInstance()->GetGlobalTextures()->GetDeltaMultiScatter(),
-				UniformData::GetInstance()->GetGlobalTextures()->GetScatterTextureDiction(chunkIndex)
+				UniformData::GetInstance()->GetGlobalTextures()->GetScatterAccumulation(chunkIndex)
 			},
 			data,
 			chunkIndex
@@ -268,9 +288,72 @@ uint32_t PerPlanetUniforms::AllocatePlanetChunk()
 		data.erase(data.begin() + 4, data.end());
 	}
 
+	UniformData::GetInstance()->GetGlobalTextures()->ResolveAtmosphereTables(chunkIndex, pScheduler);
+
+	// All passes above are batched, flush them before uniforms synced above are overwritten by next planet
+	InitCmdBatcher()->Flush();
+
+	// Read back before scratch images are gone, cache always holds full precision data
+	if (m_atmosphereLUTCacheEnabled || m_atmosphereLUTVerificationEnabled)
+	{
+		ReadbackAtmosphereLUTs(chunkIndex, luts);
+
+		if (m_atmosphereLUTCacheEnabled)
+			AtmosphereLUTCache::Save(parameterHash, luts);
+
+		if (m_atmosphereLUTVerificationEnabled)
+			VerifyAtmosphereLUTs(chunkIndex, luts);
+	}
+
+	// Scheduler keeps references of scratch images
+	pScheduler = nullptr;
+	UniformData::GetInstance()->GetGlobalTextures()->ReleaseAtmosphereScratchImages();
+
 	return chunkIndex;
 }
 
+static void UploadAtmosphereTable(const std::shared_ptr<Image>& pTable, const std::vector<float>& texels)
+{
+	if (pTable->GetImageInfo().format != VK_FORMAT_R16G16B16A16_SFLOAT)
+	{
+		pTable->UpdateByteStream(texels.data(), (uint32_t)(texels.size() * sizeof(float)));
+		return;
+	}
+
+	std::vector<uint16_t> halfTexels(texels.size());
+	for (std::size_t i = 0; i < texels.size(); i++)
+		halfTexels[i] = glm::packHalf1x16(texels[i]);
+
+	pTable->UpdateByteStream(halfTexels.data(), (uint32_t)(halfTexels.size() * sizeof(uint16_t)));
+}
+
+void PerPlanetUniforms::UploadAtmosphereLUTs(uint32_t chunkIndex, const AtmosphereLUTs& luts)
+{
+	std::shared_ptr<GlobalTextures> pGlobalTextures = UniformData::GetInstance()->GetGlobalTextures();
+	UploadAtmosphereTable(pGlobalTextures->GetTransmittanceTextureDiction(chunkIndex), luts.transmittance);
+	UploadAtmosphereTable(pGlobalTextures->GetScatterTextureDiction(chunkIndex), luts.scatter);
+	UploadAtmosphereTable(pGlobalTextures->GetIrradianceTextureDiction(chunkIndex), luts.irradiance);
+}
+
+void PerPlanetUniforms::ReadbackAtmosphereLUTs(uint32_t chunkIndex, AtmosphereLUTs& luts)
+{
+	AtmosphereLUTCache::AllocateLUTs(luts);
+
+	// Accumulation images are always RGBA32F
+	std::shared_ptr<GlobalTextures> pGlobalTextures = UniformData::GetInstance()->GetGlobalTextures();
+	pGlobalTextures->GetTransmittanceTextureDiction(chunkIndex)->ReadByteStream(luts.transmittance.data(), (uint32_t)(luts.transmittance.size() * sizeof(float)));
+	pGlobalTextures->GetScatterAccumulation(chunkIndex)->ReadByteStream(luts.scatter.data(), (uint32_t)(luts.scatter.size() * sizeof(float)));
+	pGlobalTextures->GetIrradianceAccumulation(chunkIndex)->ReadByteStream(luts.irradiance.data(), (uint32_t)(luts.irradiance.size() * sizeof(float)));
+}
+
+void PerPlanetUniforms::VerifyAtmosphereLUTs(uint32_t chunkIndex, const AtmosphereLUTs& luts) const
+{
+	AtmosphereLUTs referenceLUTs;
+	AtmosphereReferenceBaker::Bake(m_singlePrecisionPerPlanetVariables[chunkIndex].AtmosphereParameters, referenceLUTs);
+
+	std::cout << "Atmosphere tables of planet " << chunkIndex << ", relative error to cpu reference: " << AtmosphereLUTCache::Compare(luts, referenceLUTs) << std::endl;
+}
+
 void PerPlanetUniforms::UpdateDirtyChunkInternal(uint32_t index)
 {
 }
@@ -320,29 +403,27 @@ void PerPlanetUniforms::PreComputeAtmosphereData
 	std::shared_ptr<Material> pMaterial = CustomizedComputeMaterial::CreateMaterial(vars);
 
 	// Recording
-	std::shared_ptr<CommandBuffer> pCommandBuffer = MainThreadCommandPool(PhysicalDevice::QueueFamily::ALL_ROUND)->AllocateCommandBuffer(CommandBuffer::CBLevel::PRIMARY);
-	pCommandBuffer->StartPrimaryRecording();
-
-	for (uint32_t i = 0; i < (uint32_t)inputTextures.size(); i++)
+	InitCmdBatcher()->Record([&](const std::shared_ptr<CommandBuffer>& pCommandBuffer)
 	{
-		pScheduler->ClaimResourceUsage
-		(
-			pCommandBuffer,
-			inputTextures[i],
-			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-			VK_IMAGE_LAYOUT_GENERAL,
-			VK_ACCESS_SHADER_READ_BIT
-		);
-	}
-
-	pMaterial->BeforeRenderPass(pCommandBuffer, pScheduler);
-	pMaterial->Dispatch(pCommandBuffer);
-	pMaterial->AfterRenderPass(pCommandBuffer);
+		for (uint32_t i = 0; i < (uint32_t)inputTextures.size(); i++)
+		{
+			pScheduler->ClaimResourceUsage
+			(
+				pCommandBuffer,
+				inputTextures[i],
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_IMAGE_LAYOUT_GENERAL,
+				VK_ACCESS_SHADER_READ_BIT
+			);
+		}
 
-	pCommandBuffer->EndPrimaryRecording();
+		pMaterial->BeforeRenderPass(pCommandBuffer, pScheduler);
+		pMaterial->Dispatch(pCommandBuffer);
+		pMaterial->AfterRenderPass(pCommandBuffer);
 
-	// Do the job
-	GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::ALL_ROUND)->SubmitCommandBuffer(pCommandBuffer, nullptr, true);
+		// Material is temporary, keep it alive until batched work is done
+		pCommandBuffer->AddToReferenceTable(pMaterial);
+	});
 }
 
 std::vector<UniformVarList> PerPlanetUniforms::PrepareUniformVarList() const
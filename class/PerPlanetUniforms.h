@@ -5,6 +5,7 @@
 class CommandBuffer;
 class Image;
 class ResourceBarrierScheduler;
+class AtmosphereLUTs;
 
 const static uint32_t PLANET_LOD_MAX_LEVEL = 32;
 
@@ -90,6 +91,12 @@ public:
 	double GetPlanetTriangleSubdivideLevel(uint32_t index) const { return m_perPlanetVariables[index].PlanetDescriptor0.y; }
 	double GetLODDistance(uint32_t index, uint32_t level) const { return m_perPlanetVariables[index].PlanetLODDistanceLUT[level]; }
 	uint32_t AllocatePlanetChunk();
+	const AtmosphereParameters<float>& GetAtmosphereParameters(uint32_t index) const { return m_singlePrecisionPerPlanetVariables[index].AtmosphereParameters; }
+
+	// Atmosphere tables are loaded from disk cache when possible, otherwise they're precomputed on gpu and saved
+	void SetAtmosphereLUTCacheEnabled(bool flag) { m_atmosphereLUTCacheEnabled = flag; }
+	// Bake tables with cpu reference baker as well and report difference, very slow, for verification only
+	void SetAtmosphereLUTVerificationEnabled(bool flag) { m_atmosphereLUTVerificationEnabled = flag; }
 
 public:
 	std::vector<UniformVarList> PrepareUniformVarList() const override;
@@ -112,9 +119,16 @@ protected:
 		uint32_t chunkIndex
 	);
 
+	static void UploadAtmosphereLUTs(uint32_t chunkIndex, const AtmosphereLUTs& luts);
+	static void ReadbackAtmosphereLUTs(uint32_t chunkIndex, AtmosphereLUTs& luts);
+	void VerifyAtmosphereLUTs(uint32_t chunkIndex, const AtmosphereLUTs& luts) const;
+
 protected:
 	PerPlanetVariablesd		m_perPlanetVariables[MAXIMUM_OBJECTS];
 	PerPlanetVariablesf		m_singlePrecisionPerPlanetVariables[MAXIMUM_OBJECTS];
 
 	std::vector<uint32_t>	m_dirtyChunks;
+
+	bool					m_atmosphereLUTCacheEnabled = true;
+	bool					m_atmosphereLUTVerificationEnabled = false;
 };
\ No newline at end of file
@@ -25,12 +25,15 @@ bool RenderPassDiction::Init()
 		{
 		case  PipelineRenderPassGBuffer:
 			m_pipelineRenderPasses[PipelineRenderPassGBuffer] = GBufferPass::Create(); break;
+		case  PipelineRenderPassGBufferLate:
+			m_pipelineRenderPasses[PipelineRenderPassGBufferLate] = GBufferPass::Create(true); break;
 		case  PipelineRenderPassMotionTileMax:
 			m_pipelineRenderPasses[PipelineRenderPassMotionTileMax] = CustomizedRenderPass::Create({ { FrameBufferDiction::OFFSCREEN_MOTION_TILE_FORMAT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,{ 0 } } }); break;
 		case  PipelineRenderPassMotionNeighborMax:
 			m_pipelineRenderPasses[PipelineRenderPassMotionNeighborMax] = CustomizedRenderPass::Create({ { FrameBufferDiction::OFFSCREEN_MOTION_TILE_FORMAT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,{ 0 } } }); break;
 		case  PipelineRenderPassShadowMap:
-			m_pipelineRenderPasses[PipelineRenderPassShadowMap] = CustomizedRenderPass::Create({ { FrameBufferDiction::OFFSCREEN_DEPTH_FORMAT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,{ 0 } } }); break;
+			// Shadow map is loaded, it's either copied from static shadow cache, or the cache itself
+			m_pipelineRenderPasses[PipelineRenderPassShadowMap] = CustomizedRenderPass::Create({ { FrameBufferDiction::OFFSCREEN_DEPTH_FORMAT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,{ 0 }, VK_ATTACHMENT_LOAD_OP_LOAD } }); break;
 		case PipelineRenderPassSSAOSSR:
 			m_pipelineRenderPasses[PipelineRenderPassSSAOSSR] = CustomizedRenderPass::Create({ 
 				{ FrameBufferDiction::SSAO_FORMAT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,{ 0 } },
@@ -14,6 +14,7 @@ public:
 	enum PipelineRenderPass
 	{
 		PipelineRenderPassGBuffer,
+		PipelineRenderPassGBufferLate,		// Loads gbuffer, for late phase draws of gpu occlusion culling
 		PipelineRenderPassMotionTileMax,
 		PipelineRenderPassMotionNeighborMax,
 		PipelineRenderPassShadowMap,
@@ -5,7 +5,10 @@
 #include "../vulkan/Framebuffer.h"
 #include "../vulkan/SwapChain.h"
 #include "../vulkan/Image.h"
+#include "../vulkan/CommandBuffer.h"
 #include "../vulkan/GlobalVulkanStates.h"
+#include "../vulkan/SharedBufferManager.h"
+#include "../vulkan/ShaderModule.h"
 #include "../common/Util.h"
 #include "RenderPassDiction.h"
 #include "ForwardRenderPass.h"
@@ -17,6 +20,37 @@
 #include "MaterialInstance.h"
 #include "FrameEventManager.h"
 #include "ResourceBarrierScheduler.h"
+#include "FrameWorkManager.h"
+#include "GPUProfiler.h"
+#include "GlobalTextures.h"
+#include "OcclusionCullingMaterial.h"
+#include "SkinningMaterial.h"
+
+static const char* MATERIAL_SCOPE_NAMES[RenderWorkManager::MaterialEnumCount] =
+{
+	"Skinning",
+	"PBRGBuffer",
+	"PBRSkinnedGBuffer",
+	"PBRPlanetGBuffer",
+	"BackgroundMotion",
+	"HiZGen",
+	"MotionTileMax",
+	"MotionNeighborMax",
+	"Shadow",
+	"SkinnedShadow",
+	"StaticShadow",
+	"ShadowCacheClear",
+	"SSAOSSR",
+	"SSAOBlurV",
+	"SSAOBlurH",
+	"DeferredShading",
+	"TemporalResolve",
+	"DepthOfField",
+	"BloomDownSample",
+	"BloomUpSample",
+	"Combine",
+	"PostProcess",
+};
 
 bool RenderWorkManager::Init()
 {
@@ -25,13 +59,21 @@ bool RenderWorkManager::Init()
 
 	FrameEventManager::GetInstance()->Register(m_pInstance);
 
+	m_preSkinning = ShaderModule::IsBinaryAvailable(L"../data/shaders/skinning.comp.spv") && ShaderModule::IsBinaryAvailable(L"../data/shaders/pbr_gbuffer_gen_preskinned.vert.spv");
+	m_shadowCache = ShaderModule::IsBinaryAvailable(L"../data/shaders/shadow_cache_clear.vert.spv");
+
 	m_materials.resize(MaterialEnumCount);
 	for (uint32_t i = 0; i < MaterialEnumCount; i++)
 	{
 		switch ((MaterialEnum)i)
 		{
+		case Skinning:
+		{
+			if (m_preSkinning)
+				m_materials[i] = { { SkinningMaterial::CreateDefaultMaterial() } };
+		}break;
 		case PBRGBuffer:		m_materials[i] = { { GBufferMaterial::CreateDefaultMaterial()} }; break;
-		case PBRSkinnedGBuffer: m_materials[i] = { { GBufferMaterial::CreateDefaultMaterial(true) } }; break;
+		case PBRSkinnedGBuffer: m_materials[i] = { { GBufferMaterial::CreateDefaultMaterial(true, m_preSkinning) } }; break;
 		case PBRPlanetGBuffer:	m_materials[i] = { { GBufferPlanetMaterial::CreateDefaultMaterial() } }; break;
 		case BackgroundMotion:	
 		{
@@ -49,53 +91,43 @@ bool RenderWorkManager::Init()
 			m_materials[i] = { {ForwardMaterial::CreateDefaultMaterial(info)} };
 		}break;
 
-		case MotionTileMax:		
+		// Created once a feature reading Hi-Z is enabled
+		case HiZGen:			break;
+		// Created along with neighbor max, it's skipped if tile reduction is fused
+		case MotionTileMax:		break;
+		case MotionNeighborMax:	CreateMotionTileMaterials(); break;
+		case Shadow:
 		{
-			std::vector<std::shared_ptr<Image>> inputImages;
-			std::vector<std::shared_ptr<Image>> outputImages;
-			for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
+			for (uint32_t j = 0; j < SHADOW_CASCADE_COUNT; j++)
 			{
-				inputImages.push_back(FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_GBuffer)[i]->GetColorTarget(FrameBufferDiction::MotionVector));
-				outputImages.push_back(FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_MotionTileMax)[i]->GetColorTarget(0));
+				m_materials[i].materialSet.push_back(ShadowMapMaterial::CreateDefaultMaterial(j));
 			}
-			m_materials[i] = { { CreateTileMaxMaterial(inputImages, outputImages) } };
 		}break;
-		case MotionNeighborMax:
+		case SkinnedShadow:
 		{
-			std::vector<std::shared_ptr<Image>> inputImages;
-			std::vector<std::shared_ptr<Image>> outputImages;
-			for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
+			for (uint32_t j = 0; j < SHADOW_CASCADE_COUNT; j++)
 			{
-				inputImages.push_back(FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_MotionTileMax)[i]->GetColorTarget(0));
-				outputImages.push_back(FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_MotionNeighborMax)[i]->GetColorTarget(0));
+				m_materials[i].materialSet.push_back(ShadowMapMaterial::CreateDefaultMaterial(j, false, !m_preSkinning));
 			}
-			m_materials[i] = { { CreateNeighborMaxMaterial(inputImages, outputImages) } };
 		}break;
-		case Shadow:			m_materials[i] = { { ShadowMapMaterial::CreateDefaultMaterial() } }; break;
-		case SkinnedShadow:		m_materials[i] = { { ShadowMapMaterial::CreateDefaultMaterial(true) } }; break;
-		case SSAOSSR:			m_materials[i] = { { CreateSSAOSSRMaterial() } }; break;
-		case SSAOBlurV:			
+		case StaticShadow:
 		{
-			std::vector<std::shared_ptr<Image>> inputImages;
-			std::vector<std::shared_ptr<Image>> outputImages;
-			for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
+			for (uint32_t j = 0; j < SHADOW_CASCADE_COUNT; j++)
 			{
-				inputImages.push_back(FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_SSAOSSR)[i]->GetColorTarget(0));
-				outputImages.push_back(FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_SSAOBlurV)[i]->GetColorTarget(0));
+				m_materials[i].materialSet.push_back(ShadowMapMaterial::CreateDefaultMaterial(j, true));
 			}
-			m_materials[i] = { { CreateGaussianBlurMaterial(inputImages, outputImages, { true, 1, 1 }) } };
 		}break;
-		case SSAOBlurH:			
+		case ShadowCacheClear:
 		{
-			std::vector<std::shared_ptr<Image>> inputImages;
-			std::vector<std::shared_ptr<Image>> outputImages;
-			for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
+			for (uint32_t j = 0; j < SHADOW_CASCADE_COUNT; j++)
 			{
-				inputImages.push_back(FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_SSAOBlurV)[i]->GetColorTarget(0));
-				outputImages.push_back(FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_SSAOBlurH)[i]->GetColorTarget(0));
+				m_materials[i].materialSet.push_back(ShadowMapMaterial::CreateCacheClearMaterial(j, m_shadowCache));
 			}
-			m_materials[i] = { { CreateGaussianBlurMaterial(inputImages, outputImages,{ false, 1, 1 }) } };
 		}break;
+		case SSAOSSR:			m_materials[i] = { { CreateSSAOSSRMaterial() } }; break;
+		// Created along with horizontal blur, it's skipped if blur is fused
+		case SSAOBlurV:			break;
+		case SSAOBlurH:			CreateSSAOBlurMaterials(); break;
 		case DeferredShading:	m_materials[i] = { { CreateDeferredShadingMaterial() } }; break;
 		case TemporalResolve:	m_materials[i] = { { CreateTemporalResolveMaterial(0), CreateTemporalResolveMaterial(1) } }; break;
 		case DepthOfField:
@@ -105,14 +137,7 @@ bool RenderWorkManager::Init()
 				m_materials[i].materialSet.push_back(CreateDOFMaterial((DOFPass)j));
 			}
 		}break;
-		case BloomDownSample:
-		{
-			for (uint32_t j = 0; j < BLOOM_ITER_COUNT; j++)
-			{
-				BloomPass bloomPass = (j == 0) ? BloomPass::PREFILTER : BloomPass::DOWNSAMPLE;
-				m_materials[i].materialSet.push_back(CreateBloomMaterial(bloomPass, j));
-			}
-		}break;
+		case BloomDownSample:	CreateBloomDownSampleMaterials(); break;
 		case BloomUpSample:
 		{
 			for (uint32_t j = 0; j < BLOOM_ITER_COUNT; j++)
@@ -155,20 +180,200 @@ std::shared_ptr<MaterialInstance> RenderWorkManager::AcquirePBRPlanetMaterialIns
 	return pMaterialInstance;
 }
 
-std::shared_ptr<MaterialInstance> RenderWorkManager::AcquireShadowMaterialInstance() const
+std::shared_ptr<MaterialInstance> RenderWorkManager::AcquireShadowMaterialInstance(uint32_t cascadeIndex) const
 {
-	std::shared_ptr<MaterialInstance> pMaterialInstance = GetMaterial(Shadow)->CreateMaterialInstance();
+	std::shared_ptr<MaterialInstance> pMaterialInstance = GetMaterial(Shadow, cascadeIndex)->CreateMaterialInstance();
 	pMaterialInstance->SetRenderMask(1 << ShadowMapGen);
+	pMaterialInstance->SetShadowCascadeMask(1 << cascadeIndex);
 	return pMaterialInstance;
 }
 
-std::shared_ptr<MaterialInstance> RenderWorkManager::AcquireSkinnedShadowMaterialInstance() const
+std::shared_ptr<MaterialInstance> RenderWorkManager::AcquireSkinnedShadowMaterialInstance(uint32_t cascadeIndex) const
 {
-	std::shared_ptr<MaterialInstance> pMaterialInstance = GetMaterial(SkinnedShadow)->CreateMaterialInstance();
+	std::shared_ptr<MaterialInstance> pMaterialInstance = GetMaterial(SkinnedShadow, cascadeIndex)->CreateMaterialInstance();
 	pMaterialInstance->SetRenderMask(1 << ShadowMapGen);
+	pMaterialInstance->SetShadowCascadeMask(1 << cascadeIndex);
+	return pMaterialInstance;
+}
+
+std::shared_ptr<MaterialInstance> RenderWorkManager::AcquireStaticShadowMaterialInstance(uint32_t cascadeIndex) const
+{
+	std::shared_ptr<MaterialInstance> pMaterialInstance = GetMaterial(StaticShadow, cascadeIndex)->CreateMaterialInstance();
+	pMaterialInstance->SetRenderMask(1 << ShadowCacheGen);
+	pMaterialInstance->SetShadowCascadeMask(1 << cascadeIndex);
 	return pMaterialInstance;
 }
 
+void RenderWorkManager::SetGPUCullingEnabled(bool flag)
+{
+	// Draws stay unculled if culling or Hi-Z shader isn't compiled
+	m_GPUCulling = flag && ShaderModule::IsBinaryAvailable(L"../data/shaders/occlusion_culling.comp.spv") && ShaderModule::IsBinaryAvailable(L"../data/shaders/hiz_gen.comp.spv");
+
+	// Skinned and planet materials don't have bounds that match what's drawn, they're never culled
+	if (m_GPUCulling)
+	{
+		CreateHiZGenMaterials();
+		GetMaterial(PBRGBuffer)->EnableGPUCulling();
+	}
+}
+
+void RenderWorkManager::CreateHiZGenMaterials()
+{
+	if (m_materials[HiZGen].materialSet.size() != 0)
+		return;
+
+	for (uint32_t i = 0; i < UniformData::GetInstance()->GetGlobalTextures()->GetHiZMipLevelCount(); i++)
+	{
+		m_materials[HiZGen].materialSet.push_back(CreateHiZGenMaterial(i));
+	}
+}
+
+void RenderWorkManager::SetHiZSSREnabled(bool flag)
+{
+	// Linear ray march stays if Hi-Z tracing variant or Hi-Z shader isn't compiled
+	flag = flag && ShaderModule::IsBinaryAvailable(L"../data/shaders/ssao_ssr_hiz_gen.comp.spv") && ShaderModule::IsBinaryAvailable(L"../data/shaders/hiz_gen.comp.spv");
+	if (m_HiZSSR == flag)
+		return;
+
+	m_HiZSSR = flag;
+	m_materials[SSAOSSR] = { { CreateSSAOSSRMaterial(m_HiZSSR) } };
+
+	if (m_HiZSSR)
+		CreateHiZGenMaterials();
+}
+
+void RenderWorkManager::SetFusedSSAOBlurEnabled(bool flag)
+{
+	flag = flag && ShaderModule::IsBinaryAvailable(L"../data/shaders/separable_blur.comp.spv");
+	if (m_fusedSSAOBlur == flag)
+		return;
+
+	m_fusedSSAOBlur = flag;
+	CreateSSAOBlurMaterials();
+}
+
+void RenderWorkManager::SetFusedMotionTileEnabled(bool flag)
+{
+	flag = flag && ShaderModule::IsBinaryAvailable(L"../data/shaders/tile_neighbor_max.comp.spv");
+	if (m_fusedMotionTile == flag)
+		return;
+
+	m_fusedMotionTile = flag;
+	CreateMotionTileMaterials();
+}
+
+void RenderWorkManager::CreateMotionTileMaterials()
+{
+	m_materials[MotionTileMax].materialSet.clear();
+
+	std::vector<std::shared_ptr<Image>> motionVectors;
+	std::vector<std::shared_ptr<Image>> tileMaxImages;
+	std::vector<std::shared_ptr<Image>> neighborMaxImages;
+	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
+	{
+		motionVectors.push_back(FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_GBuffer)[i]->GetColorTarget(FrameBufferDiction::MotionVector));
+		tileMaxImages.push_back(FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_MotionTileMax)[i]->GetColorTarget(0));
+		neighborMaxImages.push_back(FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_MotionNeighborMax)[i]->GetColorTarget(0));
+	}
+
+	// Fused neighbor max reduces motion tiles itself
+	if (m_fusedMotionTile)
+	{
+		m_materials[MotionNeighborMax] = { { CreateTileNeighborMaxMaterial(motionVectors, neighborMaxImages) } };
+		return;
+	}
+
+	m_materials[MotionTileMax] = { { CreateTileMaxMaterial(motionVectors, tileMaxImages) } };
+	m_materials[MotionNeighborMax] = { { CreateNeighborMaxMaterial(tileMaxImages, neighborMaxImages) } };
+}
+
+void RenderWorkManager::CreateSSAOBlurMaterials()
+{
+	m_materials[SSAOBlurV].materialSet.clear();
+
+	std::vector<std::shared_ptr<Image>> ssaoImages;
+	std::vector<std::shared_ptr<Image>> blurVImages;
+	std::vector<std::shared_ptr<Image>> blurHImages;
+	for (uint32_t i = 0; i < GetSwapChain()->GetSwapChainImageCount(); i++)
+	{
+		ssaoImages.push_back(FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_SSAOSSR)[i]->GetColorTarget(0));
+		blurVImages.push_back(FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_SSAOBlurV)[i]->GetColorTarget(0));
+		blurHImages.push_back(FrameBufferDiction::GetInstance()->GetFrameBuffers(FrameBufferDiction::FrameBufferType_SSAOBlurH)[i]->GetColorTarget(0));
+	}
+
+	// Fused blur does both directions in horizontal blur material
+	if (m_fusedSSAOBlur)
+	{
+		m_materials[SSAOBlurH] = { { CreateSeparableBlurMaterial(ssaoImages, blurHImages, { false, 1, 1 }) } };
+		return;
+	}
+
+	m_materials[SSAOBlurV] = { { CreateGaussianBlurMaterial(ssaoImages, blurVImages, { true, 1, 1 }) } };
+	m_materials[SSAOBlurH] = { { CreateGaussianBlurMaterial(blurVImages, blurHImages, { false, 1, 1 }) } };
+}
+
+void RenderWorkManager::SetBloomSinglePassEnabled(bool flag)
+{
+	flag = flag && ShaderModule::IsBinaryAvailable(L"../data/shaders/bloom_downsample_single_pass.comp.spv");
+	if (m_bloomSinglePass == flag)
+		return;
+
+	m_bloomSinglePass = flag;
+	CreateBloomDownSampleMaterials();
+}
+
+void RenderWorkManager::CreateBloomDownSampleMaterials()
+{
+	m_materials[BloomDownSample].materialSet.clear();
+
+	if (m_bloomSinglePass)
+	{
+		m_materials[BloomDownSample].materialSet.push_back(CreateBloomMaterial(BloomPass::SINGLE_PASS_DOWNSAMPLE, BLOOM_ITER_COUNT, BLOOM_FUSED_UPSAMPLE_COUNT));
+		return;
+	}
+
+	for (uint32_t i = 0; i < BLOOM_ITER_COUNT; i++)
+	{
+		BloomPass bloomPass = (i == 0) ? BloomPass::PREFILTER : BloomPass::DOWNSAMPLE;
+		m_materials[BloomDownSample].materialSet.push_back(CreateBloomMaterial(bloomPass, i));
+	}
+}
+
+void RenderWorkManager::BeginMaterialScope(const std::shared_ptr<CommandBuffer>& pCmdBuffer, MaterialEnum materialEnum, int32_t index)
+{
+	if (!GPUProfiler::GetInstance()->IsEnabled())
+		return;
+
+	// Scope names of materials are registered once, so that recording command buffers doesn't compose them
+	// Slot 0 is the plain material name, slot "index + 1" has index appended
+	std::call_once(m_materialScopeNamesFlag, [this]()
+	{
+		m_materialScopeNameIndices.resize(MaterialEnumCount);
+		for (uint32_t i = 0; i < MaterialEnumCount; i++)
+		{
+			m_materialScopeNameIndices[i].push_back(GPUProfiler::GetInstance()->GetScopeNameIndex(MATERIAL_SCOPE_NAMES[i]));
+			for (uint32_t j = 0; j < (uint32_t)m_materials[i].materialSet.size(); j++)
+				m_materialScopeNameIndices[i].push_back(GPUProfiler::GetInstance()->GetScopeNameIndex(std::string(MATERIAL_SCOPE_NAMES[i]) + std::to_string(j)));
+		}
+	});
+
+	GPUProfiler::GetInstance()->BeginScope(pCmdBuffer, m_materialScopeNameIndices[materialEnum][index + 1]);
+}
+
+void RenderWorkManager::DispatchHiZGen(const std::shared_ptr<CommandBuffer>& pCmdBuffer, uint32_t pingpong)
+{
+	GPUProfiler::GetInstance()->BeginScope(pCmdBuffer, "HiZ");
+	for (uint32_t i = 0; i < (uint32_t)m_materials[HiZGen].materialSet.size(); i++)
+	{
+		BeginMaterialScope(pCmdBuffer, HiZGen, i);
+		GetMaterial(HiZGen, i)->BeforeRenderPass(pCmdBuffer, m_pResBarrierScheduler, pingpong);
+		GetMaterial(HiZGen, i)->Dispatch(pCmdBuffer, pingpong);
+		GetMaterial(HiZGen, i)->AfterRenderPass(pCmdBuffer, pingpong);
+		GPUProfiler::GetInstance()->EndScope(pCmdBuffer);
+	}
+	GPUProfiler::GetInstance()->EndScope(pCmdBuffer);
+}
+
 void RenderWorkManager::SyncMaterialData()
 {
 	for (auto& materialSet : m_materials)
@@ -180,8 +385,43 @@ void RenderWorkManager::SyncMaterialData()
 	}
 }
 
+bool RenderWorkManager::IsAsyncComputeSupported() const
+{
+	return GetPhysicalDevice()->GetQueueFamilyIndex(PhysicalDevice::QueueFamily::COMPUTE) != GetPhysicalDevice()->GetQueueFamilyIndex(PhysicalDevice::QueueFamily::ALL_ROUND)
+		&& FrameWorkManager::GetInstance()->IsTimelineSemaphoreEnabled();
+}
+
 void RenderWorkManager::Draw(const std::shared_ptr<CommandBuffer>& pDrawCmdBuffer, uint32_t pingpong)
 {
+	Draw(pDrawCmdBuffer, nullptr, nullptr, pingpong);
+}
+
+void RenderWorkManager::Draw(const std::shared_ptr<CommandBuffer>& pDrawCmdBuffer, const std::shared_ptr<CommandBuffer>& pAsyncComputeCmdBuffer, const std::shared_ptr<CommandBuffer>& pPostAsyncCmdBuffer, uint32_t pingpong)
+{
+	bool asyncCompute = pAsyncComputeCmdBuffer != nullptr;
+	const std::shared_ptr<CommandBuffer>& pComputeCmdBuffer = asyncCompute ? pAsyncComputeCmdBuffer : pDrawCmdBuffer;
+	const std::shared_ptr<CommandBuffer>& pPostCmdBuffer = asyncCompute ? pPostAsyncCmdBuffer : pDrawCmdBuffer;
+
+	// Images read by async compute passes, they're read by deferred shading as well, so they go back after
+	std::vector<std::shared_ptr<VKGPUSyncRes>> asyncComputeInputs =
+	{
+		FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer)->GetColorTarget(FrameBufferDiction::GBuffer0),
+		FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer)->GetColorTarget(FrameBufferDiction::GBuffer2),
+		FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer)->GetDepthStencilTarget()
+	};
+	if (m_HiZSSR)
+		asyncComputeInputs.push_back(UniformData::GetInstance()->GetGlobalTextures()->GetHiZTexture(FrameWorkManager::GetInstance()->FrameIndex()));
+
+	// Images written by async compute passes and read by deferred shading
+	// They're fully overwritten every frame, so they don't need to go back to compute queue
+	std::vector<std::shared_ptr<VKGPUSyncRes>> asyncComputeOutputs =
+	{
+		FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_SSAOSSR)->GetColorTarget(1),
+		FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_SSAOBlurH)->GetColorTarget(0)
+	};
+
+	GPUProfiler::GetInstance()->BeginScope(pDrawCmdBuffer, "Frame");
+
 	for (uint32_t i = 0; i < (uint32_t)FrameBufferDiction::GBuffer::GBufferCount; i++)
 	{
 		m_pResBarrierScheduler->ClaimResourceUsage
@@ -203,115 +443,357 @@ void RenderWorkManager::Draw(const std::shared_ptr<CommandBuffer>& pDrawCmdBuffe
 		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
 	);
 
+	// Skinned vertices are consumed by both gbuffer and shadow map passes
+	if (m_preSkinning)
+	{
+		GPUProfiler::GetInstance()->BeginScope(pDrawCmdBuffer, "Skinning");
+		GetMaterial(Skinning)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
+		GetMaterial(Skinning)->Dispatch(pDrawCmdBuffer, pingpong);
+		GetMaterial(Skinning)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+		GPUProfiler::GetInstance()->EndScope(pDrawCmdBuffer);
+
+		m_pResBarrierScheduler->ClaimResourceUsage
+		(
+			pDrawCmdBuffer,
+			VertexAttribBufferMgr(VertexFormatPNTCT)->GetBuffer(),
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT
+		);
+
+		// Previous positions are read by skinned gbuffer vertex shader
+		m_pResBarrierScheduler->ClaimResourceUsage
+		(
+			pDrawCmdBuffer,
+			VertexAttribBufferMgr(VertexFormatP)->GetBuffer(),
+			VK_PIPELINE_STAGE_VERTEX_SHADER_BIT,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_ACCESS_SHADER_READ_BIT
+		);
+	}
+
+	if (m_GPUCulling)
+	{
+		GPUProfiler::GetInstance()->BeginScope(pDrawCmdBuffer, "OcclusionCulling");
+		GetMaterial(PBRGBuffer)->DispatchCulling(pDrawCmdBuffer, m_pResBarrierScheduler, OcclusionCullingMaterial::EarlyPhase);
+		GPUProfiler::GetInstance()->EndScope(pDrawCmdBuffer);
+	}
+
+	GPUProfiler::GetInstance()->BeginScope(pDrawCmdBuffer, "GBuffer");
 	GetMaterial(PBRGBuffer)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
 	GetMaterial(PBRSkinnedGBuffer)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
 	GetMaterial(PBRPlanetGBuffer)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
 	GetMaterial(BackgroundMotion)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
 	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassGBuffer)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer));
-	GetMaterial(PBRGBuffer)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong);
-	GetMaterial(PBRSkinnedGBuffer)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong);
-	GetMaterial(PBRPlanetGBuffer)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong);
+	// Scene goes to viewport picked by dynamic resolution, which is baked into command buffers
+	// Materials share render pass, so their scopes only cover their draws, barriers around render pass go to scope of the pass
+	BeginMaterialScope(pDrawCmdBuffer, PBRGBuffer);
+	GetMaterial(PBRGBuffer)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong, true);
+	GPUProfiler::GetInstance()->EndScope(pDrawCmdBuffer);
+	BeginMaterialScope(pDrawCmdBuffer, PBRSkinnedGBuffer);
+	GetMaterial(PBRSkinnedGBuffer)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong, true);
+	GPUProfiler::GetInstance()->EndScope(pDrawCmdBuffer);
+	BeginMaterialScope(pDrawCmdBuffer, PBRPlanetGBuffer);
+	GetMaterial(PBRPlanetGBuffer)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong, true);
+	GPUProfiler::GetInstance()->EndScope(pDrawCmdBuffer);
 	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassGBuffer)->NextSubpass(pDrawCmdBuffer);
-	GetMaterial(BackgroundMotion)->DrawScreenQuad(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer));
+	BeginMaterialScope(pDrawCmdBuffer, BackgroundMotion);
+	GetMaterial(BackgroundMotion)->DrawScreenQuad(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), 0, true);
+	GPUProfiler::GetInstance()->EndScope(pDrawCmdBuffer);
 	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassGBuffer)->EndRenderPass(pDrawCmdBuffer);
 	GetMaterial(BackgroundMotion)->AfterRenderPass(pDrawCmdBuffer, pingpong);
 	GetMaterial(PBRPlanetGBuffer)->AfterRenderPass(pDrawCmdBuffer, pingpong);
 	GetMaterial(PBRSkinnedGBuffer)->AfterRenderPass(pDrawCmdBuffer, pingpong);
 	GetMaterial(PBRGBuffer)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+	GPUProfiler::GetInstance()->EndScope(pDrawCmdBuffer);
 
+	if (m_GPUCulling)
+	{
+		// Hi-Z of depth drawn so far, late phase tests against it, and early phase of next frame reuses it
+		DispatchHiZGen(pDrawCmdBuffer, pingpong);
 
-	GetMaterial(MotionTileMax)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
-	GetMaterial(MotionTileMax)->Dispatch(pDrawCmdBuffer, pingpong);
-	GetMaterial(MotionTileMax)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+		GPUProfiler::GetInstance()->BeginScope(pDrawCmdBuffer, "GBufferLate");
+		GetMaterial(PBRGBuffer)->DispatchCulling(pDrawCmdBuffer, m_pResBarrierScheduler, OcclusionCullingMaterial::LatePhase);
 
+		for (uint32_t i = 0; i < (uint32_t)FrameBufferDiction::GBuffer::GBufferCount; i++)
+		{
+			m_pResBarrierScheduler->ClaimResourceUsage
+			(
+				pDrawCmdBuffer,
+				FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer)->GetColorTarget(i),
+				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+				VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+			);
+		}
 
+		m_pResBarrierScheduler->ClaimResourceUsage
+		(
+			pDrawCmdBuffer,
+			FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer)->GetDepthStencilTarget(),
+			VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+		);
+
+		// Same frame buffer and materials, render pass only differs in that it loads attachments
+		GetMaterial(PBRGBuffer)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
+		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassGBufferLate)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer));
+		GetMaterial(PBRGBuffer)->DrawLateIndirect(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_GBuffer), pingpong, true);
+		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassGBufferLate)->NextSubpass(pDrawCmdBuffer);
+		RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassGBufferLate)->EndRenderPass(pDrawCmdBuffer);
+		GetMaterial(PBRGBuffer)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+		GPUProfiler::GetInstance()->EndScope(pDrawCmdBuffer);
+	}
+
+	// Reflection rays are traced against complete depth, so pyramid is (re)built after every gbuffer draw
+	// With gpu culling it's rebuilt after late phase, early phase of next frame gets a complete pyramid as well
+	if (m_HiZSSR)
+		DispatchHiZGen(pDrawCmdBuffer, pingpong);
+
+
+	// Fused neighbor max reduces motion tiles itself
+	if (!m_fusedMotionTile)
+	{
+		GPUProfiler::GetInstance()->BeginScope(pDrawCmdBuffer, "MotionTileMax");
+		GetMaterial(MotionTileMax)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
+		GetMaterial(MotionTileMax)->Dispatch(pDrawCmdBuffer, pingpong);
+		GetMaterial(MotionTileMax)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+		GPUProfiler::GetInstance()->EndScope(pDrawCmdBuffer);
+	}
+
+
+	GPUProfiler::GetInstance()->BeginScope(pDrawCmdBuffer, "MotionNeighborMax");
 	GetMaterial(MotionNeighborMax)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
 	GetMaterial(MotionNeighborMax)->Dispatch(pDrawCmdBuffer, pingpong);
 	GetMaterial(MotionNeighborMax)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+	GPUProfiler::GetInstance()->EndScope(pDrawCmdBuffer);
+
+	if (asyncCompute)
+	{
+		for (auto& pResource : asyncComputeInputs)
+		{
+			m_pResBarrierScheduler->TransferQueueOwnership
+			(
+				pDrawCmdBuffer,
+				pAsyncComputeCmdBuffer,
+				pResource,
+				PhysicalDevice::QueueFamily::ALL_ROUND,
+				PhysicalDevice::QueueFamily::COMPUTE,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_ACCESS_SHADER_READ_BIT
+			);
+		}
+	}
 
 	m_pResBarrierScheduler->ClaimResourceUsage
 	(
-		pDrawCmdBuffer,
+		pPostCmdBuffer,
+		FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowCache)->GetDepthStencilTarget(),
+		VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+	);
+
+	// Commands are the same every frame, whether a cascade of static shadow cache is re-rendered is driven by data:
+	// Its clear quad collapses and its static casters are culled away, if it's still valid
+	GPUProfiler::GetInstance()->BeginScope(pPostCmdBuffer, "ShadowCache");
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		GetMaterial(ShadowCacheClear, i)->BeforeRenderPass(pPostCmdBuffer, m_pResBarrierScheduler, pingpong);
+		GetMaterial(StaticShadow, i)->BeforeRenderPass(pPostCmdBuffer, m_pResBarrierScheduler, pingpong);
+	}
+	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShadowMap)->BeginRenderPass(pPostCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowCache));
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		BeginMaterialScope(pPostCmdBuffer, ShadowCacheClear, i);
+		GetMaterial(ShadowCacheClear, i)->DrawScreenQuad(pPostCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowCache), pingpong);
+		GPUProfiler::GetInstance()->EndScope(pPostCmdBuffer);
+		BeginMaterialScope(pPostCmdBuffer, StaticShadow, i);
+		GetMaterial(StaticShadow, i)->Draw(pPostCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowCache), pingpong);
+		GPUProfiler::GetInstance()->EndScope(pPostCmdBuffer);
+	}
+	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShadowMap)->EndRenderPass(pPostCmdBuffer);
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		GetMaterial(StaticShadow, i)->AfterRenderPass(pPostCmdBuffer, pingpong);
+		GetMaterial(ShadowCacheClear, i)->AfterRenderPass(pPostCmdBuffer, pingpong);
+	}
+	GPUProfiler::GetInstance()->EndScope(pPostCmdBuffer);
+
+	m_pResBarrierScheduler->ClaimResourceUsage
+	(
+		pPostCmdBuffer,
 		FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap)->GetDepthStencilTarget(),
 		VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
 		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
 		VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
 	);
 
-	GetMaterial(Shadow)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
-	GetMaterial(SkinnedShadow)->BeforeRenderPass(pDrawCmdBuffer, nullptr, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShadowMap)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap));
-	GetMaterial(Shadow)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap), pingpong);
-	GetMaterial(SkinnedShadow)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShadowMap)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(SkinnedShadow)->AfterRenderPass(pDrawCmdBuffer, pingpong);
-	GetMaterial(Shadow)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+	GPUProfiler::GetInstance()->BeginScope(pPostCmdBuffer, "ShadowMap");
+	// Static shadow cache is the base of shadow map, dynamic casters are rendered on top of it
+	std::shared_ptr<Image> pShadowCache = FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowCache)->GetDepthStencilTarget();
+	VkImageCopy shadowCacheCopy = {};
+	shadowCacheCopy.srcSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1 };
+	shadowCacheCopy.dstSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 0, 1 };
+	shadowCacheCopy.extent = pShadowCache->GetImageInfo().extent;
+	pPostCmdBuffer->CopyImage(pShadowCache, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap)->GetDepthStencilTarget(), { shadowCacheCopy });
+
+	// All cascades are rendered into their own tiles within one render pass
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		GetMaterial(Shadow, i)->BeforeRenderPass(pPostCmdBuffer, m_pResBarrierScheduler, pingpong);
+		GetMaterial(SkinnedShadow, i)->BeforeRenderPass(pPostCmdBuffer, nullptr, pingpong);
+	}
+	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShadowMap)->BeginRenderPass(pPostCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap));
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		BeginMaterialScope(pPostCmdBuffer, Shadow, i);
+		GetMaterial(Shadow, i)->Draw(pPostCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap), pingpong);
+		GPUProfiler::GetInstance()->EndScope(pPostCmdBuffer);
+		BeginMaterialScope(pPostCmdBuffer, SkinnedShadow, i);
+		GetMaterial(SkinnedShadow, i)->Draw(pPostCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap), pingpong);
+		GPUProfiler::GetInstance()->EndScope(pPostCmdBuffer);
+	}
+	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShadowMap)->EndRenderPass(pPostCmdBuffer);
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		GetMaterial(SkinnedShadow, i)->AfterRenderPass(pPostCmdBuffer, pingpong);
+		GetMaterial(Shadow, i)->AfterRenderPass(pPostCmdBuffer, pingpong);
+	}
+	GPUProfiler::GetInstance()->EndScope(pPostCmdBuffer);
 
 
-	GetMaterial(SSAOSSR)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
-	GetMaterial(SSAOSSR)->Dispatch(pDrawCmdBuffer, pingpong);
-	GetMaterial(SSAOSSR)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+	GPUProfiler::GetInstance()->BeginScope(pComputeCmdBuffer, "SSAOSSR");
+	GetMaterial(SSAOSSR)->BeforeRenderPass(pComputeCmdBuffer, m_pResBarrierScheduler, pingpong);
+	GetMaterial(SSAOSSR)->Dispatch(pComputeCmdBuffer, pingpong);
+	GetMaterial(SSAOSSR)->AfterRenderPass(pComputeCmdBuffer, pingpong);
+	GPUProfiler::GetInstance()->EndScope(pComputeCmdBuffer);
 
 
-	GetMaterial(SSAOBlurV)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
-	GetMaterial(SSAOBlurV)->Dispatch(pDrawCmdBuffer, pingpong);
-	GetMaterial(SSAOBlurV)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+	GPUProfiler::GetInstance()->BeginScope(pComputeCmdBuffer, "SSAOBlur");
+	// Fused blur does both directions in horizontal blur material
+	if (!m_fusedSSAOBlur)
+	{
+		BeginMaterialScope(pComputeCmdBuffer, SSAOBlurV);
+		GetMaterial(SSAOBlurV)->BeforeRenderPass(pComputeCmdBuffer, m_pResBarrierScheduler, pingpong);
+		GetMaterial(SSAOBlurV)->Dispatch(pComputeCmdBuffer, pingpong);
+		GetMaterial(SSAOBlurV)->AfterRenderPass(pComputeCmdBuffer, pingpong);
+		GPUProfiler::GetInstance()->EndScope(pComputeCmdBuffer);
+	}
 
 
-	GetMaterial(SSAOBlurH)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
-	GetMaterial(SSAOBlurH)->Dispatch(pDrawCmdBuffer, pingpong);
-	GetMaterial(SSAOBlurH)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+	BeginMaterialScope(pComputeCmdBuffer, SSAOBlurH);
+	GetMaterial(SSAOBlurH)->BeforeRenderPass(pComputeCmdBuffer, m_pResBarrierScheduler, pingpong);
+	GetMaterial(SSAOBlurH)->Dispatch(pComputeCmdBuffer, pingpong);
+	GetMaterial(SSAOBlurH)->AfterRenderPass(pComputeCmdBuffer, pingpong);
+	GPUProfiler::GetInstance()->EndScope(pComputeCmdBuffer);
+	GPUProfiler::GetInstance()->EndScope(pComputeCmdBuffer);
 
 
-	GetMaterial(DeferredShading)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
-	GetMaterial(DeferredShading)->Dispatch(pDrawCmdBuffer, pingpong);
-	GetMaterial(DeferredShading)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+	if (asyncCompute)
+	{
+		for (auto& pResource : asyncComputeInputs)
+		{
+			m_pResBarrierScheduler->TransferQueueOwnership
+			(
+				pAsyncComputeCmdBuffer,
+				pPostAsyncCmdBuffer,
+				pResource,
+				PhysicalDevice::QueueFamily::COMPUTE,
+				PhysicalDevice::QueueFamily::ALL_ROUND,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_ACCESS_SHADER_READ_BIT
+			);
+		}
+
+		for (auto& pResource : asyncComputeOutputs)
+		{
+			m_pResBarrierScheduler->TransferQueueOwnership
+			(
+				pAsyncComputeCmdBuffer,
+				pPostAsyncCmdBuffer,
+				pResource,
+				PhysicalDevice::QueueFamily::COMPUTE,
+				PhysicalDevice::QueueFamily::ALL_ROUND,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+				VK_ACCESS_SHADER_READ_BIT
+			);
+		}
+	}
+
+
+	GPUProfiler::GetInstance()->BeginScope(pPostCmdBuffer, "DeferredShading");
+	GetMaterial(DeferredShading)->BeforeRenderPass(pPostCmdBuffer, m_pResBarrierScheduler, pingpong);
+	GetMaterial(DeferredShading)->Dispatch(pPostCmdBuffer, pingpong);
+	GetMaterial(DeferredShading)->AfterRenderPass(pPostCmdBuffer, pingpong);
+	GPUProfiler::GetInstance()->EndScope(pPostCmdBuffer);
 
 
-	GetMaterial(TemporalResolve, pingpong)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
-	GetMaterial(TemporalResolve, pingpong)->Dispatch(pDrawCmdBuffer, pingpong);
-	GetMaterial(TemporalResolve, pingpong)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+	GPUProfiler::GetInstance()->BeginScope(pPostCmdBuffer, "TemporalResolve");
+	GetMaterial(TemporalResolve, pingpong)->BeforeRenderPass(pPostCmdBuffer, m_pResBarrierScheduler, pingpong);
+	GetMaterial(TemporalResolve, pingpong)->Dispatch(pPostCmdBuffer, pingpong);
+	GetMaterial(TemporalResolve, pingpong)->AfterRenderPass(pPostCmdBuffer, pingpong);
+	GPUProfiler::GetInstance()->EndScope(pPostCmdBuffer);
 
+	GPUProfiler::GetInstance()->BeginScope(pPostCmdBuffer, "DepthOfField");
 	for (uint32_t i = 0; i < (uint32_t)DOFPass::COUNT; i++)
 	{
-		GetMaterial(DepthOfField, i)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
-		GetMaterial(DepthOfField, i)->Dispatch(pDrawCmdBuffer, pingpong);
-		GetMaterial(DepthOfField, i)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+		BeginMaterialScope(pPostCmdBuffer, DepthOfField, i);
+		GetMaterial(DepthOfField, i)->BeforeRenderPass(pPostCmdBuffer, m_pResBarrierScheduler, pingpong);
+		GetMaterial(DepthOfField, i)->Dispatch(pPostCmdBuffer, pingpong);
+		GetMaterial(DepthOfField, i)->AfterRenderPass(pPostCmdBuffer, pingpong);
+		GPUProfiler::GetInstance()->EndScope(pPostCmdBuffer);
 	}
+	GPUProfiler::GetInstance()->EndScope(pPostCmdBuffer);
 
+	GPUProfiler::GetInstance()->BeginScope(pPostCmdBuffer, "Bloom");
 	// Downsample first
-	for (uint32_t i = 0; i < BLOOM_ITER_COUNT; i++)
+	uint32_t downsampleCount = m_bloomSinglePass ? 1 : BLOOM_ITER_COUNT;
+	for (uint32_t i = 0; i < downsampleCount; i++)
 	{
-		GetMaterial(BloomDownSample, i)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
-		GetMaterial(BloomDownSample, i)->Dispatch(pDrawCmdBuffer, pingpong);
-		GetMaterial(BloomDownSample, i)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+		BeginMaterialScope(pPostCmdBuffer, BloomDownSample, i);
+		GetMaterial(BloomDownSample, i)->BeforeRenderPass(pPostCmdBuffer, m_pResBarrierScheduler, pingpong);
+		GetMaterial(BloomDownSample, i)->Dispatch(pPostCmdBuffer, pingpong);
+		GetMaterial(BloomDownSample, i)->AfterRenderPass(pPostCmdBuffer, pingpong);
+		GPUProfiler::GetInstance()->EndScope(pPostCmdBuffer);
 	}
 
-	// Upsample then
-	for (int32_t i = BLOOM_ITER_COUNT - 1; i >= 0; i--)
+	// Upsample then, skipping iterations fused into single pass downsample
+	int32_t fusedUpsampleCount = m_bloomSinglePass ? BLOOM_FUSED_UPSAMPLE_COUNT : 0;
+	for (int32_t i = (int32_t)BLOOM_ITER_COUNT - 1 - fusedUpsampleCount; i >= 0; i--)
 	{
-		GetMaterial(BloomUpSample, i)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
-		GetMaterial(BloomUpSample, i)->Dispatch(pDrawCmdBuffer, pingpong);
-		GetMaterial(BloomUpSample, i)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+		BeginMaterialScope(pPostCmdBuffer, BloomUpSample, i);
+		GetMaterial(BloomUpSample, i)->BeforeRenderPass(pPostCmdBuffer, m_pResBarrierScheduler, pingpong);
+		GetMaterial(BloomUpSample, i)->Dispatch(pPostCmdBuffer, pingpong);
+		GetMaterial(BloomUpSample, i)->AfterRenderPass(pPostCmdBuffer, pingpong);
+		GPUProfiler::GetInstance()->EndScope(pPostCmdBuffer);
 	}
+	GPUProfiler::GetInstance()->EndScope(pPostCmdBuffer);
+
+	GPUProfiler::GetInstance()->BeginScope(pPostCmdBuffer, "Combine");
+	GetMaterial(Combine)->BeforeRenderPass(pPostCmdBuffer, m_pResBarrierScheduler, pingpong);
+	GetMaterial(Combine)->Dispatch(pPostCmdBuffer, pingpong);
+	GetMaterial(Combine)->AfterRenderPass(pPostCmdBuffer, pingpong);
+	GPUProfiler::GetInstance()->EndScope(pPostCmdBuffer);
 
-	GetMaterial(Combine)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
-	GetMaterial(Combine)->Dispatch(pDrawCmdBuffer, pingpong);
-	GetMaterial(Combine)->AfterRenderPass(pDrawCmdBuffer, pingpong);
 
+	GPUProfiler::GetInstance()->BeginScope(pPostCmdBuffer, "PostProcess");
+	GetMaterial(PostProcess)->BeforeRenderPass(pPostCmdBuffer, m_pResBarrierScheduler, pingpong);
+	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassPostProcessing)->BeginRenderPass(pPostCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_PostProcessing));
+	GetMaterial(PostProcess)->Draw(pPostCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_PostProcessing), pingpong);
+	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassPostProcessing)->EndRenderPass(pPostCmdBuffer);
+	GetMaterial(PostProcess)->AfterRenderPass(pPostCmdBuffer, pingpong);
+	GPUProfiler::GetInstance()->EndScope(pPostCmdBuffer);
 
-	GetMaterial(PostProcess)->BeforeRenderPass(pDrawCmdBuffer, m_pResBarrierScheduler, pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassPostProcessing)->BeginRenderPass(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_PostProcessing));
-	GetMaterial(PostProcess)->Draw(pDrawCmdBuffer, FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_PostProcessing), pingpong);
-	RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassPostProcessing)->EndRenderPass(pDrawCmdBuffer);
-	GetMaterial(PostProcess)->AfterRenderPass(pDrawCmdBuffer, pingpong);
+	GPUProfiler::GetInstance()->EndScope(pPostCmdBuffer);
 
 	m_pResBarrierScheduler->ClearReferenceTable();
 }
 
 void RenderWorkManager::OnFrameBegin()
 {
-	SetRenderStateMask((1 << RenderWorkManager::Scene) | (1 << RenderWorkManager::ShadowMapGen));
+	SetRenderStateMask((1 << RenderWorkManager::Scene) | (1 << RenderWorkManager::ShadowMapGen) | (1 << RenderWorkManager::ShadowCacheGen));
 }
 
 void RenderWorkManager::OnPostSceneTraversal()
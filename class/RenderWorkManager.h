@@ -5,6 +5,7 @@
 #include "CustomizedComputeMaterial.h"
 #include "RenderPassDiction.h"
 #include "FrameEventListener.h"
+#include <mutex>
 
 class FrameBuffer;
 class Texture2D;
@@ -32,6 +33,8 @@ class RenderWorkManager : public Singleton<RenderWorkManager>, public IFrameEven
 {
 	// FIXME: Temp
 	static const uint32_t BLOOM_ITER_COUNT = 5;
+	// Last few bloom upsample iterations fused into single pass downsample
+	static const uint32_t BLOOM_FUSED_UPSAMPLE_COUNT = 2;
 
 public:
 	enum RenderState
@@ -42,19 +45,24 @@ public:
 		BrdfLutGen,
 		Scene,
 		ShadowMapGen,
+		ShadowCacheGen,
 		RenderStateCount
 	};
 
 	enum MaterialEnum
 	{
+		Skinning,
 		PBRGBuffer,
 		PBRSkinnedGBuffer,
 		PBRPlanetGBuffer,
 		BackgroundMotion,
+		HiZGen,
 		MotionTileMax,
 		MotionNeighborMax,
 		Shadow,
 		SkinnedShadow,
+		StaticShadow,
+		ShadowCacheClear,
 		SSAOSSR,
 		SSAOBlurV,
 		SSAOBlurH,
@@ -80,11 +88,42 @@ public:
 	std::shared_ptr<MaterialInstance> AcquirePBRMaterialInstance() const;
 	std::shared_ptr<MaterialInstance> AcquirePBRSkinnedMaterialInstance() const;
 	std::shared_ptr<MaterialInstance> AcquirePBRPlanetMaterialInstance() const;
-	std::shared_ptr<MaterialInstance> AcquireShadowMaterialInstance() const;
-	std::shared_ptr<MaterialInstance> AcquireSkinnedShadowMaterialInstance() const;
+	// Shadow map material instances render casters into one shadow cascade
+	std::shared_ptr<MaterialInstance> AcquireShadowMaterialInstance(uint32_t cascadeIndex) const;
+	std::shared_ptr<MaterialInstance> AcquireSkinnedShadowMaterialInstance(uint32_t cascadeIndex) const;
+	// Static shadow material instances render static casters into static shadow cache of one cascade
+	std::shared_ptr<MaterialInstance> AcquireStaticShadowMaterialInstance(uint32_t cascadeIndex) const;
+
+	// Gpu occlusion culling of pbr gbuffer draws, it has to be set before any command buffer is recorded
+	void SetGPUCullingEnabled(bool flag);
+	bool IsGPUCullingEnabled() const { return m_GPUCulling; }
+	// Screen space reflection traced through Hi-Z, it has to be set before any command buffer is recorded
+	void SetHiZSSREnabled(bool flag);
+	bool IsHiZSSREnabled() const { return m_HiZSSR; }
+	// Bloom downsample iterations are done by one dispatch, last few upsample iterations are fused into it as well
+	// It has to be set before any command buffer is recorded, split passes stay if its shader binary isn't compiled
+	void SetBloomSinglePassEnabled(bool flag);
+	// SSAO blur and motion tile reduction are done by one dispatch each, intermediate images are skipped
+	// They have to be set before any command buffer is recorded, split passes stay if their shader binaries aren't compiled
+	void SetFusedSSAOBlurEnabled(bool flag);
+	bool IsFusedSSAOBlurEnabled() const { return m_fusedSSAOBlur; }
+	void SetFusedMotionTileEnabled(bool flag);
+	bool IsFusedMotionTileEnabled() const { return m_fusedMotionTile; }
+	bool IsBloomSinglePassEnabled() const { return m_bloomSinglePass; }
+	// Skinned meshes are skinned once per frame by compute, or by vertex shaders of every pass if its shader binaries aren't compiled
+	bool IsPreSkinningEnabled() const { return m_preSkinning; }
+	// Static shadow casters are cached per cascade, or re-rendered every frame if cache clear shader binary isn't compiled
+	bool IsShadowCacheEnabled() const { return m_shadowCache; }
 
 	void SyncMaterialData();
 	void Draw(const std::shared_ptr<CommandBuffer>& pDrawCmdBuffer, uint32_t pingpong);
+	// Async compute mode, SSAO and its blurs are recorded into "pAsyncComputeCmdBuffer" for compute queue
+	// Graphics work is split: "pDrawCmdBuffer" produces GBuffer, "pPostAsyncCmdBuffer" does the rest, with shadow map rendering overlapping async compute
+	// Queue ownership of images shared by both queues is transferred here, caller's submissions have to order them accordingly
+	void Draw(const std::shared_ptr<CommandBuffer>& pDrawCmdBuffer, const std::shared_ptr<CommandBuffer>& pAsyncComputeCmdBuffer, const std::shared_ptr<CommandBuffer>& pPostAsyncCmdBuffer, uint32_t pingpong);
+
+	// Only if compute queue is of a different family, and cached submissions could wait for each other across queues
+	bool IsAsyncComputeSupported() const;
 
 	void OnFrameBegin() override;
 	void OnPostSceneTraversal() override;
@@ -94,6 +133,17 @@ public:
 
 	std::shared_ptr<Material>	GetMaterial(MaterialEnum materialEnum, uint32_t index = 0) const { return m_materials[materialEnum].GetMaterial(index); }
 
+protected:
+	// Builds Hi-Z pyramid of current frame from gbuffer depth
+	void DispatchHiZGen(const std::shared_ptr<CommandBuffer>& pCmdBuffer, uint32_t pingpong);
+	// Hi-Z pyramid is only built if gpu culling or Hi-Z SSR reads it
+	void CreateHiZGenMaterials();
+	void CreateBloomDownSampleMaterials();
+	void CreateSSAOBlurMaterials();
+	void CreateMotionTileMaterials();
+	// Gpu profiler scope of one material, nested in scope of its pass, index is appended to name of materials with several instances doing different work
+	void BeginMaterialScope(const std::shared_ptr<CommandBuffer>& pCmdBuffer, MaterialEnum materialEnum, int32_t index = -1);
+
 protected:
 	// Since there could be some mutants of the same material class
 	// We encapsulate these one or more materials into "MaterialSet"
@@ -105,6 +155,16 @@ protected:
 
 	std::vector<MaterialSet>	m_materials;
 	uint32_t					m_renderStateMask;
+	bool						m_GPUCulling = false;
+	bool						m_HiZSSR = false;
+	bool						m_preSkinning = false;
+	bool						m_shadowCache = false;
+	bool						m_bloomSinglePass = false;
+	bool						m_fusedSSAOBlur = false;
+	bool						m_fusedMotionTile = false;
+	// GPU profiler name indices of material scopes, see BeginMaterialScope()
+	std::vector<std::vector<uint32_t>>	m_materialScopeNameIndices;
+	std::once_flag						m_materialScopeNamesFlag;
 
 	std::shared_ptr<ResourceBarrierScheduler> m_pResBarrierScheduler;
 };
\ No newline at end of file
@@ -88,9 +88,9 @@ void ResourceBarrierScheduler::ClaimResourceUsage
 		srcAccessFlags != 0 ||
 		srcImageLayout != dstImageLayout)
 	{
-		std::vector<VkMemoryBarrier> memBarriers;
-		std::vector<VkBufferMemoryBarrier> bufferMemBarriers;
-		std::vector<VkImageMemoryBarrier> imageMemBarriers;
+		FrameVector<VkMemoryBarrier> memBarriers;
+		FrameVector<VkBufferMemoryBarrier> bufferMemBarriers;
+		FrameVector<VkImageMemoryBarrier> imageMemBarriers;
 
 		// Don't do anything if barrier is not necessary
 		if (srcStageFlags == 0)
@@ -146,52 +146,68 @@ void ResourceBarrierScheduler::ReleaseQueueOwnership
 {
 	ResourceUsageRecord& usageRecord = m_claimedResourceUsageList[pResource];
 
-	ClaimedResourceUsage usage;
+	ClaimedResourceUsage usage = {};
 	usage.lastWriteIndex = -1;
 
-	if (usageRecord.size() != 0)
-	{
-		if (usageRecord[usageRecord.size() - 1].isAccessWrite)
-			usage.lastWriteIndex = (uint32_t)usageRecord.size() - 1;
-		else
-			usage.lastWriteIndex = usageRecord[usageRecord.size() - 1].lastWriteIndex;
-	}
+	if (usageRecord.size() == 0)
+		return;
+
+	if (usageRecord[usageRecord.size() - 1].isAccessWrite)
+		usage.lastWriteIndex = (uint32_t)usageRecord.size() - 1;
+	else
+		usage.lastWriteIndex = usageRecord[usageRecord.size() - 1].lastWriteIndex;
+
+	VkPipelineStageFlags srcStageFlags;
+	VkAccessFlags srcAccessFlags;
+	VkImageLayout srcImageLayout;
 
 	if (usage.lastWriteIndex != -1)
 	{
-		std::vector<VkMemoryBarrier> memBarriers;
-		std::vector<VkBufferMemoryBarrier> bufferMemBarriers;
-		std::vector<VkImageMemoryBarrier> imageMemBarriers;
+		srcStageFlags = usageRecord[usage.lastWriteIndex].stagesFlags;
+		srcAccessFlags = usageRecord[usage.lastWriteIndex].accessFlags;
+		srcImageLayout = usageRecord[usage.lastWriteIndex].imageLayout;
+	}
+	// Resource only read since it's acquired, it's released as well, or its content isn't valid on dst queue family
+	else if (!usageRecord[usageRecord.size() - 1].isQueueReleaseIssued)
+	{
+		srcStageFlags = usageRecord[usageRecord.size() - 1].accumulatedReadStages;
+		srcAccessFlags = 0;
+		srcImageLayout = usageRecord[usageRecord.size() - 1].imageLayout;
+	}
+	else
+		return;
 
-		pResource->PrepareQueueReleaseBarrier
-		(
-			usageRecord[usage.lastWriteIndex].accessFlags,
-			usageRecord[usage.lastWriteIndex].imageLayout,
-			srcQueueFamily,
-			dstQueueFamily,
-			memBarriers,
-			bufferMemBarriers,
-			imageMemBarriers
-		);
+	FrameVector<VkMemoryBarrier> memBarriers;
+	FrameVector<VkBufferMemoryBarrier> bufferMemBarriers;
+	FrameVector<VkImageMemoryBarrier> imageMemBarriers;
 
-		// Only attach barrier if there's a write for queue release/acquire
-		pCmdBuffer->AttachBarriers
-		(
-			usageRecord[usage.lastWriteIndex].stagesFlags,
-			VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
-			memBarriers,
-			bufferMemBarriers,
-			imageMemBarriers
-		);
+	pResource->PrepareQueueReleaseBarrier
+	(
+		srcAccessFlags,
+		srcImageLayout,
+		srcQueueFamily,
+		dstQueueFamily,
+		memBarriers,
+		bufferMemBarriers,
+		imageMemBarriers
+	);
+
+	pCmdBuffer->AttachBarriers
+	(
+		srcStageFlags,
+		VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+		memBarriers,
+		bufferMemBarriers,
+		imageMemBarriers
+	);
 
-		usage.isQueueReleaseIssued = true;
-		usage.srcQueueFamily = srcQueueFamily;
-		usage.dstQueueFamily = dstQueueFamily;
+	usage.isQueueReleaseIssued = true;
+	usage.srcQueueFamily = srcQueueFamily;
+	usage.dstQueueFamily = dstQueueFamily;
 
-		usage.imageLayout = usageRecord[usage.lastWriteIndex].imageLayout;
+	usage.imageLayout = srcImageLayout;
 
-		usageRecord.push_back(usage);
-	}
+	usageRecord.push_back(usage);
 }
 
 void ResourceBarrierScheduler::AcquireQueueOwnership
@@ -207,9 +223,6 @@ void ResourceBarrierScheduler::AcquireQueueOwnership
 {
 	ResourceUsageRecord& usageRecord = m_claimedResourceUsageList[pResource];
 
-	ClaimedResourceUsage usage;
-	usage.lastWriteIndex = -1;
-
 	// No need for ownership acquire
 	if (usageRecord.size() == 0)
 		return;
@@ -225,9 +238,9 @@ void ResourceBarrierScheduler::AcquireQueueOwnership
 		&& usageRecord[usageRecord.size() - 1].imageLayout == dstImageLayout
 	);
 
-	std::vector<VkMemoryBarrier> memBarriers;
-	std::vector<VkBufferMemoryBarrier> bufferMemBarriers;
-	std::vector<VkImageMemoryBarrier> imageMemBarriers;
+	FrameVector<VkMemoryBarrier> memBarriers;
+	FrameVector<VkBufferMemoryBarrier> bufferMemBarriers;
+	FrameVector<VkImageMemoryBarrier> imageMemBarriers;
 
 	pResource->PrepareQueueAcquireBarrier
 	(
@@ -240,10 +253,10 @@ void ResourceBarrierScheduler::AcquireQueueOwnership
 		imageMemBarriers
 	);
 
-	// Only attach barrier if there's a write for queue release/acquire
+	// Src stages are the same as dst, so that acquire is ordered after a semaphore wait on these stages
 	pCmdBuffer->AttachBarriers
 	(
-		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		dstPipelineStageFlags,
 		dstPipelineStageFlags,
 		memBarriers,
 		bufferMemBarriers,
@@ -252,4 +265,29 @@ void ResourceBarrierScheduler::AcquireQueueOwnership
 
 	// Clear previous queue usage record for new queue
 	usageRecord.clear();
+
+	// Acquire acts as the first write on new queue, so that following usages are synchronized against it and know current layout
+	ClaimedResourceUsage usage = { dstPipelineStageFlags, dstAccessFlags, dstImageLayout, true, (uint32_t)-1 };
+	usage.flushedStages[dstAccessFlags] = dstPipelineStageFlags;
+	usageRecord.push_back(usage);
+}
+
+void ResourceBarrierScheduler::TransferQueueOwnership
+(
+	const std::shared_ptr<CommandBuffer>& pSrcCmdBuffer,
+	const std::shared_ptr<CommandBuffer>& pDstCmdBuffer,
+	const std::shared_ptr<VKGPUSyncRes>& pResource,
+	PhysicalDevice::QueueFamily	srcQueueFamily,
+	PhysicalDevice::QueueFamily	dstQueueFamily,
+	VkPipelineStageFlags dstPipelineStageFlags,
+	VkAccessFlags dstAccessFlags
+)
+{
+	ReleaseQueueOwnership(pSrcCmdBuffer, pResource, srcQueueFamily, dstQueueFamily);
+
+	ResourceUsageRecord& usageRecord = m_claimedResourceUsageList[pResource];
+	if (usageRecord.size() == 0 || !usageRecord[usageRecord.size() - 1].isQueueReleaseIssued)
+		return;
+
+	AcquireQueueOwnership(pDstCmdBuffer, pResource, srcQueueFamily, dstQueueFamily, dstPipelineStageFlags, usageRecord[usageRecord.size() - 1].imageLayout, dstAccessFlags);
 }
\ No newline at end of file
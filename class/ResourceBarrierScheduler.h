@@ -43,6 +43,18 @@ public:
 		VkAccessFlags dstAccessFlags
 	);
 
+	// Release on "pSrcCmdBuffer" and acquire on "pDstCmdBuffer", image layout stays the same, following usages change it if needed
+	void TransferQueueOwnership
+	(
+		const std::shared_ptr<CommandBuffer>& pSrcCmdBuffer,
+		const std::shared_ptr<CommandBuffer>& pDstCmdBuffer,
+		const std::shared_ptr<VKGPUSyncRes>& pResource,
+		PhysicalDevice::QueueFamily	srcQueueFamily,
+		PhysicalDevice::QueueFamily	dstQueueFamily,
+		VkPipelineStageFlags dstPipelineStageFlags,
+		VkAccessFlags dstAccessFlags
+	);
+
 protected:
 	static bool IsAccessWrite(VkAccessFlags accessFlags);
 
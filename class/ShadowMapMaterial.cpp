@@ -13,7 +13,7 @@
 #include "PerFrameResource.h"
 #include "../common/Util.h"
 
-std::shared_ptr<ShadowMapMaterial> ShadowMapMaterial::CreateDefaultMaterial(bool skinned)
+std::shared_ptr<ShadowMapMaterial> ShadowMapMaterial::CreateDefaultMaterial(uint32_t cascadeIndex, bool staticCache, bool skinned)
 {
 	SimpleMaterialCreateInfo simpleMaterialInfo = {};
 	std::wstring vert = skinned ? L"../data/shaders/shadow_map_gen_skinned.vert.spv" : L"../data/shaders/shadow_map_gen.vert.spv";
@@ -21,17 +21,40 @@ std::shared_ptr<ShadowMapMaterial> ShadowMapMaterial::CreateDefaultMaterial(bool
 	simpleMaterialInfo.vertexFormat = skinned ? (1 << VAFPosition) | (1 << VAFBone) : (1 << VAFPosition);
 	simpleMaterialInfo.vertexFormatInMem = skinned ? VertexFormatPNTCTB : VertexFormatPNTCT;
 	simpleMaterialInfo.subpassIndex = 0;
-	simpleMaterialInfo.frameBufferType = FrameBufferDiction::FrameBufferType_ShadowMap;
+	simpleMaterialInfo.frameBufferType = staticCache ? FrameBufferDiction::FrameBufferType_ShadowCache : FrameBufferDiction::FrameBufferType_ShadowMap;
 	simpleMaterialInfo.pRenderPass = RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShadowMap);
 	simpleMaterialInfo.depthTestEnable = false;
 	simpleMaterialInfo.depthWriteEnable = false;
 
+	return CreateMaterial(cascadeIndex, simpleMaterialInfo, false);
+}
+
+std::shared_ptr<ShadowMapMaterial> ShadowMapMaterial::CreateCacheClearMaterial(uint32_t cascadeIndex, bool cached)
+{
+	SimpleMaterialCreateInfo simpleMaterialInfo = {};
+	// Screen quad triangle is at depth 0 as well
+	std::wstring vert = cached ? L"../data/shaders/shadow_cache_clear.vert.spv" : L"../data/shaders/screen_quad.vert.spv";
+	simpleMaterialInfo.shaderPaths = { vert, L"", L"", L"", L"", L"" };
+	simpleMaterialInfo.vertexFormat = 0;
+	simpleMaterialInfo.vertexFormatInMem = 0;
+	simpleMaterialInfo.subpassIndex = 0;
+	simpleMaterialInfo.frameBufferType = FrameBufferDiction::FrameBufferType_ShadowCache;
+	simpleMaterialInfo.pRenderPass = RenderPassDiction::GetInstance()->GetPipelineRenderPass(RenderPassDiction::PipelineRenderPassShadowMap);
+	simpleMaterialInfo.depthTestEnable = false;
+	simpleMaterialInfo.depthWriteEnable = false;
+
+	return CreateMaterial(cascadeIndex, simpleMaterialInfo, true);
+}
+
+std::shared_ptr<ShadowMapMaterial> ShadowMapMaterial::CreateMaterial(uint32_t cascadeIndex, const SimpleMaterialCreateInfo& simpleMaterialInfo, bool cacheClear)
+{
 	std::shared_ptr<ShadowMapMaterial> pShadowMapMaterial = std::make_shared<ShadowMapMaterial>();
+	pShadowMapMaterial->m_cascadeIndex = cascadeIndex;
 
 	VkGraphicsPipelineCreateInfo createInfo = {};
 
 	std::vector<VkPipelineColorBlendAttachmentState> blendStatesInfo;
-	uint32_t colorTargetCount = (uint32_t)FrameBufferDiction::GetInstance()->GetFrameBuffer(FrameBufferDiction::FrameBufferType_ShadowMap)->GetColorTargets().size();
+	uint32_t colorTargetCount = (uint32_t)FrameBufferDiction::GetInstance()->GetFrameBuffer(simpleMaterialInfo.frameBufferType)->GetColorTargets().size();
 
 	for (uint32_t i = 0; i < colorTargetCount; i++)
 	{
@@ -62,7 +85,8 @@ std::shared_ptr<ShadowMapMaterial> ShadowMapMaterial::CreateDefaultMaterial(bool
 	depthStencilCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
 	depthStencilCreateInfo.depthTestEnable = true;
 	depthStencilCreateInfo.depthWriteEnable = true;
-	depthStencilCreateInfo.depthCompareOp = VK_COMPARE_OP_GREATER_OR_EQUAL;
+	// Clear overwrites whatever is cached
+	depthStencilCreateInfo.depthCompareOp = cacheClear ? VK_COMPARE_OP_ALWAYS : VK_COMPARE_OP_GREATER_OR_EQUAL;
 
 	VkPipelineInputAssemblyStateCreateInfo assemblyCreateInfo = {};
 	assemblyCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -75,12 +99,12 @@ std::shared_ptr<ShadowMapMaterial> ShadowMapMaterial::CreateDefaultMaterial(bool
 	VkPipelineRasterizationStateCreateInfo rasterizerCreateInfo = {};
 	rasterizerCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
 	rasterizerCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
-	rasterizerCreateInfo.cullMode = VK_CULL_MODE_FRONT_BIT;
+	rasterizerCreateInfo.cullMode = cacheClear ? VK_CULL_MODE_NONE : VK_CULL_MODE_FRONT_BIT;
 	rasterizerCreateInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
 	rasterizerCreateInfo.lineWidth = 1.0f;
 	rasterizerCreateInfo.depthClampEnable = VK_FALSE;
 	rasterizerCreateInfo.rasterizerDiscardEnable = VK_FALSE;
-	rasterizerCreateInfo.depthBiasEnable = VK_TRUE;
+	rasterizerCreateInfo.depthBiasEnable = cacheClear ? VK_FALSE : VK_TRUE;
 	rasterizerCreateInfo.depthBiasConstantFactor = 20000;
 	rasterizerCreateInfo.depthBiasClamp = 2;
 	rasterizerCreateInfo.depthBiasSlopeFactor = 0;
@@ -130,7 +154,26 @@ std::shared_ptr<ShadowMapMaterial> ShadowMapMaterial::CreateDefaultMaterial(bool
 	createInfo.subpass = simpleMaterialInfo.subpassIndex;
 	createInfo.renderPass = simpleMaterialInfo.pRenderPass->GetRenderPass()->GetDeviceHandle();
 
-	if (pShadowMapMaterial.get() && pShadowMapMaterial->Init(pShadowMapMaterial, simpleMaterialInfo.shaderPaths, simpleMaterialInfo.pRenderPass, createInfo, simpleMaterialInfo.materialUniformVars, simpleMaterialInfo.vertexFormat, simpleMaterialInfo.vertexFormatInMem, true))
+	// Cascade index, to pick its light matrix
+	std::vector<VkPushConstantRange> pushConstsRanges =
+	{
+		{ VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t) }
+	};
+
+	if (pShadowMapMaterial.get() && pShadowMapMaterial->Init(pShadowMapMaterial, simpleMaterialInfo.shaderPaths, simpleMaterialInfo.pRenderPass, createInfo, pushConstsRanges, simpleMaterialInfo.materialUniformVars, simpleMaterialInfo.vertexFormat, simpleMaterialInfo.vertexFormatInMem, true))
 		return pShadowMapMaterial;
 	return nullptr;
+}
+
+void ShadowMapMaterial::CustomizeCommandBuffer(const std::shared_ptr<CommandBuffer>& pSecondaryCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong)
+{
+	// Viewport of the whole frame buffer is replaced by tile of this cascade
+	uint32_t tileSize = pFrameBuffer->GetFramebufferInfo().width / FrameBufferDiction::SHADOW_CASCADE_ATLAS_DIM;
+	int32_t tileX = (int32_t)((m_cascadeIndex % FrameBufferDiction::SHADOW_CASCADE_ATLAS_DIM) * tileSize);
+	int32_t tileY = (int32_t)((m_cascadeIndex / FrameBufferDiction::SHADOW_CASCADE_ATLAS_DIM) * tileSize);
+
+	pSecondaryCmdBuf->SetViewports({ { (float)tileX, (float)tileY, (float)tileSize, (float)tileSize, 0, 1 } });
+	pSecondaryCmdBuf->SetScissors({ { { tileX, tileY }, { tileSize, tileSize } } });
+
+	pSecondaryCmdBuf->PushConstants(m_pPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(m_cascadeIndex), &m_cascadeIndex);
 }
\ No newline at end of file
@@ -4,11 +4,29 @@
 class ShadowMapMaterial : public Material
 {
 public:
-	static std::shared_ptr<ShadowMapMaterial> CreateDefaultMaterial(bool skinned = false);
+	// Every shadow cascade has its own material, so that its render queue only contains casters of this cascade
+	// All cascades render into their own tiles of the same shadow map
+	// Materials with "staticCache" render static casters into static shadow cache instead, it's copied into shadow map every frame
+	// Skinned casters are drawn the same way, with skinning targets written by "SkinningMaterial"
+	// Unless compute skinning isn't available, then materials with "skinned" skin casters in vertex shader
+	static std::shared_ptr<ShadowMapMaterial> CreateDefaultMaterial(uint32_t cascadeIndex, bool staticCache = false, bool skinned = false);
+	// Clears tile of a cascade in static shadow cache, if the cache of this cascade is re-rendered this frame
+	// Without "cached" the tile is cleared every frame by a plain screen quad, static casters have to be re-rendered every frame then
+	static std::shared_ptr<ShadowMapMaterial> CreateCacheClearMaterial(uint32_t cascadeIndex, bool cached = true);
 
 public:
+	uint32_t GetCascadeIndex() const { return m_cascadeIndex; }
+
 	void Draw(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false) override
 	{
 		DrawIndirect(pCmdBuf, pFrameBuffer, pingpong, overrideVP);
 	}
+
+protected:
+	static std::shared_ptr<ShadowMapMaterial> CreateMaterial(uint32_t cascadeIndex, const SimpleMaterialCreateInfo& simpleMaterialInfo, bool cacheClear);
+
+	void CustomizeCommandBuffer(const std::shared_ptr<CommandBuffer>& pSecondaryCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0) override;
+
+protected:
+	uint32_t	m_cascadeIndex = 0;
 };
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "SkinningJobUniforms.h"
+#include "../vulkan/DescriptorSet.h"
+#include "../vulkan/ShaderStorageBuffer.h"
+#include "Material.h"
+
+bool SkinningJobUniforms::Init(const std::shared_ptr<SkinningJobUniforms>& pSelf)
+{
+	if (!UniformDataStorage::Init(pSelf, sizeof(m_skinningJobs), PerFrameDataStorage::ShaderStorage))
+		return false;
+	return true;
+}
+
+std::shared_ptr<SkinningJobUniforms> SkinningJobUniforms::Create()
+{
+	std::shared_ptr<SkinningJobUniforms> pSkinningJobUniforms = std::make_shared<SkinningJobUniforms>();
+	if (pSkinningJobUniforms.get() && pSkinningJobUniforms->Init(pSkinningJobUniforms))
+		return pSkinningJobUniforms;
+	return nullptr;
+}
+
+void SkinningJobUniforms::UpdateDirtyChunkInternal(uint32_t index)
+{
+}
+
+std::vector<UniformVarList> SkinningJobUniforms::PrepareUniformVarList() const
+{
+	return
+	{
+		{
+			DynamicShaderStorageBuffer,
+			"SkinningJobs",
+			{
+				{ OneUnit, "Source vertex offset" },
+				{ OneUnit, "Skinned vertex offset" },
+				{ OneUnit, "Previous position offset" },
+				{ OneUnit, "Vertex count" },
+				{ OneUnit, "Per-animation chunk index" },
+				{ OneUnit, "First thread" },
+				{ OneUnit, "History valid" },
+				{ OneUnit, "Padding" },
+			}
+		}
+	};
+}
+
+uint32_t SkinningJobUniforms::SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const
+{
+	pDescriptorSet->UpdateShaderStorageBufferDynamic(bindingIndex++, std::dynamic_pointer_cast<ShaderStorageBuffer>(GetBuffer()));
+
+	return bindingIndex;
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "ChunkBasedUniforms.h"
+
+class DescriptorSet;
+
+// A skinning job skins all vertices of a skinned mesh with bones of one animation instance
+// Vertex offsets are in vertices, within vertex attribute buffers of source format, PNTCT format and position format respectively
+// A thread of skinning shader handles one vertex, threads of a job start from "firstThread"
+typedef struct _SkinningJob
+{
+	uint32_t srcVertexOffset = 0;
+	uint32_t dstVertexOffset = 0;
+	uint32_t prevVertexOffset = 0;
+	uint32_t vertexCount = 0;			// 0 terminates job list
+	uint32_t animationChunkIndex = 0;
+	uint32_t firstThread = 0;
+	uint32_t historyValid = 0;			// 0 if skinned vertices of last frame aren't available, previous positions are the same as current ones then
+	uint32_t padding = 0;
+}SkinningJob;
+
+class SkinningJobUniforms : public ChunkBasedUniforms
+{
+public:
+	// One slot is reserved for terminator
+	static const uint32_t MAX_JOB_COUNT = MAXIMUM_OBJECTS - 1;
+
+public:
+	bool Init(const std::shared_ptr<SkinningJobUniforms>& pSelf);
+	static std::shared_ptr<SkinningJobUniforms> Create();
+
+public:
+	void SetJob(uint32_t index, const SkinningJob& job) { m_skinningJobs[index] = job; SetChunkDirty(index); }
+	const SkinningJob& GetJob(uint32_t index) const { return m_skinningJobs[index]; }
+
+	std::vector<UniformVarList> PrepareUniformVarList() const override;
+	uint32_t SetupDescriptorSet(const std::shared_ptr<DescriptorSet>& pDescriptorSet, uint32_t bindingIndex) const override;
+
+protected:
+	void UpdateDirtyChunkInternal(uint32_t index) override;
+	const void* AcquireDataPtr() const override { return &m_skinningJobs[0]; }
+	uint32_t AcquireDataSize() const override { return sizeof(m_skinningJobs); }
+
+protected:
+	SkinningJob	m_skinningJobs[MAXIMUM_OBJECTS];
+};
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "SkinningMaterial.h"
+#include "../vulkan/DescriptorSet.h"
+#include "../vulkan/SwapChain.h"
+#include "../vulkan/GlobalDeviceObjects.h"
+#include "../vulkan/CommandBuffer.h"
+#include "../vulkan/SharedVertexBuffer.h"
+#include "../vulkan/SharedIndirectBuffer.h"
+#include "../common/Util.h"
+#include "FrameWorkManager.h"
+#include "Mesh.h"
+
+std::shared_ptr<SkinningMaterial> SkinningMaterial::CreateDefaultMaterial()
+{
+	std::shared_ptr<SkinningMaterial> pMaterial = std::make_shared<SkinningMaterial>();
+	if (pMaterial.get() && pMaterial->Init(pMaterial))
+		return pMaterial;
+	return nullptr;
+}
+
+bool SkinningMaterial::Init(const std::shared_ptr<SkinningMaterial>& pSelf)
+{
+	// Layout customization below depends on it
+	m_pSkinningJobUniforms = SkinningJobUniforms::Create();
+
+	VkComputePipelineCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+
+	// Group count is overridden by indirect dispatch
+	if (!Material::Init(pSelf, L"../data/shaders/skinning.comp.spv", createInfo, {}, {}, { 1, 1, 1 }))
+		return false;
+
+	uint32_t bindingIndex = m_pSkinningJobUniforms->SetupDescriptorSet(m_pUniformStorageDescriptorSet, 0);
+	m_pUniformStorageDescriptorSet->UpdateShaderStorageBuffer(bindingIndex++, VertexAttribBufferMgr(VertexFormatPNTCTB)->GetBuffer());
+	m_pUniformStorageDescriptorSet->UpdateShaderStorageBuffer(bindingIndex++, VertexAttribBufferMgr(VertexFormatPNTCT)->GetBuffer());
+	m_pUniformStorageDescriptorSet->UpdateShaderStorageBuffer(bindingIndex++, VertexAttribBufferMgr(VertexFormatP)->GetBuffer());
+
+	// Compute materials only have offsets of global uniforms, jobs are dynamic too
+	for (uint32_t frameIndex = 0; frameIndex < GetSwapChain()->GetSwapChainImageCount(); frameIndex++)
+		m_cachedFrameOffsets[frameIndex].push_back(m_pSkinningJobUniforms->GetFrameOffset() * frameIndex);
+
+	std::vector<VkDispatchIndirectCommand> dispatchArgs(GetSwapChain()->GetSwapChainImageCount(), { 0, 1, 1 });
+	m_pDispatchArgsBuffer = SharedIndirectBuffer::Create(GetDevice(), sizeof(VkDispatchIndirectCommand) * (uint32_t)dispatchArgs.size());
+	m_pDispatchArgsBuffer->UpdateByteStream(dispatchArgs.data(), 0, sizeof(VkDispatchIndirectCommand) * (uint32_t)dispatchArgs.size());
+
+	return true;
+}
+
+uint32_t SkinningMaterial::GetPrevPositionOffset(const std::shared_ptr<SharedVertexBuffer>& pPrevPositions)
+{
+	return pPrevPositions->GetBufferOffset() / GetVertexBytes(VertexFormatP);
+}
+
+void SkinningMaterial::AddJob
+(
+	const std::shared_ptr<Mesh>& pSkinnedMesh,
+	const std::shared_ptr<Mesh>& pTargetMesh,
+	const std::shared_ptr<SharedVertexBuffer>& pPrevPositions,
+	uint32_t animationChunkIndex,
+	bool historyValid
+)
+{
+	ASSERTION(m_skinningJobs.size() < SkinningJobUniforms::MAX_JOB_COUNT);
+	ASSERTION(pSkinnedMesh->GetVertexFormat() == VertexFormatPNTCTB && pTargetMesh->GetVertexFormat() == VertexFormatPNTCT);
+
+	SkinningJob job;
+	job.srcVertexOffset = pSkinnedMesh->GetVertexBuffer()->GetBufferOffset() / pSkinnedMesh->GetVertexBytes();
+	job.dstVertexOffset = pTargetMesh->GetVertexBuffer()->GetBufferOffset() / pTargetMesh->GetVertexBytes();
+	job.prevVertexOffset = GetPrevPositionOffset(pPrevPositions);
+	job.vertexCount = pSkinnedMesh->GetVerticesCount();
+	job.animationChunkIndex = animationChunkIndex;
+	job.firstThread = m_skinningJobs.empty() ? 0 : m_skinningJobs.back().firstThread + m_skinningJobs.back().vertexCount;
+	job.historyValid = historyValid ? 1 : 0;
+
+	m_skinningJobs.push_back(job);
+}
+
+void SkinningMaterial::SyncBufferData()
+{
+	Material::SyncBufferData();
+
+	for (uint32_t i = 0; i < (uint32_t)m_skinningJobs.size(); i++)
+		m_pSkinningJobUniforms->SetJob(i, m_skinningJobs[i]);
+
+	// Terminate job list, slots after it are stale and never read
+	m_pSkinningJobUniforms->SetJob((uint32_t)m_skinningJobs.size(), SkinningJob());
+
+	m_pSkinningJobUniforms->SyncBufferData();
+
+	uint32_t threadCount = m_skinningJobs.empty() ? 0 : m_skinningJobs.back().firstThread + m_skinningJobs.back().vertexCount;
+	VkDispatchIndirectCommand dispatchArgs = { (threadCount + GROUP_SIZE - 1) / GROUP_SIZE, 1, 1 };
+	m_pDispatchArgsBuffer->UpdateByteStream(&dispatchArgs, FrameWorkManager::GetInstance()->FrameIndex() * sizeof(VkDispatchIndirectCommand), sizeof(VkDispatchIndirectCommand));
+}
+
+void SkinningMaterial::Dispatch(const std::shared_ptr<CommandBuffer>& pCmdBuf, uint32_t pingpong)
+{
+	PrepareCommandBuffer(pCmdBuf, nullptr, true, pingpong, false);
+	pCmdBuf->DispatchIndirect(m_pDispatchArgsBuffer, FrameWorkManager::GetInstance()->FrameIndex());
+}
+
+void SkinningMaterial::OnFrameEnd()
+{
+	Material::OnFrameEnd();
+
+	// Jobs keep capacity, so they don't allocate next frame
+	m_skinningJobs.clear();
+}
+
+void SkinningMaterial::CustomizeMaterialLayout(std::vector<UniformVarList>& materialLayout)
+{
+	materialLayout.push_back(m_pSkinningJobUniforms->PrepareUniformVarList()[0]);
+	materialLayout.push_back({ StorageBuffer, "SkinnedMeshVertices", {} });
+	materialLayout.push_back({ StorageBuffer, "SkinnedVertices", {} });
+	materialLayout.push_back({ StorageBuffer, "PrevPositions", {} });
+}
+
+void SkinningMaterial::ClaimResourceUsage(const std::shared_ptr<CommandBuffer>& pCmdBuffer, const std::shared_ptr<ResourceBarrierScheduler>& pScheduler, uint32_t pingpong)
+{
+	if (pScheduler == nullptr)
+		return;
+
+	pScheduler->ClaimResourceUsage
+	(
+		pCmdBuffer,
+		VertexAttribBufferMgr(VertexFormatPNTCTB)->GetBuffer(),
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_IMAGE_LAYOUT_UNDEFINED,
+		VK_ACCESS_SHADER_READ_BIT
+	);
+
+	// Skinned vertices and previous positions are read before written, as positions are moved to previous ones
+	std::vector<std::shared_ptr<VKGPUSyncRes>> buffers = { VertexAttribBufferMgr(VertexFormatPNTCT)->GetBuffer(), VertexAttribBufferMgr(VertexFormatP)->GetBuffer() };
+	for (auto& pBuffer : buffers)
+	{
+		pScheduler->ClaimResourceUsage
+		(
+			pCmdBuffer,
+			pBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_IMAGE_LAYOUT_UNDEFINED,
+			VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+		);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include "Material.h"
+#include "SkinningJobUniforms.h"
+
+class Mesh;
+class SharedVertexBuffer;
+
+// Skinned meshes are skinned once per frame by compute, instead of by vertex shaders of every pass drawing them
+// Each skinned mesh renderer owns a skinning target, a mesh of PNTCT format sharing indices of skinned mesh,
+// so that gbuffer and shadow materials draw it the same way as a static mesh
+// Skinned positions of last frame are moved into a position buffer before being overwritten, gbuffer reads them for motion vectors
+// Jobs change every frame while commands are prebaked, so dispatch is indirect, with group count written along with jobs
+class SkinningMaterial : public Material
+{
+public:
+	static const uint32_t GROUP_SIZE = 64;
+
+public:
+	static std::shared_ptr<SkinningMaterial> CreateDefaultMaterial();
+
+public:
+	// Skin "pSkinnedMesh" with bones of animation chunk "animationChunkIndex" into "pTargetMesh" in current frame
+	// If "historyValid" is false, previous positions are set to the ones skinned this frame, e.g. target is just created
+	void AddJob
+	(
+		const std::shared_ptr<Mesh>& pSkinnedMesh,
+		const std::shared_ptr<Mesh>& pTargetMesh,
+		const std::shared_ptr<SharedVertexBuffer>& pPrevPositions,
+		uint32_t animationChunkIndex,
+		bool historyValid
+	);
+
+	void SyncBufferData() override;
+	void Draw(const std::shared_ptr<CommandBuffer>& pCmdBuf, const std::shared_ptr<FrameBuffer>& pFrameBuffer, uint32_t pingpong = 0, bool overrideVP = false) override {}
+	void Dispatch(const std::shared_ptr<CommandBuffer>& pCmdBuf, uint32_t pingpong = 0) override;
+	void OnFrameEnd() override;
+
+	// Vertex offset of previous positions of a skinning target, in position format vertex buffer
+	static uint32_t GetPrevPositionOffset(const std::shared_ptr<SharedVertexBuffer>& pPrevPositions);
+
+protected:
+	bool Init(const std::shared_ptr<SkinningMaterial>& pSelf);
+
+	void CustomizeMaterialLayout(std::vector<UniformVarList>& materialLayout) override;
+	void ClaimResourceUsage(const std::shared_ptr<CommandBuffer>& pCmdBuffer, const std::shared_ptr<ResourceBarrierScheduler>& pScheduler, uint32_t pingpong = 0) override;
+
+protected:
+	std::shared_ptr<SkinningJobUniforms>	m_pSkinningJobUniforms;
+	std::shared_ptr<SharedIndirectBuffer>	m_pDispatchArgsBuffer;
+	std::vector<SkinningJob>				m_skinningJobs;
+};
\ No newline at end of file
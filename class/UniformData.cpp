@@ -31,6 +31,7 @@ bool UniformData::Init()
 		case UniformStorageType::PerAnimationUniformBuffer:	m_uniformStorageBuffers[i] = PerAnimationUniforms::Create(); break;
 		case UniformStorageType::PerFrameBoneBuffer:		m_uniformStorageBuffers[i] = PerBoneUniforms::Create(); break;
 		case UniformStorageType::PerFrameVariableBuffer:	m_uniformStorageBuffers[i] = PerFrameUniforms::Create(); break;
+		case UniformStorageType::PerFrameLightBuffer:		m_uniformStorageBuffers[i] = PerFrameLightUniforms::Create(); break;
 		case UniformStorageType::PerObjectVariableBuffer:	m_uniformStorageBuffers[i] = PerObjectUniforms::Create(); break;
 		default:
 			break;
@@ -65,6 +66,11 @@ bool UniformData::Init()
 	return true;
 }
 
+void UniformData::UpdateGlobalTextureDescriptors()
+{
+	m_uniformTextures[GlobalUniformTextures]->SetupDescriptorSet(m_descriptorSets[GlobalUniformsLocation], m_globalTextureBindingSlot);
+}
+
 void UniformData::OnFrameBegin()
 {
 	GetGlobalTextures()->GenerateSkyBox(0);
@@ -72,6 +78,8 @@ void UniformData::OnFrameBegin()
 
 void UniformData::OnPostSceneTraversal()
 {
+	// Local lights are all collected during scene traversal
+	GetPerFrameLightUniforms()->BuildClusters();
 	SyncDataBuffer();
 }
 
@@ -131,6 +139,10 @@ void UniformData::BuildDescriptorSets()
 	std::vector<UniformVarList> perFrameBoneVars = m_uniformStorageBuffers[UniformStorageType::PerFrameBoneBuffer]->PrepareUniformVarList();
 	perFrameUniformVars.insert(perFrameUniformVars.end(), perFrameBoneVars.begin(), perFrameBoneVars.end());
 
+	// Setup per frame light var list
+	std::vector<UniformVarList> perFrameLightVars = m_uniformStorageBuffers[UniformStorageType::PerFrameLightBuffer]->PrepareUniformVarList();
+	perFrameUniformVars.insert(perFrameUniformVars.end(), perFrameLightVars.begin(), perFrameLightVars.end());
+
 	// Setup per object uniform var list
 	std::vector<UniformVarList> perObjectUniformVars = m_uniformStorageBuffers[UniformStorageType::PerObjectVariableBuffer]->PrepareUniformVarList();
 
@@ -243,12 +255,14 @@ void UniformData::BuildDescriptorSets()
 	bindingSlot = m_uniformStorageBuffers[PerMeshUniformBuffer]->SetupDescriptorSet(m_descriptorSets[GlobalUniformsLocation], bindingSlot);
 	bindingSlot = m_uniformStorageBuffers[PerPlanetBuffer]->SetupDescriptorSet(m_descriptorSets[GlobalUniformsLocation], bindingSlot);
 	bindingSlot = m_uniformStorageBuffers[PerAnimationUniformBuffer]->SetupDescriptorSet(m_descriptorSets[GlobalUniformsLocation], bindingSlot);
+	m_globalTextureBindingSlot = bindingSlot;
 	bindingSlot = m_uniformTextures[GlobalUniformTextures]->SetupDescriptorSet(m_descriptorSets[GlobalUniformsLocation], bindingSlot);
 
 	// 2. Per frame descriptor set
 	bindingSlot = 0;
 	bindingSlot = m_uniformStorageBuffers[PerFrameVariableBuffer]->SetupDescriptorSet(m_descriptorSets[PerFrameUniformsLocation], bindingSlot);
 	bindingSlot = m_uniformStorageBuffers[PerFrameBoneBuffer]->SetupDescriptorSet(m_descriptorSets[PerFrameUniformsLocation], bindingSlot);
+	bindingSlot = m_uniformStorageBuffers[PerFrameLightBuffer]->SetupDescriptorSet(m_descriptorSets[PerFrameUniformsLocation], bindingSlot);
 
 	// 3. Per object descriptor set
 	m_uniformStorageBuffers[PerObjectVariableBuffer]->SetupDescriptorSet(m_descriptorSets[PerObjectUniformsLocation], 0);
@@ -1,6 +1,7 @@
 #pragma once
 #include "GlobalUniforms.h"
 #include "PerFrameUniforms.h"
+#include "PerFrameLightUniforms.h"
 #include "PerObjectUniforms.h"
 #include "GBufferInputUniforms.h"
 #include "GlobalTextures.h"
@@ -37,6 +38,7 @@ public:
 		PerAnimationUniformBuffer,
 		PerFrameVariableBuffer,
 		PerFrameBoneBuffer,
+		PerFrameLightBuffer,
 		PerObjectVariableBuffer,
 		PerObjectMaterialVariableBuffer,
 		UniformStorageTypeCount
@@ -62,6 +64,7 @@ public:
 	std::shared_ptr<PerAnimationUniforms> GetPerAnimationUniforms() const { return std::dynamic_pointer_cast<PerAnimationUniforms>(m_uniformStorageBuffers[UniformStorageType::PerAnimationUniformBuffer]); }
 	std::shared_ptr<PerFrameUniforms> GetPerFrameUniforms() const { return std::dynamic_pointer_cast<PerFrameUniforms>(m_uniformStorageBuffers[UniformStorageType::PerFrameVariableBuffer]); }
 	std::shared_ptr<PerBoneUniforms> GetPerFrameBoneUniforms() const { return std::dynamic_pointer_cast<PerBoneUniforms>(m_uniformStorageBuffers[UniformStorageType::PerFrameBoneBuffer]); }
+	std::shared_ptr<PerFrameLightUniforms> GetPerFrameLightUniforms() const { return std::dynamic_pointer_cast<PerFrameLightUniforms>(m_uniformStorageBuffers[UniformStorageType::PerFrameLightBuffer]); }
 	std::shared_ptr<PerObjectUniforms> GetPerObjectUniforms() const { return std::dynamic_pointer_cast<PerObjectUniforms>(m_uniformStorageBuffers[UniformStorageType::PerObjectVariableBuffer]); }
 	std::shared_ptr<PerFrameDataStorage> GetUniformStorage(UniformStorageType uniformStorageType) const { return m_uniformStorageBuffers[uniformStorageType]; }
 	
@@ -75,6 +78,8 @@ public:
 
 	std::vector<std::shared_ptr<DescriptorSetLayout>> GetDescriptorSetLayouts() const { return m_descriptorSetLayouts; }
 	std::vector<std::shared_ptr<DescriptorSet>> GetDescriptorSets() const { return m_descriptorSets; }
+	// Rewrite global texture bindings after global textures are swapped, descriptor set must not be in use by gpu
+	void UpdateGlobalTextureDescriptors();
 
 public:
 	void OnFrameBegin() override;
@@ -95,4 +100,5 @@ protected:
 	std::vector<std::shared_ptr<DescriptorSet>>				m_descriptorSets;
 
 	std::vector<std::vector<uint32_t>>						m_cachedFrameOffsets;
+	uint32_t												m_globalTextureBindingSlot = 0;
 };
\ No newline at end of file
@@ -0,0 +1,353 @@
+#include "AllocationTracker.h"
+#include <atomic>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#if defined(_WIN32)
+#include <windows.h>
+#include <dbghelp.h>
+#pragma comment(lib, "dbghelp.lib")
+#endif
+
+static const char* PHASE_NAMES[] = { "Setup", "FrameBegin", "PostSceneTraversal", "PreCmdPreparation", "PreCmdSubmission", "FrameEnd" };
+
+typedef struct _CallSite
+{
+	bool		used;
+	uint32_t	hash;
+	uint32_t	depth;
+	void*		frames[AllocationTracker::CALL_STACK_DEPTH];
+	uint64_t	count;
+	uint64_t	bytes;
+}CallSite;
+
+typedef struct _BenchmarkState
+{
+	bool		active;
+	bool		done;
+	bool		passed;
+	uint32_t	warmupFrames;
+	uint32_t	measureFrames;
+	uint32_t	maxAllocationsPerFrame;
+	uint32_t	measuredFrames;
+	uint32_t	failedFrames;
+	uint64_t	worstFrameAllocations;
+	uint64_t	totalAllocations;
+	uint64_t	totalBytes;
+}BenchmarkState;
+
+// Everything here is statically zero initialized, so it's valid even for allocations happening before dynamic initialization
+static std::atomic<uint32_t>	g_phase;
+static std::atomic<uint64_t>	g_allocationCount[AllocationTracker::PhaseCount];
+static std::atomic<uint64_t>	g_allocationBytes[AllocationTracker::PhaseCount];
+
+static std::atomic_flag			g_callSiteLock = ATOMIC_FLAG_INIT;
+static CallSite					g_callSites[AllocationTracker::MAX_CALL_SITE_COUNT];
+static uint64_t					g_droppedCallSiteCount;
+
+static AllocationTracker::FrameStats	g_lastFrameStats;
+static AllocationTracker::FrameStats	g_intervalStats;
+static uint32_t							g_frameCount;
+static uint32_t							g_intervalFrameCount;
+static BenchmarkState					g_benchmark;
+
+// Allocations made by tracker itself(reporting, symbolizing) are ignored
+static thread_local bool		t_inTracker;
+
+static uint64_t SumCount(const AllocationTracker::FrameStats& stats)
+{
+	uint64_t sum = 0;
+	for (uint32_t i = 0; i < AllocationTracker::PhaseCount; i++)
+		sum += stats.allocationCount[i];
+	return sum;
+}
+
+static uint64_t SumBytes(const AllocationTracker::FrameStats& stats)
+{
+	uint64_t sum = 0;
+	for (uint32_t i = 0; i < AllocationTracker::PhaseCount; i++)
+		sum += stats.allocationBytes[i];
+	return sum;
+}
+
+static void PrintCallStackFrame(void* pAddress)
+{
+	std::cout << "\t\t";
+#if defined(_WIN32)
+	static bool symbolsInitialized = false;
+	HANDLE process = GetCurrentProcess();
+	if (!symbolsInitialized)
+	{
+		SymSetOptions(SYMOPT_UNDNAME | SYMOPT_DEFERRED_LOADS | SYMOPT_LOAD_LINES);
+		SymInitialize(process, NULL, TRUE);
+		symbolsInitialized = true;
+	}
+
+	char buffer[sizeof(SYMBOL_INFO) + MAX_SYM_NAME];
+	SYMBOL_INFO* pSymbol = (SYMBOL_INFO*)buffer;
+	pSymbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+	pSymbol->MaxNameLen = MAX_SYM_NAME;
+	DWORD64 displacement = 0;
+
+	IMAGEHLP_LINE64 line = {};
+	line.SizeOfStruct = sizeof(line);
+	DWORD lineDisplacement = 0;
+
+	if (SymFromAddr(process, (DWORD64)pAddress, &displacement, pSymbol))
+		std::cout << pSymbol->Name;
+	else
+		std::cout << pAddress;
+
+	if (SymGetLineFromAddr64(process, (DWORD64)pAddress, &lineDisplacement, &line))
+		std::cout << " (" << line.FileName << ":" << line.LineNumber << ")";
+#else
+	std::cout << pAddress;
+#endif
+	std::cout << "\n";
+}
+
+bool AllocationTracker::IsCompiledIn()
+{
+#if defined(ALLOCATION_TRACKING)
+	return true;
+#else
+	return false;
+#endif
+}
+
+void AllocationTracker::SetPhase(Phase phase)
+{
+	g_phase.store(phase, std::memory_order_relaxed);
+}
+
+void AllocationTracker::RecordAllocation(std::size_t numBytes)
+{
+	if (t_inTracker)
+		return;
+
+	uint32_t phase = g_phase.load(std::memory_order_relaxed);
+	g_allocationCount[phase].fetch_add(1, std::memory_order_relaxed);
+	g_allocationBytes[phase].fetch_add(numBytes, std::memory_order_relaxed);
+
+	void* frames[CALL_STACK_DEPTH] = {};
+	uint32_t depth = 0;
+	uint32_t hash = 0;
+#if defined(_WIN32)
+	// Skip this function and operator new
+	DWORD backTraceHash = 0;
+	depth = CaptureStackBackTrace(2, CALL_STACK_DEPTH, frames, &backTraceHash);
+	hash = backTraceHash;
+#endif
+
+	while (g_callSiteLock.test_and_set(std::memory_order_acquire));
+
+	uint32_t index = hash % MAX_CALL_SITE_COUNT;
+	bool recorded = false;
+	for (uint32_t i = 0; i < MAX_CALL_SITE_COUNT; i++, index = (index + 1) % MAX_CALL_SITE_COUNT)
+	{
+		CallSite& site = g_callSites[index];
+		if (!site.used)
+		{
+			site.used = true;
+			site.hash = hash;
+			site.depth = depth;
+			memcpy(site.frames, frames, sizeof(frames));
+		}
+		else if (site.hash != hash || site.depth != depth || memcmp(site.frames, frames, sizeof(frames)) != 0)
+			continue;
+
+		site.count++;
+		site.bytes += numBytes;
+		recorded = true;
+		break;
+	}
+
+	if (!recorded)
+		g_droppedCallSiteCount++;
+
+	g_callSiteLock.clear(std::memory_order_release);
+}
+
+void AllocationTracker::ClearCallSites()
+{
+	while (g_callSiteLock.test_and_set(std::memory_order_acquire));
+	memset(g_callSites, 0, sizeof(g_callSites));
+	g_droppedCallSiteCount = 0;
+	g_callSiteLock.clear(std::memory_order_release);
+}
+
+void AllocationTracker::NewFrame()
+{
+	t_inTracker = true;
+
+	for (uint32_t i = 0; i < PhaseCount; i++)
+	{
+		g_lastFrameStats.allocationCount[i] = g_allocationCount[i].exchange(0, std::memory_order_relaxed);
+		g_lastFrameStats.allocationBytes[i] = g_allocationBytes[i].exchange(0, std::memory_order_relaxed);
+	}
+
+	// Stats closed at the first frame are setup allocations
+	if (g_frameCount++ == 0)
+	{
+		if (IsCompiledIn())
+			std::cout << "Setup heap allocations: " << SumCount(g_lastFrameStats) << ", bytes: " << SumBytes(g_lastFrameStats) << "\n";
+		if (g_benchmark.active && g_benchmark.warmupFrames == 0)
+			ClearCallSites();
+		t_inTracker = false;
+		return;
+	}
+
+	uint64_t frameAllocations = SumCount(g_lastFrameStats);
+	uint32_t frameNumber = g_frameCount - 1;
+
+	if (g_benchmark.active && !g_benchmark.done)
+	{
+		if (frameNumber == g_benchmark.warmupFrames)
+			ClearCallSites();
+		else if (frameNumber > g_benchmark.warmupFrames)
+		{
+			g_benchmark.measuredFrames++;
+			g_benchmark.totalAllocations += frameAllocations;
+			g_benchmark.totalBytes += SumBytes(g_lastFrameStats);
+			g_benchmark.worstFrameAllocations = (std::max)(g_benchmark.worstFrameAllocations, frameAllocations);
+			if (frameAllocations > g_benchmark.maxAllocationsPerFrame)
+				g_benchmark.failedFrames++;
+
+			if (g_benchmark.measuredFrames == g_benchmark.measureFrames)
+			{
+				g_benchmark.done = true;
+				g_benchmark.passed = g_benchmark.failedFrames == 0;
+
+				std::cout << "Allocation benchmark " << (g_benchmark.passed ? "PASSED" : "FAILED")
+					<< ": " << g_benchmark.measuredFrames << " steady state frames"
+					<< ", " << g_benchmark.failedFrames << " frames over budget of " << g_benchmark.maxAllocationsPerFrame
+					<< ", worst frame: " << g_benchmark.worstFrameAllocations
+					<< ", average: " << (double)g_benchmark.totalAllocations / g_benchmark.measuredFrames << " allocations, "
+					<< (double)g_benchmark.totalBytes / g_benchmark.measuredFrames << " bytes\n";
+				Report(16);
+			}
+		}
+	}
+	else if (IsCompiledIn() && !g_benchmark.active)
+	{
+		for (uint32_t i = 0; i < PhaseCount; i++)
+		{
+			g_intervalStats.allocationCount[i] += g_lastFrameStats.allocationCount[i];
+			g_intervalStats.allocationBytes[i] += g_lastFrameStats.allocationBytes[i];
+		}
+
+		if (++g_intervalFrameCount == REPORT_FRAME_INTERVAL)
+		{
+			std::cout << "Heap allocations over last " << REPORT_FRAME_INTERVAL << " frames, per frame:\n";
+			for (uint32_t i = 0; i < PhaseCount; i++)
+			{
+				std::cout << "\t" << PHASE_NAMES[i] << ": "
+					<< (double)g_intervalStats.allocationCount[i] / REPORT_FRAME_INTERVAL << " allocations, "
+					<< (double)g_intervalStats.allocationBytes[i] / REPORT_FRAME_INTERVAL << " bytes\n";
+			}
+			Report(8);
+			ClearCallSites();
+
+			g_intervalStats = {};
+			g_intervalFrameCount = 0;
+		}
+	}
+
+	t_inTracker = false;
+}
+
+void AllocationTracker::StartBenchmark(uint32_t warmupFrames, uint32_t measureFrames, uint32_t maxAllocationsPerFrame)
+{
+	g_benchmark = {};
+	g_benchmark.active = true;
+	g_benchmark.warmupFrames = warmupFrames;
+	g_benchmark.measureFrames = (std::max)(1u, measureFrames);
+	g_benchmark.maxAllocationsPerFrame = maxAllocationsPerFrame;
+
+	if (!IsCompiledIn())
+		std::cout << "Allocation benchmark requested, but allocation tracking isn't compiled in, rebuild with ALLOCATION_TRACKING\n";
+}
+
+bool AllocationTracker::IsBenchmarkDone()
+{
+	return g_benchmark.done;
+}
+
+bool AllocationTracker::IsBenchmarkPassed()
+{
+	return g_benchmark.passed;
+}
+
+const AllocationTracker::FrameStats& AllocationTracker::GetLastFrameStats()
+{
+	return g_lastFrameStats;
+}
+
+void AllocationTracker::Report(uint32_t topCallSiteCount)
+{
+	bool inTracker = t_inTracker;
+	t_inTracker = true;
+
+	std::cout << "Last frame heap allocations:\n";
+	for (uint32_t i = 0; i < PhaseCount; i++)
+		std::cout << "\t" << PHASE_NAMES[i] << ": " << g_lastFrameStats.allocationCount[i] << " allocations, " << g_lastFrameStats.allocationBytes[i] << " bytes\n";
+
+	std::vector<CallSite> sites;
+	while (g_callSiteLock.test_and_set(std::memory_order_acquire));
+	for (uint32_t i = 0; i < MAX_CALL_SITE_COUNT; i++)
+	{
+		if (g_callSites[i].used)
+			sites.push_back(g_callSites[i]);
+	}
+	uint64_t droppedCallSiteCount = g_droppedCallSiteCount;
+	g_callSiteLock.clear(std::memory_order_release);
+
+	std::sort(sites.begin(), sites.end(), [](const CallSite& a, const CallSite& b) { return a.count > b.count; });
+
+	std::cout << "Top call sites(" << sites.size() << " in total, " << droppedCallSiteCount << " allocations dropped as table is full):\n";
+	for (uint32_t i = 0; i < (std::min)((uint32_t)sites.size(), topCallSiteCount); i++)
+	{
+		std::cout << "\t" << sites[i].count << " allocations, " << sites[i].bytes << " bytes\n";
+		for (uint32_t j = 0; j < sites[i].depth; j++)
+			PrintCallStackFrame(sites[i].frames[j]);
+	}
+
+	t_inTracker = inTracker;
+}
+
+#if defined(ALLOCATION_TRACKING)
+void* operator new(std::size_t numBytes)
+{
+	AllocationTracker::RecordAllocation(numBytes);
+	void* pData = std::malloc(numBytes == 0 ? 1 : numBytes);
+	if (pData == nullptr)
+		throw std::bad_alloc();
+	return pData;
+}
+
+void* operator new[](std::size_t numBytes)
+{
+	return operator new(numBytes);
+}
+
+void* operator new(std::size_t numBytes, const std::nothrow_t&) noexcept
+{
+	AllocationTracker::RecordAllocation(numBytes);
+	return std::malloc(numBytes == 0 ? 1 : numBytes);
+}
+
+void* operator new[](std::size_t numBytes, const std::nothrow_t& tag) noexcept
+{
+	return operator new(numBytes, tag);
+}
+
+void operator delete(void* pData) noexcept { std::free(pData); }
+void operator delete[](void* pData) noexcept { std::free(pData); }
+void operator delete(void* pData, std::size_t) noexcept { std::free(pData); }
+void operator delete[](void* pData, std::size_t) noexcept { std::free(pData); }
+void operator delete(void* pData, const std::nothrow_t&) noexcept { std::free(pData); }
+void operator delete[](void* pData, const std::nothrow_t&) noexcept { std::free(pData); }
+#endif
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// Opt-in tracker of global heap allocations
+// Global operator new is only replaced when built with ALLOCATION_TRACKING(cmake option of the same name), otherwise counters stay 0
+// Every allocation is attributed to current frame phase, phases follow events of FrameEventManager,
+// and to its call site, which is a short captured call stack, symbolized only when reported
+class AllocationTracker
+{
+public:
+	enum Phase
+	{
+		Setup,					// Before first frame
+		FrameBegin,				// Scene update and culling
+		PostSceneTraversal,		// Uniform and material data sync
+		PreCmdPreparation,		// Command recording
+		PreCmdSubmission,		// Submission and present
+		FrameEnd,				// Frame end listeners and next image acquire
+		PhaseCount
+	};
+
+	typedef struct _FrameStats
+	{
+		uint64_t	allocationCount[PhaseCount];
+		uint64_t	allocationBytes[PhaseCount];
+	}FrameStats;
+
+	static const uint32_t MAX_CALL_SITE_COUNT = 4096;
+	static const uint32_t CALL_STACK_DEPTH = 8;
+	static const uint32_t REPORT_FRAME_INTERVAL = 600;
+
+public:
+	static bool IsCompiledIn();
+
+	static void SetPhase(Phase phase);
+	// Called when a new frame begins, it closes stats of previous frame
+	static void NewFrame();
+
+	// Skip "warmupFrames", then every one of following "measureFrames" must not exceed "maxAllocationsPerFrame"
+	// Call sites are cleared when warm up is done, so that report only shows steady state offenders
+	static void StartBenchmark(uint32_t warmupFrames, uint32_t measureFrames, uint32_t maxAllocationsPerFrame);
+	static bool IsBenchmarkDone();
+	static bool IsBenchmarkPassed();
+
+	static const FrameStats& GetLastFrameStats();
+	static void Report(uint32_t topCallSiteCount);
+
+	// Called by replaced operator new
+	static void RecordAllocation(std::size_t numBytes);
+
+protected:
+	static void ClearCallSites();
+};
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "FrameArena.h"
+#include "Macros.h"
+#include <memory>
+#include <mutex>
+
+class LinearArena
+{
+	typedef struct _Block
+	{
+		uint8_t*	pData;
+		std::size_t	size;
+	}Block;
+
+public:
+	~LinearArena()
+	{
+		for (auto& block : m_blocks)
+			::operator delete(block.pData);
+	}
+
+	void* Allocate(std::size_t numBytes, std::size_t alignment, bool& heapAllocated)
+	{
+		heapAllocated = false;
+
+		while (m_currentBlock < m_blocks.size())
+		{
+			Block& block = m_blocks[m_currentBlock];
+			uintptr_t start = ((uintptr_t)block.pData + m_offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+			if (start + numBytes <= (uintptr_t)block.pData + block.size)
+			{
+				m_offset = start + numBytes - (uintptr_t)block.pData;
+				return (void*)start;
+			}
+
+			// Rest of current block is wasted until next reset
+			m_currentBlock++;
+			m_offset = 0;
+		}
+
+		// Allocation larger than a block gets a dedicated one, it's kept and reused as well
+		std::size_t blockSize = FrameArena::BLOCK_SIZE;
+		if (numBytes + alignment > blockSize)
+			blockSize = numBytes + alignment;
+		m_blocks.push_back({ (uint8_t*)::operator new(blockSize), blockSize });
+		heapAllocated = true;
+
+		Block& block = m_blocks.back();
+		m_currentBlock = (uint32_t)m_blocks.size() - 1;
+		uintptr_t start = ((uintptr_t)block.pData + alignment - 1) & ~(uintptr_t)(alignment - 1);
+		m_offset = start + numBytes - (uintptr_t)block.pData;
+		return (void*)start;
+	}
+
+	void Reset()
+	{
+		m_currentBlock = 0;
+		m_offset = 0;
+	}
+
+	std::size_t GetBlockSize() const { return m_blocks.empty() ? 0 : m_blocks.back().size; }
+
+private:
+	std::vector<Block>	m_blocks;
+	uint32_t			m_currentBlock = 0;
+	std::size_t			m_offset = 0;
+};
+
+class ThreadArenas
+{
+public:
+	LinearArena	arenas[FrameArena::MAX_FRAME_COUNT];
+};
+
+// Registry is only touched when a thread allocates for the first time and when a frame is reset
+static std::mutex								g_registryMutex;
+static std::vector<std::unique_ptr<ThreadArenas>>	g_threadArenas;
+static thread_local ThreadArenas*				t_pThreadArenas = nullptr;
+
+std::atomic<uint32_t>		FrameArena::m_frameIndex(0);
+std::atomic<uint32_t>		FrameArena::m_heapAllocationCount(0);
+std::atomic<std::size_t>	FrameArena::m_reservedBytes(0);
+uint32_t					FrameArena::m_lastFrameHeapAllocationCount = 0;
+
+void FrameArena::BeginFrame(uint32_t frameIndex)
+{
+	ASSERTION(frameIndex < MAX_FRAME_COUNT);
+
+	Reset(frameIndex);
+
+	m_lastFrameHeapAllocationCount = m_heapAllocationCount.exchange(0);
+	m_frameIndex.store(frameIndex, std::memory_order_relaxed);
+}
+
+void FrameArena::Reset(uint32_t frameIndex)
+{
+	std::unique_lock<std::mutex> lock(g_registryMutex);
+	for (auto& pThreadArenas : g_threadArenas)
+		pThreadArenas->arenas[frameIndex].Reset();
+}
+
+void* FrameArena::Allocate(std::size_t numBytes, std::size_t alignment)
+{
+	if (t_pThreadArenas == nullptr)
+	{
+		std::unique_lock<std::mutex> lock(g_registryMutex);
+		g_threadArenas.push_back(std::make_unique<ThreadArenas>());
+		t_pThreadArenas = g_threadArenas.back().get();
+	}
+
+	LinearArena& arena = t_pThreadArenas->arenas[m_frameIndex.load(std::memory_order_relaxed)];
+
+	bool heapAllocated;
+	void* pData = arena.Allocate(numBytes, alignment, heapAllocated);
+	if (heapAllocated)
+	{
+		m_heapAllocationCount.fetch_add(1, std::memory_order_relaxed);
+		m_reservedBytes.fetch_add(arena.GetBlockSize(), std::memory_order_relaxed);
+	}
+	return pData;
+}
\ No newline at end of file
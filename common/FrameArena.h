@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Linear arena for transient cpu data that lives no longer than one frame
+// Each thread owns one arena per frame in flight, an allocation bumps a pointer inside the calling thread's own blocks and takes no lock
+// Individual deallocation does nothing, arena of a frame is rewound as a whole once that frame's fence is signaled,
+// blocks are kept for reuse, so after a few warm up frames transient containers don't touch heap any more
+// NOTE: Anything allocated from here must be released before the same frame index comes back
+class FrameArena
+{
+public:
+	static const uint32_t		MAX_FRAME_COUNT = 8;
+	static const std::size_t	BLOCK_SIZE = 256 * 1024;
+
+public:
+	// Called by FrameWorkManager on main thread, after waiting for fence of "frameIndex", no worker should be running at this point
+	static void BeginFrame(uint32_t frameIndex);
+
+	static void* Allocate(std::size_t numBytes, std::size_t alignment);
+	static uint32_t GetFrameIndex() { return m_frameIndex.load(std::memory_order_relaxed); }
+
+	// Heap allocations performed by all arenas during last frame, it should stay 0 in steady state
+	static uint32_t GetLastFrameHeapAllocationCount() { return m_lastFrameHeapAllocationCount; }
+	// Heap bytes held by all arenas of all threads
+	static std::size_t GetReservedBytes() { return m_reservedBytes.load(std::memory_order_relaxed); }
+
+protected:
+	static void Reset(uint32_t frameIndex);
+
+protected:
+	static std::atomic<uint32_t>	m_frameIndex;
+	static std::atomic<uint32_t>	m_heapAllocationCount;
+	static std::atomic<std::size_t>	m_reservedBytes;
+	static uint32_t					m_lastFrameHeapAllocationCount;
+};
+
+// Stateless stl allocator backed by calling thread's arena of current frame
+template <typename T>
+class FrameAllocator
+{
+public:
+	typedef T value_type;
+
+	FrameAllocator() {}
+	template <typename U>
+	FrameAllocator(const FrameAllocator<U>&) {}
+
+	T* allocate(std::size_t count) { return (T*)FrameArena::Allocate(count * sizeof(T), alignof(T)); }
+	void deallocate(T*, std::size_t) {}
+
+	template <typename U>
+	bool operator == (const FrameAllocator<U>&) const { return true; }
+	template <typename U>
+	bool operator != (const FrameAllocator<U>&) const { return false; }
+};
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
\ No newline at end of file
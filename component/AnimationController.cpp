@@ -115,6 +115,13 @@ void AnimationController::OnPreRender()
 	m_pMeshRenderer->OverrideModelMatrix(GetBaseObject()->GetCachedWorldTransform());
 }
 
+void AnimationController::OnCachedDataUpdated(const Matrix4d& cachedWorldTransform)
+{
+	// Mesh renderer is drawn with model matrix of this object, so are its bounds
+	if (m_pMeshRenderer != nullptr)
+		m_pMeshRenderer->UpdateAnimatedWorldBounds(cachedWorldTransform);
+}
+
 void AnimationController::SyncBoneTransformToUniform(const std::shared_ptr<BaseObject>& pObject, uint32_t boneIndex, const DualQuaterniond& boneOffsetDQ)
 {
 	Matrix4d transform = GetBaseObject()->GetCachedWorldTransform();
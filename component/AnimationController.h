@@ -24,6 +24,7 @@ public:
 public:
 	void Update() override;
 	void OnPreRender() override;
+	void OnCachedDataUpdated(const Matrix4d& cachedWorldTransform) override;
 
 protected:
 	bool Init(const std::shared_ptr<AnimationController>& pAnimationController, const std::shared_ptr<SkeletonAnimationInstance>& pAnimationInstance = nullptr);
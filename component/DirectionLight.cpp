@@ -8,31 +8,34 @@
 #include "../class/UniformData.h"
 #include "../vulkan/GlobalDeviceObjects.h"
 #include "PhysicalCamera.h"
+#include "../class/FramePipeline.h"
+#include "../class/FrameBufferDiction.h"
 
-const double DirectionLight::DEFAULT_SHADOWMAP_SIZE = 512;
-const double DirectionLight::DEFAULT_FRUSTUM_SIZE = 2.56;
-const double DirectionLight::DEFAULT_FRUSTUM_LENGTH = 5.12;
+const double DirectionLight::DEFAULT_SHADOW_DISTANCE = 16.0;
+const double DirectionLight::DEFAULT_CASTER_EXTENSION = 5.12;
+const double DirectionLight::DEFAULT_SPLIT_LAMBDA = 0.75;
 
 DEFINITE_CLASS_RTTI(DirectionLight, BaseComponent);
 
-bool DirectionLight::Init(const std::shared_ptr<DirectionLight>& pLight, const Vector3d& lightColor, const Vector3d& frustumSize, const Vector2ui& shadowMapSize)
+bool DirectionLight::Init(const std::shared_ptr<DirectionLight>& pLight, const Vector3d& lightColor, double shadowDistance, double casterExtension)
 {
 	if (!BaseComponent::Init(pLight))
 		return false;
 
 	SetLightColor(lightColor);
-	m_frustumSize = frustumSize;
-	m_shadowMapSize = shadowMapSize;
+	m_shadowDistance = shadowDistance;
+	m_casterExtension = casterExtension;
+	m_splitLambda = DEFAULT_SPLIT_LAMBDA;
 
 	m_targetLightDirectionChanged = false;
 
 	return true;
 }
 
-std::shared_ptr<DirectionLight> DirectionLight::Create(const Vector3d& lightColor, const Vector3d& frustumSize, const Vector2ui& shadowMapSize)
+std::shared_ptr<DirectionLight> DirectionLight::Create(const Vector3d& lightColor, double shadowDistance, double casterExtension)
 {
 	std::shared_ptr<DirectionLight> pLight = std::make_shared<DirectionLight>();
-	if (pLight.get() && pLight->Init(pLight, lightColor, frustumSize, shadowMapSize))
+	if (pLight.get() && pLight->Init(pLight, lightColor, shadowDistance, casterExtension))
 	{
 		InputHub::GetInstance()->Register(pLight);
 		return pLight;
@@ -43,40 +46,101 @@ std::shared_ptr<DirectionLight> DirectionLight::Create(const Vector3d& lightColo
 
 void DirectionLight::UpdateData()
 {
-	std::shared_ptr<BaseObject> pObj = GetBaseObject();
-
-	Matrix4d proj;
-	proj.c00 = 1.0 / m_frustumSize.x;
-
-	// Reverse y top side down for vulkan ndc
-	proj.c11 = -1.0 / m_frustumSize.y;
-
-	// -1 <= z / fz <= 1
-	// 0 <= z / fz + 1 <= 2
-	// 0 <= 0.5(z / fz + 1) <= 1
-	// 0 <= 0.5z / fz + 0.5 <= 1
-	// Convert to range 0~1 for vulkan ndc depth
-	proj.c22 = 0.5 / m_frustumSize.z;
-	proj.c32 = 0.5;
-
-	// 3rd step: get light projection matrix
-	m_cs2lsProjMatrix = proj;
-
 	// light space 2 world space
-	Matrix4d ls2ws = pObj->GetCachedWorldTransform();
+	Matrix4d ls2ws = GetBaseObject()->GetCachedWorldTransform();
 	// light direction in world space
 	m_wsLightDirection = ls2ws[2].xyz();
 	// light direction in camera space
 	m_csLightDirection = UniformData::GetInstance()->GetPerFrameUniforms()->GetViewMatrix().TransformAsVector(m_wsLightDirection);
 
-	// 2nd step: from world space 2 light space
-	m_cs2lsProjMatrix *= ls2ws.Inverse();
+	UpdateCascades();
+}
 
-	// 1st step: from camera space 2 world space
-	// final = 3rd * 2nd * 1st
-	// final matrix transforms vertices from camera space 2 light space and then to light ndc
+void DirectionLight::UpdateCascades()
+{
 	// FIXME: should use camera world transform instead of acquiring it from per frame uniform, since it could be results from last frame
-	m_cs2lsProjMatrix *= UniformData::GetInstance()->GetPerFrameUniforms()->GetViewCoordinateSystem();
+	Matrix4d cs2ws = UniformData::GetInstance()->GetPerFrameUniforms()->GetViewCoordinateSystem();
+
+	double nearPlane = UniformData::GetInstance()->GetPerFrameUniforms()->GetNearFarAB().x;
+	double farPlane = UniformData::GetInstance()->GetPerFrameUniforms()->GetNearFarAB().y;
+	farPlane = farPlane < m_shadowDistance ? farPlane : m_shadowDistance;
+
+	double tangentH = UniformData::GetInstance()->GetGlobalUniforms()->GetMainCameraHorizontalTangentFOV_2();
+	double tangentV = UniformData::GetInstance()->GetGlobalUniforms()->GetMainCameraVerticalTangentFOV_2();
+	// Squared ratio between distance of a frustum corner to view axis and its depth
+	double k2 = tangentH * tangentH + tangentV * tangentV;
+
+	// Only rotation of light object matters, cascades are placed around view frustum slices
+	Matrix3d ls2wsRotation = GetBaseObject()->GetCachedWorldTransform().RotationMatrix();
+	Matrix3d ws2lsRotation = ls2wsRotation;
+	ws2lsRotation.Transpose();
+
+	double sliceNear = nearPlane;
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+	{
+		// Practical split scheme, blending logarithmic and uniform split distances
+		double ratio = (i + 1) / (double)SHADOW_CASCADE_COUNT;
+		double logSplit = nearPlane * pow(farPlane / nearPlane, ratio);
+		double uniformSplit = nearPlane + (farPlane - nearPlane) * ratio;
+		double sliceFar = m_splitLambda * logSplit + (1.0 - m_splitLambda) * uniformSplit;
+
+		// Smallest bounding sphere of frustum slice, its center is on view axis, where distances to near and far corners are equal
+		// Sphere doesn't change with camera rotation, so does cascade size, which keeps shadow from shimmering
+		double centerDepth = (sliceNear + sliceFar) * (1.0 + k2) * 0.5;
+		centerDepth = centerDepth < sliceFar ? centerDepth : sliceFar;
+		double radius = sqrt((sliceFar - centerDepth) * (sliceFar - centerDepth) + sliceFar * sliceFar * k2);
+
+		Vector3d lsCenter = ws2lsRotation * cs2ws.TransformAsPoint({ 0, 0, -centerDepth });
+
+		// Snap cascade center to shadow map texels, so that static casters are rasterized the same when camera moves
+		double texelSize = radius * 2.0 / FrameBufferDiction::SHADOW_GEN_WINDOW_SIZE;
+		lsCenter.x = floor(lsCenter.x / texelSize) * texelSize;
+		lsCenter.y = floor(lsCenter.y / texelSize) * texelSize;
+
+		// Extend box towards light to capture casters out of the sphere
+		Vector3d halfSize = { radius, radius, radius + m_casterExtension * 0.5 };
+		lsCenter.z -= m_casterExtension * 0.5;
+		Matrix4d cascadeTransform = Matrix4d(ls2wsRotation, ls2wsRotation * lsCenter);
+
+		// Thanks to snapping, cascade stays still until camera moves more than a texel, so does its static shadow cache
+		bool cascadeChanged = halfSize != m_cascadeHalfSizes[i];
+		for (uint32_t j = 0; j < 4; j++)
+			cascadeChanged = cascadeChanged || cascadeTransform[j] != m_cascadeTransforms[i][j];
+		if (cascadeChanged)
+			m_cascadeVersions[i]++;
+
+		m_cascadeHalfSizes[i] = halfSize;
+		m_cascadeTransforms[i] = cascadeTransform;
+
+		Matrix4d proj;
+		proj.c00 = 1.0 / m_cascadeHalfSizes[i].x;
+
+		// Reverse y top side down for vulkan ndc
+		proj.c11 = -1.0 / m_cascadeHalfSizes[i].y;
+
+		// -1 <= z / fz <= 1
+		// 0 <= z / fz + 1 <= 2
+		// 0 <= 0.5(z / fz + 1) <= 1
+		// 0 <= 0.5z / fz + 0.5 <= 1
+		// Convert to range 0~1 for vulkan ndc depth
+		proj.c22 = 0.5 / m_cascadeHalfSizes[i].z;
+		proj.c32 = 0.5;
+
+		// final = cascade box projection * world space 2 cascade box space * camera space 2 world space
+		// final matrix transforms vertices from camera space 2 cascade box space and then to light ndc
+		Matrix4d ws2cascade = m_cascadeTransforms[i];
+		ws2cascade.Inverse();
+		m_cs2lsProjMatrices[i] = proj * ws2cascade * cs2ws;
+
+		m_cascadeSplits[i] = sliceFar;
+		sliceNear = sliceFar;
+	}
+}
+
+PyramidFrustumd DirectionLight::GetCascadeVolume(uint32_t cascadeIndex) const
+{
+	// Cascade box space ranges from -half size to half size on all 3 axes, see UpdateCascades()
+	return PyramidFrustumd::OrthographicBox(m_cascadeTransforms[cascadeIndex], m_cascadeHalfSizes[cascadeIndex]);
 }
 
 void DirectionLight::SetLightColor(const Vector3d& lightColor)
@@ -89,6 +153,12 @@ void DirectionLight::Update()
 	if (!m_targetLightDirectionChanged)
 		return;
 
+	// View coordinate system is written by render stage, so it's done at frame boundary in pipelined mode, which takes effect one frame later
+	FramePipeline::GetInstance()->UpdateRenderState([this]() { UpdateLightDirection(); });
+}
+
+void DirectionLight::UpdateLightDirection()
+{
 	// Set unit rotation
 	std::shared_ptr<BaseObject> pObj = GetBaseObject();
 	pObj->SetRotation({ 0, 0, 0, 1 });
@@ -112,7 +182,9 @@ void DirectionLight::OnPreRender()
 
 	UniformData::GetInstance()->GetPerFrameUniforms()->SetWorldSpaceMainLightDir(m_wsLightDirection);
 	UniformData::GetInstance()->GetPerFrameUniforms()->SetMainLightDir(m_csLightDirection);
-	UniformData::GetInstance()->GetPerFrameUniforms()->SetMainLightVP(m_cs2lsProjMatrix);
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; i++)
+		UniformData::GetInstance()->GetPerFrameUniforms()->SetMainLightVP(i, m_cs2lsProjMatrices[i]);
+	UniformData::GetInstance()->GetPerFrameUniforms()->SetShadowCascadeSplits(m_cascadeSplits);
 	UniformData::GetInstance()->GetPerFrameUniforms()->SetMainLightColor(m_lightColor);
 }
 
@@ -1,25 +1,39 @@
 #pragma once
 #include "../Base/BaseComponent.h"
 #include "../Maths/Matrix.h"
+#include "../Maths/PyramidFrustum.h"
 #include "../class/InputHub.h"
+#include "../class/PerFrameUniforms.h"
 
 class DirectionLight : public BaseComponent, public IInputListener
 {
 	DECLARE_CLASS_RTTI(DirectionLight);
 
 public:
-	static const double DEFAULT_SHADOWMAP_SIZE;
-	static const double DEFAULT_FRUSTUM_SIZE;
-	static const double DEFAULT_FRUSTUM_LENGTH;
+	static const double DEFAULT_SHADOW_DISTANCE;
+	static const double DEFAULT_CASTER_EXTENSION;
+	static const double DEFAULT_SPLIT_LAMBDA;
 
 protected:
-	bool Init(const std::shared_ptr<DirectionLight>& pLight, const Vector3d& lightColor, const Vector3d& frustumSize, const Vector2ui& shadowMapSize);
+	bool Init(const std::shared_ptr<DirectionLight>& pLight, const Vector3d& lightColor, double shadowDistance, double casterExtension);
 
 public:
-	static std::shared_ptr<DirectionLight> Create(const Vector3d& lightColor, const Vector3d& frustumSize = { DEFAULT_FRUSTUM_SIZE, DEFAULT_FRUSTUM_SIZE, DEFAULT_FRUSTUM_LENGTH }, const Vector2ui& shadowMapSize = { (uint32_t)DEFAULT_SHADOWMAP_SIZE, (uint32_t)DEFAULT_SHADOWMAP_SIZE });
+	// "shadowDistance": camera space distance that shadow cascades cover, capped by camera far plane
+	// "casterExtension": how far casters between a cascade and the light are still captured
+	static std::shared_ptr<DirectionLight> Create(const Vector3d& lightColor, double shadowDistance = DEFAULT_SHADOW_DISTANCE, double casterExtension = DEFAULT_CASTER_EXTENSION);
 
 public:
 	void SetLightColor(const Vector3d& lightColor);
+	void SetShadowDistance(double shadowDistance) { m_shadowDistance = shadowDistance; }
+	double GetShadowDistance() const { return m_shadowDistance; }
+	// Blend factor between logarithmic(1) and uniform(0) cascade splits
+	void SetSplitLambda(double lambda) { m_splitLambda = lambda; }
+	double GetSplitLambda() const { return m_splitLambda; }
+
+	// World space volume covered by a shadow cascade, valid after OnPreRender
+	PyramidFrustumd GetCascadeVolume(uint32_t cascadeIndex) const;
+	// Increased whenever volume of a cascade changes, static shadow cache rendered with a different version is invalid
+	uint32_t GetCascadeVersion(uint32_t cascadeIndex) const { return m_cascadeVersions[cascadeIndex]; }
 
 	void Update() override;
 	void OnPreRender() override;
@@ -31,13 +45,22 @@ public:
 
 protected:
 	void UpdateData();
+	void UpdateCascades();
+	void UpdateLightDirection();
 	void PrepareTargetLightDirection(const Vector2d& mousePosition);
 
 protected:
 	Vector3d	m_lightColor;
-	Vector3d	m_frustumSize;
-	Vector2ui	m_shadowMapSize;
-	Matrix4d	m_cs2lsProjMatrix;
+	double		m_shadowDistance;
+	double		m_casterExtension;
+	double		m_splitLambda;
+
+	Matrix4d	m_cs2lsProjMatrices[SHADOW_CASCADE_COUNT];
+	Matrix4d	m_cascadeTransforms[SHADOW_CASCADE_COUNT];	// From cascade box space to world space
+	Vector3d	m_cascadeHalfSizes[SHADOW_CASCADE_COUNT];
+	Vector4d	m_cascadeSplits;							// Camera space far distance of each cascade
+	uint32_t	m_cascadeVersions[SHADOW_CASCADE_COUNT] = {};
+
 	Vector3d	m_wsLightDirection;
 	Vector3d	m_csLightDirection;
 	Vector3d	m_targetLightDirection;
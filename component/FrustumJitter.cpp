@@ -2,6 +2,7 @@
 #include "../Base/BaseObject.h"
 #include "../class/UniformData.h"
 #include "PhysicalCamera.h"
+#include "../class/FramePipeline.h"
 
 bool HaltonSequence::Initialized = false;
 uint32_t HaltonSequence::PatternLength = 32;
@@ -102,7 +103,9 @@ void FrustumJitter::Update()
 	if (!m_jitterEnabled)
 		return;
 
-	m_pCamera->SetJitterOffset({ HaltonSequence::POINTS_HALTON_2_3[m_haltonMode].first[m_currentIndex], HaltonSequence::POINTS_HALTON_2_3[m_haltonMode].first[m_currentIndex + 1] });
+	// Projection is built by render stage
+	Vector2d jitterOffset = { HaltonSequence::POINTS_HALTON_2_3[m_haltonMode].first[m_currentIndex], HaltonSequence::POINTS_HALTON_2_3[m_haltonMode].first[m_currentIndex + 1] };
+	FramePipeline::GetInstance()->UpdateRenderState([pCamera = m_pCamera, jitterOffset]() { pCamera->SetJitterOffset(jitterOffset); });
 	m_currentIndex = (m_currentIndex + 2) % HaltonSequence::POINTS_HALTON_2_3[m_haltonMode].second;
 }
 
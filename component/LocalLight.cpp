@@ -0,0 +1,64 @@
+#include "LocalLight.h"
+#include "../Base/BaseObject.h"
+#include "../class/UniformData.h"
+#include <math.h>
+#include <algorithm>
+
+DEFINITE_CLASS_RTTI(LocalLight, BaseComponent);
+
+bool LocalLight::Init(const std::shared_ptr<LocalLight>& pLight, const Vector3d& lightColor, double radius, bool isSpotLight, double innerConeAngle, double outerConeAngle)
+{
+	if (!BaseComponent::Init(pLight))
+		return false;
+
+	m_lightColor = lightColor;
+	m_radius = radius;
+	m_isSpotLight = isSpotLight;
+
+	if (m_isSpotLight)
+		SetConeAngles(innerConeAngle, outerConeAngle);
+
+	return true;
+}
+
+std::shared_ptr<LocalLight> LocalLight::CreatePointLight(const Vector3d& lightColor, double radius)
+{
+	std::shared_ptr<LocalLight> pLight = std::make_shared<LocalLight>();
+	if (pLight.get() && pLight->Init(pLight, lightColor, radius, false, 0, 0))
+		return pLight;
+	return nullptr;
+}
+
+std::shared_ptr<LocalLight> LocalLight::CreateSpotLight(const Vector3d& lightColor, double radius, double innerConeAngle, double outerConeAngle)
+{
+	std::shared_ptr<LocalLight> pLight = std::make_shared<LocalLight>();
+	if (pLight.get() && pLight->Init(pLight, lightColor, radius, true, innerConeAngle, outerConeAngle))
+		return pLight;
+	return nullptr;
+}
+
+void LocalLight::SetConeAngles(double innerConeAngle, double outerConeAngle)
+{
+	ASSERTION(m_isSpotLight);
+
+	// Attenuation goes linearly from 0 at outer cone to 1 at inner cone, in cosine
+	double cosInner = cos(innerConeAngle);
+	double cosOuter = cos(outerConeAngle);
+	m_spotScale = 1.0 / (std::max)(cosInner - cosOuter, 1e-4);
+	m_spotOffset = -cosOuter * m_spotScale;
+}
+
+void LocalLight::OnPreRender()
+{
+	Matrix4d ls2ws = GetBaseObject()->GetCachedWorldTransform();
+
+	UniformData::GetInstance()->GetPerFrameLightUniforms()->AddLocalLight
+	(
+		ls2ws[3].xyz(),
+		m_radius,
+		m_lightColor,
+		m_isSpotLight ? ls2ws[2].xyz().Normal() : Vector3d(),
+		m_spotScale,
+		m_spotOffset
+	);
+}
\ No newline at end of file
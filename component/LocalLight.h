@@ -0,0 +1,36 @@
+#pragma once
+#include "../Base/BaseComponent.h"
+#include "../Maths/Matrix.h"
+
+// Point or spot light lit by clustered deferred shading, it doesn't cast shadow
+// Light sits at object position, spot light shines along object's z axis
+class LocalLight : public BaseComponent
+{
+	DECLARE_CLASS_RTTI(LocalLight);
+
+protected:
+	bool Init(const std::shared_ptr<LocalLight>& pLight, const Vector3d& lightColor, double radius, bool isSpotLight, double innerConeAngle, double outerConeAngle);
+
+public:
+	// "radius": distance where light fades out completely
+	static std::shared_ptr<LocalLight> CreatePointLight(const Vector3d& lightColor, double radius);
+	// Cone angles are half angles in radian, light is full within inner cone and fades out towards outer one
+	static std::shared_ptr<LocalLight> CreateSpotLight(const Vector3d& lightColor, double radius, double innerConeAngle, double outerConeAngle);
+
+public:
+	void SetLightColor(const Vector3d& lightColor) { m_lightColor = lightColor; }
+	Vector3d GetLightColor() const { return m_lightColor; }
+	void SetRadius(double radius) { m_radius = radius; }
+	double GetRadius() const { return m_radius; }
+	void SetConeAngles(double innerConeAngle, double outerConeAngle);
+	bool IsSpotLight() const { return m_isSpotLight; }
+
+	void OnPreRender() override;
+
+protected:
+	Vector3d	m_lightColor;
+	double		m_radius;
+	bool		m_isSpotLight = false;
+	double		m_spotScale = 0;
+	double		m_spotOffset = 1;
+};
\ No newline at end of file
@@ -22,6 +22,8 @@
 #include "../class/FrameWorkManager.h"
 #include "../class/MaterialInstance.h"
 #include "../class/Mesh.h"
+#include "../class/SkinningMaterial.h"
+#include "../common/Util.h"
 #include "../common/Singleton.h"
 
 DEFINITE_CLASS_RTTI(MeshRenderer, BaseComponent);
@@ -62,12 +64,20 @@ bool MeshRenderer::Init(const std::shared_ptr<MeshRenderer>& pSelf, const std::s
 
 	m_pMesh = pMesh;
 
+	if (m_pMesh != nullptr && m_pMesh->GetBoneCount() != 0 && RenderWorkManager::GetInstance()->IsPreSkinningEnabled())
+	{
+		m_pSkinningTarget = Mesh::CreateSkinningTarget(m_pMesh);
+		m_pPrevPositions = SharedVertexBuffer::Create(GetDevice(), m_pMesh->GetVerticesCount() * GetVertexBytes(VertexFormatP), VertexFormatP);
+	}
+
 	for (auto & val : materialInstances)
 	{
 		m_materialInstances.push_back(val);
 
 #if defined(_DEBUG)
-		if (m_pMesh != nullptr)
+		if (m_pSkinningTarget != nullptr)
+			ASSERTION(m_pSkinningTarget->GetVertexFormat() == val->GetMaterial()->GetVertexFormatInMem());
+		else if (m_pMesh != nullptr)
 			ASSERTION(m_pMesh->GetVertexFormat() == val->GetMaterial()->GetVertexFormatInMem());
 #endif
 	}
@@ -77,6 +87,73 @@ bool MeshRenderer::Init(const std::shared_ptr<MeshRenderer>& pSelf, const std::s
 	return true;
 }
 
+bool MeshRenderer::IsFrustumCullable() const
+{
+	// World bounds are invalid until cached transform is published with this renderer attached
+	if (!m_frustumCullingEnabled || m_pMesh == nullptr || !m_pMesh->GetBounds().IsValid() || !m_worldBounds.IsValid())
+		return false;
+
+	// Customized instances are placed by per instance data, mesh bounds alone can't tell
+	if (m_instanceCount > 1)
+		return false;
+
+	return true;
+}
+
+void MeshRenderer::OnCachedDataUpdated(const Matrix4d& cachedWorldTransform)
+{
+	// Skinned bounds are driven by animation controller
+	if (m_pMesh == nullptr || !m_pMesh->GetBounds().IsValid() || m_pSkinningTarget != nullptr)
+		return;
+
+	m_pendingWorldBounds = m_pMesh->GetBounds().Transform(cachedWorldTransform);
+}
+
+void MeshRenderer::UpdateAnimatedWorldBounds(const Matrix4d& cachedWorldTransform)
+{
+	if (m_pMesh == nullptr || !m_pMesh->GetBounds().IsValid())
+		return;
+
+	// A cube surrounding bind pose bounds in any orientation, scaled to leave room for limbs and root motion
+	Vector3d center = m_pMesh->GetBounds().Center();
+	double halfSize = m_pMesh->GetBounds().Radius() * m_animatedBoundsScale;
+	BoundingBoxd animatedBounds(center - Vector3d(halfSize), center + Vector3d(halfSize));
+
+	m_pendingWorldBounds = animatedBounds.Transform(cachedWorldTransform);
+}
+
+void MeshRenderer::OnCachedDataPublished()
+{
+	m_prevWorldBounds = m_worldBounds;
+	m_worldBounds = m_pendingWorldBounds;
+}
+
+void MeshRenderer::SetOccluder(bool flag)
+{
+	m_occluder = flag;
+
+	if (m_occluder && m_pMesh != nullptr)
+		m_pMesh->PrepareOccluderGeometry();
+}
+
+bool MeshRenderer::IsOccluder() const
+{
+	return m_occluder && IsFrustumCullable() && m_pSkinningTarget == nullptr && m_pMesh->GetOccluderIndices().size() != 0;
+}
+
+Matrix4d MeshRenderer::GetModelMatrix() const
+{
+	if (m_modelMatrixOverride)
+		return m_overrideModelMatrix;
+	else
+		return GetBaseObject()->GetCachedWorldTransform();
+}
+
+bool MeshRenderer::IsWorldBoundsChanged() const
+{
+	return m_worldBounds.min != m_prevWorldBounds.min || m_worldBounds.max != m_prevWorldBounds.max;
+}
+
 void MeshRenderer::OnRenderObject()
 {
 	if (m_pMesh == nullptr)
@@ -94,11 +171,51 @@ void MeshRenderer::OnRenderObject()
 	else
 		UniformData::GetInstance()->GetPerObjectUniforms()->SetModelMatrix(m_perObjectBufferIndex, GetBaseObject()->GetCachedWorldTransform());
 
+	// Skinning target is drawn instead, utility index tells where its previous positions are
+	std::shared_ptr<Mesh> pRenderMesh = m_pMesh;
+	uint32_t utilityIndex = m_utilityIndex;
+	if (m_pSkinningTarget != nullptr)
+	{
+		pRenderMesh = m_pSkinningTarget;
+		utilityIndex = SkinningMaterial::GetPrevPositionOffset(m_pPrevPositions);
+	}
+
+	bool rendered = false;
 	for (uint32_t i = 0; i < m_materialInstances.size(); i++)
 	{
 		if ((RenderWorkManager::GetInstance()->GetRenderStateMask() & m_materialInstances[i]->GetRenderMask()) == 0)
 			continue;
 
-		m_materialInstances[i]->InsertIntoRenderQueue(m_pMesh, m_perObjectBufferIndex, m_pMesh->GetMeshChunkIndex(), m_utilityIndex, m_instanceCount, m_startInstance);
+		// Culled by view frustum, material instances rendering into other passes(e.g. shadow map) stay
+		if (!m_isVisible && (m_materialInstances[i]->GetRenderMask() & ~(1 << RenderWorkManager::Scene)) == 0)
+			continue;
+
+		if ((m_materialInstances[i]->GetRenderMask() & ~((1 << RenderWorkManager::ShadowMapGen) | (1 << RenderWorkManager::ShadowCacheGen))) == 0)
+		{
+			// Outside of volumes of shadow cascades this material instance renders to
+			if ((m_shadowCascadeMask & m_materialInstances[i]->GetShadowCascadeMask()) == 0)
+				continue;
+
+			// Static casters only render into shadow cache, dynamic ones only into shadow map
+			bool cacheMaterialInstance = (m_materialInstances[i]->GetRenderMask() & (1 << RenderWorkManager::ShadowCacheGen)) != 0;
+			if (cacheMaterialInstance != IsStaticShadowCaster())
+				continue;
+		}
+
+		m_materialInstances[i]->InsertIntoRenderQueue(pRenderMesh, m_perObjectBufferIndex, m_pMesh->GetMeshChunkIndex(), utilityIndex, m_instanceCount, m_startInstance);
+		rendered = true;
+	}
+
+	// Skinned once no matter how many passes draw it, with bones of animation instance in utility index
+	if (rendered && m_pSkinningTarget != nullptr)
+	{
+		std::static_pointer_cast<SkinningMaterial>(RenderWorkManager::GetInstance()->GetMaterial(RenderWorkManager::Skinning))->AddJob
+		(
+			m_pMesh, m_pSkinningTarget, m_pPrevPositions, m_utilityIndex, m_skinningHistoryValid
+		);
+		m_skinningHistoryValid = true;
 	}
+	// Not skinned while culled, positions of last frame are gone once it shows up again
+	else if (m_pSkinningTarget != nullptr)
+		m_skinningHistoryValid = false;
 }
\ No newline at end of file
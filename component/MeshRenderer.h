@@ -1,12 +1,14 @@
 #pragma once
 #include "../Base/BaseComponent.h"
 #include "../Maths/Matrix.h"
+#include "../Maths/BoundingBox.h"
 
 class Mesh;
 class Material;
 class MaterialInstance;
 class DescriptorSet;
 class DescriptorPool;
+class SharedVertexBuffer;
 
 class MeshRenderer : public BaseComponent
 {
@@ -21,8 +23,12 @@ public:
 
 public:
 	void OnRenderObject() override;
+	void OnCachedDataUpdated(const Matrix4d& cachedWorldTransform) override;
+	void OnCachedDataPublished() override;
 
 	std::shared_ptr<Mesh> GetMesh() const { return m_pMesh; }
+	// Skinned meshes are skinned by compute into a skinning target of each renderer, it's what material instances draw
+	std::shared_ptr<Mesh> GetSkinningTarget() const { return m_pSkinningTarget; }
 
 	uint32_t GetInstanceCount() const { return m_instanceCount; }
 	void SetInstanceCount(uint32_t instanceCount) { m_instanceCount = instanceCount; }
@@ -32,6 +38,43 @@ public:
 	void SetUtilityIndex(uint32_t index) { m_utilityIndex = index; }
 	void OverrideModelMatrix(const Matrix4d& matrix) { m_overrideModelMatrix = matrix; m_modelMatrixOverride = true; }
 
+	// Frustum culling only affects material instances that render to scene, shadow map ones are filtered by light volume instead
+	void SetFrustumCullingEnabled(bool flag) { m_frustumCullingEnabled = flag; }
+	// Only renderers with valid world bounds could be culled, customized instancing is excluded
+	// Skinned renderers only get world bounds if an animation controller drives them, see UpdateAnimatedWorldBounds()
+	bool IsFrustumCullable() const;
+	void SetVisible(bool flag) { m_isVisible = flag; }
+	bool IsVisible() const { return m_isVisible; }
+	// Bit i is set if this renderer is inside volume of shadow cascade i, for static casters it's only set if cache of cascade i is re-rendered
+	// Material instances that only render to shadow map or shadow cache are skipped if none of their cascades is set
+	void SetShadowCascadeMask(uint32_t mask) { m_shadowCascadeMask = mask; }
+	uint32_t GetShadowCascadeMask() const { return m_shadowCascadeMask; }
+	bool IsShadowCaster() const { return m_shadowCascadeMask != 0; }
+	// Static casters are rendered into static shadow cache with shadow cache material instances, others into shadow map every frame
+	// Moving a static caster is allowed, it invalidates cache of cascades it touches
+	// Only cullable renderers could be static casters, since cache invalidation is driven by world bounds
+	// Skinned ones are excluded too, animation changes their shadow without moving their bounds
+	void SetStaticShadowCaster(bool flag) { m_staticShadowCaster = flag; }
+	bool IsStaticShadowCaster() const { return m_staticShadowCaster && IsFrustumCullable() && m_pSkinningTarget == nullptr; }
+	// Occluders are rasterized with occluder geometry of mesh into software occlusion buffer, other cullable renderers are tested against it
+	// Only cullable static geometry could be occluders, skinned meshes move away from bind pose geometry
+	// Occluder geometry of mesh is built when it's tagged, so it has to be done after software occlusion culling is enabled
+	void SetOccluder(bool flag);
+	bool IsOccluder() const;
+
+	Matrix4d GetModelMatrix() const;
+
+	// World space bounds are updated along with cached transform, and published with it
+	const BoundingBoxd& GetWorldBounds() const { return m_worldBounds; }
+	// Skinned renderers are moved by model matrix of animation controller object, rather than their own one
+	// Controller calls this with its cached transform, bind pose bounds are inflated around their center to cover animated vertices
+	void UpdateAnimatedWorldBounds(const Matrix4d& cachedWorldTransform);
+	// Animations moving far from bind pose need a larger scale, default 1.5 times the radius of bind pose bounds in every direction
+	void SetAnimatedBoundsScale(double scale) { m_animatedBoundsScale = scale; }
+	// World space bounds before last publish
+	const BoundingBoxd& GetPrevWorldBounds() const { return m_prevWorldBounds; }
+	bool IsWorldBoundsChanged() const;
+
 protected:
 	bool Init(const std::shared_ptr<MeshRenderer>& pSelf, const std::shared_ptr<Mesh> pMesh, const std::vector<std::shared_ptr<MaterialInstance>>& materialInstances);
 
@@ -39,6 +82,11 @@ protected:
 	std::shared_ptr<Mesh>	m_pMesh;
 	uint32_t				m_perObjectBufferIndex;
 
+	// Skinned positions of last frame are kept in "m_pPrevPositions" for motion vectors, they're invalid until skinned once
+	std::shared_ptr<Mesh>				m_pSkinningTarget;
+	std::shared_ptr<SharedVertexBuffer>	m_pPrevPositions;
+	bool								m_skinningHistoryValid = false;
+
 	std::vector<std::shared_ptr<MaterialInstance>> m_materialInstances;
 
 	// For the same mesh with same material, there's a mechanism to get them rendered with instancing rather than multi indirect command
@@ -58,4 +106,14 @@ protected:
 
 	bool					m_modelMatrixOverride = false;
 	Matrix4d				m_overrideModelMatrix;
+
+	bool					m_frustumCullingEnabled = true;
+	bool					m_isVisible = true;
+	uint32_t				m_shadowCascadeMask = 0xffffffff;
+	bool					m_staticShadowCaster = false;
+	bool					m_occluder = false;
+	BoundingBoxd			m_worldBounds;
+	BoundingBoxd			m_prevWorldBounds;
+	BoundingBoxd			m_pendingWorldBounds;	// Written by simulation, not visible until published
+	double					m_animatedBoundsScale = 1.5;
 };
\ No newline at end of file
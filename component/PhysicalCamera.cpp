@@ -52,9 +52,17 @@ void PhysicalCamera::UpdateViewMatrix()
 
 void PhysicalCamera::UpdateProjMatrix()
 {
+	// Jitter is a sub pixel offset of the viewport scene is rendered to, which changes along with dynamic resolution
+	Vector2d renderSize = UniformData::GetInstance()->GetGlobalUniforms()->GetRenderWindowSize();
+	if (m_jitterRenderSize != renderSize)
+		m_projDirty = true;
+
 	if (!m_projDirty)
 		return;
 
+	m_jitterRenderSize = renderSize;
+	Vector2d jitterOffset = { m_jitterOffset.x / renderSize.x, m_jitterOffset.y / renderSize.y };
+
 	// Vulkan ndc depth ranges from 0 to 1
 	// Depth range from near plane 0 to infinite far plane 1
 	// A = f / (n - f), B = fn / (n - f)
@@ -84,11 +92,11 @@ void PhysicalCamera::UpdateProjMatrix()
 	// 4). x2 = 2 * jitter_offset / window_width
 	// 5). jitter_offset = jitter * window_width
 	// 6). x2 = 2 * jitter
-	proj.z0 = 2.0f * m_jitterOffset.x;
+	proj.z0 = 2.0f * jitterOffset.x;
 
 	// Since vulkan ndc is right hand and Y axis is upside down, we need to reverse it
 	proj.y1 = -2.0f * m_supplementProps.fixedNearPlane / m_supplementProps.fixedNearPlaneHeight;
-	proj.z1 = 2.0f * m_jitterOffset.y;
+	proj.z1 = 2.0f * jitterOffset.y;
 
 	proj.z2 = A;
 	proj.w2 = B;
@@ -96,7 +104,7 @@ void PhysicalCamera::UpdateProjMatrix()
 	proj.z3 = -1.0f;
 	proj.w3 = 0.0f;
 
-	UniformData::GetInstance()->GetPerFrameUniforms()->SetCameraJitterOffset(m_jitterOffset);
+	UniformData::GetInstance()->GetPerFrameUniforms()->SetCameraJitterOffset(jitterOffset);
 	UniformData::GetInstance()->GetPerFrameUniforms()->SetEyeSpaceSize({ m_supplementProps.fixedNearPlaneWidth, m_supplementProps.fixedNearPlaneHeight });
 	UniformData::GetInstance()->GetPerFrameUniforms()->SetNearFarAB({ m_supplementProps.fixedNearPlane, m_props.farPlane, A, B });
 	UniformData::GetInstance()->GetGlobalUniforms()->SetProjectionMatrix(proj);
@@ -130,8 +138,6 @@ void PhysicalCamera::UpdateCameraProps()
 void PhysicalCamera::SetJitterOffset(Vector2d jitterOffset)
 {
 	m_jitterOffset = jitterOffset;
-	m_jitterOffset.x /= FrameBufferDiction::WINDOW_WIDTH;
-	m_jitterOffset.y /= FrameBufferDiction::WINDOW_HEIGHT;
 	m_projDirty = true;
 }
 
@@ -196,7 +202,8 @@ void PhysicalCamera::UpdateCameraSupplementProps()
 	m_supplementProps.fixedNearPlaneHeight = m_supplementProps.fixedNearPlane * m_supplementProps.filmHeight / m_props.focalLength;	// 2 * n * tan(FOV_2)
 	m_supplementProps.fixedNearPlaneWidth = m_supplementProps.fixedNearPlaneHeight * m_props.aspect;
 
-	m_frustum = { {0, 0, 0}, {0, 0, -1}, m_supplementProps.verticalFOV_2, m_props.aspect };
+	// No far plane, projection matrix uses infinite far plane
+	m_frustum = { {0, 0, 0}, {0, 0, -1}, m_supplementProps.verticalFOV_2, m_props.aspect, m_supplementProps.fixedNearPlane };
 
 	m_projDirty = true;
 	m_propDirty = true;
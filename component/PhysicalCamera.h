@@ -81,5 +81,6 @@ protected:
 	bool							m_projDirty;
 	bool							m_propDirty;
 
-	Vector2d						m_jitterOffset;
+	Vector2d						m_jitterOffset;			// In pixels
+	Vector2d						m_jitterRenderSize;		// Render window size jitter offset in projection is normalized by
 };
\ No newline at end of file
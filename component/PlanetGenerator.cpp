@@ -65,6 +65,10 @@ void PlanetGenerator::Start()
 {
 	m_pMeshRenderer = GetComponent<MeshRenderer>();
 
+	// Planet patches are culled while being generated, mesh bounds mean nothing here
+	if (m_pMeshRenderer != nullptr)
+		m_pMeshRenderer->SetFrustumCullingEnabled(false);
+
 	m_maxLODLevel = (uint32_t)UniformData::GetInstance()->GetGlobalUniforms()->GetMaxPlanetLODLevel();
 
 	// Make a copy here
@@ -80,7 +84,7 @@ void PlanetGenerator::Start()
 PlanetGenerator::CullState PlanetGenerator::FrustumCull(const Vector3d& a, const Vector3d& b, const Vector3d& c, double height)
 {
 	CullState state = CullState::DIVIDE;
-	for (uint32_t i = 0; i < m_cameraFrustumLocal.FrustumFace_COUNT; i++)
+	for (uint32_t i = 0; i < m_cameraFrustumLocal.FrustumFace_SIDE_COUNT; i++)
 	{
 		uint32_t outsideCount = 0;
 		outsideCount += m_cameraFrustumLocal.planes[i].PlaneTest(a) > 0 ? 0 : 1;
@@ -108,7 +112,7 @@ PlanetGenerator::CullState PlanetGenerator::FrustumCull(const Vector3d& a, const
 PlanetGenerator::CullState PlanetGenerator::FrustumCull(const Vector3d& p0, const Vector3d& p1, const Vector3d& p2, const Vector3d& p3, double height)
 {
 	CullState state = CullState::DIVIDE;
-	for (uint32_t i = 0; i < m_cameraFrustumLocal.FrustumFace_COUNT; i++)
+	for (uint32_t i = 0; i < m_cameraFrustumLocal.FrustumFace_SIDE_COUNT; i++)
 	{
 		uint32_t outsideCount = 0;
 		outsideCount += m_cameraFrustumLocal.planes[i].PlaneTest(p0) > 0 ? 0 : 1;
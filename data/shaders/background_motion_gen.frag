@@ -17,7 +17,11 @@ layout (location = 1) out vec4 outBGMotionVec;
 
 void main() 
 {
-	vec3 skyBox = texture(RGBA16_512_CUBE_SKYBOX[uint(perFrameData.envPingpongIndex)], normalize(inViewDir)).xyz;
+	uint envIndex = uint(perFrameData.envPingpongIndex);
+	vec3 skyBox = texture(RGBA16_512_CUBE_SKYBOX[envIndex], normalize(inViewDir)).xyz;
+	// Newly generated skybox is blended in over a few frames
+	if (perFrameData.envBlendFactor < 1.0f)
+		skyBox = mix(texture(RGBA16_512_CUBE_SKYBOX[1 - envIndex], normalize(inViewDir)).xyz, skyBox, perFrameData.envBlendFactor);
 	outBGColorAndCoC = vec4(skyBox, CalculateCoC(perFrameData.nearFarAB.y));
 
 	vec2 prevScreenCoord = inPrevClipSpacePos.xy / inPrevClipSpacePos.z;
@@ -0,0 +1,67 @@
+#if !defined(SHADER_CLUSTERED_LIGHTING)
+#define SHADER_CLUSTERED_LIGHTING
+
+#include "uniform_layout.sh"
+#include "global_parameters.sh"
+#include "pbr_functions.sh"
+
+// "uv" is normalized within render viewport, "depth" is camera space distance along view axis
+// Slices are picked in the same way as LightClusterGrid::GetSliceIndex
+uint GetLightClusterIndex(vec2 uv, float depth)
+{
+	uvec2 tile = min(uvec2(uv * vec2(LIGHT_CLUSTER_TILE_COLUMN_COUNT, LIGHT_CLUSTER_TILE_ROW_COUNT)), uvec2(LIGHT_CLUSTER_TILE_COLUMN_COUNT - 1, LIGHT_CLUSTER_TILE_ROW_COUNT - 1));
+
+	uint slice = 0;
+	if (depth > clusterParams.x)
+		slice = min(uint(log(depth / clusterParams.x) * clusterParams.y), LIGHT_CLUSTER_SLICE_COUNT - 1);
+
+	return (slice * LIGHT_CLUSTER_TILE_ROW_COUNT + tile.y) * LIGHT_CLUSTER_TILE_COLUMN_COUNT + tile.x;
+}
+
+// Direct radiance of local lights in the cluster of a pixel, with the same brdf as main light, local lights don't cast shadow
+vec3 ClusteredLocalLightRadiance(vec2 uv, vec3 csPosition, vec3 n, vec3 v, vec3 albedo, float roughness, float metalic, vec3 F0)
+{
+	uvec2 cluster = lightClusters[GetLightClusterIndex(uv, -csPosition.z)];
+
+	float NdotV = max(0.0f, dot(n, v));
+
+	vec3 radiance = vec3(0);
+	for (uint i = 0; i < cluster.y; i++)
+	{
+		LocalLightData light = localLights[lightIndices[cluster.x + i]];
+
+		vec3 lightVec = light.csPositionRadius.xyz - csPosition;
+		float sqrDist = dot(lightVec, lightVec);
+		float sqrRadius = light.csPositionRadius.w * light.csPositionRadius.w;
+
+		// Clusters are conservative, pixel could still be out of light range
+		if (sqrDist >= sqrRadius)
+			continue;
+
+		vec3 l = lightVec * inversesqrt(max(sqrDist, 1e-8f));
+
+		// Inverse square falloff, windowed to reach 0 at light radius
+		float window = clamp(1.0f - (sqrDist * sqrDist) / (sqrRadius * sqrRadius), 0.0f, 1.0f);
+		float attenuation = window * window / max(sqrDist, 1e-4f);
+
+		float spot = clamp(dot(light.csSpotDirectionOffset.xyz, -l) * light.colorSpotScale.a + light.csSpotDirectionOffset.w, 0.0f, 1.0f);
+		attenuation *= spot * spot;
+
+		vec3 h = normalize(l + v);
+		float NdotH = max(0.0f, dot(n, h));
+		float NdotL = max(0.0f, dot(n, l));
+		float LdotH = max(0.0f, dot(l, h));
+
+		vec3 fresnel = Fresnel_Schlick(F0, LdotH);
+		vec3 kD = (1.0 - metalic) * (vec3(1.0) - fresnel);
+
+		vec3 specular = fresnel * G_SchlicksmithGGX(NdotL, NdotV, roughness) * min(1.0f, GGX_D(NdotH, roughness)) / (4.0f * NdotL * NdotV + 0.001f);
+		vec3 diffuse = albedo * kD / PI;
+
+		radiance += (specular + diffuse) * NdotL * attenuation * light.colorSpotScale.rgb;
+	}
+
+	return radiance;
+}
+
+#endif
\ No newline at end of file
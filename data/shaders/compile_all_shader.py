@@ -1,33 +1,67 @@
 from pathlib import Path
+import hashlib
 import os
 
-def compile_shader(abs_path, ext):
+# Hash of what a binary is compiled from, CMake checks shipped binaries against it when glslc isn't available
+# Any shared header(*.sh) change makes every binary stale, line endings are ignored
+HASH_FILE_NAME = 'shader_binary_hashes.txt'
+
+def read_text(path):
+	return Path(path).read_bytes().replace(b'\r', b'')
+
+def read_headers(abs_path):
+	header_paths = sorted(Path(abs_path).glob('**/*.sh'), key = lambda path : path.relative_to(abs_path).as_posix())
+	return b''.join(read_text(path) for path in header_paths)
+
+def source_hash(source, defines, headers):
+	return hashlib.sha256(source + b'\n' + ' '.join(defines).encode() + b'\n' + headers).hexdigest()
+
+def compile_variant(abs_path, path_in_string, binary, defines, headers, hashes):
+	cmd = 'glslc ' + path_in_string + ''.join(' ' + define for define in defines) + ' -o ' + os.path.join(abs_path, binary)
+	print(cmd)
+	if os.system(cmd) == 0:
+		hashes[binary] = source_hash(read_text(path_in_string), defines, headers)
+
+def compile_shader(abs_path, ext, headers, hashes):
 
 	path_list = Path(abs_path).glob('**/*.' + ext)
 
 	for path in path_list:
 		path_in_string = str(path)
-		_path, _file = os.path.split(path_in_string)
-		
+		_file = path.relative_to(abs_path).as_posix()
+
 		if _file == 'screen_quad.vert':
-			cmd = 'glslc ' + path_in_string + ' -DENABLE_CS_POS_RECONSTRUCTION -o ' + _path + '/screen_quad_vert_recon.vert.spv'
-			print(cmd)
-			os.system(cmd)
-			
-			cmd = 'glslc ' + path_in_string + ' -DENABLE_CS_VIEW_RAY -o ' + _path + '/screen_quad_cs_view_ray.vert.spv'
-			print(cmd)
-			os.system(cmd)
-			
-			cmd = 'glslc ' + path_in_string + ' -DENABLE_CS_POS_RECONSTRUCTION -DENABLE_CS_VIEW_RAY -o ' + _path + '/screen_quad_vert_recon_cs_view_ray.vert.spv'
-			print(cmd)
-			os.system(cmd)
-
-		cmd = 'glslc ' + path_in_string + ' -o ' + path_in_string + '.spv'
-		print(cmd)
-		os.system(cmd)
-	
-cur_path = os.path.dirname(os.path.abspath(__file__))
-	
-compile_shader(cur_path, 'vert')
-compile_shader(cur_path, 'frag')
-compile_shader(cur_path, 'comp')
\ No newline at end of file
+			compile_variant(abs_path, path_in_string, 'screen_quad_vert_recon.vert.spv', ['-DENABLE_CS_POS_RECONSTRUCTION'], headers, hashes)
+			compile_variant(abs_path, path_in_string, 'screen_quad_cs_view_ray.vert.spv', ['-DENABLE_CS_VIEW_RAY'], headers, hashes)
+			compile_variant(abs_path, path_in_string, 'screen_quad_vert_recon_cs_view_ray.vert.spv', ['-DENABLE_CS_POS_RECONSTRUCTION', '-DENABLE_CS_VIEW_RAY'], headers, hashes)
+
+		if _file == 'ssao_ssr_gen.comp':
+			compile_variant(abs_path, path_in_string, 'ssao_ssr_hiz_gen.comp.spv', ['-DHIZ_TRACING'], headers, hashes)
+
+		compile_variant(abs_path, path_in_string, _file + '.spv', [], headers, hashes)
+
+def load_hashes(abs_path):
+	hashes = {}
+	hash_path = os.path.join(abs_path, HASH_FILE_NAME)
+	if os.path.exists(hash_path):
+		for line in Path(hash_path).read_text().splitlines():
+			if line:
+				binary_hash, binary = line.split(' ', 1)
+				hashes[binary] = binary_hash
+	return hashes
+
+def save_hashes(abs_path, hashes):
+	lines = [hashes[binary] + ' ' + binary + '\n' for binary in sorted(hashes)]
+	with open(os.path.join(abs_path, HASH_FILE_NAME), 'w', newline = '\n') as hash_file:
+		hash_file.writelines(lines)
+
+if __name__ == '__main__':
+	cur_path = os.path.dirname(os.path.abspath(__file__))
+	headers = read_headers(cur_path)
+	hashes = load_hashes(cur_path)
+
+	compile_shader(cur_path, 'vert', headers, hashes)
+	compile_shader(cur_path, 'frag', headers, hashes)
+	compile_shader(cur_path, 'comp', headers, hashes)
+
+	save_hashes(cur_path, hashes)
\ No newline at end of file
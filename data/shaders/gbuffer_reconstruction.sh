@@ -40,14 +40,31 @@ vec3 ReconstructCSPosition(in ivec2 coord, in vec2 oneNearPosition, in sampler2D
 
 float AcquireShadowFactor(vec4 csPosition, sampler2D ShadowMapDepthBuffer)
 {
+	// Pick the first cascade covering this depth, nothing beyond the last one is shadowed
+	float viewDepth = -csPosition.z;
+	int cascadeIndex = 0;
+	for (; cascadeIndex < 4; cascadeIndex++)
+	{
+		if (viewDepth <= perFrameData.shadowCascadeSplits[cascadeIndex])
+			break;
+	}
+
+	if (cascadeIndex == 4)
+		return 1.0f;
+
 	// The view matrix in main light VP needs to be the transfrom from main camera space rather than world space
 	// Doing this to avoid large number of world space position in a large scale scene
-	vec4 lsPosition = perFrameData.mainLightVP * csPosition;
+	vec4 lsPosition = perFrameData.mainLightVP[cascadeIndex] * csPosition;
 	lsPosition /= lsPosition.w;
 	lsPosition.xy = lsPosition.xy * 0.5f + 0.5f;	// NOTE: Don't do this to z, as it's already within [0, 1] after vulkan ndc transform
 
 	lsPosition.z = max(0, lsPosition.z);
 
+	// Cascades are tiled 2x2 in shadow map, keep pcf kernel inside tile of this cascade
+	vec2 tileTexelSize = 2.0f / textureSize(ShadowMapDepthBuffer, 0);
+	lsPosition.xy = clamp(lsPosition.xy, tileTexelSize * 1.5f, 1.0f - tileTexelSize * 1.5f);
+	lsPosition.xy = (lsPosition.xy + vec2(cascadeIndex % 2, cascadeIndex / 2)) * 0.5f;
+
 	vec2 texelSize = 1.0f / textureSize(ShadowMapDepthBuffer, 0);
 	float shadowFactor = 0.0f;
 	float pcfDepth;
@@ -26,7 +26,8 @@ void main()
 
 	// Motion Blur
 	vec3 fullMotionColor = vec3(0);
-	vec2 motionNeighborMax = texture(MotionNeighborMax[frameIndex], inUv).rg;
+	// Motion tiles only cover dynamic resolution viewport
+	vec2 motionNeighborMax = texture(MotionNeighborMax[frameIndex], inUv * globalData.renderWindowSize.xy * globalData.gameWindowSize.zw).rg;
 	vec2 step = motionNeighborMax / globalData.MotionBlurSettings.y;	// either side samples a pre-defined amount of colors
 	vec2 startPos = inUv + step * 0.5f * PDsrand(inUv + vec2(perFrameData.time.y));	// Randomize starting position
 
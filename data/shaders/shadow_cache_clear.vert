@@ -0,0 +1,22 @@
+#version 450
+
+#extension GL_ARB_separate_shader_objects : enable
+#extension GL_ARB_shading_language_420pack : enable
+
+#include "uniform_layout.sh"
+
+layout(push_constant) uniform PushConsts {
+	layout (offset = 0) uint cascadeIndex;
+} pushConsts;
+
+void main() 
+{
+	vec2 uv = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+
+	// A triangle covering tile of this cascade writes cleared depth(0) if its cache is re-rendered this frame
+	// Otherwise it collapses to a degenerate one, so that cached depth stays
+	if (perFrameData.shadowCacheDirty[pushConsts.cascadeIndex] > 0.5f)
+		gl_Position = vec4(uv * 2.0f - 1.0f, 0.0f, 1.0f);
+	else
+		gl_Position = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+}
@@ -8,9 +8,13 @@ layout (location = 0) in vec3 inPos;
 #include "uniform_layout.sh"
 #include "utilities.sh"
 
+layout(push_constant) uniform PushConsts {
+	layout (offset = 0) uint cascadeIndex;
+} pushConsts;
+
 void main() 
 {
 	int perObjectIndex = objectDataIndex[GetIndirectIndex(gl_DrawID, gl_InstanceIndex)].perObjectIndex;
 
-	gl_Position = perFrameData.mainLightVP * perObjectData[perObjectIndex].MV * vec4(inPos.xyz, 1.0);
+	gl_Position = perFrameData.mainLightVP[pushConsts.cascadeIndex] * perObjectData[perObjectIndex].MV * vec4(inPos.xyz, 1.0);
 }
@@ -11,6 +11,10 @@ layout (location = 6) in uint inBoneIndices;
 #include "quaternion.sh"
 #include "utilities.sh"
 
+layout(push_constant) uniform PushConsts {
+	layout (offset = 0) uint cascadeIndex;
+} pushConsts;
+
 void main() 
 {
 	int indirectIndex = GetIndirectIndex(gl_DrawID, gl_InstanceIndex);
@@ -54,5 +58,5 @@ void main()
 
 	vec3 animated_pos = DualQuaternionTransformPoint(result, inPos);
 
-	gl_Position = perFrameData.mainLightVP * perObjectData[perObjectIndex].MV * vec4(animated_pos, 1.0);
+	gl_Position = perFrameData.mainLightVP[pushConsts.cascadeIndex] * perObjectData[perObjectIndex].MV * vec4(animated_pos, 1.0);
 }
@@ -16,6 +16,7 @@ struct GlobalData
 	vec4 SSAOWindowSize;
 	vec4 bloomWindowSize;
 	vec4 motionTileWindowSize;
+	vec4 renderWindowSize;
 
 	// Main camera settings
 	vec4 MainCameraSettings0;
@@ -109,7 +110,7 @@ struct PerFrameData
 	mat4 view;					
 	mat4 viewCoordSystem;		
 	mat4 prevView;	
-	mat4 mainLightVP;
+	mat4 mainLightVP[4];
 	vec4 wsCameraPosition;
 	vec4 wsCameraDeltaPosition;
 	vec4 wsCameraDirection;
@@ -118,6 +119,8 @@ struct PerFrameData
 	vec4 wsMainLightDir;
 	vec4 mainLightDir;
 	vec4 mainLightColor;
+	vec4 shadowCascadeSplits;
+	vec4 shadowCacheDirty;
 	vec2 cameraJitterOffset;
 	vec2 time;
 	vec2 haltonX8Jitter;
@@ -127,9 +130,24 @@ struct PerFrameData
 	float frameIndex;
 	float pingpongIndex;
 	float envPingpongIndex;
-	float reservedPadding1;
+	float envBlendFactor;
 };
 
+// See PerFrameLightUniforms.h for spot cone attenuation
+struct LocalLightData
+{
+	vec4 csPositionRadius;		// xyz: camera space position, w: distance where light fades out
+	vec4 colorSpotScale;
+	vec4 csSpotDirectionOffset;
+};
+
+// Same as LightClusterGrid and PerFrameLightUniforms
+#define LIGHT_CLUSTER_TILE_COLUMN_COUNT 16
+#define LIGHT_CLUSTER_TILE_ROW_COUNT 9
+#define LIGHT_CLUSTER_SLICE_COUNT 24
+#define MAX_LOCAL_LIGHT_COUNT 256
+#define MAX_LIGHT_INDEX_COUNT 16384
+
 struct PerObjectData
 {
 	mat4 MV;			// We can keep the translation of modelview matrix, as it's relative to camera. Larger number means far away, float rounding isn't visible
@@ -216,6 +234,14 @@ layout(std430, set = 1, binding = 1) buffer PerFrameBoneUniforms
 	PerFrameBoneData perFrameBoneData[];
 };
 
+layout(std430, set = 1, binding = 2) buffer PerFrameLightUniforms
+{
+	vec4			clusterParams;		// x: cluster near distance, y: slice scale, z: light count
+	LocalLightData	localLights[MAX_LOCAL_LIGHT_COUNT];
+	uvec2			lightClusters[LIGHT_CLUSTER_TILE_COLUMN_COUNT * LIGHT_CLUSTER_TILE_ROW_COUNT * LIGHT_CLUSTER_SLICE_COUNT];	// x: offset in light indices, y: count
+	uint			lightIndices[MAX_LIGHT_INDEX_COUNT];
+};
+
 layout(std430, set = 2, binding = 0) buffer PerObjectUniforms
 {
 	PerObjectData perObjectData[];
@@ -0,0 +1,138 @@
+#include "../Maths/LightClusterGrid.h"
+#include <cstdio>
+
+// Default frustum: 90 degree fov both ways, clusters from 0.1 to 100
+// A sphere at depth 10 spans slices 15 to 16 for radius up to 0.5, "log(depth / 0.1) * 24 / log(1000)" is 15.82 at 9.5 and 16.17 at 10.5
+// Column 8 spans ndc [0, 0.125], row 4 spans ndc [-1/9, 1/9]
+
+static uint32_t g_failureCount = 0;
+
+#define CHECK(expr) \
+	do { if (!(expr)) { printf("%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #expr); g_failureCount++; } } while (0)
+
+static void TestSphereWithinOneTile()
+{
+	LightClusterGrid grid;
+	LightClusterGrid::LightFootprint footprint;
+
+	CHECK(grid.ComputeFootprint({ 0.625f, 0.0f, -10.0f, 0.2f }, footprint));
+	CHECK(footprint.columnMask == (1 << 8));
+	CHECK(footprint.rowMask == (1 << 4));
+	CHECK(footprint.minSlice == 15);
+	CHECK(footprint.maxSlice == 16);
+}
+
+static void TestSphereOnAxis()
+{
+	LightClusterGrid grid;
+	LightClusterGrid::LightFootprint footprint;
+
+	// Middle column boundary goes through view axis, middle row doesn't
+	CHECK(grid.ComputeFootprint({ 0.0f, 0.0f, -10.0f, 0.5f }, footprint));
+	CHECK(footprint.columnMask == ((1 << 7) | (1 << 8)));
+	CHECK(footprint.rowMask == (1 << 4));
+	CHECK(footprint.minSlice == 15);
+	CHECK(footprint.maxSlice == 16);
+}
+
+static void TestSphereStraddlingRowBoundary()
+{
+	LightClusterGrid grid;
+	LightClusterGrid::LightFootprint footprint;
+
+	// Centered on boundary between row 3 and row 4, rows go down the screen while y goes up
+	CHECK(grid.ComputeFootprint({ 0.625f, 10.0f / 9.0f, -10.0f, 0.2f }, footprint));
+	CHECK(footprint.columnMask == (1 << 8));
+	CHECK(footprint.rowMask == ((1 << 3) | (1 << 4)));
+
+	// Just below the boundary
+	CHECK(grid.ComputeFootprint({ 0.625f, 10.0f / 9.0f - 0.5f, -10.0f, 0.2f }, footprint));
+	CHECK(footprint.rowMask == (1 << 4));
+}
+
+static void TestSphereBehindCamera()
+{
+	LightClusterGrid grid;
+	LightClusterGrid::LightFootprint footprint;
+
+	CHECK(!grid.ComputeFootprint({ 0.0f, 0.0f, 5.0f, 1.0f }, footprint));
+
+	// Camera inside of sphere, it covers every tile of first slice
+	CHECK(grid.ComputeFootprint({ 0.0f, 0.0f, 0.5f, 1.0f }, footprint));
+	CHECK(footprint.columnMask == (1 << LightClusterGrid::TILE_COLUMN_COUNT) - 1);
+	CHECK(footprint.rowMask == (1 << LightClusterGrid::TILE_ROW_COUNT) - 1);
+	CHECK(footprint.minSlice == 0);
+}
+
+static void TestSphereOutsideFrustum()
+{
+	LightClusterGrid grid;
+	LightClusterGrid::LightFootprint footprint;
+
+	CHECK(!grid.ComputeFootprint({ 20.0f, 0.0f, -10.0f, 1.0f }, footprint));
+	CHECK(!grid.ComputeFootprint({ 0.0f, -20.0f, -10.0f, 1.0f }, footprint));
+}
+
+static void TestBuild()
+{
+	LightClusterGrid grid;
+	grid.Build({ { 0.625f, 0.0f, -10.0f, 0.2f }, { 0.0f, 0.0f, -10.0f, 0.5f }, { 0.0f, 0.0f, 5.0f, 1.0f } }, 1024);
+
+	// 2 clusters of light 0, 4 of light 1, light 2 is behind camera
+	CHECK(grid.GetLightIndices().size() == 6);
+	CHECK(grid.GetDroppedLightIndexCount() == 0);
+
+	for (uint32_t slice = 15; slice <= 16; slice++)
+	{
+		const LightClusterGrid::ClusterRange& shared = grid.GetCluster(8, 4, slice);
+		CHECK(shared.count == 2);
+		CHECK(grid.GetLightIndices()[shared.offset] == 0);
+		CHECK(grid.GetLightIndices()[shared.offset + 1] == 1);
+
+		const LightClusterGrid::ClusterRange& left = grid.GetCluster(7, 4, slice);
+		CHECK(left.count == 1);
+		CHECK(grid.GetLightIndices()[left.offset] == 1);
+	}
+
+	CHECK(grid.GetCluster(8, 4, 14).count == 0);
+	CHECK(grid.GetCluster(9, 4, 15).count == 0);
+	CHECK(grid.GetCluster(8, 3, 15).count == 0);
+}
+
+static void TestBuildOverBudget()
+{
+	LightClusterGrid grid;
+	grid.Build(std::vector<Vector4f>(10, { 0.625f, 0.0f, -10.0f, 0.2f }), 12);
+
+	// Cluster of slice 15 comes first and takes 10, slice 16 gets what's left
+	CHECK(grid.GetLightIndices().size() == 12);
+	CHECK(grid.GetDroppedLightIndexCount() == 8);
+	CHECK(grid.GetCluster(8, 4, 15).count == 10);
+	CHECK(grid.GetCluster(8, 4, 16).count == 2);
+	CHECK(grid.GetLightIndices()[grid.GetCluster(8, 4, 16).offset] == 0);
+	CHECK(grid.GetLightIndices()[grid.GetCluster(8, 4, 16).offset + 1] == 1);
+
+	uint32_t totalCount = 0;
+	for (auto& cluster : grid.GetClusters())
+	{
+		CHECK(cluster.offset + cluster.count <= (uint32_t)grid.GetLightIndices().size());
+		totalCount += cluster.count;
+	}
+	CHECK(totalCount == 12);
+}
+
+int main()
+{
+	TestSphereWithinOneTile();
+	TestSphereOnAxis();
+	TestSphereStraddlingRowBoundary();
+	TestSphereBehindCamera();
+	TestSphereOutsideFrustum();
+	TestBuild();
+	TestBuildOverBudget();
+
+	if (g_failureCount == 0)
+		printf("All light cluster grid tests passed\n");
+
+	return g_failureCount == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "../Maths/MaskedOcclusionBuffer.h"
+#include <cstdio>
+#include <random>
+
+// Camera looks towards -z with 90 degree fov both ways, so clip x and y are view x and y, and w is view depth
+// Occlusion buffer depth is 1/w, an occluder at depth 5 has depth 0.2
+// Screen x of view x at depth d is "(x / d * 0.5 + 0.5) * WIDTH"
+
+static uint32_t g_failureCount = 0;
+
+#define CHECK(expr) \
+	do { if (!(expr)) { printf("%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #expr); g_failureCount++; } } while (0)
+
+static Matrix4f GetViewToClip()
+{
+	return Matrix4f({ 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 0, -1 }, { 0, 0, 0.1f, 0 });
+}
+
+// Rectangle facing camera at "depth"
+static void AddRectOccluder(MaskedOcclusionBuffer& buffer, float minX, float minY, float maxX, float maxY, float depth)
+{
+	std::vector<Vector3f> positions = { { minX, minY, -depth }, { maxX, minY, -depth }, { maxX, maxY, -depth }, { minX, maxY, -depth } };
+	buffer.AddOccluder(GetViewToClip(), positions, { 0, 2, 1, 0, 3, 2 });
+}
+
+static bool TestBox(const MaskedOcclusionBuffer& buffer, double minX, double minY, double minDepth, double maxX, double maxY, double maxDepth)
+{
+	return buffer.TestAABB(GetViewToClip().DoublePrecision(), BoundingBoxd({ minX, minY, -maxDepth }, { maxX, maxY, -minDepth }));
+}
+
+static void TestFullScreenOccluder()
+{
+	MaskedOcclusionBuffer buffer;
+	// Goes beyond frustum on every side, so it's clipped
+	AddRectOccluder(buffer, -10.0f, -10.0f, 10.0f, 10.0f, 5.0f);
+	buffer.Rasterize();
+
+	CHECK(buffer.GetTriangleCount() != 0);
+	for (uint32_t tileY = 0; tileY < MaskedOcclusionBuffer::TILE_ROW_COUNT; tileY++)
+	{
+		for (uint32_t tileX = 0; tileX < MaskedOcclusionBuffer::TILE_COLUMN_COUNT; tileX++)
+		{
+			CHECK(std::abs(buffer.GetTile(tileX, tileY).depth0 - 0.2f) < 1e-5f);
+			CHECK(buffer.GetTile(tileX, tileY).mask == 0);
+		}
+	}
+
+	// Behind occluder, including a box partially off screen
+	CHECK(!TestBox(buffer, -1, -1, 15, 1, 1, 20));
+	CHECK(!TestBox(buffer, 10, -1, 15, 30, 1, 20));
+	// In front of occluder, and crossing it
+	CHECK(TestBox(buffer, -1, -1, 3, 1, 1, 4));
+	CHECK(TestBox(buffer, -1, -1, 4, 1, 1, 6));
+	// Crossing near plane
+	CHECK(TestBox(buffer, -1, -1, -1, 1, 1, 20));
+	// Entirely off screen boxes are left to frustum culling
+	CHECK(TestBox(buffer, 30, -1, 15, 40, 1, 20));
+}
+
+static void TestPartialCoverage()
+{
+	MaskedOcclusionBuffer buffer;
+	// Right edge at screen x 100, in the middle of tile column 12, which spans pixels 96 to 103
+	AddRectOccluder(buffer, -10.0f, -10.0f, -1.09375f, 10.0f, 5.0f);
+	buffer.Rasterize();
+
+	for (uint32_t tileY = 0; tileY < MaskedOcclusionBuffer::TILE_ROW_COUNT; tileY++)
+	{
+		CHECK(std::abs(buffer.GetTile(11, tileY).depth0 - 0.2f) < 1e-5f);
+
+		// Left 4 pixels of every row are in working layer
+		CHECK(buffer.GetTile(12, tileY).depth0 == 0);
+		CHECK(buffer.GetTile(12, tileY).mask == 0x0f0f0f0f);
+		CHECK(std::abs(buffer.GetTile(12, tileY).depth1 - 0.2f) < 1e-5f);
+
+		CHECK(buffer.GetTile(13, tileY).depth0 == 0);
+		CHECK(buffer.GetTile(13, tileY).mask == 0);
+	}
+
+	// Box projects onto screen x 96.8 to 98.9 at depth 20, covered pixels of edge tile hide it
+	CHECK(!TestBox(buffer, -4.84375, -1, 19.9, -4.53125, 1, 20));
+	// Box reaches pixels right of occluder edge
+	CHECK(TestBox(buffer, -4.84375, -1, 19.9, -3.0, 1, 20));
+	// Box behind whole tiles, and box straddling occluder edge
+	CHECK(!TestBox(buffer, -10, -1, 19.9, -6, 1, 20));
+	CHECK(TestBox(buffer, -6, -1, 19.9, 1, 1, 20));
+}
+
+static void TestMergedCoverage()
+{
+	MaskedOcclusionBuffer buffer;
+	// Two halves of the screen rasterized one after another, at different depths
+	AddRectOccluder(buffer, -10.0f, -10.0f, 0.0f, 10.0f, 5.0f);
+	AddRectOccluder(buffer, 0.0f, -10.0f, 10.0f, 10.0f, 8.0f);
+	buffer.Rasterize();
+
+	// Farther one decides depth where both meet
+	CHECK(std::abs(buffer.GetTile(0, 0).depth0 - 0.2f) < 1e-5f);
+	CHECK(std::abs(buffer.GetTile(MaskedOcclusionBuffer::TILE_COLUMN_COUNT - 1, 0).depth0 - 0.125f) < 1e-5f);
+	CHECK(!TestBox(buffer, -1, -1, 15, 1, 1, 20));
+	// Between the two occluders
+	CHECK(TestBox(buffer, 1, -1, 6, 2, 1, 7));
+	CHECK(!TestBox(buffer, -2, -1, 6, -1, 1, 7));
+}
+
+static void TestParallelMatchesSerial()
+{
+	MaskedOcclusionBuffer serial;
+	MaskedOcclusionBuffer parallel;
+
+	// Enough small overlapping triangles at random depths to go parallel
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> position(-12.0f, 12.0f);
+	std::uniform_real_distribution<float> size(-3.0f, 3.0f);
+	std::uniform_real_distribution<float> depth(2.0f, 20.0f);
+
+	std::vector<Vector3f> positions;
+	std::vector<uint32_t> indices;
+	for (uint32_t i = 0; i < 4 * MaskedOcclusionBuffer::PARALLEL_TRIANGLE_THRESHOLD; i++)
+	{
+		Vector3f center(position(random), position(random), -depth(random));
+		for (uint32_t j = 0; j < 3; j++)
+		{
+			indices.push_back((uint32_t)positions.size());
+			positions.push_back(center + Vector3f(size(random), size(random), size(random)));
+		}
+	}
+
+	serial.AddOccluder(GetViewToClip(), positions, indices);
+	parallel.AddOccluder(GetViewToClip(), positions, indices);
+	CHECK(parallel.GetTriangleCount() >= MaskedOcclusionBuffer::PARALLEL_TRIANGLE_THRESHOLD);
+
+	serial.Rasterize();
+	parallel.RasterizeParallel();
+
+	for (uint32_t tileY = 0; tileY < MaskedOcclusionBuffer::TILE_ROW_COUNT; tileY++)
+	{
+		for (uint32_t tileX = 0; tileX < MaskedOcclusionBuffer::TILE_COLUMN_COUNT; tileX++)
+		{
+			const MaskedOcclusionBuffer::Tile& serialTile = serial.GetTile(tileX, tileY);
+			const MaskedOcclusionBuffer::Tile& parallelTile = parallel.GetTile(tileX, tileY);
+			CHECK(serialTile.mask == parallelTile.mask);
+			CHECK(serialTile.depth0 == parallelTile.depth0);
+			CHECK(serialTile.mask == 0 || serialTile.depth1 == parallelTile.depth1);
+		}
+	}
+}
+
+int main()
+{
+	TestFullScreenOccluder();
+	TestPartialCoverage();
+	TestMergedCoverage();
+	TestParallelMatchesSerial();
+
+	if (g_failureCount == 0)
+		printf("All masked occlusion buffer tests passed\n");
+
+	return g_failureCount == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "WorkerPool.hpp"
+#include <algorithm>
+
+bool WorkerPool::Init()
+{
+	if (!Singleton<WorkerPool>::Init())
+		return false;
+
+	uint32_t workerCount = (std::max)(std::thread::hardware_concurrency(), 1u) - 1;
+	for (uint32_t i = 0; i < workerCount; i++)
+		m_workers.push_back(std::thread(&WorkerPool::Loop, this));
+
+	return true;
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_isDestroying = true;
+	}
+	m_taskCondition.notify_all();
+
+	for (auto& worker : m_workers)
+		worker.join();
+}
+
+void WorkerPool::Loop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_taskCondition.wait(lock, [this] { return m_nextTask < m_taskCount || m_isDestroying; });
+
+		if (m_isDestroying)
+			break;
+
+		uint32_t task = m_nextTask++;
+		const std::function<void(uint32_t)>* pFunc = m_pFunc;
+
+		lock.unlock();
+		(*pFunc)(task);
+		lock.lock();
+
+		if (--m_pendingTaskCount == 0)
+			m_doneCondition.notify_all();
+	}
+}
+
+void WorkerPool::ParallelFor(uint32_t taskCount, const std::function<void(uint32_t)>& func)
+{
+	if (taskCount == 0)
+		return;
+
+	std::unique_lock<std::mutex> callLock(m_callMutex);
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	m_pFunc = &func;
+	m_taskCount = taskCount;
+	m_nextTask = 0;
+	m_pendingTaskCount = taskCount;
+	m_taskCondition.notify_all();
+
+	// Calling thread works too rather than waiting idle
+	while (m_nextTask < m_taskCount)
+	{
+		uint32_t task = m_nextTask++;
+
+		lock.unlock();
+		func(task);
+		lock.lock();
+
+		m_pendingTaskCount--;
+	}
+
+	m_doneCondition.wait(lock, [this] { return m_pendingTaskCount == 0; });
+
+	m_pFunc = nullptr;
+	m_taskCount = 0;
+	m_nextTask = 0;
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+#include <thread>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include "../common/Singleton.h"
+
+// Persistent worker threads for short data parallel jobs within a frame, e.g. BVH queries and occlusion buffer rasterization
+// Threads are created once and sleep between jobs, so a job doesn't pay thread creation every time it runs
+// Unlike ThreadWorker, it has nothing to do with device or per frame resources
+class WorkerPool : public Singleton<WorkerPool>
+{
+public:
+	~WorkerPool();
+
+public:
+	bool Init() override;
+
+	// Worker threads plus the calling thread
+	uint32_t GetConcurrency() const { return (uint32_t)m_workers.size() + 1; }
+
+	// Call "func" with every task index below "taskCount", calling thread takes tasks too, returns when all of them are done
+	// Calls from different threads are serialized, a task mustn't call ParallelFor() itself
+	void ParallelFor(uint32_t taskCount, const std::function<void(uint32_t)>& func);
+
+protected:
+	void Loop();
+
+protected:
+	std::vector<std::thread>	m_workers;
+	std::mutex					m_callMutex;
+
+	// States below are guarded by "m_mutex"
+	std::mutex					m_mutex;
+	std::condition_variable		m_taskCondition;
+	std::condition_variable		m_doneCondition;
+	const std::function<void(uint32_t)>*	m_pFunc = nullptr;
+	uint32_t					m_taskCount = 0;
+	uint32_t					m_nextTask = 0;
+	uint32_t					m_pendingTaskCount = 0;
+	bool						m_isDestroying = false;
+};
\ No newline at end of file
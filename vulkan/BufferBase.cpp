@@ -16,9 +16,9 @@ void BufferBase::PrepareBarriers
 	VkImageLayout				srcImageLayout,
 	VkAccessFlags				dstAccessFlags,
 	VkImageLayout				dstImageLayout,
-	std::vector<VkMemoryBarrier>&		memBarriers,
-	std::vector<VkBufferMemoryBarrier>&	bufferMemBarriers,
-	std::vector<VkImageMemoryBarrier>&	imageMemBarriers
+	FrameVector<VkMemoryBarrier>&		memBarriers,
+	FrameVector<VkBufferMemoryBarrier>&	bufferMemBarriers,
+	FrameVector<VkImageMemoryBarrier>&	imageMemBarriers
 )
 {
 	// We don't do specific buffer memory barrier here
@@ -37,9 +37,9 @@ void BufferBase::PrepareQueueReleaseBarrier
 	VkImageLayout				srcImageLayout,
 	PhysicalDevice::QueueFamily	srcQueueFamily,
 	PhysicalDevice::QueueFamily	dstQueueFamily,
-	std::vector<VkMemoryBarrier>&		memBarriers,
-	std::vector<VkBufferMemoryBarrier>&	bufferMemBarriers,
-	std::vector<VkImageMemoryBarrier>&	imageMemBarriers
+	FrameVector<VkMemoryBarrier>&		memBarriers,
+	FrameVector<VkBufferMemoryBarrier>&	bufferMemBarriers,
+	FrameVector<VkImageMemoryBarrier>&	imageMemBarriers
 )
 {
 	VkBufferMemoryBarrier queueReleaseBarrier;
@@ -65,9 +65,9 @@ void BufferBase::PrepareQueueAcquireBarrier
 	VkImageLayout				dstImageLayout,
 	PhysicalDevice::QueueFamily	srcQueueFamily,
 	PhysicalDevice::QueueFamily	dstQueueFamily,
-	std::vector<VkMemoryBarrier>&		memBarriers,
-	std::vector<VkBufferMemoryBarrier>&	bufferMemBarriers,
-	std::vector<VkImageMemoryBarrier>&	imageMemBarriers
+	FrameVector<VkMemoryBarrier>&		memBarriers,
+	FrameVector<VkBufferMemoryBarrier>&	bufferMemBarriers,
+	FrameVector<VkImageMemoryBarrier>&	imageMemBarriers
 )
 {
 	VkBufferMemoryBarrier queueAcquireBarrier;
@@ -21,9 +21,9 @@ public:
 		VkImageLayout				srcImageLayout,
 		VkAccessFlags				dstAccessFlags,
 		VkImageLayout				dstImageLayout,
-		std::vector<VkMemoryBarrier>&		memBarriers,
-		std::vector<VkBufferMemoryBarrier>&	bufferMemBarriers,
-		std::vector<VkImageMemoryBarrier>&	imageMemBarriers
+		FrameVector<VkMemoryBarrier>&		memBarriers,
+		FrameVector<VkBufferMemoryBarrier>&	bufferMemBarriers,
+		FrameVector<VkImageMemoryBarrier>&	imageMemBarriers
 	) override;
 
 	void PrepareQueueReleaseBarrier
@@ -32,9 +32,9 @@ public:
 		VkImageLayout				srcImageLayout,
 		PhysicalDevice::QueueFamily	srcQueueFamily,
 		PhysicalDevice::QueueFamily	dstQueueFamily,
-		std::vector<VkMemoryBarrier>&		memBarriers,
-		std::vector<VkBufferMemoryBarrier>&	bufferMemBarriers,
-		std::vector<VkImageMemoryBarrier>&	imageMemBarriers
+		FrameVector<VkMemoryBarrier>&		memBarriers,
+		FrameVector<VkBufferMemoryBarrier>&	bufferMemBarriers,
+		FrameVector<VkImageMemoryBarrier>&	imageMemBarriers
 	) override;
 
 	void PrepareQueueAcquireBarrier
@@ -43,9 +43,9 @@ public:
 		VkImageLayout				dstImageLayout,
 		PhysicalDevice::QueueFamily	srcQueueFamily,
 		PhysicalDevice::QueueFamily	dstQueueFamily,
-		std::vector<VkMemoryBarrier>&		memBarriers,
-		std::vector<VkBufferMemoryBarrier>&	bufferMemBarriers,
-		std::vector<VkImageMemoryBarrier>&	imageMemBarriers
+		FrameVector<VkMemoryBarrier>&		memBarriers,
+		FrameVector<VkBufferMemoryBarrier>&	bufferMemBarriers,
+		FrameVector<VkImageMemoryBarrier>&	imageMemBarriers
 	) override;
 
 	virtual uint32_t GetBufferOffset() const = 0;
@@ -15,6 +15,7 @@
 #include "../vulkan/GlobalVulkanStates.h"
 #include "GlobalDeviceObjects.h"
 #include "IndirectBuffer.h"
+#include "QueryPool.h"
 #include "../common/Enums.h"
 
 CommandBuffer::~CommandBuffer()
@@ -95,7 +96,7 @@ void CommandBuffer::PrepareNormalDrawCommands(const DrawCmdData& data)
 	vkCmdSetViewport(GetDeviceHandle(), 0, 1, &viewport);
 	vkCmdSetScissor(GetDeviceHandle(), 0, 1, &scissorRect);
 
-	std::vector<VkDescriptorSet> dsSets;
+	FrameVector<VkDescriptorSet> dsSets;
 	for (uint32_t i = 0; i < data.descriptorSets.size(); i++)
 		dsSets.push_back(data.descriptorSets[i]->GetDeviceHandle());
 
@@ -103,8 +104,8 @@ void CommandBuffer::PrepareNormalDrawCommands(const DrawCmdData& data)
 
 	vkCmdBindPipeline(GetDeviceHandle(), VK_PIPELINE_BIND_POINT_GRAPHICS, data.pPipeline->GetDeviceHandle());
 
-	std::vector<VkBuffer> vertexBuffers;
-	std::vector<VkDeviceSize> offsets;
+	FrameVector<VkBuffer> vertexBuffers;
+	FrameVector<VkDeviceSize> offsets;
 	for (uint32_t i = 0; i < data.vertexBuffers.size(); i++)
 	{
 		vertexBuffers.push_back(data.vertexBuffers[i]->GetDeviceHandle());
@@ -122,9 +123,9 @@ void CommandBuffer::PrepareNormalDrawCommands(const DrawCmdData& data)
 	m_drawCmdData = data;
 }
 
-void CommandBuffer::IssueBarriersBeforeCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const std::vector<VkBufferCopy>& regions)
+void CommandBuffer::IssueBarriersBeforeCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const FrameVector<VkBufferCopy>& regions)
 {
-	std::vector<VkBufferMemoryBarrier> bufferBarriers;
+	FrameVector<VkBufferMemoryBarrier> bufferBarriers;
 
 	// Src barriers
 	for (uint32_t i = 0; i < regions.size(); i++)
@@ -173,9 +174,9 @@ void CommandBuffer::IssueBarriersBeforeCopy(const std::shared_ptr<BufferBase>& p
 	);
 }
 
-void CommandBuffer::IssueBarriersAfterCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const std::vector<VkBufferCopy>& regions)
+void CommandBuffer::IssueBarriersAfterCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const FrameVector<VkBufferCopy>& regions)
 {
-	std::vector<VkBufferMemoryBarrier> bufferBarriers;
+	FrameVector<VkBufferMemoryBarrier> bufferBarriers;
 
 	// Src barriers
 	for (uint32_t i = 0; i < regions.size(); i++)
@@ -226,7 +227,7 @@ void CommandBuffer::IssueBarriersAfterCopy(const std::shared_ptr<BufferBase>& pS
 
 void CommandBuffer::IssueBarriersBeforeCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkBufferImageCopy>& regions) 
 {
-	std::vector<VkBufferMemoryBarrier> bufferBarriers;
+	FrameVector<VkBufferMemoryBarrier> bufferBarriers;
 	
 	for (uint32_t i = 0; i < regions.size(); i++)
 	{
@@ -254,7 +255,7 @@ void CommandBuffer::IssueBarriersBeforeCopy(const std::shared_ptr<BufferBase>& p
 		{}
 	);
 
-	std::vector<VkImageMemoryBarrier> imgBarriers;
+	FrameVector<VkImageMemoryBarrier> imgBarriers;
 
 	for (uint32_t i = 0; i < regions.size(); i++)
 	{
@@ -291,7 +292,7 @@ void CommandBuffer::IssueBarriersBeforeCopy(const std::shared_ptr<BufferBase>& p
 }
 void CommandBuffer::IssueBarriersAfterCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkBufferImageCopy>& regions)
 {
-	std::vector<VkBufferMemoryBarrier> bufferBarriers;
+	FrameVector<VkBufferMemoryBarrier> bufferBarriers;
 
 	for (uint32_t i = 0; i < regions.size(); i++)
 	{
@@ -319,7 +320,7 @@ void CommandBuffer::IssueBarriersAfterCopy(const std::shared_ptr<BufferBase>& pS
 		{}
 	);
 
-	std::vector<VkImageMemoryBarrier> imgBarriers;
+	FrameVector<VkImageMemoryBarrier> imgBarriers;
 
 	for (uint32_t i = 0; i < regions.size(); i++)
 	{
@@ -355,9 +356,112 @@ void CommandBuffer::IssueBarriersAfterCopy(const std::shared_ptr<BufferBase>& pS
 	);
 }
 
+void CommandBuffer::IssueBarriersBeforeCopy(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<BufferBase>& pDst, const std::vector<VkBufferImageCopy>& regions)
+{
+	FrameVector<VkImageMemoryBarrier> imgBarriers;
+
+	for (uint32_t i = 0; i < regions.size(); i++)
+	{
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = regions[i].imageSubresource.aspectMask;
+		subresourceRange.baseMipLevel = regions[i].imageSubresource.mipLevel;
+		subresourceRange.levelCount = 1;
+		subresourceRange.baseArrayLayer = regions[i].imageSubresource.baseArrayLayer;
+		subresourceRange.layerCount = regions[i].imageSubresource.layerCount;
+
+		// Image could be written by shaders right before readback, e.g. precomputed by compute shaders
+		VkImageMemoryBarrier imgBarrier = {};
+		imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imgBarrier.image = pSrc->GetDeviceHandle();
+		imgBarrier.subresourceRange = subresourceRange;
+		imgBarrier.oldLayout = pSrc->GetImageInfo().initialLayout;
+		imgBarrier.srcAccessMask = pSrc->GetAccessFlags() | VK_ACCESS_SHADER_WRITE_BIT;
+		imgBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imgBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		imgBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		imgBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+		imgBarriers.push_back(imgBarrier);
+	}
+
+	AttachBarriers
+	(
+		pSrc->GetAccessStages(),
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		{},
+		{},
+		imgBarriers
+	);
+}
+
+void CommandBuffer::IssueBarriersAfterCopy(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<BufferBase>& pDst, const std::vector<VkBufferImageCopy>& regions)
+{
+	FrameVector<VkBufferMemoryBarrier> bufferBarriers;
+
+	for (uint32_t i = 0; i < regions.size(); i++)
+	{
+		VkBufferMemoryBarrier bufferBarrier = {};
+		bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		bufferBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		bufferBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		bufferBarrier.buffer = pDst->GetDeviceHandle();
+		bufferBarrier.offset = regions[i].bufferOffset;
+
+		if (i < regions.size() - 1)
+			bufferBarrier.size = regions[i + 1].bufferOffset - regions[i].bufferOffset;
+		else
+			bufferBarrier.size = pDst->GetBufferInfo().size - regions[i].bufferOffset;
+
+		bufferBarriers.push_back(bufferBarrier);
+	}
+
+	AttachBarriers
+	(
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT,
+		{},
+		bufferBarriers,
+		{}
+	);
+
+	FrameVector<VkImageMemoryBarrier> imgBarriers;
+
+	for (uint32_t i = 0; i < regions.size(); i++)
+	{
+		VkImageSubresourceRange subresourceRange = {};
+		subresourceRange.aspectMask = regions[i].imageSubresource.aspectMask;
+		subresourceRange.baseMipLevel = regions[i].imageSubresource.mipLevel;
+		subresourceRange.levelCount = 1;
+		subresourceRange.baseArrayLayer = regions[i].imageSubresource.baseArrayLayer;
+		subresourceRange.layerCount = regions[i].imageSubresource.layerCount;
+
+		VkImageMemoryBarrier imgBarrier = {};
+		imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imgBarrier.image = pSrc->GetDeviceHandle();
+		imgBarrier.subresourceRange = subresourceRange;
+		imgBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		imgBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		imgBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imgBarrier.newLayout = pSrc->GetImageInfo().initialLayout;
+		imgBarrier.dstAccessMask = pSrc->GetAccessFlags();
+		imgBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+		imgBarriers.push_back(imgBarrier);
+	}
+
+	AttachBarriers
+	(
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		pSrc->GetAccessStages(),
+		{},
+		{},
+		imgBarriers
+	);
+}
+
 void CommandBuffer::IssueBarriersBeforeCopy(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkImageCopy>& regions) 
 {
-	std::vector<VkImageMemoryBarrier> imgBarriers;
+	FrameVector<VkImageMemoryBarrier> imgBarriers;
 
 	for (uint32_t i = 0; i < regions.size(); i++)
 	{
@@ -422,7 +526,7 @@ void CommandBuffer::IssueBarriersBeforeCopy(const std::shared_ptr<Image>& pSrc,
 
 void CommandBuffer::IssueBarriersAfterCopy(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkImageCopy>& regions) 
 {
-	std::vector<VkImageMemoryBarrier> imgBarriers;
+	FrameVector<VkImageMemoryBarrier> imgBarriers;
 
 	for (uint32_t i = 0; i < regions.size(); i++)
 	{
@@ -587,7 +691,7 @@ void CommandBuffer::IssueBarriersAfterCopy(const std::shared_ptr<Image>& pSrc, c
 	);
 }
 
-void CommandBuffer::CopyBuffer(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const std::vector<VkBufferCopy>& regions)
+void CommandBuffer::CopyBuffer(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const FrameVector<VkBufferCopy>& regions)
 {
 	IssueBarriersBeforeCopy(pSrc, pDst, regions);
 
@@ -681,6 +785,23 @@ void CommandBuffer::CopyBufferImage(const std::shared_ptr<Buffer>& pSrc, const s
 	AddToReferenceTable(pDst);
 }
 
+void CommandBuffer::CopyImageBuffer(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Buffer>& pDst, const std::vector<VkBufferImageCopy>& regions)
+{
+	IssueBarriersBeforeCopy(pSrc, pDst, regions);
+
+	vkCmdCopyImageToBuffer(GetDeviceHandle(),
+		pSrc->GetDeviceHandle(),
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		pDst->GetDeviceHandle(),
+		(uint32_t)regions.size(),
+		regions.data());
+
+	IssueBarriersAfterCopy(pSrc, pDst, regions);
+
+	AddToReferenceTable(pSrc);
+	AddToReferenceTable(pDst);
+}
+
 void CommandBuffer::PushConstants(const std::shared_ptr<PipelineLayout>& pPipelineLayout, VkShaderStageFlags shaderFlag, uint32_t offset, uint32_t size, const void* pData)
 {
 	vkCmdPushConstants(GetDeviceHandle(), pPipelineLayout->GetDeviceHandle(), shaderFlag, offset, size, pData);
@@ -693,7 +814,7 @@ void CommandBuffer::PrepareBufferCopyCommands(const BufferCopyCmdData& data)
 	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 	CHECK_VK_ERROR(vkBeginCommandBuffer(GetDeviceHandle(), &beginInfo));
 
-	std::vector<VkBufferMemoryBarrier> barriers;
+	FrameVector<VkBufferMemoryBarrier> barriers;
 	VkPipelineStageFlagBits srcStages;
 	VkPipelineStageFlagBits dstStages;
 
@@ -831,7 +952,7 @@ void CommandBuffer::EndSecondaryRecording()
 
 void CommandBuffer::ExecuteSecondaryCommandBuffer(const std::vector<std::shared_ptr<CommandBuffer>>& cmdBuffers)
 {
-	std::vector<VkCommandBuffer> rawCmdBuffers;
+	FrameVector<VkCommandBuffer> rawCmdBuffers;
 	std::for_each(cmdBuffers.begin(), cmdBuffers.end(), [&rawCmdBuffers](auto& pCmdBuffer) {rawCmdBuffers.push_back(pCmdBuffer->GetDeviceHandle());});
 	vkCmdExecuteCommands(GetDeviceHandle(), (uint32_t)rawCmdBuffers.size(), rawCmdBuffers.data());
 
@@ -843,9 +964,9 @@ void CommandBuffer::AttachBarriers
 (
 	VkPipelineStageFlags src,
 	VkPipelineStageFlags dst,
-	const std::vector<VkMemoryBarrier>& memBarriers,
-	const std::vector<VkBufferMemoryBarrier>& bufferMemBarriers,
-	const std::vector<VkImageMemoryBarrier>& imageMemBarriers
+	const FrameVector<VkMemoryBarrier>& memBarriers,
+	const FrameVector<VkBufferMemoryBarrier>& bufferMemBarriers,
+	const FrameVector<VkImageMemoryBarrier>& imageMemBarriers
 )
 {
 	vkCmdPipelineBarrier
@@ -872,7 +993,7 @@ void CommandBuffer::SetScissors(const std::vector<VkRect2D>& scissors)
 
 void CommandBuffer::BindDescriptorSets(VkPipelineBindPoint bindingPoint, const std::shared_ptr<PipelineLayout>& pPipelineLayout, const std::vector<std::shared_ptr<DescriptorSet>>& descriptorSets, const std::vector<uint32_t>& offsets)
 {
-	std::vector<VkDescriptorSet> rawDSList;
+	FrameVector<VkDescriptorSet> rawDSList;
 	for (uint32_t i = 0; i < (uint32_t)descriptorSets.size(); i++)
 	{
 		AddToReferenceTable(descriptorSets[i]);
@@ -960,7 +1081,7 @@ void CommandBuffer::NextSubpass()
 
 void CommandBuffer::Execute(const std::vector<std::shared_ptr<CommandBuffer>>& cmdBuffers)
 {
-	std::vector<VkCommandBuffer> cmds;
+	FrameVector<VkCommandBuffer> cmds;
 	for (auto& cmd : cmdBuffers)
 	{
 		cmds.push_back(cmd->GetDeviceHandle());
@@ -975,6 +1096,23 @@ void CommandBuffer::Dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_
 	vkCmdDispatch(GetDeviceHandle(), groupCountX, groupCountY, groupCountZ);
 }
 
+void CommandBuffer::DispatchIndirect(const std::shared_ptr<BufferBase>& pIndirectBuffer, uint32_t offset)
+{
+	// Same as draw indirect, offset is measured by elements
+	vkCmdDispatchIndirect(GetDeviceHandle(), pIndirectBuffer->GetDeviceHandle(), pIndirectBuffer->GetBufferOffset() + offset * sizeof(VkDispatchIndirectCommand));
+	AddToReferenceTable(pIndirectBuffer);
+}
+
+void CommandBuffer::ResetQueryPool(const std::shared_ptr<QueryPool>& pQueryPool, uint32_t firstQuery, uint32_t queryCount)
+{
+	vkCmdResetQueryPool(GetDeviceHandle(), pQueryPool->GetDeviceHandle(), firstQuery, queryCount);
+}
+
+void CommandBuffer::WriteTimestamp(VkPipelineStageFlagBits stage, const std::shared_ptr<QueryPool>& pQueryPool, uint32_t query)
+{
+	vkCmdWriteTimestamp(GetDeviceHandle(), stage, pQueryPool->GetDeviceHandle(), query);
+}
+
 void CommandBuffer::BeginRenderPass(const std::shared_ptr<FrameBuffer>& pFrameBuffer, const std::shared_ptr<RenderPass>& pRenderPass, const std::vector<VkClearValue>& clearValues, bool includeSecondary)
 {
 	VkRenderPassBeginInfo renderPassBeginInfo = {};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "DeviceObjectBase.h"
+#include "../common/FrameArena.h"
 
 class CommandPool;
 class PipelineBase;
@@ -14,6 +15,7 @@ class BufferBase;
 class Image;
 class PipelineLayout;
 class IndirectBuffer;
+class QueryPool;
 
 class CommandBuffer : public DeviceObjectBase<CommandBuffer>
 {
@@ -86,10 +88,11 @@ public:
 	void PrepareNormalDrawCommands(const DrawCmdData& data);
 	void PrepareBufferCopyCommands(const BufferCopyCmdData& data);
 
-	void CopyBuffer(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const std::vector<VkBufferCopy>& regions);
+	void CopyBuffer(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const FrameVector<VkBufferCopy>& regions);
 	void BlitImage(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Image>& pDst, const VkImageBlit& blit);
 	void CopyImage(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkImageCopy>& regions);
 	void CopyBufferImage(const std::shared_ptr<Buffer>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkBufferImageCopy>& regions);
+	void CopyImageBuffer(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Buffer>& pDst, const std::vector<VkBufferImageCopy>& regions);
 	void GenerateMipmaps(const std::shared_ptr<Image>& pImg, uint32_t layer);
 
 	void PushConstants(const std::shared_ptr<PipelineLayout>& pPipelineLayout, VkShaderStageFlags shaderFlag, uint32_t offset, uint32_t size, const void* pData);
@@ -98,9 +101,9 @@ public:
 	(
 		VkPipelineStageFlags src,
 		VkPipelineStageFlags dst,
-		const std::vector<VkMemoryBarrier>& memBarriers,
-		const std::vector<VkBufferMemoryBarrier>& bufferMemBarriers,
-		const std::vector<VkImageMemoryBarrier>& imageMemBarriers
+		const FrameVector<VkMemoryBarrier>& memBarriers,
+		const FrameVector<VkBufferMemoryBarrier>& bufferMemBarriers,
+		const FrameVector<VkImageMemoryBarrier>& imageMemBarriers
 	);
 
 	void SetViewports(const std::vector<VkViewport>& viewports);
@@ -126,6 +129,10 @@ public:
 	void Execute(const std::vector<std::shared_ptr<CommandBuffer>>& cmdBuffers);
 
 	void Dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+	void DispatchIndirect(const std::shared_ptr<BufferBase>& pIndirectBuffer, uint32_t offset);
+
+	void ResetQueryPool(const std::shared_ptr<QueryPool>& pQueryPool, uint32_t firstQuery, uint32_t queryCount);
+	void WriteTimestamp(VkPipelineStageFlagBits stage, const std::shared_ptr<QueryPool>& pQueryPool, uint32_t query);
 
 protected:
 	static std::shared_ptr<CommandBuffer> Create(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<CommandPool>& pCmdPool, CBLevel level);
@@ -134,12 +141,15 @@ protected:
 	bool IsValide() const { m_isValide; }
 	void SetIsValide(bool flag) { m_isValide = flag; }
 
-	void IssueBarriersBeforeCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const std::vector<VkBufferCopy>& regions);
-	void IssueBarriersAfterCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const std::vector<VkBufferCopy>& regions);
+	void IssueBarriersBeforeCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const FrameVector<VkBufferCopy>& regions);
+	void IssueBarriersAfterCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<BufferBase>& pDst, const FrameVector<VkBufferCopy>& regions);
 
 	void IssueBarriersBeforeCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkBufferImageCopy>& regions);
 	void IssueBarriersAfterCopy(const std::shared_ptr<BufferBase>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkBufferImageCopy>& regions);
 
+	void IssueBarriersBeforeCopy(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<BufferBase>& pDst, const std::vector<VkBufferImageCopy>& regions);
+	void IssueBarriersAfterCopy(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<BufferBase>& pDst, const std::vector<VkBufferImageCopy>& regions);
+
 	void IssueBarriersBeforeCopy(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkImageCopy>& regions);
 	void IssueBarriersAfterCopy(const std::shared_ptr<Image>& pSrc, const std::shared_ptr<Image>& pDst, const std::vector<VkImageCopy>& regions);
 
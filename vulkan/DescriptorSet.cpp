@@ -5,6 +5,7 @@
 #include "Image.h"
 #include "UniformBuffer.h"
 #include "ShaderStorageBuffer.h"
+#include "SharedIndirectBuffer.h"
 #include "ImageView.h"
 #include "Sampler.h"
 
@@ -60,7 +61,7 @@ void DescriptorSet::UpdateUniformBufferDynamic(uint32_t binding, const std::shar
 
 	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
 
-	m_resourceTable.push_back(pBuffer);
+	m_resourceTable[binding] = { pBuffer };
 }
 
 void DescriptorSet::UpdateUniformBuffer(uint32_t binding, const std::shared_ptr<UniformBuffer>& pBuffer)
@@ -77,7 +78,7 @@ void DescriptorSet::UpdateUniformBuffer(uint32_t binding, const std::shared_ptr<
 
 	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
 
-	m_resourceTable.push_back(pBuffer);
+	m_resourceTable[binding] = { pBuffer };
 }
 
 void DescriptorSet::UpdateImage(uint32_t binding, const std::shared_ptr<Image>& pImage, const std::shared_ptr<Sampler> pSampler, const std::shared_ptr<ImageView> pImageView, bool isStorageImage)
@@ -97,10 +98,7 @@ void DescriptorSet::UpdateImage(uint32_t binding, const std::shared_ptr<Image>&
 
 	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
 
-	m_resourceTable.push_back(pImage);
-
-	AddToReferenceTable(pSampler);
-	AddToReferenceTable(pImageView);
+	m_resourceTable[binding] = { pImage, pSampler, pImageView };
 }
 
 void DescriptorSet::UpdateImage(uint32_t binding, const CombinedImage& image, bool isStorageImage)
@@ -120,10 +118,7 @@ void DescriptorSet::UpdateImage(uint32_t binding, const CombinedImage& image, bo
 
 	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
 
-	m_resourceTable.push_back(image.pImage);
-
-	AddToReferenceTable(image.pSampler);
-	AddToReferenceTable(image.pImageView);
+	m_resourceTable[binding] = { image.pImage, image.pSampler, image.pImageView };
 }
 
 void DescriptorSet::UpdateImages(uint32_t binding, const std::vector<CombinedImage>& images, bool isStorageImage)
@@ -136,6 +131,7 @@ void DescriptorSet::UpdateImages(uint32_t binding, const std::vector<CombinedIma
 	writeData[0].dstSet = GetDeviceHandle();
 
 	std::vector<VkDescriptorImageInfo> info;
+	std::vector<std::shared_ptr<Base>> resources;
 	for (uint32_t i = 0; i < images.size(); i++)
 	{
 		info.push_back({
@@ -144,10 +140,11 @@ void DescriptorSet::UpdateImages(uint32_t binding, const std::vector<CombinedIma
 			images[i].pImage->GetImageInfo().initialLayout
 			});
 
-		m_resourceTable.push_back(images[i].pImage);
-		AddToReferenceTable(images[i].pSampler);
-		AddToReferenceTable(images[i].pImageView);
+		resources.push_back(images[i].pImage);
+		resources.push_back(images[i].pSampler);
+		resources.push_back(images[i].pImageView);
 	}
+	m_resourceTable[binding] = resources;
 	writeData[0].pImageInfo = info.data();
 
 	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
@@ -171,10 +168,7 @@ void DescriptorSet::UpdateInputImage(uint32_t binding, const std::shared_ptr<Ima
 
 	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
 
-	m_resourceTable.push_back(pImage);
-
-	AddToReferenceTable(pSampler);
-	AddToReferenceTable(pImageView);
+	m_resourceTable[binding] = { pImage, pSampler, pImageView };
 }
 
 void DescriptorSet::UpdateTexBuffer(uint32_t binding, const VkBufferView& texBufferView)
@@ -204,7 +198,7 @@ void DescriptorSet::UpdateShaderStorageBufferDynamic(uint32_t binding, const std
 
 	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
 
-	m_resourceTable.push_back(pBuffer);
+	m_resourceTable[binding] = { pBuffer };
 }
 
 void DescriptorSet::UpdateShaderStorageBuffer(uint32_t binding, const std::shared_ptr<ShaderStorageBuffer>& pBuffer)
@@ -221,5 +215,39 @@ void DescriptorSet::UpdateShaderStorageBuffer(uint32_t binding, const std::share
 
 	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
 
-	m_resourceTable.push_back(pBuffer);
+	m_resourceTable[binding] = { pBuffer };
+}
+
+void DescriptorSet::UpdateShaderStorageBuffer(uint32_t binding, const std::shared_ptr<SharedIndirectBuffer>& pBuffer)
+{
+	std::vector<VkWriteDescriptorSet> writeData = { {} };
+	writeData[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writeData[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	writeData[0].dstBinding = binding;
+	writeData[0].descriptorCount = 1;
+	writeData[0].dstSet = GetDeviceHandle();
+
+	VkDescriptorBufferInfo info = pBuffer->GetDescBufferInfo();
+	writeData[0].pBufferInfo = &info;
+
+	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
+
+	m_resourceTable[binding] = { pBuffer };
+}
+
+void DescriptorSet::UpdateShaderStorageBuffer(uint32_t binding, const std::shared_ptr<Buffer>& pBuffer)
+{
+	std::vector<VkWriteDescriptorSet> writeData = { {} };
+	writeData[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writeData[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	writeData[0].dstBinding = binding;
+	writeData[0].descriptorCount = 1;
+	writeData[0].dstSet = GetDeviceHandle();
+
+	VkDescriptorBufferInfo info = { pBuffer->GetDeviceHandle(), 0, VK_WHOLE_SIZE };
+	writeData[0].pBufferInfo = &info;
+
+	vkUpdateDescriptorSets(GetDevice()->GetDeviceHandle(), (uint32_t)writeData.size(), writeData.data(), 0, nullptr);
+
+	m_resourceTable[binding] = { pBuffer };
 }
\ No newline at end of file
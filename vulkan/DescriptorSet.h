@@ -7,6 +7,8 @@ class DescriptorPool;
 class DescriptorSetLayout;
 class UniformBuffer;
 class ShaderStorageBuffer;
+class SharedIndirectBuffer;
+class Buffer;
 class Image;
 class Sampler;
 class ImageView;
@@ -38,6 +40,10 @@ public:
 	void UpdateUniformBuffer(uint32_t binding, const std::shared_ptr<UniformBuffer>& pBuffer);
 	void UpdateShaderStorageBufferDynamic(uint32_t binding, const std::shared_ptr<ShaderStorageBuffer>& pBuffer);
 	void UpdateShaderStorageBuffer(uint32_t binding, const std::shared_ptr<ShaderStorageBuffer>& pBuffer);
+	// Indirect buffer bound as a storage buffer, so that draw commands and counts could be written by compute shaders
+	void UpdateShaderStorageBuffer(uint32_t binding, const std::shared_ptr<SharedIndirectBuffer>& pBuffer);
+	// Whole buffer bound as a storage buffer, e.g. internal buffer of a shared buffer manager, so that all chunks could be accessed
+	void UpdateShaderStorageBuffer(uint32_t binding, const std::shared_ptr<Buffer>& pBuffer);
 	void UpdateImage(uint32_t binding, const std::shared_ptr<Image>& pImage, const std::shared_ptr<Sampler> pSampler, const std::shared_ptr<ImageView> pImageView, bool isStorageImage = false);
 	void UpdateImage(uint32_t binding, const CombinedImage& image, bool isStorageImage = false);
 	void UpdateImages(uint32_t binding, const std::vector<CombinedImage>& images, bool isStorageImage = false);
@@ -55,5 +61,6 @@ protected:
 	VkDescriptorSet									m_descriptorSet;
 	std::shared_ptr<DescriptorPool>					m_pDescriptorPool;
 	std::shared_ptr<DescriptorSetLayout>			m_pDescriptorSetLayout;
-	std::vector<std::shared_ptr<VKGPUSyncRes>>		m_resourceTable;
+	// Resources referenced by each binding, released once the binding is updated with something else
+	std::map<uint32_t, std::vector<std::shared_ptr<Base>>>	m_resourceTable;
 };
\ No newline at end of file
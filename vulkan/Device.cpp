@@ -56,12 +56,20 @@ bool Device::Init(const std::shared_ptr<Instance>& pInst, const std::shared_ptr<
 	enabledFeatures.vertexPipelineStoresAndAtomics = 1;
 	enabledFeatures.fragmentStoresAndAtomics = 1;
 	enabledFeatures.depthBiasClamp = 1;
+	// Two channel storage image of Hi-Z
+	enabledFeatures.shaderStorageImageExtendedFormats = 1;
 	deviceCreateInfo.pEnabledFeatures = &enabledFeatures;
 
 	// Vulkan 1.2 feature
 	VkPhysicalDeviceVulkan12Features vulkan12Features = {};
 	vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
 	vulkan12Features.drawIndirectCount = true;
+
+	// Timeline semaphores for frame submission and cpu waits, fences are used if not supported
+	m_timelineSemaphoreEnabled = m_pPhysicalDevice->IsTimelineSemaphoreSupported();
+	if (m_timelineSemaphoreEnabled)
+		vulkan12Features.timelineSemaphore = true;
+
 	deviceCreateInfo.pNext = (void*)&vulkan12Features;
 
 
@@ -18,6 +18,7 @@ public:
 	const VkDevice GetDeviceHandle() const { return m_device; }
 	const std::shared_ptr<PhysicalDevice> GetPhysicalDevice() const { return m_pPhysicalDevice; }
 	const std::shared_ptr<Instance> GetInstance() const { return m_pVulkanInst; }
+	bool IsTimelineSemaphoreEnabled() const { return m_timelineSemaphoreEnabled; }
 
 public:
 	PFN_vkCmdDrawIndirectCountKHR CmdDrawIndexedIndirectCountKHR() const { return m_fpCmdDrawIndexedIndirectCountKHR; }
@@ -29,6 +30,7 @@ protected:
 	VkDevice							m_device;
 	std::shared_ptr<PhysicalDevice>		m_pPhysicalDevice;
 	std::shared_ptr<Instance>			m_pVulkanInst;
+	bool								m_timelineSemaphoreEnabled = false;
 
 	PFN_vkCmdDrawIndirectCountKHR		m_fpCmdDrawIndexedIndirectCountKHR;
 };
\ No newline at end of file
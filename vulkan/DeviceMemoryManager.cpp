@@ -228,6 +228,7 @@ void DeviceMemoryManager::AllocateImageMemory(uint32_t key, uint32_t numBytes, u
 	allocInfo.allocationSize = numBytes;
 	allocInfo.memoryTypeIndex = typeIndex;
 	CHECK_VK_ERROR(vkAllocateMemory(GetDevice()->GetDeviceHandle(), &allocInfo, nullptr, &node.memory));
+	m_allocatedImageBytes += numBytes;
 
 	offset = 0;
 
@@ -273,6 +274,7 @@ void DeviceMemoryManager::FreeImageMemChunk(uint32_t key)
 	auto index = m_imageMemPoolLookupTable[key];
 
 	vkFreeMemory(GetDevice()->GetDeviceHandle(), m_imageMemPool[index.first].memory, nullptr);
+	m_allocatedImageBytes -= m_imageMemPool[index.first].numBytes;
 
 	//m_imageMemPool.erase(m_imageMemPool.begin() + index.first);
 	m_imageMemPoolLookupTable[key].second = true;
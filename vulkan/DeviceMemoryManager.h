@@ -61,6 +61,8 @@ public:
 	bool UpdateBufferMemChunk(const std::shared_ptr<MemoryKey>& pMemKey, const void* pData, uint32_t offset, uint32_t numBytes);
 	bool UpdateImageMemChunk(const std::shared_ptr<MemoryKey>& pMemKey, const void* pData, uint32_t offset, uint32_t numBytes);
 	void* GetDataPtr(const std::shared_ptr<MemoryKey>& pMemKey, uint32_t offset, uint32_t numBytes);
+	// Images own dedicated allocations, this is the amount of device memory held by alive images
+	uint64_t GetAllocatedImageBytes() const { return m_allocatedImageBytes; }
 
 protected:
 	void AllocateBufferMemory(uint32_t key, uint32_t numBytes, uint32_t memoryTypeBits, uint32_t memoryPropertyBits, uint32_t& typeIndex, uint32_t& offset);
@@ -86,6 +88,8 @@ protected:
 	// bool stands for whether it's freed
 	std::vector<std::pair<uint32_t, bool>>		m_bufferBindingLookupTable;
 
+	uint64_t									m_allocatedImageBytes = 0;
+
 	static const uint32_t						LOOKUP_TABLE_SIZE_INC = 256;
 
 	friend class MemoryKey;
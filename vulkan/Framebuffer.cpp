@@ -6,6 +6,7 @@
 #include "CommandPool.h"
 #include "CommandBuffer.h"
 #include "Queue.h"
+#include "InitCommandBatcher.h"
 #include "VulkanUtil.h"
 #include "ImageView.h"
 #include "../Maths/Vector.h"
@@ -114,9 +115,6 @@ void FrameBuffer::ExtractContent(const std::shared_ptr<Image>& pImage, uint32_t
 
 void FrameBuffer::ExtractContent(const std::shared_ptr<Image>& pImage, uint32_t baseMipLevel, uint32_t numMipLevels, uint32_t baseLayer, uint32_t numLayers, uint32_t width, uint32_t height, uint32_t index)
 {
-	std::shared_ptr<CommandBuffer> pCmdBuffer = MainThreadCommandPool(PhysicalDevice::QueueFamily::ALL_ROUND)->AllocateCommandBuffer(CommandBuffer::CBLevel::PRIMARY);
-	pCmdBuffer->StartPrimaryRecording();
-
 	VkImageCopy copy = {};
 
 	copy.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
@@ -138,8 +136,9 @@ void FrameBuffer::ExtractContent(const std::shared_ptr<Image>& pImage, uint32_t
 	copy.dstSubresource.mipLevel = baseMipLevel;
 	copy.dstOffset = { 0, 0, 0 };
 
-	pCmdBuffer->CopyImage(m_images[index], pImage, { copy } );
-
-	pCmdBuffer->EndPrimaryRecording();
-	GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::ALL_ROUND)->SubmitCommandBuffer(pCmdBuffer, nullptr, true);
+	std::shared_ptr<Image> pSrcImage = m_images[index];
+	InitCmdBatcher()->Record([&copy, &pSrcImage, &pImage](const std::shared_ptr<CommandBuffer>& pCmdBuffer)
+	{
+		pCmdBuffer->CopyImage(pSrcImage, pImage, { copy });
+	});
 }
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include "../thread/ThreadTaskQueue.hpp"
 #include "GlobalVulkanStates.h"
 #include "PhysicalDevice.h"
+#include "InitCommandBatcher.h"
 
 bool GlobalDeviceObjects::InitObjects(const std::shared_ptr<Device>& pDevice)
 {
@@ -27,6 +28,8 @@ bool GlobalDeviceObjects::InitObjects(const std::shared_ptr<Device>& pDevice)
 
 	m_pStaingBufferMgr = StagingBufferManager::Create(pDevice);
 
+	m_pInitCmdBatcher = InitCommandBatcher::Create(pDevice);
+
 	m_pIndexBufferMgr = SharedBufferManager::Create(pDevice, 
 		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 
@@ -42,8 +45,9 @@ bool GlobalDeviceObjects::InitObjects(const std::shared_ptr<Device>& pDevice)
 		(VkMemoryPropertyFlagBits)(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT), 
 		SHADER_STORAGE_BUFFER_SIZE);
 
+	// Indirect buffers could be written by compute shaders too, as culling compacts draw commands into them
 	m_pIndirectBufferMgr = SharedBufferManager::Create(pDevice, 
-		VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, 
+		VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 
 		(VkMemoryPropertyFlagBits)(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT), 
 		INDIRECT_BUFFER_SIZE);
 
@@ -80,8 +84,9 @@ bool GlobalDeviceObjects::RequestAttributeBuffer(uint32_t size, uint32_t& offset
 
 const std::shared_ptr<SharedBufferManager>& GlobalDeviceObjects::GetVertexAttribBufferMgr(uint32_t vertexFormat) 
 { 
+	// Vertex buffers could be read and written by compute shaders too, as skinning writes skinned vertices into them
 	if (m_vertexAttribBufferMgrs.find(vertexFormat) == m_vertexAttribBufferMgrs.end())
-		m_vertexAttribBufferMgrs[vertexFormat] = SharedBufferManager::Create(m_pDevice, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ATTRIBUTE_BUFFER_SIZE);
+		m_vertexAttribBufferMgrs[vertexFormat] = SharedBufferManager::Create(m_pDevice, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, ATTRIBUTE_BUFFER_SIZE);
 
 	return m_vertexAttribBufferMgrs[vertexFormat];
 }
@@ -99,4 +104,5 @@ const std::shared_ptr<SharedBufferManager>& ShaderStorageBufferMgr() { return Gl
 const std::shared_ptr<SharedBufferManager>& IndirectBufferMgr() { return GlobalObjects()->GetIndirectBufferMgr(); }
 const std::shared_ptr<SharedBufferManager>& StreamingBufferMgr() { return GlobalObjects()->GetStreamingBufferMgr(); }
 const std::shared_ptr<ThreadTaskQueue>& GlobalThreadTaskQueue() { return GlobalObjects()->GetThreadTaskQueue(); }
-const std::shared_ptr<GlobalVulkanStates>& GetGlobalVulkanStates() { return GlobalObjects()->GetGlobalVulkanStates(); }
\ No newline at end of file
+const std::shared_ptr<GlobalVulkanStates>& GetGlobalVulkanStates() { return GlobalObjects()->GetGlobalVulkanStates(); }
+const std::shared_ptr<InitCommandBatcher>& InitCmdBatcher() { return GlobalObjects()->GetInitCmdBatcher(); }
\ No newline at end of file
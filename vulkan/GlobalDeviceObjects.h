@@ -17,6 +17,7 @@ class ThreadTaskQueue;
 class GlobalVulkanStates;
 class PerFrameResource;
 class RenderPass;
+class InitCommandBatcher;
 
 class GlobalDeviceObjects;
 
@@ -35,6 +36,7 @@ const std::shared_ptr<SharedBufferManager>& IndirectBufferMgr();
 const std::shared_ptr<SharedBufferManager>& StreamingBufferMgr();
 const std::shared_ptr<ThreadTaskQueue>& GlobalThreadTaskQueue();
 const std::shared_ptr<GlobalVulkanStates>& GetGlobalVulkanStates();
+const std::shared_ptr<InitCommandBatcher>& InitCmdBatcher();
 
 class GlobalDeviceObjects : public Singleton<GlobalDeviceObjects>
 {
@@ -58,6 +60,7 @@ public:
 	const std::shared_ptr<SharedBufferManager>& GetStreamingBufferMgr() const { return m_pStreamingBufferMgr; }
 	const std::shared_ptr<ThreadTaskQueue>& GetThreadTaskQueue() const { return m_pThreadTaskQueue; }
 	const std::shared_ptr<GlobalVulkanStates>& GetGlobalVulkanStates() const { return m_pGlobalVulkanStates; }
+	const std::shared_ptr<InitCommandBatcher>& GetInitCmdBatcher() const { return m_pInitCmdBatcher; }
 
 	//FIXME : remove me
 	bool RequestAttributeBuffer(uint32_t size, uint32_t& offset);
@@ -69,6 +72,7 @@ protected:
 	std::shared_ptr<DeviceMemoryManager>	m_pDeviceMemMgr;
 
 	std::shared_ptr<StagingBufferManager>	m_pStaingBufferMgr;
+	std::shared_ptr<InitCommandBatcher>		m_pInitCmdBatcher;
 
 	std::shared_ptr<SwapChain>				m_pSwapChain;
 
@@ -88,7 +92,7 @@ protected:
 	static const uint32_t ATTRIBUTE_BUFFER_SIZE = 1024 * 1024 * 64;
 	static const uint32_t INDEX_BUFFER_SIZE = 1024 * 1024 * 4;
 	static const uint32_t UNIFORM_BUFFER_SIZE = 1024 * 512;
-	static const uint32_t SHADER_STORAGE_BUFFER_SIZE = 1024 * 1024 * 2;
+	static const uint32_t SHADER_STORAGE_BUFFER_SIZE = 1024 * 1024 * 4;
 	static const uint32_t INDIRECT_BUFFER_SIZE = 1024 * 1024;
 
 	uint32_t								m_attributeBufferOffset = 0;
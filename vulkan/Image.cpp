@@ -9,6 +9,8 @@
 #include "VulkanUtil.h"
 #include "ImageView.h"
 #include "Sampler.h"
+#include "InitCommandBatcher.h"
+#include <algorithm>
 
 Image::~Image()
 {
@@ -93,9 +95,6 @@ void Image::EnsureImageLayout()
 	if (m_info.initialLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL || m_info.initialLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
 		return;
 
-	std::shared_ptr<CommandBuffer> pCmdBuffer = MainThreadCommandPool(PhysicalDevice::QueueFamily::ALL_ROUND)->AllocateCommandBuffer(CommandBuffer::CBLevel::PRIMARY);
-	pCmdBuffer->StartPrimaryRecording();
-
 	VkImageSubresourceRange subresourceRange = {};
 	subresourceRange.aspectMask = AcquireImageAspectFlags(m_info.format);
 	subresourceRange.levelCount = m_info.mipLevels;
@@ -112,44 +111,128 @@ void Image::EnsureImageLayout()
 	imgBarrier.dstAccessMask = 0;
 	imgBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
 
-	pCmdBuffer->AttachBarriers
-	(
-		VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-		VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-		{}, {}, { imgBarrier }
-	);
+	// Recorded into init batch if there's one, staging buffers are kept alive by command buffer's reference table
+	InitCmdBatcher()->Record([this, &imgBarrier](const std::shared_ptr<CommandBuffer>& pCmdBuffer)
+	{
+		pCmdBuffer->AttachBarriers
+		(
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			{}, {}, { imgBarrier }
+		);
+
+		// Image must outlive batched barrier
+		pCmdBuffer->AddToReferenceTable(GetSelfSharedPtr());
+	});
+}
 
-	pCmdBuffer->EndPrimaryRecording();
+void Image::UpdateByteStream(const GliImageWrapper& gliTex)
+{
+	InitCmdBatcher()->Record([this, &gliTex](const std::shared_ptr<CommandBuffer>& pCmdBuffer)
+	{
+		std::shared_ptr<StagingBuffer> pStagingBuffer = PrepareStagingBuffer(gliTex, pCmdBuffer);
 
-	GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::ALL_ROUND)->SubmitCommandBuffer(pCmdBuffer, nullptr, true);
+		ExecuteCopy(gliTex, pStagingBuffer, pCmdBuffer);
+	});
 }
 
-void Image::UpdateByteStream(const GliImageWrapper& gliTex)
+void Image::UpdateByteStream(const GliImageWrapper& gliTex, uint32_t layer)
 {
-	std::shared_ptr<CommandBuffer> pCmdBuffer = MainThreadCommandPool(PhysicalDevice::QueueFamily::ALL_ROUND)->AllocateCommandBuffer(CommandBuffer::CBLevel::PRIMARY);
-	pCmdBuffer->StartPrimaryRecording();
+	InitCmdBatcher()->Record([this, &gliTex, layer](const std::shared_ptr<CommandBuffer>& pCmdBuffer)
+	{
+		std::shared_ptr<StagingBuffer> pStagingBuffer = PrepareStagingBuffer(gliTex, pCmdBuffer);
 
-	std::shared_ptr<StagingBuffer> pStagingBuffer = PrepareStagingBuffer(gliTex, pCmdBuffer);
+		ExecuteCopy(gliTex, layer, pStagingBuffer, 0, pCmdBuffer);
+	});
+}
 
-	ExecuteCopy(gliTex, pStagingBuffer, pCmdBuffer);
+void Image::UpdateByteStream(const void* pData, uint32_t numBytes)
+{
+	ASSERTION(numBytes == m_info.extent.width * m_info.extent.height * m_info.extent.depth * m_info.arrayLayers * m_bytesPerPixel);
 
-	pCmdBuffer->EndPrimaryRecording();
+	std::shared_ptr<StagingBuffer> pStagingBuffer = StagingBuffer::Create(m_pDevice, numBytes);
+	pStagingBuffer->UpdateByteStream(pData, 0, numBytes);
+	InitCmdBatcher()->AddPendingStagingBytes(numBytes);
 
-	GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::ALL_ROUND)->SubmitCommandBuffer(pCmdBuffer, nullptr, true);
+	VkBufferImageCopy bufferCopyRegion = {};
+	bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	bufferCopyRegion.imageSubresource.mipLevel = 0;
+	bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
+	bufferCopyRegion.imageSubresource.layerCount = m_info.arrayLayers;
+	bufferCopyRegion.imageExtent = m_info.extent;
+	bufferCopyRegion.bufferOffset = 0;
+
+	InitCmdBatcher()->Record([this, &pStagingBuffer, &bufferCopyRegion](const std::shared_ptr<CommandBuffer>& pCmdBuffer)
+	{
+		pCmdBuffer->CopyBufferImage(pStagingBuffer, std::dynamic_pointer_cast<Image>(GetSelfSharedPtr()), { bufferCopyRegion });
+	});
 }
 
-void Image::UpdateByteStream(const GliImageWrapper& gliTex, uint32_t layer)
+void Image::ReadByteStream(void* pData, uint32_t numBytes)
 {
-	std::shared_ptr<CommandBuffer> pCmdBuffer = MainThreadCommandPool(PhysicalDevice::QueueFamily::ALL_ROUND)->AllocateCommandBuffer(CommandBuffer::CBLevel::PRIMARY);
-	pCmdBuffer->StartPrimaryRecording();
+	ASSERTION(numBytes == m_info.extent.width * m_info.extent.height * m_info.extent.depth * m_info.arrayLayers * m_bytesPerPixel);
+
+	std::shared_ptr<StagingBuffer> pStagingBuffer = StagingBuffer::Create(m_pDevice, numBytes);
 
-	std::shared_ptr<StagingBuffer> pStagingBuffer = PrepareStagingBuffer(gliTex, pCmdBuffer);
+	VkBufferImageCopy bufferCopyRegion = {};
+	bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	bufferCopyRegion.imageSubresource.mipLevel = 0;
+	bufferCopyRegion.imageSubresource.baseArrayLayer = 0;
+	bufferCopyRegion.imageSubresource.layerCount = m_info.arrayLayers;
+	bufferCopyRegion.imageExtent = m_info.extent;
+	bufferCopyRegion.bufferOffset = 0;
 
-	ExecuteCopy(gliTex, layer, pStagingBuffer, 0, pCmdBuffer);
+	InitCmdBatcher()->Record([this, &pStagingBuffer, &bufferCopyRegion](const std::shared_ptr<CommandBuffer>& pCmdBuffer)
+	{
+		pCmdBuffer->CopyImageBuffer(std::dynamic_pointer_cast<Image>(GetSelfSharedPtr()), pStagingBuffer, { bufferCopyRegion });
+	});
 
-	pCmdBuffer->EndPrimaryRecording();
+	// Nothing happens if recorded work has already been submitted, i.e. no batch is open
+	InitCmdBatcher()->Flush();
 
-	GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::ALL_ROUND)->SubmitCommandBuffer(pCmdBuffer, nullptr, true);
+	pStagingBuffer->ReadByteStream(pData, 0, numBytes);
+}
+
+void Image::ReadByteStream(GliImageWrapper& gliTex)
+{
+	ASSERTION(gliTex.textures.size() == 1);
+
+	gli::texture& tex = gliTex.textures[0];
+	ASSERTION(tex.layers() * tex.faces() == m_info.arrayLayers && tex.levels() == m_info.mipLevels);
+
+	std::shared_ptr<StagingBuffer> pStagingBuffer = StagingBuffer::Create(m_pDevice, (uint32_t)tex.size());
+
+	// Same layout as gli storage, mip levels of a layer(face) are tightly packed one after another
+	std::vector<VkBufferImageCopy> bufferCopyRegions;
+	uint32_t offset = 0;
+	for (uint32_t layer = 0; layer < m_info.arrayLayers; layer++)
+	{
+		for (uint32_t level = 0; level < m_info.mipLevels; level++)
+		{
+			VkBufferImageCopy bufferCopyRegion = {};
+			bufferCopyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			bufferCopyRegion.imageSubresource.mipLevel = level;
+			bufferCopyRegion.imageSubresource.baseArrayLayer = layer;
+			bufferCopyRegion.imageSubresource.layerCount = 1;
+			bufferCopyRegion.imageExtent.width = (std::max)(1u, m_info.extent.width >> level);
+			bufferCopyRegion.imageExtent.height = (std::max)(1u, m_info.extent.height >> level);
+			bufferCopyRegion.imageExtent.depth = 1;
+			bufferCopyRegion.bufferOffset = offset;
+
+			offset += (uint32_t)tex.size(level);
+
+			bufferCopyRegions.push_back(bufferCopyRegion);
+		}
+	}
+
+	InitCmdBatcher()->Record([this, &pStagingBuffer, &bufferCopyRegions](const std::shared_ptr<CommandBuffer>& pCmdBuffer)
+	{
+		pCmdBuffer->CopyImageBuffer(std::dynamic_pointer_cast<Image>(GetSelfSharedPtr()), pStagingBuffer, bufferCopyRegions);
+	});
+
+	InitCmdBatcher()->Flush();
+
+	pStagingBuffer->ReadByteStream(tex.data(), 0, (uint32_t)tex.size());
 }
 
 std::shared_ptr<Sampler> Image::CreateLinearRepeatSampler() const
@@ -357,9 +440,9 @@ void Image::PrepareBarriers
 	VkImageLayout				srcImageLayout,
 	VkAccessFlags				dstAccessFlags,
 	VkImageLayout				dstImageLayout,
-	std::vector<VkMemoryBarrier>&		memBarriers,
-	std::vector<VkBufferMemoryBarrier>&	bufferMemBarriers,
-	std::vector<VkImageMemoryBarrier>&	imageMemBarriers
+	FrameVector<VkMemoryBarrier>&		memBarriers,
+	FrameVector<VkBufferMemoryBarrier>&	bufferMemBarriers,
+	FrameVector<VkImageMemoryBarrier>&	imageMemBarriers
 )
 {
 	VkImageSubresourceRange subresourceRange = {};
@@ -405,9 +488,9 @@ void Image::PrepareQueueReleaseBarrier
 	VkImageLayout				srcImageLayout,
 	PhysicalDevice::QueueFamily	srcQueueFamily,
 	PhysicalDevice::QueueFamily	dstQueueFamily,
-	std::vector<VkMemoryBarrier>&		memBarriers,
-	std::vector<VkBufferMemoryBarrier>&	bufferMemBarriers,
-	std::vector<VkImageMemoryBarrier>&	imageMemBarriers
+	FrameVector<VkMemoryBarrier>&		memBarriers,
+	FrameVector<VkBufferMemoryBarrier>&	bufferMemBarriers,
+	FrameVector<VkImageMemoryBarrier>&	imageMemBarriers
 )
 {
 	VkImageMemoryBarrier queueReleaseBarrier;
@@ -439,9 +522,9 @@ void Image::PrepareQueueAcquireBarrier
 	VkImageLayout				dstImageLayout,
 	PhysicalDevice::QueueFamily	srcQueueFamily,
 	PhysicalDevice::QueueFamily	dstQueueFamily,
-	std::vector<VkMemoryBarrier>&		memBarriers,
-	std::vector<VkBufferMemoryBarrier>&	bufferMemBarriers,
-	std::vector<VkImageMemoryBarrier>&	imageMemBarriers
+	FrameVector<VkMemoryBarrier>&		memBarriers,
+	FrameVector<VkBufferMemoryBarrier>&	bufferMemBarriers,
+	FrameVector<VkImageMemoryBarrier>&	imageMemBarriers
 )
 {
 	VkImageMemoryBarrier queueAcquireBarrier;
@@ -475,6 +558,7 @@ std::shared_ptr<StagingBuffer> Image::PrepareStagingBuffer(const GliImageWrapper
 		total_bytes += (uint32_t)gliTex.textures[i].size();
 
 	std::shared_ptr<StagingBuffer> pStagingBuffer = StagingBuffer::Create(m_pDevice, total_bytes);
+	InitCmdBatcher()->AddPendingStagingBytes(total_bytes);
 
 	uint32_t offset = 0;
 	for (uint32_t i = 0; i < (uint32_t)gliTex.textures.size(); i++)
@@ -678,7 +762,7 @@ std::shared_ptr<Image> Image::CreateEmptyTexture2D(const std::shared_ptr<Device>
 		1,
 		format,
 		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
 		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
 		VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT
 	);
@@ -694,7 +778,7 @@ std::shared_ptr<Image> Image::CreateEmptyTexture2DForCompute(const std::shared_p
 		1,
 		format,
 		VK_IMAGE_LAYOUT_GENERAL,
-		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
 		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
 		VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
 	);
@@ -846,7 +930,7 @@ std::shared_ptr<Image> Image::CreateEmptyTexture3D(const std::shared_ptr<Device>
 		1,
 		format,
 		defaultLayout,
-		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_STORAGE_BIT,
 		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
 		VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT
 	);
@@ -35,6 +35,12 @@ public:
 
 	void UpdateByteStream(const GliImageWrapper& gliTex);
 	void UpdateByteStream(const GliImageWrapper& gliTex, uint32_t layer);
+	// Raw texels of mip level 0 and all layers, tightly packed, 3d textures are supported too
+	void UpdateByteStream(const void* pData, uint32_t numBytes);
+	// Blocking readback, work recorded to init command batcher so far is flushed
+	void ReadByteStream(void* pData, uint32_t numBytes);
+	// Blocking readback of all mip levels and layers into a texture of matching layout, e.g. a cube with full mip chain
+	void ReadByteStream(GliImageWrapper& gliTex);
 
 	virtual std::shared_ptr<ImageView> CreateDefaultImageView(bool isStorage = false) const;
 	virtual std::shared_ptr<ImageView> CreateImageView(uint32_t mipLevel, bool isStorage = false) const;
@@ -53,9 +59,9 @@ public:
 		VkImageLayout				srcImageLayout,
 		VkAccessFlags				dstAccessFlags,
 		VkImageLayout				dstImageLayout,
-		std::vector<VkMemoryBarrier>&		memBarriers,
-		std::vector<VkBufferMemoryBarrier>&	bufferMemBarriers,
-		std::vector<VkImageMemoryBarrier>&	imageMemBarriers
+		FrameVector<VkMemoryBarrier>&		memBarriers,
+		FrameVector<VkBufferMemoryBarrier>&	bufferMemBarriers,
+		FrameVector<VkImageMemoryBarrier>&	imageMemBarriers
 	) override;
 
 	void PrepareQueueReleaseBarrier
@@ -64,9 +70,9 @@ public:
 		VkImageLayout				srcImageLayout,
 		PhysicalDevice::QueueFamily	srcQueueFamily,
 		PhysicalDevice::QueueFamily	dstQueueFamily,
-		std::vector<VkMemoryBarrier>&		memBarriers,
-		std::vector<VkBufferMemoryBarrier>&	bufferMemBarriers,
-		std::vector<VkImageMemoryBarrier>&	imageMemBarriers
+		FrameVector<VkMemoryBarrier>&		memBarriers,
+		FrameVector<VkBufferMemoryBarrier>&	bufferMemBarriers,
+		FrameVector<VkImageMemoryBarrier>&	imageMemBarriers
 	) override;
 
 	void PrepareQueueAcquireBarrier
@@ -75,9 +81,9 @@ public:
 		VkImageLayout				dstImageLayout,
 		PhysicalDevice::QueueFamily	srcQueueFamily,
 		PhysicalDevice::QueueFamily	dstQueueFamily,
-		std::vector<VkMemoryBarrier>&		memBarriers,
-		std::vector<VkBufferMemoryBarrier>&	bufferMemBarriers,
-		std::vector<VkImageMemoryBarrier>&	imageMemBarriers
+		FrameVector<VkMemoryBarrier>&		memBarriers,
+		FrameVector<VkBufferMemoryBarrier>&	bufferMemBarriers,
+		FrameVector<VkImageMemoryBarrier>&	imageMemBarriers
 	) override;
 
 protected:
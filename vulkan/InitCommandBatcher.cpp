@@ -0,0 +1,128 @@
+#include "InitCommandBatcher.h"
+#include "GlobalDeviceObjects.h"
+#include "CommandPool.h"
+#include "CommandBuffer.h"
+#include "Queue.h"
+#include "Fence.h"
+
+bool InitCommandBatcher::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<InitCommandBatcher>& pSelf)
+{
+	if (!DeviceObjectBase::Init(pDevice, pSelf))
+		return false;
+
+	return true;
+}
+
+std::shared_ptr<InitCommandBatcher> InitCommandBatcher::Create(const std::shared_ptr<Device>& pDevice)
+{
+	std::shared_ptr<InitCommandBatcher> pBatcher = std::make_shared<InitCommandBatcher>();
+	if (pBatcher.get() && pBatcher->Init(pDevice, pBatcher))
+		return pBatcher;
+	return nullptr;
+}
+
+void InitCommandBatcher::BeginBatch()
+{
+	m_batchDepth++;
+}
+
+void InitCommandBatcher::EndBatch()
+{
+	ASSERTION(m_batchDepth > 0);
+
+	m_batchDepth--;
+	if (m_batchDepth == 0)
+		Flush();
+}
+
+const std::shared_ptr<CommandBuffer>& InitCommandBatcher::AcquireBatchCommandBuffer()
+{
+	// Start a new command buffer if current one is full, never do it in the middle of a nested recording
+	bool full = m_recordsInCurrentCmdBuffer >= MAX_RECORDS_PER_CMD_BUFFER && m_recordingDepth == 0;
+	if (m_batchCmdBuffers.size() == 0 || full)
+	{
+		if (full)
+			m_batchCmdBuffers.back()->EndPrimaryRecording();
+
+		m_batchCmdBuffers.push_back(MainThreadCommandPool(PhysicalDevice::QueueFamily::ALL_ROUND)->AllocateCommandBuffer(CommandBuffer::CBLevel::PRIMARY));
+		m_batchCmdBuffers.back()->StartPrimaryRecording();
+		m_recordsInCurrentCmdBuffer = 0;
+	}
+
+	return m_batchCmdBuffers.back();
+}
+
+void InitCommandBatcher::Record(const RecordFunc& recordFunc)
+{
+	m_recordCount++;
+
+	if (!IsBatching())
+	{
+		std::shared_ptr<CommandBuffer> pCmdBuffer = MainThreadCommandPool(PhysicalDevice::QueueFamily::ALL_ROUND)->AllocateCommandBuffer(CommandBuffer::CBLevel::PRIMARY);
+		pCmdBuffer->StartPrimaryRecording();
+		recordFunc(pCmdBuffer);
+		pCmdBuffer->EndPrimaryRecording();
+
+		GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::ALL_ROUND)->SubmitCommandBuffer(pCmdBuffer, nullptr, true);
+		m_submissionCount++;
+		return;
+	}
+
+	// Copy the handle, the vector might grow during a nested recording
+	std::shared_ptr<CommandBuffer> pCmdBuffer = AcquireBatchCommandBuffer();
+	m_recordsInCurrentCmdBuffer++;
+
+	m_recordingDepth++;
+	recordFunc(pCmdBuffer);
+	m_recordingDepth--;
+
+	if (m_recordingDepth == 0 && m_pendingStagingBytes > MAX_PENDING_STAGING_BYTES)
+		Flush();
+}
+
+void InitCommandBatcher::Flush()
+{
+	// Flush inside a recording would submit a command buffer still being recorded
+	ASSERTION(m_recordingDepth == 0);
+
+	if (m_batchCmdBuffers.size() != 0)
+	{
+		m_batchCmdBuffers.back()->EndPrimaryRecording();
+
+		std::shared_ptr<Fence> pFence = Fence::Create(GetDevice());
+		GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::ALL_ROUND)->SubmitCommandBuffers(m_batchCmdBuffers, pFence);
+		pFence->Wait();
+		m_submissionCount++;
+
+		// Resources referenced by these command buffers are released here
+		m_batchCmdBuffers.clear();
+		m_recordsInCurrentCmdBuffer = 0;
+	}
+
+	m_pendingStagingBytes = 0;
+
+	// Callbacks might add more work or callbacks, swap them out first
+	std::vector<FlushCallback> callbacks;
+	callbacks.swap(m_flushCallbacks);
+	for (auto& callback : callbacks)
+		callback();
+}
+
+void InitCommandBatcher::AddFlushCallback(const FlushCallback& callback)
+{
+	if (m_batchCmdBuffers.size() == 0)
+	{
+		callback();
+		return;
+	}
+
+	m_flushCallbacks.push_back(callback);
+}
+
+
+void InitCommandBatcher::AddPendingStagingBytes(uint64_t numBytes)
+{
+	// Nothing is pending outside of a batch, staging buffers are released right after immediate submission
+	if (IsBatching())
+		m_pendingStagingBytes += numBytes;
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "DeviceObjectBase.h"
+#include <functional>
+
+class CommandBuffer;
+
+// Collects one-time gpu work(layout transitions, uploads, copies, precomputation) issued during setup
+// Instead of submitting a command buffer and waiting for queue idle per request, work recorded between
+// BeginBatch() and EndBatch() is packed into a few command buffers and submitted once with a single fence wait
+// Outside of a batch, every request falls back to the immediate submit-and-wait path
+// NOTE: Main thread only, same as MainThreadCommandPool()
+class InitCommandBatcher : public DeviceObjectBase<InitCommandBatcher>
+{
+public:
+	typedef std::function<void(const std::shared_ptr<CommandBuffer>&)> RecordFunc;
+	typedef std::function<void()> FlushCallback;
+
+public:
+	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<InitCommandBatcher>& pSelf);
+
+	static std::shared_ptr<InitCommandBatcher> Create(const std::shared_ptr<Device>& pDevice);
+
+public:
+	// Batches can be nested, only the outermost EndBatch() flushes
+	void BeginBatch();
+	void EndBatch();
+	bool IsBatching() const { return m_batchDepth > 0; }
+
+	// Record one-time work, executed either at next Flush() or immediately if no batch is open
+	void Record(const RecordFunc& recordFunc);
+
+	// Submit everything recorded so far with one submission, wait for it, then run flush callbacks
+	// Call it when cpu side data consumed by recorded work(e.g. uniforms) is about to be overwritten
+	void Flush();
+
+	// Executed once after recorded work is done on gpu, immediately if nothing is pending
+	void AddFlushCallback(const FlushCallback& callback);
+
+	// Staging memory held by batched work until it's flushed
+	// Batch is flushed once the outermost recording is done, if it exceeds "MAX_PENDING_STAGING_BYTES"
+	void AddPendingStagingBytes(uint64_t numBytes);
+	uint64_t GetPendingStagingBytes() const { return m_pendingStagingBytes; }
+
+	uint32_t GetRecordCount() const { return m_recordCount; }
+	uint32_t GetSubmissionCount() const { return m_submissionCount; }
+	uint32_t GetSavedSubmissionCount() const { return m_recordCount - m_submissionCount; }
+
+protected:
+	const std::shared_ptr<CommandBuffer>& AcquireBatchCommandBuffer();
+
+protected:
+	std::vector<std::shared_ptr<CommandBuffer>>	m_batchCmdBuffers;
+	std::vector<FlushCallback>					m_flushCallbacks;
+	uint32_t									m_batchDepth = 0;
+	uint32_t									m_recordingDepth = 0;
+	uint32_t									m_recordsInCurrentCmdBuffer = 0;
+
+	uint64_t									m_pendingStagingBytes = 0;
+
+	uint32_t									m_recordCount = 0;
+	uint32_t									m_submissionCount = 0;
+
+	// Keep command buffers reasonably small, so that driver doesn't have to deal with a giant one
+	static const uint32_t MAX_RECORDS_PER_CMD_BUFFER = 64;
+	// Staging buffers are kept alive by command buffers until a flush, don't let them pile up during a big setup
+	static const uint64_t MAX_PENDING_STAGING_BYTES = 256 * 1024 * 1024;
+};
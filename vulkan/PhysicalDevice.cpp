@@ -45,6 +45,16 @@ bool PhysicalDevice::Init(const std::shared_ptr<Instance>& pVulkanInstance, HINS
 	//Get physical device properties
 	vkGetPhysicalDeviceProperties(m_physicalDevice, &m_physicalDeviceProperties);
 	vkGetPhysicalDeviceFeatures(m_physicalDevice, &m_physicalDeviceFeatures);
+
+	// Vulkan 1.2 features, timeline semaphore is queried from here
+	m_physicalDeviceVulkan12Features = {};
+	m_physicalDeviceVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+	VkPhysicalDeviceFeatures2 features2 = {};
+	features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features2.pNext = &m_physicalDeviceVulkan12Features;
+	vkGetPhysicalDeviceFeatures2(m_physicalDevice, &features2);
+	m_physicalDeviceVulkan12Features.pNext = nullptr;
 	vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &m_physicalDeviceMemoryProperties);
 
 	//Get depth stencil format
@@ -28,6 +28,8 @@ public:
 	const VkSurfaceKHR GetSurfaceHandle() const { return m_surface; }
 	const VkPhysicalDeviceProperties& GetPhysicalDeviceProperties() const { return m_physicalDeviceProperties; }
 	const VkPhysicalDeviceFeatures& GetPhysicalDeviceFeatures() const { return m_physicalDeviceFeatures; }
+	const VkPhysicalDeviceVulkan12Features& GetPhysicalDeviceVulkan12Features() const { return m_physicalDeviceVulkan12Features; }
+	bool IsTimelineSemaphoreSupported() const { return m_physicalDeviceVulkan12Features.timelineSemaphore == VK_TRUE; }
 	const VkPhysicalDeviceMemoryProperties& GetPhysicalDeviceMemoryProperties() const { return m_physicalDeviceMemoryProperties; }
 	VkFormatProperties GetPhysicalDeviceFormatProperties(VkFormat format) const;
 
@@ -48,6 +50,7 @@ private:
 	VkPhysicalDevice					m_physicalDevice;
 	VkPhysicalDeviceProperties			m_physicalDeviceProperties;
 	VkPhysicalDeviceFeatures			m_physicalDeviceFeatures;
+	VkPhysicalDeviceVulkan12Features	m_physicalDeviceVulkan12Features;
 	VkPhysicalDeviceMemoryProperties	m_physicalDeviceMemoryProperties;
 
 	std::vector<VkQueueFamilyProperties>	m_queueProperties;
@@ -0,0 +1,45 @@
+#include "QueryPool.h"
+
+QueryPool::~QueryPool()
+{
+	vkDestroyQueryPool(GetDevice()->GetDeviceHandle(), m_queryPool, nullptr);
+}
+
+bool QueryPool::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<QueryPool>& pSelf, VkQueryType queryType, uint32_t queryCount)
+{
+	if (!DeviceObjectBase::Init(pDevice, pSelf))
+		return false;
+
+	m_queryType = queryType;
+	m_queryCount = queryCount;
+
+	VkQueryPoolCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	info.queryType = queryType;
+	info.queryCount = queryCount;
+	CHECK_VK_ERROR(vkCreateQueryPool(GetDevice()->GetDeviceHandle(), &info, nullptr, &m_queryPool));
+
+	return true;
+}
+
+std::shared_ptr<QueryPool> QueryPool::Create(const std::shared_ptr<Device>& pDevice, VkQueryType queryType, uint32_t queryCount)
+{
+	std::shared_ptr<QueryPool> pQueryPool = std::make_shared<QueryPool>();
+	if (pQueryPool.get() && pQueryPool->Init(pDevice, pQueryPool, queryType, queryCount))
+		return pQueryPool;
+	return nullptr;
+}
+
+bool QueryPool::GetResults(uint32_t firstQuery, uint32_t queryCount, uint64_t* pResults) const
+{
+	ASSERTION(firstQuery + queryCount <= m_queryCount);
+
+	VkResult result = vkGetQueryPoolResults(GetDevice()->GetDeviceHandle(), m_queryPool, firstQuery, queryCount,
+		sizeof(uint64_t) * queryCount, pResults, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+	if (result == VK_NOT_READY)
+		return false;
+
+	ASSERTION(result == VK_SUCCESS);
+	return true;
+}
\ No newline at end of file
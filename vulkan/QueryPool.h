@@ -0,0 +1,27 @@
+#pragma once
+
+#include "DeviceObjectBase.h"
+
+class QueryPool : public DeviceObjectBase<QueryPool>
+{
+public:
+	~QueryPool();
+
+	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<QueryPool>& pSelf, VkQueryType queryType, uint32_t queryCount);
+
+public:
+	VkQueryPool GetDeviceHandle() const { return m_queryPool; }
+	VkQueryType GetQueryType() const { return m_queryType; }
+	uint32_t GetQueryCount() const { return m_queryCount; }
+
+	// Non-blocking, returns false if any of queries isn't available yet
+	bool GetResults(uint32_t firstQuery, uint32_t queryCount, uint64_t* pResults) const;
+
+public:
+	static std::shared_ptr<QueryPool> Create(const std::shared_ptr<Device>& pDevice, VkQueryType queryType, uint32_t queryCount);
+
+protected:
+	VkQueryPool	m_queryPool;
+	VkQueryType	m_queryType;
+	uint32_t	m_queryCount;
+};
\ No newline at end of file
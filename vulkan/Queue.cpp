@@ -4,6 +4,7 @@
 #include "Fence.h"
 #include "GlobalDeviceObjects.h"
 #include "SwapChain.h"
+#include "../common/FrameArena.h"
 
 Queue::~Queue()
 {
@@ -80,27 +81,90 @@ void Queue::SubmitCommandBuffers(
 	const std::shared_ptr<Fence>& pFence,
 	bool waitUtilQueueIdle)
 {
-	std::vector<VkCommandBuffer> deviceCmdBuffers;
-	for (uint32_t i = 0; i < cmdBuffers.size(); i++)
-		deviceCmdBuffers.push_back(cmdBuffers[i]->GetDeviceHandle());
-
-	std::vector<VkSemaphore> deviceWaitSemaphores;
-	for (uint32_t i = 0; i < waitSemaphores.size(); i++)
-		deviceWaitSemaphores.push_back(waitSemaphores[i]->GetDeviceHandle());
-
-	std::vector<VkSemaphore> deviceSignalSemaphores;
-	for (uint32_t i = 0; i < signalSemaphores.size(); i++)
-		deviceSignalSemaphores.push_back(signalSemaphores[i]->GetDeviceHandle());
-
-	VkSubmitInfo submitInfo = {};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.commandBufferCount	= (uint32_t)deviceCmdBuffers.size();
-	submitInfo.pCommandBuffers		= deviceCmdBuffers.data();
-	submitInfo.waitSemaphoreCount	= (uint32_t)deviceWaitSemaphores.size();
-	submitInfo.pWaitSemaphores		= deviceWaitSemaphores.data();
-	submitInfo.pWaitDstStageMask	= waitStages.data();
-	submitInfo.signalSemaphoreCount = (uint32_t)deviceSignalSemaphores.size();
-	submitInfo.pSignalSemaphores	= deviceSignalSemaphores.data();
+	SubmissionBatch batch = { cmdBuffers, waitSemaphores, {}, waitStages, signalSemaphores, {} };
+	SubmitBatches({ batch }, pFence);
+
+	if (waitUtilQueueIdle)
+	{
+		CHECK_VK_ERROR(vkQueueWaitIdle(GetDeviceHandle()));
+		if (pFence.get())
+		{
+			pFence->m_fenceState = Fence::FenceState::SIGNALED;
+		}
+	}
+}
+
+void Queue::SubmitBatches(const std::vector<SubmissionBatch>& batches, const std::shared_ptr<Fence>& pFence)
+{
+	// Handles of all batches are packed into flat arrays, reserved up front so that pointers into them stay valid
+	uint32_t cmdBufferCount = 0;
+	uint32_t waitSemaphoreCount = 0;
+	uint32_t signalSemaphoreCount = 0;
+	for (auto& batch : batches)
+	{
+		cmdBufferCount += (uint32_t)batch.cmdBuffers.size();
+		waitSemaphoreCount += (uint32_t)batch.waitSemaphores.size();
+		signalSemaphoreCount += (uint32_t)batch.signalSemaphores.size();
+	}
+
+	FrameVector<VkCommandBuffer> deviceCmdBuffers;
+	FrameVector<VkSemaphore> deviceWaitSemaphores;
+	FrameVector<uint64_t> waitValues;
+	FrameVector<VkSemaphore> deviceSignalSemaphores;
+	FrameVector<uint64_t> signalValues;
+	deviceCmdBuffers.reserve(cmdBufferCount);
+	deviceWaitSemaphores.reserve(waitSemaphoreCount);
+	waitValues.reserve(waitSemaphoreCount);
+	deviceSignalSemaphores.reserve(signalSemaphoreCount);
+	signalValues.reserve(signalSemaphoreCount);
+
+	FrameVector<VkSubmitInfo> submitInfos(batches.size());
+	FrameVector<VkTimelineSemaphoreSubmitInfo> timelineInfos(batches.size());
+
+	for (uint32_t i = 0; i < (uint32_t)batches.size(); i++)
+	{
+		const SubmissionBatch& batch = batches[i];
+
+		VkSubmitInfo& submitInfo = submitInfos[i];
+		submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+		submitInfo.commandBufferCount	= (uint32_t)batch.cmdBuffers.size();
+		submitInfo.pCommandBuffers		= deviceCmdBuffers.data() + deviceCmdBuffers.size();
+		for (auto& pCmdBuffer : batch.cmdBuffers)
+			deviceCmdBuffers.push_back(pCmdBuffer->GetDeviceHandle());
+
+		submitInfo.waitSemaphoreCount	= (uint32_t)batch.waitSemaphores.size();
+		submitInfo.pWaitSemaphores		= deviceWaitSemaphores.data() + deviceWaitSemaphores.size();
+		submitInfo.pWaitDstStageMask	= batch.waitStages.data();
+		const uint64_t* pWaitValues = waitValues.data() + waitValues.size();
+		for (uint32_t j = 0; j < (uint32_t)batch.waitSemaphores.size(); j++)
+		{
+			deviceWaitSemaphores.push_back(batch.waitSemaphores[j]->GetDeviceHandle());
+			waitValues.push_back(j < batch.waitValues.size() ? batch.waitValues[j] : 0);
+		}
+
+		submitInfo.signalSemaphoreCount = (uint32_t)batch.signalSemaphores.size();
+		submitInfo.pSignalSemaphores	= deviceSignalSemaphores.data() + deviceSignalSemaphores.size();
+		const uint64_t* pSignalValues = signalValues.data() + signalValues.size();
+		for (uint32_t j = 0; j < (uint32_t)batch.signalSemaphores.size(); j++)
+		{
+			deviceSignalSemaphores.push_back(batch.signalSemaphores[j]->GetDeviceHandle());
+			signalValues.push_back(j < batch.signalValues.size() ? batch.signalValues[j] : 0);
+		}
+
+		if (batch.waitValues.size() != 0 || batch.signalValues.size() != 0)
+		{
+			VkTimelineSemaphoreSubmitInfo& timelineInfo = timelineInfos[i];
+			timelineInfo = {};
+			timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+			timelineInfo.waitSemaphoreValueCount = submitInfo.waitSemaphoreCount;
+			timelineInfo.pWaitSemaphoreValues = pWaitValues;
+			timelineInfo.signalSemaphoreValueCount = submitInfo.signalSemaphoreCount;
+			timelineInfo.pSignalSemaphoreValues = pSignalValues;
+			submitInfo.pNext = &timelineInfo;
+		}
+	}
 
 	VkFence fence = 0;
 	if (pFence.get())
@@ -109,21 +173,12 @@ void Queue::SubmitCommandBuffers(
 		fence = pFence->GetDeviceHandle();
 	}
 
-	vkQueueSubmit(GetDeviceHandle(), 1, &submitInfo, fence);
+	CHECK_VK_ERROR(vkQueueSubmit(GetDeviceHandle(), (uint32_t)submitInfos.size(), submitInfos.data(), fence));
 
 	if (pFence.get())
 	{
 		pFence->m_fenceState = Fence::FenceState::READ_FOR_SIGNAL;
 	}
-
-	if (waitUtilQueueIdle)
-	{
-		CHECK_VK_ERROR(vkQueueWaitIdle(GetDeviceHandle()));
-		if (pFence.get())
-		{
-			pFence->m_fenceState = Fence::FenceState::SIGNALED;
-		}
-	}
 }
 
 void Queue::WaitForIdle()
@@ -9,6 +9,19 @@ class Fence;
 
 class Queue : public DeviceObjectBase<Queue>
 {
+public:
+	// One VkSubmitInfo
+	// Values are for timeline semaphores and are indexed the same as semaphores, missing ones and those of binary semaphores are ignored
+	typedef struct _SubmissionBatch
+	{
+		std::vector<std::shared_ptr<CommandBuffer>>	cmdBuffers;
+		std::vector<std::shared_ptr<Semaphore>>		waitSemaphores;
+		std::vector<uint64_t>						waitValues;
+		std::vector<VkPipelineStageFlags>			waitStages;
+		std::vector<std::shared_ptr<Semaphore>>		signalSemaphores;
+		std::vector<uint64_t>						signalValues;
+	}SubmissionBatch;
+
 public:
 	~Queue();
 
@@ -48,6 +61,9 @@ public:
 		const std::shared_ptr<Fence>& pFence,
 		bool waitUtilQueueIdle = false);
 
+	// All batches go to queue with one vkQueueSubmit, in order
+	void SubmitBatches(const std::vector<SubmissionBatch>& batches, const std::shared_ptr<Fence>& pFence);
+
 	void WaitForIdle();
 
 public:
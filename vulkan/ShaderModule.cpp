@@ -1,6 +1,8 @@
 #include "ShaderModule.h"
 #include <fstream>
 
+static const std::wstring SHIPPED_BINARY_DIR = L"../data/shaders/";
+
 ShaderModule::~ShaderModule()
 {
 	vkDestroyShaderModule(GetDevice()->GetDeviceHandle(), m_shaderModule, nullptr);
@@ -11,8 +13,10 @@ bool ShaderModule::Init(const std::shared_ptr<Device>& pDevice, const std::share
 	if (!DeviceObjectBase::Init(pDevice, pSelf))
 		return false;
 
+	m_shaderPath = GetBinaryPath(path);
+
 	std::ifstream ifs;
-	ifs.open(path, std::ios::binary);
+	ifs.open(m_shaderPath, std::ios::binary);
 	if (ifs.fail())
 		return false;
 
@@ -43,6 +47,22 @@ bool ShaderModule::Init(const std::shared_ptr<Device>& pDevice, const std::share
 	return true;
 }
 
+std::wstring ShaderModule::GetBinaryPath(const std::wstring& path)
+{
+#if defined(SHADER_BINARY_DIR)
+	if (path.compare(0, SHIPPED_BINARY_DIR.size(), SHIPPED_BINARY_DIR) == 0)
+		return SHADER_BINARY_DIR + path.substr(SHIPPED_BINARY_DIR.size());
+#endif
+	return path;
+}
+
+bool ShaderModule::IsBinaryAvailable(const std::wstring& path)
+{
+	std::ifstream ifs;
+	ifs.open(GetBinaryPath(path), std::ios::binary);
+	return !ifs.fail();
+}
+
 std::shared_ptr<ShaderModule> ShaderModule::Create(const std::shared_ptr<Device>& pDevice, const std::wstring& path, ShaderType type, const std::string& entryName)
 {
 	std::shared_ptr<ShaderModule> pModule = std::make_shared<ShaderModule>();
@@ -27,6 +27,9 @@ public:
 	std::string GetEntryName() const { return m_entryName; }
 
 public:
+	// Binaries compiled by build are loaded from SHADER_BINARY_DIR(see CMakeLists.txt), shipped ones in data/shaders otherwise
+	static std::wstring GetBinaryPath(const std::wstring& path);
+	static bool IsBinaryAvailable(const std::wstring& path);
 	static std::shared_ptr<ShaderModule> Create(const std::shared_ptr<Device>& pDevice, const std::wstring& path, ShaderType type, const std::string& entryName);
 
 protected:
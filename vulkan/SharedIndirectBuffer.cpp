@@ -5,7 +5,7 @@ bool SharedIndirectBuffer::Init(const std::shared_ptr<Device>& pDevice, const st
 {
 	VkBufferCreateInfo info = {};
 	info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	info.usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+	info.usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
 	info.size = numBytes;
 
 	if (!SharedBuffer::Init(pDevice, pSelf, info))
@@ -11,6 +11,9 @@ public:
 	static std::shared_ptr<SharedIndirectBuffer> Create(const std::shared_ptr<Device>& pDevice, uint32_t numBytes);
 
 public:
+	// For compute shaders writing draw commands or counts
+	VkDescriptorBufferInfo GetDescBufferInfo() const { return m_pBufferKey->GetSharedBufferMgr()->GetBufferDesc(m_pBufferKey); }
+
 	void SetIndirectCmd(uint32_t index, const VkDrawIndexedIndirectCommand& cmd);
 	void SetIndirectCmdCount(uint32_t count);
 
@@ -7,7 +7,7 @@ bool StagingBuffer::Init(const std::shared_ptr<Device>& pDevice,
 {
 	VkBufferCreateInfo info = {};
 	info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
 	info.size = numBytes;
 	if (!Buffer::Init(pDevice, pSelf, info, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
 		return false;
@@ -30,4 +30,10 @@ std::shared_ptr<StagingBuffer> StagingBuffer::Create(const std::shared_ptr<Devic
 void StagingBuffer::UpdateByteStream(const void* pData, uint32_t offset, uint32_t numBytes)
 {
 	DeviceMemMgr()->UpdateBufferMemChunk(m_pMemKey, pData, offset, numBytes);
+}
+
+void StagingBuffer::ReadByteStream(void* pData, uint32_t offset, uint32_t numBytes) const
+{
+	// Memory is host coherent, no need to invalidate
+	memcpy(pData, (const char*)DeviceMemMgr()->GetDataPtr(m_pMemKey, offset, numBytes) + offset, numBytes);
 }
\ No newline at end of file
@@ -15,4 +15,6 @@ public:
 
 public:
 	void UpdateByteStream(const void* pData, uint32_t offset, uint32_t numBytes) override;
+	// Staging buffer is also used as a readback target, make sure gpu work writing it is done before calling this
+	void ReadByteStream(void* pData, uint32_t offset, uint32_t numBytes) const;
 };
\ No newline at end of file
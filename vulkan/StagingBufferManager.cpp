@@ -4,6 +4,7 @@
 #include <algorithm>
 #include "Queue.h"
 #include "CommandBuffer.h"
+#include "InitCommandBatcher.h"
 
 bool StagingBufferManager::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<StagingBufferManager>& pSelf)
 {
@@ -25,26 +26,32 @@ std::shared_ptr<StagingBufferManager> StagingBufferManager::Create(const std::sh
 
 void StagingBufferManager::FlushDataMainThread()
 {
-	std::shared_ptr<CommandBuffer> pCmdBuffer = MainThreadCommandPool(PhysicalDevice::QueueFamily::ALL_ROUND)->AllocateCommandBuffer(CommandBuffer::CBLevel::PRIMARY);
+	if (m_pendingUpdateBuffer.size() == 0)
+		return;
 
-	pCmdBuffer->StartPrimaryRecording();
-
-	// Copy each chunk to dst buffer
-	std::for_each(m_pendingUpdateBuffer.begin(), m_pendingUpdateBuffer.end(), [&](const PendingBufferInfo& info)
+	InitCmdBatcher()->Record([this](const std::shared_ptr<CommandBuffer>& pCmdBuffer)
 	{
-		VkBufferCopy copy = {};
-		copy.dstOffset = info.dstOffset;
-		copy.srcOffset = info.srcOffset;
-		copy.size = info.numBytes;
-		pCmdBuffer->CopyBuffer(m_pStagingBufferPool, info.pBuffer, { copy });
+		// Copy each chunk to dst buffer
+		std::for_each(m_pendingUpdateBuffer.begin(), m_pendingUpdateBuffer.end(), [&](const PendingBufferInfo& info)
+		{
+			VkBufferCopy copy = {};
+			copy.dstOffset = info.dstOffset;
+			copy.srcOffset = info.srcOffset;
+			copy.size = info.numBytes;
+			pCmdBuffer->CopyBuffer(m_pStagingBufferPool, info.pBuffer, { copy });
+		});
 	});
 
-	pCmdBuffer->EndPrimaryRecording();
-
-	GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::ALL_ROUND)->SubmitCommandBuffer(pCmdBuffer, nullptr, true);
-
 	m_pendingUpdateBuffer.clear();
-	m_usedNumBytes = 0;
+
+	// Staging pool can't be reused until recorded copies are done
+	// If they're batched, later updates keep appending, and pool is rewound after batch is flushed
+	// Rewinding is skipped if new updates are still pending by then, they'll be flushed later
+	InitCmdBatcher()->AddFlushCallback([this]()
+	{
+		if (m_pendingUpdateBuffer.size() == 0)
+			m_usedNumBytes = 0;
+	});
 }
 
 void StagingBufferManager::RecordDataFlush(const std::shared_ptr<CommandBuffer>& pCmdBuffer)
@@ -65,6 +72,13 @@ void StagingBufferManager::RecordDataFlush(const std::shared_ptr<CommandBuffer>&
 
 void StagingBufferManager::UpdateByteStream(const std::shared_ptr<BufferBase>& pBuffer, const void* pData, uint32_t offset, uint32_t numBytes)
 {
+	// Pool is still occupied by batched copies, flush them so that it could be rewound
+	if (InitCmdBatcher()->IsBatching() && m_usedNumBytes + numBytes > m_pStagingBufferPool->GetBufferInfo().size)
+	{
+		FlushDataMainThread();
+		InitCmdBatcher()->Flush();
+	}
+
 	uint32_t currentOffset = m_usedNumBytes;
 	m_pendingUpdateBuffer.push_back({ pBuffer, offset, currentOffset, numBytes });
 	m_usedNumBytes += numBytes;
@@ -4,6 +4,7 @@
 #include "CommandPool.h"
 #include "Queue.h"
 #include "CommandBuffer.h"
+#include "InitCommandBatcher.h"
 
 bool SwapChainImage::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<SwapChainImage>& pSelf, VkImage rawImageHandle)
 {
@@ -52,12 +53,8 @@ std::shared_ptr<SwapChainImage> SwapChainImage::Create(const std::shared_ptr<Dev
 
 void SwapChainImage::EnsureImageLayout()
 {
-	std::shared_ptr<CommandBuffer> pCmdBuffer = MainThreadCommandPool(PhysicalDevice::QueueFamily::ALL_ROUND)->AllocateCommandBuffer(CommandBuffer::CBLevel::PRIMARY);
-
-	pCmdBuffer->StartPrimaryRecording();
-
 	//Change image layout
-	std::vector<VkImageMemoryBarrier> imgBarriers(1);
+	FrameVector<VkImageMemoryBarrier> imgBarriers(1);
 	imgBarriers[0] = {};
 	imgBarriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 	imgBarriers[0].srcAccessMask = 0;
@@ -73,16 +70,18 @@ void SwapChainImage::EnsureImageLayout()
 	imgBarriers[0].subresourceRange.baseArrayLayer = 0;
 	imgBarriers[0].subresourceRange.layerCount = 1;
 
-	pCmdBuffer->AttachBarriers
-	(
-		VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-		{},
-		{},
-		imgBarriers
-	);
-
-	pCmdBuffer->EndPrimaryRecording();
+	InitCmdBatcher()->Record([this, &imgBarriers](const std::shared_ptr<CommandBuffer>& pCmdBuffer)
+	{
+		pCmdBuffer->AttachBarriers
+		(
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			{},
+			{},
+			imgBarriers
+		);
 
-	GlobalObjects()->GetQueue(PhysicalDevice::QueueFamily::ALL_ROUND)->SubmitCommandBuffer(pCmdBuffer, nullptr, true);
+		// Image must outlive batched barrier
+		pCmdBuffer->AddToReferenceTable(GetSelfSharedPtr());
+	});
 }
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include "TimelineSemaphore.h"
+
+bool TimelineSemaphore::Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<TimelineSemaphore>& pSelf, uint64_t initialValue)
+{
+	if (!DeviceObjectBase::Init(pDevice, pSelf))
+		return false;
+
+	ASSERTION(pDevice->IsTimelineSemaphoreEnabled());
+
+	VkSemaphoreTypeCreateInfo typeInfo = {};
+	typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	typeInfo.initialValue = initialValue;
+
+	VkSemaphoreCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	info.pNext = &typeInfo;
+	CHECK_VK_ERROR(vkCreateSemaphore(GetDevice()->GetDeviceHandle(), &info, nullptr, &m_semaphore));
+
+	return true;
+}
+
+std::shared_ptr<TimelineSemaphore> TimelineSemaphore::Create(const std::shared_ptr<Device>& pDevice, uint64_t initialValue)
+{
+	std::shared_ptr<TimelineSemaphore> pSemaphore = std::make_shared<TimelineSemaphore>();
+	if (pSemaphore.get() && pSemaphore->Init(pDevice, pSemaphore, initialValue))
+		return pSemaphore;
+	return nullptr;
+}
+
+uint64_t TimelineSemaphore::GetCompletedValue() const
+{
+	uint64_t value = 0;
+	CHECK_VK_ERROR(vkGetSemaphoreCounterValue(GetDevice()->GetDeviceHandle(), m_semaphore, &value));
+	return value;
+}
+
+void TimelineSemaphore::Wait(uint64_t value) const
+{
+	VkSemaphoreWaitInfo waitInfo = {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &m_semaphore;
+	waitInfo.pValues = &value;
+	CHECK_VK_ERROR(vkWaitSemaphores(GetDevice()->GetDeviceHandle(), &waitInfo, UINT64_MAX));
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "Semaphore.h"
+
+// Semaphore with a monotonically increasing 64 bit value
+// Submissions wait for or signal a specific value, and cpu could query or wait for it without fences
+class TimelineSemaphore : public Semaphore
+{
+public:
+	bool Init(const std::shared_ptr<Device>& pDevice, const std::shared_ptr<TimelineSemaphore>& pSelf, uint64_t initialValue);
+
+public:
+	uint64_t GetCompletedValue() const;
+	void Wait(uint64_t value) const;
+
+public:
+	static std::shared_ptr<TimelineSemaphore> Create(const std::shared_ptr<Device>& pDevice, uint64_t initialValue = 0);
+};
\ No newline at end of file
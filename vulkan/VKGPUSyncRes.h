@@ -1,6 +1,7 @@
 #pragma once
 
 #include "VKFenceGuardRes.h"
+#include "../common/FrameArena.h"
 #include <set>
 
 class Semaphore;
@@ -18,9 +19,9 @@ public:
 		VkImageLayout				srcImageLayout,
 		VkAccessFlags				dstAccessFlags,
 		VkImageLayout				dstImageLayout,
-		std::vector<VkMemoryBarrier>&		memBarriers,
-		std::vector<VkBufferMemoryBarrier>&	bufferMemBarriers,
-		std::vector<VkImageMemoryBarrier>&	imageMemBarriers
+		FrameVector<VkMemoryBarrier>&		memBarriers,
+		FrameVector<VkBufferMemoryBarrier>&	bufferMemBarriers,
+		FrameVector<VkImageMemoryBarrier>&	imageMemBarriers
 	) = 0;
 
 	virtual void PrepareQueueReleaseBarrier
@@ -29,9 +30,9 @@ public:
 		VkImageLayout				srcImageLayout,
 		PhysicalDevice::QueueFamily	srcQueueFamily,
 		PhysicalDevice::QueueFamily	dstQueueFamily,
-		std::vector<VkMemoryBarrier>&		memBarriers,
-		std::vector<VkBufferMemoryBarrier>&	bufferMemBarriers,
-		std::vector<VkImageMemoryBarrier>&	imageMemBarriers
+		FrameVector<VkMemoryBarrier>&		memBarriers,
+		FrameVector<VkBufferMemoryBarrier>&	bufferMemBarriers,
+		FrameVector<VkImageMemoryBarrier>&	imageMemBarriers
 	) = 0;
 
 	virtual void PrepareQueueAcquireBarrier
@@ -40,9 +41,9 @@ public:
 		VkImageLayout				dstImageLayout,
 		PhysicalDevice::QueueFamily	srcQueueFamily,
 		PhysicalDevice::QueueFamily	dstQueueFamily,
-		std::vector<VkMemoryBarrier>&		memBarriers,
-		std::vector<VkBufferMemoryBarrier>&	bufferMemBarriers,
-		std::vector<VkImageMemoryBarrier>&	imageMemBarriers
+		FrameVector<VkMemoryBarrier>&		memBarriers,
+		FrameVector<VkBufferMemoryBarrier>&	bufferMemBarriers,
+		FrameVector<VkImageMemoryBarrier>&	imageMemBarriers
 	) = 0;
 
 private:
@@ -30,6 +30,7 @@ uint32_t VulkanUtil::GetBytesFromFormat(VkFormat format)
 	case VK_FORMAT_R16G16_SNORM:				return 4;
 	case VK_FORMAT_R32G32B32_SFLOAT:			return 12;
 	case VK_FORMAT_R32G32B32A32_SFLOAT:			return 16;
+	case VK_FORMAT_R32_UINT:					return 4;
 	default: ASSERTION(false);	// New one used, add it here
 	}
 	return 0;